@@ -1,4 +1,8 @@
 #!/bin/sh -e
+fail() {
+    echo "Error: $1"
+    exit 1
+}
 
 notExists() {
 	  [ ! -f "$1" ]
@@ -53,6 +57,8 @@ cp -f "${NCBITAXINFO}/names.dmp"     "${TAXDBNAME}_names.dmp"
 cp -f "${NCBITAXINFO}/nodes.dmp"     "${TAXDBNAME}_nodes.dmp"
 cp -f "${NCBITAXINFO}/merged.dmp"    "${TAXDBNAME}_merged.dmp"
 cp -f "${NCBITAXINFO}/delnodes.dmp"  "${TAXDBNAME}_delnodes.dmp"
+"$MMSEQS" createbintaxonomy "${TAXDBNAME}_names.dmp" "${TAXDBNAME}_nodes.dmp" "${TAXDBNAME}_merged.dmp" "${TAXDBNAME}_taxonomy" \
+    --mapping-file "${TAXDBNAME}_mapping" || fail "createbintaxonomy died"
 echo "Database created"
 
 if [ -n "$REMOVE_TMP" ]; then
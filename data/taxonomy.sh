@@ -25,6 +25,21 @@ TARGET="$2"
 RESULTS="$3"
 TMP_PATH="$4"
 
+# the align module of the search writes the LCA directly
+if [ -n "${FUSED_LCA}" ]; then
+    mkdir -p "${TMP_PATH}/tmp_hsp1"
+    # shellcheck disable=SC2086
+    "$MMSEQS" search "${INPUT}" "${TARGET}" "${RESULTS}" "${TMP_PATH}/tmp_hsp1" ${SEARCH1_PAR} \
+        || fail "Search died"
+
+    if [ -n "${REMOVE_TMP}" ]; then
+        echo "Remove temporary files"
+        rm -rf "${TMP_PATH}/tmp_hsp1"
+        rm -f "${TMP_PATH}/taxonomy.sh"
+    fi
+    exit 0
+fi
+
 if [ ! -e "${TMP_PATH}/first" ]; then
     mkdir -p "${TMP_PATH}/tmp_hsp1"
     # shellcheck disable=SC2086
@@ -0,0 +1,99 @@
+#ifndef KALLOC_H_
+#define KALLOC_H_
+
+/* Arena for the km argument of the ksw2 functions. Memory handed out from the arena is released
+   all at once with km_reset, kfree is a no-op for it. Requests that do not fit fall back to malloc
+   and let the next km_reset grow the arena, so repeated alignments of similar size stop allocating.
+   A NULL km uses malloc and free directly. */
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+	char *data;
+	size_t size;
+	size_t used;
+	size_t requested;
+} kmem_t;
+
+#define KM_ALIGN 16
+
+static inline void *km_init(size_t size)
+{
+	kmem_t *km = (kmem_t*)malloc(sizeof(kmem_t));
+	km->data = (char*)malloc(size);
+	km->size = size;
+	km->used = 0;
+	km->requested = 0;
+	return km;
+}
+
+static inline void km_destroy(void *_km)
+{
+	kmem_t *km = (kmem_t*)_km;
+	if (km == 0) return;
+	free(km->data);
+	free(km);
+}
+
+// releases everything allocated from the arena, grows it if the last use did not fit
+static inline void km_reset(void *_km)
+{
+	kmem_t *km = (kmem_t*)_km;
+	if (km->requested > km->size) {
+		free(km->data);
+		km->size = km->requested + km->requested / 2;
+		km->data = (char*)malloc(km->size);
+	}
+	km->used = 0;
+	km->requested = 0;
+}
+
+static inline int km_contains(const kmem_t *km, const void *ptr)
+{
+	return (const char*)ptr >= km->data && (const char*)ptr < km->data + km->size;
+}
+
+// every block starts with its size to support krealloc
+static inline void *kmalloc(void *_km, size_t size)
+{
+	kmem_t *km = (kmem_t*)_km;
+	if (km == 0) return malloc(size);
+	size_t need = KM_ALIGN + (size + KM_ALIGN - 1) / KM_ALIGN * KM_ALIGN;
+	km->requested += need;
+	if (km->used + need > km->size) return malloc(size);
+	char *block = km->data + km->used;
+	*(size_t*)block = size;
+	km->used += need;
+	return block + KM_ALIGN;
+}
+
+static inline void *kcalloc(void *km, size_t count, size_t size)
+{
+	if (km == 0) return calloc(count, size);
+	void *ptr = kmalloc(km, count * size);
+	memset(ptr, 0, count * size);
+	return ptr;
+}
+
+static inline void kfree(void *_km, void *ptr)
+{
+	kmem_t *km = (kmem_t*)_km;
+	if (km == 0 || km_contains(km, ptr) == 0) free(ptr);
+}
+
+static inline void *krealloc(void *_km, void *ptr, size_t size)
+{
+	kmem_t *km = (kmem_t*)_km;
+	if (km == 0 || (ptr != 0 && km_contains(km, ptr) == 0)) return realloc(ptr, size);
+	if (ptr == 0) return kmalloc(km, size);
+	size_t old = *(size_t*)((char*)ptr - KM_ALIGN);
+	if (size <= old) return ptr;
+	void *grown = kmalloc(km, size);
+	memcpy(grown, ptr, old);
+	return grown;
+}
+
+#undef KM_ALIGN
+
+#endif
@@ -94,6 +94,7 @@ typedef __m512  simd_float;
 #define simdf32_max(x,y)    _mm512_max_ps(x,y)
 #define simdf32_min(x,y)    _mm512_min_ps(x,y)
 #define simdf32_load(x)     _mm512_load_ps(x)
+#define simdf32_loadu(x)    _mm512_loadu_ps(x)
 #define simdf32_store(x,y)  _mm512_store_ps(x,y)
 #define simdf32_set(x)      _mm512_set1_ps(x)
 #define simdf32_setzero(x)  _mm512_setzero_ps()
@@ -268,6 +269,7 @@ typedef __m256 simd_float;
 #define simdf32_max(x,y)    _mm256_max_ps(x,y)
 #define simdf32_min(x,y)    _mm256_min_ps(x,y)
 #define simdf32_load(x)     _mm256_load_ps(x)
+#define simdf32_loadu(x)    _mm256_loadu_ps(x)
 #define simdf32_store(x,y)  _mm256_store_ps(x,y)
 #define simdf32_set(x)      _mm256_set1_ps(x)
 #define simdf32_setzero(x)  _mm256_setzero_ps()
@@ -327,6 +329,7 @@ typedef __m128  simd_float;
 #define simdf32_max(x,y)    _mm_max_ps(x,y)
 #define simdf32_min(x,y)    _mm_min_ps(x,y)
 #define simdf32_load(x)     _mm_load_ps(x)
+#define simdf32_loadu(x)    _mm_loadu_ps(x)
 #define simdf32_store(x,y)  _mm_store_ps(x,y)
 #define simdf32_set(x)      _mm_set1_ps(x)
 #define simdf32_setzero(x)  _mm_setzero_ps()
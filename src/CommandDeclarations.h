@@ -32,6 +32,7 @@ extern int mvdb(int argc, const char **argv, const Command& command);
 extern int createtsv(int argc, const char **argv, const Command& command);
 extern int dbtype(int argc, const char **argv, const Command& command);
 extern int decompress(int argc, const char **argv, const Command &command);
+extern int dbd(int argc, const char **argv, const Command& command);
 extern int diffseqdbs(int argc, const char **argv, const Command& command);
 extern int easycluster(int argc, const char **argv, const Command& command);
 extern int easylinclust(int argc, const char **argv, const Command& command);
@@ -100,6 +101,7 @@ extern int swapresults(int argc, const char **argv, const Command& command);
 extern int taxonomy(int argc, const char **argv, const Command& command);
 extern int easytaxonomy(int argc, const char **argv, const Command& command);
 extern int createtaxdb(int argc, const char **argv, const Command& command);
+extern int createbintaxonomy(int argc, const char **argv, const Command& command);
 extern int translateaa(int argc, const char **argv, const Command& command);
 extern int translatenucs(int argc, const char **argv, const Command& command);
 extern int tsv2db(int argc, const char **argv, const Command& command);
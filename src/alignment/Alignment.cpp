@@ -12,6 +12,7 @@
 #include "FileUtil.h"
 #include "LinsearchIndexReader.h"
 #include "IndexReader.h"
+#include "TaxonomyLca.h"
 
 
 #ifdef OPENMP
@@ -26,7 +27,10 @@ Alignment::Alignment(const std::string &querySeqDB,
 
         covThr(par.covThr), canCovThr(par.covThr), covMode(par.covMode), seqIdMode(par.seqIdMode), evalThr(par.evalThr), seqIdThr(par.seqIdThr),
         alnLenThr(par.alnLenThr), includeIdentity(par.includeIdentity), addBacktrace(par.addBacktrace), realign(par.realign), scoreBias(par.scoreBias),
-        threads(static_cast<unsigned int>(par.threads)), compressed(par.compressed), outDB(outDB), outDBIndex(outDBIndex),
+        tracebackMode(par.tracebackMode),
+        bandWidth(par.bandWidth), prescreen(par.prescreen), taxonomyLca(NULL), lcaMode(par.taxonomySearchMode),
+        threads(static_cast<unsigned int>(par.threads)), compressed(par.compressed),
+        prefetchTargets(par.preloadMode == Parameters::PRELOAD_MODE_MMAP_PREFETCH), outDB(outDB), outDBIndex(outDBIndex),
         maxSeqLen(par.maxSeqLen), compBiasCorrection(par.compBiasCorrection), altAlignment(par.altAlignment), qdbr(NULL), qDbrIdx(NULL),
         tdbr(NULL), tDbrIdx(NULL) {
 
@@ -52,10 +56,11 @@ Alignment::Alignment(const std::string &querySeqDB,
     }
 
     std::string scoringMatrixFile = par.scoringMatrixFile;
-    bool touch = (par.preloadMode != Parameters::PRELOAD_MODE_MMAP);
+    bool touch = Parameters::shouldTouchData(par.preloadMode);
     tDbrIdx = new IndexReader(targetSeqDB, par.threads, IndexReader::SEQUENCES, (touch) ? (IndexReader::PRELOAD_INDEX | IndexReader::PRELOAD_DATA) : 0 );
     tdbr = tDbrIdx->sequenceReader;
     targetSeqType = tdbr->getDbtype();
+    prescreen = prescreen && Parameters::isEqualDbtype(targetSeqType, Parameters::DBTYPE_AMINO_ACIDS);
     sameQTDB = (targetSeqDB.compare(querySeqDB) == 0);
     if (sameQTDB == true) {
         qDbrIdx = tDbrIdx;
@@ -84,7 +89,7 @@ Alignment::Alignment(const std::string &querySeqDB,
     //qdbr->readMmapedDataInMemory();
     // make sure to touch target after query, so if there is not enough memory for the query, at least the targets
     // might have had enough space left to be residung in the page cache
-    if (sameQTDB == false && tDbrIdx == NULL && par.preloadMode != Parameters::PRELOAD_MODE_MMAP) {
+    if (sameQTDB == false && tDbrIdx == NULL && Parameters::shouldTouchData(par.preloadMode)) {
         tdbr->readMmapedDataInMemory();
     }
 
@@ -140,6 +145,14 @@ Alignment::Alignment(const std::string &querySeqDB,
     } else {
         realign_m = NULL;
     }
+
+    if (par.fusedLca == true) {
+        if (lcaMode != Parameters::TAXONOMY_SINGLE_SEARCH && lcaMode != Parameters::TAXONOMY_TOP_HIT) {
+            Debug(Debug::ERROR) << "Fused LCA supports only --lca-mode 1 and 4.\n";
+            EXIT(EXIT_FAILURE);
+        }
+        taxonomyLca = new TaxonomyLca(targetSeqDB, par);
+    }
 }
 
 void Alignment::initSWMode(unsigned int alignmentMode) {
@@ -205,25 +218,39 @@ Alignment::~Alignment() {
 
     prefdbr->close();
     delete prefdbr;
+
+    if (taxonomyLca != NULL) {
+        delete taxonomyLca;
+    }
 }
 
 void Alignment::run(const unsigned int mpiRank, const unsigned int mpiNumProc,
                     const unsigned int maxAlnNum, const unsigned int maxRejected) {
+    // queries are handed out in chunks on demand, the prefilter result size approximates the alignment cost
+    const size_t chunkCount = static_cast<size_t>(mpiNumProc) * CHUNKS_PER_PROCESS;
+    ChunkDispenser dispenser(prefdbr->getSeqLens(), prefdbr->getSize(), chunkCount);
+    const std::string lockFile = outDB + ".lock";
+#ifdef HAVE_MPI
+    dispenser.useMpiWorkQueue();
+#else
+    dispenser.useLockFile(lockFile, mpiRank == 0);
+#endif
 
-    size_t dbFrom = 0;
-    size_t dbSize = 0;
-    Util::decomposeDomainByAminoAcid(prefdbr->getDataSize(), prefdbr->getSeqLens(),
-                                     prefdbr->getSize(), mpiRank, mpiNumProc, &dbFrom, &dbSize);
-
-    Debug(Debug::INFO) << "Compute split from " << dbFrom << " to " << (dbFrom + dbSize) << "\n";
+    Debug(Debug::INFO) << "Compute " << dispenser.getChunkCount() << " chunks with " << mpiNumProc << " processes\n";
     std::pair<std::string, std::string> tmpOutput = Util::createTmpFileNames(outDB, outDBIndex, mpiRank);
-    run(tmpOutput.first, tmpOutput.second, dbFrom, dbSize, maxAlnNum, maxRejected, true);
+    run(tmpOutput.first, tmpOutput.second, dispenser, maxAlnNum, maxRejected, true);
+    dispenser.finish();
 
 #ifdef HAVE_MPI
     MPI_Barrier(MPI_COMM_WORLD);
+#else
+    if (mpiRank == 0) {
+        dispenser.waitForProcesses(mpiNumProc);
+        FileUtil::remove(lockFile.c_str());
+    }
 #endif
 
-    if (MMseqsMPI::isMaster()) {
+    if (mpiRank == 0) {
         std::vector<std::pair<std::string, std::string> > splitFiles;
         for (unsigned int proc = 0; proc < mpiNumProc; proc++) {
             splitFiles.push_back(Util::createTmpFileNames(outDB, outDBIndex, proc));
@@ -235,24 +262,56 @@ void Alignment::run(const unsigned int mpiRank, const unsigned int mpiNumProc,
 }
 
 void Alignment::run(const unsigned int maxAlnNum, const unsigned int maxRejected) {
-    run(outDB, outDBIndex, 0, prefdbr->getSize(), maxAlnNum, maxRejected, false);
+    ChunkDispenser dispenser(prefdbr->getSeqLens(), prefdbr->getSize(), 1);
+    run(outDB, outDBIndex, dispenser, maxAlnNum, maxRejected, false);
 }
 
-void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
-                    const size_t dbFrom, const size_t dbSize,
+void Alignment::run(const std::string &outDB, const std::string &outDBIndex, ChunkDispenser &dispenser,
                     const unsigned int maxAlnNum, const unsigned int maxRejected, bool merge) {
     size_t alignmentsNum = 0;
     size_t totalPassedNum = 0;
-    DBWriter dbw(outDB.c_str(), outDBIndex.c_str(), threads, compressed, Parameters::DBTYPE_ALIGNMENT_RES);
+    size_t queryCount = 0;
+    size_t taxonNotFound = 0;
+    size_t taxonFound = 0;
+    const int outDbType = (taxonomyLca != NULL) ? Parameters::DBTYPE_TAXONOMICAL_RESULT : Parameters::DBTYPE_ALIGNMENT_RES;
+    DBWriter dbw(outDB.c_str(), outDBIndex.c_str(), threads, compressed, outDbType);
     dbw.open();
 
-    // handle no alignment case early, below would divide by 0 otherwise
-    if (dbSize == 0) {
-        dbw.close(merge);
+    EvalueComputation evaluer(tdbr->getAminoAcidDBSize(), this->m, gapOpen, gapExtend);
+    size_t dbFrom = 0;
+    size_t dbSize = 0;
+    while (dispenser.next(&dbFrom, &dbSize)) {
+        queryCount += dbSize;
+        run(dbw, evaluer, dbFrom, dbSize, maxAlnNum, maxRejected, alignmentsNum, totalPassedNum, taxonFound, taxonNotFound);
+    }
+
+    dbw.close(merge);
+
+    // handle no alignment case, below would divide by 0 otherwise
+    if (queryCount == 0) {
         return;
     }
 
-    EvalueComputation evaluer(tdbr->getAminoAcidDBSize(), this->m, gapOpen, gapExtend);
+    Debug(Debug::INFO) << "\n" << alignmentsNum << " alignments calculated.\n";
+    Debug(Debug::INFO) << totalPassedNum << " sequence pairs passed the thresholds ("
+                       << ((float) totalPassedNum / (float) alignmentsNum) << " of overall calculated).\n";
+
+    size_t hits = totalPassedNum / queryCount;
+    size_t hits_rest = totalPassedNum % queryCount;
+    float hits_f = ((float) hits) + ((float) hits_rest) / (float) queryCount;
+    Debug(Debug::INFO) << hits_f << " hits per query sequence.\n";
+    if (taxonomyLca != NULL) {
+        Debug(Debug::INFO) << "Taxonomy for " << taxonNotFound << " entries not found out of " << taxonNotFound + taxonFound << "\n";
+    }
+}
+
+void Alignment::run(DBWriter &dbw, EvalueComputation &evaluer, const size_t dbFrom, const size_t dbSize,
+                    const unsigned int maxAlnNum, const unsigned int maxRejected,
+                    size_t &alignmentsTotal, size_t &passedTotal, size_t &taxonFoundTotal, size_t &taxonNotFoundTotal) {
+    size_t alignmentsNum = 0;
+    size_t totalPassedNum = 0;
+    size_t taxonNotFound = 0;
+    size_t taxonFound = 0;
     size_t totalMemory = Util::getTotalSystemMemory();
     size_t flushSize = 1000000;
     if(totalMemory > prefdbr->getTotalDataSize()){
@@ -274,14 +333,27 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
             std::string alnResultsOutString;
             alnResultsOutString.reserve(1024*1024);
             char buffer[1024+32768];
+            std::vector<unsigned int> prefetchKeys;
+            const char *screenTargets[PRESCREEN_WINDOW];
+            bool screenPasses[PRESCREEN_WINDOW];
+            // compressed targets are all decompressed into the same buffer of a thread, the window keeps copies
+            const bool copyScreenTargets = tdbr->isCompressed();
+            std::string screenCopies;
+            size_t screenOffsets[PRESCREEN_WINDOW];
             Sequence qSeq(maxSeqLen, querySeqType, m, 0, false, compBiasCorrection);
             Sequence dbSeq(maxSeqLen, targetSeqType, m, 0, false, compBiasCorrection);
-            Matcher matcher(querySeqType, maxSeqLen, m, &evaluer, compBiasCorrection, gapOpen, gapExtend);
+            Matcher matcher(querySeqType, maxSeqLen, m, &evaluer, compBiasCorrection, gapOpen, gapExtend, tracebackMode, bandWidth);
             Matcher *realigner = NULL;
             if (realign ==  true) {
-                realigner = new Matcher(querySeqType, maxSeqLen, realign_m, &evaluer, compBiasCorrection, gapOpen, gapExtend);
+                realigner = new Matcher(querySeqType, maxSeqLen, realign_m, &evaluer, compBiasCorrection, gapOpen, gapExtend, tracebackMode, bandWidth);
             }
-#pragma omp for schedule(dynamic, 5) reduction(+: alignmentsNum, totalPassedNum)
+            std::vector<TaxID> taxa;
+            // reused for every query, the results of a query are collected without allocating per hit
+            ResultBatch swResults;
+            ResultBatch swRealignResults;
+            // every alignment is written into it, its backtrace keeps the capacity between hits
+            Matcher::result_t res;
+#pragma omp for schedule(dynamic, 5) reduction(+: alignmentsNum, totalPassedNum, taxonNotFound, taxonFound)
             for (size_t id = start; id < (start + bucketSize); id++) {
                 progress.updateProgress();
 
@@ -299,13 +371,55 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
                     qSeq.mapSequence(id, queryDbKey, querySeqData);
                     matcher.initQuery(&qSeq);
                 }
+                if (prefetchTargets == true) {
+                    prefetchKeys.clear();
+                    char *current = data;
+                    while (*current != '\0' && prefetchKeys.size() < static_cast<size_t>(maxAlnNum) + maxRejected) {
+                        char dbKeyBuffer[255 + 1];
+                        Util::parseKey(current, dbKeyBuffer);
+                        prefetchKeys.push_back((unsigned int) strtoul(dbKeyBuffer, NULL, 10));
+                        current = Util::skipLine(current);
+                    }
+                    tdbr->prefetch(prefetchKeys.data(), prefetchKeys.size());
+                }
                 // parse the prefiltering list and calculate a Smith-Waterman alignment for each sequence in the list
-                std::vector<Matcher::result_t> swResults;
-                std::vector<Matcher::result_t> swRealignResults;
+                swResults.clear();
+                swRealignResults.clear();
                 size_t passedNum = 0;
                 unsigned int rejected = 0;
+                size_t screenCount = 0;
+                size_t screenPos = 0;
 
                 while (*data != '\0' && passedNum < maxAlnNum && rejected < maxRejected) {
+                    // score the next hits together, hits are still accepted and rejected one by one below
+                    if (prescreen == true && screenPos == screenCount) {
+                        screenPos = 0;
+                        screenCount = 0;
+                        screenCopies.clear();
+                        char *current = data;
+                        while (*current != '\0' && screenCount < PRESCREEN_WINDOW) {
+                            char dbKeyBuffer[255 + 1];
+                            Util::parseKey(current, dbKeyBuffer);
+                            const char *targetData = tdbr->getDataByDBKey((unsigned int) strtoul(dbKeyBuffer, NULL, 10), thread_idx);
+                            // missing targets are reported below
+                            screenTargets[screenCount] = (targetData == NULL) ? "" : targetData;
+                            if (copyScreenTargets == true) {
+                                screenOffsets[screenCount] = screenCopies.size();
+                                screenCopies.append(screenTargets[screenCount]);
+                                screenCopies.push_back('\0');
+                            }
+                            screenCount++;
+                            current = Util::skipLine(current);
+                        }
+                        if (copyScreenTargets == true) {
+                            for (size_t i = 0; i < screenCount; i++) {
+                                screenTargets[i] = screenCopies.c_str() + screenOffsets[i];
+                            }
+                        }
+                        matcher.screenTargets(screenTargets, screenCount, evalThr, screenPasses);
+                    }
+                    const bool screenPassed = (prescreen == false) || screenPasses[screenPos++];
+
                     // DB key of the db sequence
                     char dbKeyBuffer[255 + 1];
                     const char* words[10];
@@ -336,9 +450,14 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
                         continue;
                     }
                     const bool isIdentity = (queryDbKey == dbKey && (includeIdentity || sameQTDB)) ? true : false;
+                    if (screenPassed == false && isIdentity == false) {
+                        rejected++;
+                        data = Util::skipLine(data);
+                        continue;
+                    }
 
                     // calculate Smith-Waterman alignment
-                    Matcher::result_t res = matcher.getSWResult(&dbSeq, static_cast<int>(diagonal), isReverse, covMode, covThr, evalThr, swMode, seqIdMode, isIdentity);
+                    matcher.getSWResult(res, &dbSeq, static_cast<int>(diagonal), isReverse, covMode, covThr, evalThr, swMode, seqIdMode, isIdentity);
                     alignmentsNum++;
 
                     //set coverage and seqid if identity
@@ -348,7 +467,7 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
                         res.seqId = 1.0f;
                     }
                     if(checkCriteria(res, isIdentity, evalThr, seqIdThr, alnLenThr, covMode, covThr)){
-                        swResults.emplace_back(res);
+                        swResults.pushCompressed(res, addBacktrace);
                         passedNum++;
                         totalPassedNum++;
                         rejected = 0;
@@ -359,47 +478,72 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
                     data = Util::skipLine(data);
                 }
                 if(altAlignment > 0 && realign == false ){
-                    computeAlternativeAlignment(queryDbKey, dbSeq, swResults, matcher, evalThr, swMode, thread_idx);
+                    computeAlternativeAlignment(queryDbKey, dbSeq, res, swResults, matcher, evalThr, swMode, thread_idx);
                 }
 
                 // write the results
-                std::sort(swResults.begin(), swResults.end(), Matcher::compareHits);
+                swResults.sort();
                 if (realign == true) {
                     realigner->initQuery(&qSeq);
                     for (size_t result = 0; result < swResults.size(); result++) {
-                        char *dbSeqData = tdbr->getDataByDBKey(swResults[result].dbKey, thread_idx);
+                        char *dbSeqData = tdbr->getDataByDBKey(swResults.dbKey[result], thread_idx);
                         if (dbSeqData == NULL) {
-                            Debug(Debug::ERROR) << "Sequence " << swResults[result].dbKey <<" is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
+                            Debug(Debug::ERROR) << "Sequence " << swResults.dbKey[result] <<" is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
                             EXIT(EXIT_FAILURE);
                         }
-                        dbSeq.mapSequence(static_cast<size_t>(-1), swResults[result].dbKey, dbSeqData);
-                        const bool isIdentity = (queryDbKey == swResults[result].dbKey && (includeIdentity || sameQTDB)) ? true : false;
-                        Matcher::result_t res = realigner->getSWResult(&dbSeq, INT_MAX, false, covMode, covThr, FLT_MAX,
-                                                                       Matcher::SCORE_COV_SEQID, seqIdMode, isIdentity);
+                        dbSeq.mapSequence(static_cast<size_t>(-1), swResults.dbKey[result], dbSeqData);
+                        const bool isIdentity = (queryDbKey == swResults.dbKey[result] && (includeIdentity || sameQTDB)) ? true : false;
+                        realigner->getSWResult(res, &dbSeq, INT_MAX, false, covMode, covThr, FLT_MAX,
+                                               Matcher::SCORE_COV_SEQID, seqIdMode, isIdentity);
                         const bool covOK = Util::hasCoverage(realignCov, covMode, res.qcov, res.dbcov);
                         if(covOK == true|| isIdentity){
-                            swResults[result].backtrace  = res.backtrace;
-                            swResults[result].qStartPos  = res.qStartPos;
-                            swResults[result].qEndPos    = res.qEndPos;
-                            swResults[result].dbStartPos = res.dbStartPos;
-                            swResults[result].dbEndPos   = res.dbEndPos;
-                            swResults[result].alnLength  = res.alnLength;
-                            swResults[result].seqId      = res.seqId;
-                            swResults[result].qcov       = res.qcov;
-                            swResults[result].dbcov      = res.dbcov;
-                            swRealignResults.push_back(swResults[result]);
+                            // the alignment of the realigner with the score and E-value of the first alignment
+                            res.dbKey = swResults.dbKey[result];
+                            res.score = swResults.score[result];
+                            res.eval  = swResults.eval[result];
+                            res.qLen  = swResults.qLen[result];
+                            res.dbLen = swResults.dbLen[result];
+                            swRealignResults.pushCompressed(res, addBacktrace);
                         }
                     }
-                    swResults = swRealignResults;
+                    std::swap(swResults, swRealignResults);
                     if(altAlignment> 0 ){
-                        computeAlternativeAlignment(queryDbKey, dbSeq, swResults, matcher, FLT_MAX, Matcher::SCORE_COV_SEQID, thread_idx);
+                        computeAlternativeAlignment(queryDbKey, dbSeq, res, swResults, matcher, FLT_MAX, Matcher::SCORE_COV_SEQID, thread_idx);
                     }
                 }
 
-                // put the contents of the swResults list into a result DB
-                for (size_t result = 0; result < swResults.size(); result++) {
-                    size_t len = Matcher::resultToBuffer(buffer, swResults[result], addBacktrace);
-                    alnResultsOutString.append(buffer, len);
+                if (taxonomyLca != NULL) {
+                    // same result as filterdb --beats-first on the printed E-values followed by lca
+                    if (swResults.empty()) {
+                        TaxonomyLca::writeUnclassified(alnResultsOutString);
+                    } else {
+                        double topEval = 0.0;
+                        if (lcaMode == Parameters::TAXONOMY_TOP_HIT) {
+                            snprintf(buffer, sizeof(buffer), "%.3E", swResults.eval[0]);
+                            topEval = strtod(buffer, NULL);
+                        }
+                        taxa.clear();
+                        for (size_t result = 0; result < swResults.size(); result++) {
+                            if (lcaMode == Parameters::TAXONOMY_TOP_HIT && result > 0) {
+                                snprintf(buffer, sizeof(buffer), "%.3E", swResults.eval[result]);
+                                if (strtod(buffer, NULL) > topEval) {
+                                    continue;
+                                }
+                            }
+                            if (taxonomyLca->addTaxon(swResults.dbKey[result], taxa)) {
+                                taxonFound++;
+                            } else {
+                                taxonNotFound++;
+                            }
+                        }
+                        taxonomyLca->writeLca(taxa, alnResultsOutString);
+                    }
+                } else {
+                    // put the contents of the swResults list into a result DB
+                    for (size_t result = 0; result < swResults.size(); result++) {
+                        size_t len = swResults.toBuffer(buffer, result, addBacktrace);
+                        alnResultsOutString.append(buffer, len);
+                    }
                 }
                 dbw.writeData(alnResultsOutString.c_str(), alnResultsOutString.length(), queryDbKey, thread_idx);
                 alnResultsOutString.clear();
@@ -417,16 +561,10 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
 
     }
 
-    dbw.close(merge);
-
-    Debug(Debug::INFO) << "\n" << alignmentsNum << " alignments calculated.\n";
-    Debug(Debug::INFO) << totalPassedNum << " sequence pairs passed the thresholds ("
-                       << ((float) totalPassedNum / (float) alignmentsNum) << " of overall calculated).\n";
-
-    size_t hits = totalPassedNum / dbSize;
-    size_t hits_rest = totalPassedNum % dbSize;
-    float hits_f = ((float) hits) + ((float) hits_rest) / (float) dbSize;
-    Debug(Debug::INFO) << hits_f << " hits per query sequence.\n";
+    alignmentsTotal += alignmentsNum;
+    passedTotal += totalPassedNum;
+    taxonFoundTotal += taxonFound;
+    taxonNotFoundTotal += taxonNotFound;
 }
 
 size_t Alignment::estimateHDDMemoryConsumption(int dbSize, int maxSeqs) {
@@ -457,32 +595,32 @@ bool Alignment::checkCriteria(Matcher::result_t &res, bool isIdentity, double ev
 }
 
 void Alignment::computeAlternativeAlignment(unsigned int queryDbKey, Sequence &dbSeq,
-                                            std::vector<Matcher::result_t> &swResults,
+                                            Matcher::result_t &res, ResultBatch &swResults,
                                             Matcher &matcher, float evalThr, int swMode, int thread_idx) {
     int xIndex = m->aa2int[static_cast<int>('X')];
     size_t firstItResSize = swResults.size();
     for(size_t i = 0; i < firstItResSize; i++) {
-        const bool isIdentity = (queryDbKey == swResults[i].dbKey && (includeIdentity || sameQTDB))
+        const bool isIdentity = (queryDbKey == swResults.dbKey[i] && (includeIdentity || sameQTDB))
                                 ? true : false;
         if (isIdentity == true) {
             continue;
         }
-        char *dbSeqData = tdbr->getDataByDBKey(swResults[i].dbKey, thread_idx);
+        char *dbSeqData = tdbr->getDataByDBKey(swResults.dbKey[i], thread_idx);
         if (dbSeqData == NULL) {
-            Debug(Debug::ERROR) << "Sequence " << swResults[i].dbKey <<" is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
+            Debug(Debug::ERROR) << "Sequence " << swResults.dbKey[i] <<" is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
             EXIT(EXIT_FAILURE);
         }
-        dbSeq.mapSequence(static_cast<size_t>(-1), swResults[i].dbKey, dbSeqData);
-        for (int pos = swResults[i].dbStartPos; pos < swResults[i].dbEndPos; ++pos) {
+        dbSeq.mapSequence(static_cast<size_t>(-1), swResults.dbKey[i], dbSeqData);
+        for (int pos = swResults.dbStartPos[i]; pos < swResults.dbEndPos[i]; ++pos) {
             dbSeq.int_sequence[pos] = xIndex;
         }
         bool nextAlignment = true;
         for (int altAli = 0; altAli < altAlignment && nextAlignment; altAli++) {
-            Matcher::result_t res = matcher.getSWResult(&dbSeq, INT_MAX, false, covMode, covThr, evalThr, swMode,
-                                                        seqIdMode, isIdentity);
+            matcher.getSWResult(res, &dbSeq, INT_MAX, false, covMode, covThr, evalThr, swMode,
+                                seqIdMode, isIdentity);
             nextAlignment = checkCriteria(res, isIdentity, evalThr, seqIdThr, alnLenThr, covMode, covThr);
             if (nextAlignment == true) {
-                swResults.emplace_back(res);
+                swResults.pushCompressed(res, addBacktrace);
                 for (int pos = res.dbStartPos; pos < res.dbEndPos; pos++) {
                     dbSeq.int_sequence[pos] = xIndex;
                 }
@@ -5,11 +5,16 @@
 #include <list>
 #include "IndexReader.h"
 #include "DBReader.h"
+#include "DBWriter.h"
 #include "Parameters.h"
 #include "BaseMatrix.h"
 #include "Sequence.h"
 #include "SequenceLookup.h"
 #include "Matcher.h"
+#include "ResultBatch.h"
+#include "ChunkDispenser.h"
+
+class TaxonomyLca;
 
 class Alignment {
 
@@ -30,15 +35,25 @@ public:
     void run(const unsigned int mpiRank, const unsigned int mpiNumProc,
              const unsigned int maxAlnNum, const unsigned int maxRejected);
 
-    //Run parallel
-    void run(const std::string &outDB, const std::string &outDBIndex,
-             const size_t dbFrom, const size_t dbSize,
+    //Run parallel over all chunks handed out by the dispenser
+    void run(const std::string &outDB, const std::string &outDBIndex, ChunkDispenser &dispenser,
              const unsigned int maxAlnNum, const unsigned int maxRejected, bool merge);
 
     static bool checkCriteria(Matcher::result_t &res, bool isIdentity, double evalThr, double seqIdThr, int alnLenThr, int covMode, float covThr);
 
 
 private:
+    // chunks per process for the dynamic distribution of queries
+    static const size_t CHUNKS_PER_PROCESS = 64;
+
+    // prefilter hits scored together by the prescreen, more hits pack the SIMD lanes more evenly
+    static const size_t PRESCREEN_WINDOW = 8 * SmithWaterman::BATCH_SIZE;
+
+    // aligns the queries dbFrom to dbFrom + dbSize and adds the counts to the totals
+    void run(DBWriter &dbw, EvalueComputation &evaluer, const size_t dbFrom, const size_t dbSize,
+             const unsigned int maxAlnNum, const unsigned int maxRejected,
+             size_t &alignmentsTotal, size_t &passedTotal, size_t &taxonFoundTotal, size_t &taxonNotFoundTotal);
+
     // sequence coverage threshold
     double covThr;
 
@@ -75,10 +90,23 @@ private:
     //to increase/decrease the threshold for finishing the alignment 
     float scoreBias;
 
+    // Parameters::TRACEBACK_MODE_THREE_PASS or TRACEBACK_MODE_SINGLE_PASS
+    const int tracebackMode;
+    const int bandWidth;
+    // score batches of amino acid targets before aligning them, see Matcher::screenTargets
+    bool prescreen;
+
+    // with --fused-lca the LCA of the hits is written instead of the alignments, NULL otherwise
+    TaxonomyLca *taxonomyLca;
+    // Parameters::TAXONOMY_SINGLE_SEARCH uses all hits, TAXONOMY_TOP_HIT only those with the E-value of the best hit
+    const int lcaMode;
+
     // keeps state of the SW alignment mode (ALIGNMENT_MODE_SCORE_ONLY, ALIGNMENT_MODE_SCORE_COV or ALIGNMENT_MODE_SCORE_COV_SEQID)
     unsigned int swMode;
     unsigned int threads;
     unsigned int compressed;
+    // read the targets of a prefilter list into the page cache before aligning them
+    bool prefetchTargets;
 
     const std::string outDB;
     const std::string outDBIndex;
@@ -115,7 +143,7 @@ private:
     static size_t estimateHDDMemoryConsumption(int dbSize, int maxSeqs);
 
     void computeAlternativeAlignment(unsigned int queryDbKey, Sequence &dbSeq,
-                                     std::vector<Matcher::result_t> &vector, Matcher &matcher,
+                                     Matcher::result_t &res, ResultBatch &results, Matcher &matcher,
                                      float evalThr, int swMode, int thread_idx);
 };
 
@@ -27,6 +27,10 @@ fastMatrix(SubstitutionMatrix::createAsciiSubMat(*subMat))
     queryRevCompSeqRev =  new uint8_t[maxSequenceLength];
     queryRevCompCharSeq  =  new char[maxSequenceLength];
     mat = new int8_t[subMat->alphabetSize*subMat->alphabetSize];
+    // a cigar has at most one operation per query and target residue
+    cigar = new uint32_t[2 * maxSequenceLength];
+    // ksw2 allocates its matrices from this arena, it grows to the largest alignment seen
+    km = km_init(16 * maxSequenceLength);
     this->subMat = (NucleotideMatrix*) subMat;
     for (int i = 0; i < subMat->alphabetSize; i++) {
         for (int j = 0; j < subMat->alphabetSize; j++) {
@@ -48,6 +52,8 @@ BandedNucleotideAligner::~BandedNucleotideAligner(){
     delete [] fastMatrix.matrixData;
     delete [] fastMatrix.matrix;
     delete [] mat;
+    delete [] cigar;
+    km_destroy(km);
 }
 
 void BandedNucleotideAligner::initQuery(Sequence * query){
@@ -110,10 +116,8 @@ s_align BandedNucleotideAligner::align(Sequence * targetSeqObj,
     if(qUngappedStartPos == 0 && qUngappedEndPos == querySeqObj->L -1
        && dbUngappedStartPos == 0 && dbUngappedEndPos == targetSeqObj->L - 1){
         s_align result;
-        uint32_t * retCigar = new uint32_t[1];
-        retCigar[0] = 0;
-        retCigar[0] = querySeqObj->L << 4;
-        result.cigar = retCigar;
+        cigar[0] = querySeqObj->L << 4;
+        result.cigar = cigar;
         result.cigarLen = 1;
         result.score1 = alignment.score;
         result.qStartPos1 = qUngappedStartPos;
@@ -137,11 +141,12 @@ s_align BandedNucleotideAligner::align(Sequence * targetSeqObj,
     int qStartRev = (querySeqObj->L  - qUngappedEndPos) - 1;
     int tStartRev = (targetSeqObj->L - dbUngappedEndPos) - 1;
 
+    km_reset(km);
     ksw_extz_t ez;
     int flag = 0;
     flag |= KSW_EZ_SCORE_ONLY;
     flag |= KSW_EZ_EXTZ_ONLY;
-    ksw_extz2_sse(0, querySeqObj->L - qStartRev, querySeqRevAlign + qStartRev, targetSeqObj->L - tStartRev, targetSeqRev + tStartRev, 5, mat, gapo, gape, 64, 40, flag, &ez);
+    ksw_extz2_sse(km, querySeqObj->L - qStartRev, querySeqRevAlign + qStartRev, targetSeqObj->L - tStartRev, targetSeqRev + tStartRev, 5, mat, gapo, gape, 64, 40, flag, &ez);
 
     int qStartPos = querySeqObj->L  - ( qStartRev + ez.max_q ) -1 ;
     int tStartPos = targetSeqObj->L - ( tStartRev + ez.max_t ) -1;
@@ -153,16 +158,14 @@ s_align BandedNucleotideAligner::align(Sequence * targetSeqObj,
 //    ezAlign.cigar = cigar;
 //    printf("%d %d\n", qStartPos, tStartPos);
     memset(&ezAlign, 0, sizeof(ksw_extz_t));
-    ksw_extz2_sse(0, querySeqObj->L-qStartPos, querySeqAlign+qStartPos, targetSeqObj->L-tStartPos, targetSeq+tStartPos, 5,
+    ksw_extz2_sse(km, querySeqObj->L-qStartPos, querySeqAlign+qStartPos, targetSeqObj->L-tStartPos, targetSeq+tStartPos, 5,
                   mat, gapo, gape, 64, 40, alignFlag, &ezAlign);
 
-    std::string letterCode = "MID";
-    uint32_t * retCigar = new uint32_t[ezAlign.n_cigar];
     for(int i = 0; i < ezAlign.n_cigar; i++){
-        retCigar[i]=ezAlign.cigar[i];
+        cigar[i]=ezAlign.cigar[i];
     }
     s_align result;
-    result.cigar = retCigar;
+    result.cigar = cigar;
     result.cigarLen = ezAlign.n_cigar;
     result.score1 = ezAlign.max;
     result.qStartPos1 = qStartPos;
@@ -200,7 +203,7 @@ s_align BandedNucleotideAligner::align(Sequence * targetSeqObj,
             }
         }
     }
-    free(ezAlign.cigar);
+    kfree(km, ezAlign.cigar);
     return result;
 //        std::cout << static_cast<float>(aaIds)/ static_cast<float>(alignment.len) << std::endl;
 
@@ -38,7 +38,10 @@ private:
     Sequence * querySeqObj;
     int8_t * mat;
     NucleotideMatrix * subMat;
-//    uint32_t * cigar;
+    // cigar of the last alignment, s_align::cigar points into it
+    uint32_t * cigar;
+    // memory pool of ksw2
+    void * km;
     int gapo;
     int gape;
 };
@@ -24,7 +24,16 @@ int align(int argc, const char **argv, const Command& command) {
 #ifdef HAVE_MPI
     aln.run(MMseqsMPI::rank, MMseqsMPI::numProc, par.maxAccept, par.maxRejected);
 #else
-    aln.run(par.maxAccept, par.maxRejected);
+    // several processes on the same node share the queries over a lock file
+    if (par.procCount > 1) {
+        if (par.procId >= par.procCount) {
+            Debug(Debug::ERROR) << "--proc-id has to be smaller than --proc-count.\n";
+            EXIT(EXIT_FAILURE);
+        }
+        aln.run(par.procId, par.procCount, par.maxAccept, par.maxRejected);
+    } else {
+        aln.run(par.maxAccept, par.maxRejected);
+    }
 #endif
 
     return EXIT_SUCCESS;
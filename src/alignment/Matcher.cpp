@@ -7,16 +7,21 @@
 
 
 Matcher::Matcher(int querySeqType, int maxSeqLen, BaseMatrix *m, EvalueComputation * evaluer,
-                 bool aaBiasCorrection, int gapOpen, int gapExtend){
+                 bool aaBiasCorrection, int gapOpen, int gapExtend, int tracebackMode, int bandWidth){
     this->m = m;
     this->tinySubMat = NULL;
     this->gapOpen = gapOpen;
     this->gapExtend = gapExtend;
+    this->tracebackMode = tracebackMode;
+    this->bandWidth = bandWidth;
     if(Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_PROFILE_STATE_PROFILE) == false ) {
         setSubstitutionMatrix(m);
     }
 
     this->maxSeqLen = maxSeqLen;
+    screenBatch = NULL;
+    screenMaxima = NULL;
+    screenBatchLength = 0;
     nuclaligner=NULL;
     aligner=NULL;
     if(Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_NUCLEOTIDES)){
@@ -49,6 +54,8 @@ Matcher::~Matcher(){
         delete [] tinySubMat;
         tinySubMat = NULL;
     }
+    free(screenBatch);
+    free(screenMaxima);
 }
 
 void Matcher::initQuery(Sequence* query){
@@ -66,6 +73,13 @@ void Matcher::initQuery(Sequence* query){
 Matcher::result_t Matcher::getSWResult(Sequence* dbSeq, const int diagonal, bool isReverse, const int covMode, const float covThr,
                                        const double evalThr, unsigned int alignmentMode, unsigned int seqIdMode,
                                        bool isIdentity){
+    getSWResult(resultBuffer, dbSeq, diagonal, isReverse, covMode, covThr, evalThr, alignmentMode, seqIdMode, isIdentity);
+    return resultBuffer;
+}
+
+void Matcher::getSWResult(result_t &result, Sequence* dbSeq, const int diagonal, bool isReverse, const int covMode,
+                          const float covThr, const double evalThr, unsigned int alignmentMode, unsigned int seqIdMode,
+                          bool isIdentity){
     // calculation of the score and traceback of the alignment
     int32_t maskLen = currentQuery->L / 2;
 
@@ -79,7 +93,8 @@ Matcher::result_t Matcher::getSWResult(Sequence* dbSeq, const int diagonal, bool
     //std::cout <<datapoints << " " << m->getBitFactor() <<" "<< evalThr << " " << seqDbSize << " " << currentQuery->L << " " << dbSeq->L<< " " << scoreThr << " " << std::endl;
     s_align alignment;
     // compute sequence identity
-    std::string backtrace;
+    std::string &backtrace = result.backtrace;
+    backtrace.clear();
     int aaIds = 0;
 
     if(Parameters::isEqualDbtype(dbSeq->getSequenceType(), Parameters::DBTYPE_NUCLEOTIDES)){
@@ -92,7 +107,13 @@ Matcher::result_t Matcher::getSWResult(Sequence* dbSeq, const int diagonal, bool
         alignment = nuclaligner->align(dbSeq, diagonal, isReverse, backtrace, aaIds, evaluer);
         alignmentMode = Matcher::SCORE_COV_SEQID;
     }else{ if(isIdentity==false){
-            alignment = aligner->ssw_align(dbSeq->int_sequence, dbSeq->L, gapOpen, gapExtend, alignmentMode, evalThr, evaluer, covMode, covThr, maskLen);
+            // the banded alignment falls back to the full matrix if the band would cover most of it
+            bool isBanded = bandWidth > 0 && aligner->ssw_align_banded(alignment, dbSeq->int_sequence, dbSeq->L, gapOpen, gapExtend, alignmentMode, evalThr, evaluer, covMode, covThr, diagonal, bandWidth);
+            if (isBanded == false && tracebackMode == Parameters::TRACEBACK_MODE_SINGLE_PASS) {
+                alignment = aligner->ssw_align_single_pass(dbSeq->int_sequence, dbSeq->L, gapOpen, gapExtend, alignmentMode, evalThr, evaluer, covMode, covThr, maskLen, diagonal);
+            } else if (isBanded == false) {
+                alignment = aligner->ssw_align(dbSeq->int_sequence, dbSeq->L, gapOpen, gapExtend, alignmentMode, evalThr, evaluer, covMode, covThr, maskLen);
+            }
         }else{
             alignment = aligner->scoreIdentical(dbSeq->int_sequence, dbSeq->L, evaluer, alignmentMode);
         }
@@ -103,7 +124,6 @@ Matcher::result_t Matcher::getSWResult(Sequence* dbSeq, const int diagonal, bool
                     for (int32_t c = 0; c < alignment.cigarLen; ++c) {
                         char letter = SmithWaterman::cigar_int_to_op(alignment.cigar[c]);
                         uint32_t length = SmithWaterman::cigar_int_to_len(alignment.cigar[c]);
-                        backtrace.reserve(length);
 
                         for (uint32_t i = 0; i < length; ++i){
                             if (letter == 'M') {
@@ -180,18 +200,104 @@ Matcher::result_t Matcher::getSWResult(Sequence* dbSeq, const int diagonal, bool
     double evalue = alignment.evalue;
     int bitScore = static_cast<int>(evaluer->computeBitScore(alignment.score1)+0.5);
 
-    result_t result;
-    if(isReverse){
-        result = result_t(dbSeq->getDbKey(), bitScore, qcov, dbcov, seqId, evalue, alnLength, qStartPos, qEndPos, currentQuery->L, dbEndPos, dbStartPos, dbSeq->L, backtrace);
-    }else{
-        result = result_t(dbSeq->getDbKey(), bitScore, qcov, dbcov, seqId, evalue, alnLength, qStartPos, qEndPos, currentQuery->L, dbStartPos, dbEndPos, dbSeq->L, backtrace);
+    result.dbKey = dbSeq->getDbKey();
+    result.score = bitScore;
+    result.qcov = qcov;
+    result.dbcov = dbcov;
+    result.seqId = seqId;
+    result.eval = evalue;
+    result.alnLength = alnLength;
+    result.qStartPos = qStartPos;
+    result.qEndPos = qEndPos;
+    result.qLen = currentQuery->L;
+    result.dbStartPos = isReverse ? dbEndPos : dbStartPos;
+    result.dbEndPos = isReverse ? dbStartPos : dbEndPos;
+    result.dbLen = dbSeq->L;
+}
+
+void Matcher::screenTargets(const char **targets, size_t count, const double evalThr, bool *passes) {
+    std::fill(passes, passes + count, true);
+    // a few targets leave most lanes empty and long queries keep the striped kernel busy, both are aligned directly
+    if (aligner == NULL || count < SmithWaterman::BATCH_SIZE / 4 || currentQuery->L > SCREEN_MAX_QUERY_LENGTH) {
+        return;
     }
 
+    screenEntries.clear();
+    for (size_t i = 0; i < count; i++) {
+        // same end of sequence as Sequence::mapSequence
+        ScreenEntry entry;
+        entry.index = i;
+        entry.length = 0;
+        while (targets[i][entry.length] != '\0' && targets[i][entry.length] != '\n' && entry.length < static_cast<unsigned int>(maxSeqLen)) {
+            entry.length++;
+        }
+        if (entry.length > 0) {
+            screenEntries.push_back(entry);
+        }
+    }
 
-    delete [] alignment.cigar;
-    return result;
-}
+    // longest targets first, each into the lane that ends first, so that the lanes end up about equally long.
+    // Every lane is computed up to the longest one, targets that would make the lanes much longer than the
+    // average are aligned directly.
+    std::sort(screenEntries.begin(), screenEntries.end(), compareScreenLength);
+    size_t totalLength = 0;
+    for (size_t i = 0; i < screenEntries.size(); i++) {
+        totalLength += screenEntries[i].length;
+    }
+    const size_t maxLength = totalLength / SmithWaterman::BATCH_SIZE * 5 / 4 + 1;
+    unsigned int laneEnd[SmithWaterman::BATCH_SIZE] = {};
+    unsigned int length = 0;
+    size_t placed = 0;
+    for (size_t i = 0; i < screenEntries.size(); i++) {
+        const unsigned int lane = std::min_element(laneEnd, laneEnd + SmithWaterman::BATCH_SIZE) - laneEnd;
+        if (laneEnd[lane] + screenEntries[i].length > maxLength) {
+            continue;
+        }
+        screenEntries[placed] = screenEntries[i];
+        screenEntries[placed].lane = lane;
+        screenEntries[placed].start = laneEnd[lane];
+        laneEnd[lane] += screenEntries[i].length;
+        length = std::max(length, laneEnd[lane]);
+        placed++;
+    }
+    screenEntries.resize(placed);
+    if (length == 0) {
+        return;
+    }
+    if (length > screenBatchLength) {
+        free(screenBatch);
+        free(screenMaxima);
+        screenBatchLength = length;
+        screenBatch = (uint8_t *) mem_align(ALIGN_INT, screenBatchLength * SmithWaterman::BATCH_SIZE);
+        screenMaxima = (uint8_t *) mem_align(ALIGN_INT, screenBatchLength * SmithWaterman::BATCH_SIZE);
+    }
+    memset(screenBatch, SmithWaterman::BATCH_PAD, length * SmithWaterman::BATCH_SIZE);
+    for (size_t i = 0; i < screenEntries.size(); i++) {
+        const ScreenEntry &entry = screenEntries[i];
+        const char *target = targets[entry.index];
+        uint8_t *lane = screenBatch + entry.start * SmithWaterman::BATCH_SIZE + entry.lane;
+        for (unsigned int pos = 0; pos < entry.length; pos++) {
+            lane[pos * SmithWaterman::BATCH_SIZE] = static_cast<uint8_t>(m->aa2int[(int) target[pos]]);
+        }
+        lane[0] |= SmithWaterman::BATCH_START;
+    }
 
+    if (aligner->ssw_score_batch(screenBatch, length, gapOpen, gapExtend, screenMaxima) == false) {
+        return;
+    }
+    for (size_t i = 0; i < screenEntries.size(); i++) {
+        const ScreenEntry &entry = screenEntries[i];
+        const uint8_t *lane = screenMaxima + entry.start * SmithWaterman::BATCH_SIZE + entry.lane;
+        uint8_t score = 0;
+        for (unsigned int pos = 0; pos < entry.length; pos++) {
+            score = std::max(score, lane[pos * SmithWaterman::BATCH_SIZE]);
+        }
+        // saturated scores are only known to be high, the alignment decides
+        if (score < 255 && evaluer->computeEvalue(score, currentQuery->L) > evalThr) {
+            passes[entry.index] = false;
+        }
+    }
+}
 
 void Matcher::readAlignmentResults(std::vector<result_t> &result, char *data, bool readCompressed) {
     if(data == NULL) {
@@ -301,12 +407,26 @@ Matcher::result_t Matcher::parseAlignmentRecord(const char *data, bool readCompr
 
 
 size_t Matcher::resultToBuffer(char * buff1, const result_t &result, bool addBacktrace, bool compress) {
+    if (addBacktrace && compress) {
+        std::string compressedCigar = Matcher::compressAlignment(result.backtrace);
+        return resultToBuffer(buff1, result.dbKey, result.score, result.seqId, result.eval,
+                              result.qStartPos, result.qEndPos, result.qLen, result.dbStartPos, result.dbEndPos, result.dbLen,
+                              compressedCigar.c_str(), compressedCigar.length());
+    }
+    return resultToBuffer(buff1, result.dbKey, result.score, result.seqId, result.eval,
+                          result.qStartPos, result.qEndPos, result.qLen, result.dbStartPos, result.dbEndPos, result.dbLen,
+                          addBacktrace ? result.backtrace.c_str() : NULL, result.backtrace.length());
+}
+
+size_t Matcher::resultToBuffer(char * buff1, unsigned int dbKey, int score, float seqId, double eval,
+                               int qStartPos, int qEndPos, unsigned int qLen, int dbStartPos, int dbEndPos, unsigned int dbLen,
+                               const char *backtrace, size_t backtraceLen) {
     char * basePos = buff1;
-    char * tmpBuff = Itoa::u32toa_sse2((uint32_t) result.dbKey, buff1);
+    char * tmpBuff = Itoa::u32toa_sse2((uint32_t) dbKey, buff1);
     *(tmpBuff-1) = '\t';
-    tmpBuff = Itoa::i32toa_sse2(result.score, tmpBuff);
+    tmpBuff = Itoa::i32toa_sse2(score, tmpBuff);
     *(tmpBuff-1) = '\t';
-    float seqIdFlt = result.seqId;
+    float seqIdFlt = seqId;
     //TODO seqid, evalue
 
 
@@ -336,39 +456,32 @@ size_t Matcher::resultToBuffer(char * buff1, const result_t &result, bool addBac
             *(tmpBuff) = '0';
             tmpBuff++;
         }
-        int seqId = seqIdFlt*1000;
-        tmpBuff = Itoa::i32toa_sse2(seqId, tmpBuff);
+        int seqIdInt = seqIdFlt*1000;
+        tmpBuff = Itoa::i32toa_sse2(seqIdInt, tmpBuff);
         *(tmpBuff-1) = '\t';
     }
 
-    tmpBuff += sprintf(tmpBuff,"%.3E",result.eval);
+    tmpBuff += sprintf(tmpBuff,"%.3E",eval);
     tmpBuff++;
     *(tmpBuff-1) = '\t';
-    tmpBuff = Itoa::i32toa_sse2(result.qStartPos, tmpBuff);
+    tmpBuff = Itoa::i32toa_sse2(qStartPos, tmpBuff);
     *(tmpBuff-1) = '\t';
-    tmpBuff = Itoa::i32toa_sse2(result.qEndPos, tmpBuff);
+    tmpBuff = Itoa::i32toa_sse2(qEndPos, tmpBuff);
     *(tmpBuff-1) = '\t';
-    tmpBuff = Itoa::i32toa_sse2(result.qLen, tmpBuff);
+    tmpBuff = Itoa::i32toa_sse2(qLen, tmpBuff);
     *(tmpBuff-1) = '\t';
-    tmpBuff = Itoa::i32toa_sse2(result.dbStartPos, tmpBuff);
+    tmpBuff = Itoa::i32toa_sse2(dbStartPos, tmpBuff);
     *(tmpBuff-1) = '\t';
-    tmpBuff = Itoa::i32toa_sse2(result.dbEndPos, tmpBuff);
-    if(addBacktrace == true){
+    tmpBuff = Itoa::i32toa_sse2(dbEndPos, tmpBuff);
+    if(backtrace != NULL){
         *(tmpBuff-1) = '\t';
-        tmpBuff = Itoa::i32toa_sse2(result.dbLen, tmpBuff);
-        if(compress){
-            *(tmpBuff-1) = '\t';
-            std::string compressedCigar = Matcher::compressAlignment(result.backtrace);
-            tmpBuff = strncpy(tmpBuff, compressedCigar.c_str(), compressedCigar.length());
-            tmpBuff+= compressedCigar.length()+1;
-        }else{
-            *(tmpBuff-1) = '\t';
-            tmpBuff = strncpy(tmpBuff, result.backtrace.c_str(), result.backtrace.length());
-            tmpBuff+= result.backtrace.length()+1;
-        }
+        tmpBuff = Itoa::i32toa_sse2(dbLen, tmpBuff);
+        *(tmpBuff-1) = '\t';
+        memcpy(tmpBuff, backtrace, backtraceLen);
+        tmpBuff += backtraceLen + 1;
     }else{
         *(tmpBuff-1) = '\t';
-        tmpBuff = Itoa::i32toa_sse2(result.dbLen, tmpBuff);
+        tmpBuff = Itoa::i32toa_sse2(dbLen, tmpBuff);
     }
 
     *(tmpBuff-1) = '\n';
@@ -53,7 +53,7 @@ public:
                  int dbStartPos,
                  int dbEndPos,
                  unsigned int dbLen,
-                 std::string backtrace) : dbKey(dbkey), score(score), qcov(qcov),
+                 const std::string &backtrace) : dbKey(dbkey), score(score), qcov(qcov),
                                           dbcov(dbcov), seqId(seqId), eval(eval), alnLength(alnLength),
                                           qStartPos(qStartPos), qEndPos(qEndPos), qLen(qLen),
                                           dbStartPos(dbStartPos), dbEndPos(dbEndPos), dbLen(dbLen),
@@ -122,7 +122,7 @@ public:
 
     Matcher(int querySeqType, int maxSeqLen, BaseMatrix *m,
             EvalueComputation * evaluer, bool aaBiasCorrection,
-            int gapOpen, int gapExtend);
+            int gapOpen, int gapExtend, int tracebackMode = Parameters::TRACEBACK_MODE_THREE_PASS, int bandWidth = 0);
 
     ~Matcher();
 
@@ -130,6 +130,14 @@ public:
     result_t getSWResult(Sequence* dbSeq, const int diagonal, bool isReverse, const int covMode, const float covThr, const double evalThr,
                          unsigned int alignmentMode, unsigned int seqIdMode, bool isIdentical);
 
+    // same as above, the backtrace is written into the one of result and keeps its capacity if result is reused
+    void getSWResult(result_t &result, Sequence* dbSeq, const int diagonal, bool isReverse, const int covMode, const float covThr,
+                     const double evalThr, unsigned int alignmentMode, unsigned int seqIdMode, bool isIdentical);
+
+    // marks the targets (entries of an amino acid sequence database) whose 8 bit score against the query cannot
+    // reach evalThr, the targets are packed into the lanes of SmithWaterman::ssw_score_batch and scored at once
+    void screenTargets(const char **targets, size_t count, const double evalThr, bool *passes);
+
     // need for sorting the results
     static bool compareHits (const result_t &first, const result_t &second){
         //return (first.eval < second.eval);
@@ -214,6 +222,11 @@ public:
 
     static size_t resultToBuffer(char * buffer, const result_t &result, bool addBacktrace, bool compress  = true);
 
+    // writes the backtrace column unchanged unless backtrace is NULL
+    static size_t resultToBuffer(char * buffer, unsigned int dbKey, int score, float seqId, double eval,
+                                 int qStartPos, int qEndPos, unsigned int qLen, int dbStartPos, int dbEndPos, unsigned int dbLen,
+                                 const char *backtrace, size_t backtraceLen);
+
     static int computeAlnLength(int anEnd, int start, int dbEnd, int dbStart);
 
 
@@ -223,6 +236,32 @@ private:
     int gapOpen;
     // costs to extend a gap
     int gapExtend;
+    // Parameters::TRACEBACK_MODE_THREE_PASS or TRACEBACK_MODE_SINGLE_PASS
+    int tracebackMode;
+    // half width of the band around the prefilter diagonal, 0 aligns the full matrix
+    int bandWidth;
+    // last result of the returning getSWResult, its backtrace keeps the capacity between alignments
+    result_t resultBuffer;
+    // residues and best scores per position of the lanes of screenTargets
+    uint8_t *screenBatch;
+    uint8_t *screenMaxima;
+    size_t screenBatchLength;
+    // the striped kernel is about as fast as ssw_score_batch for longer queries
+    static const int SCREEN_MAX_QUERY_LENGTH = 512;
+    // placement of a target of screenTargets in the lanes
+    struct ScreenEntry {
+        unsigned int index;
+        unsigned int length;
+        unsigned int lane;
+        unsigned int start;
+    };
+    std::vector<ScreenEntry> screenEntries;
+    static bool compareScreenLength(const ScreenEntry &first, const ScreenEntry &second) {
+        if (first.length != second.length) {
+            return first.length > second.length;
+        }
+        return first.index < second.index;
+    }
 
     // calculate the query queryProfile for SIMD registers processing 8 elements
     int maxSeqLen;
@@ -0,0 +1,260 @@
+#include "ResultBatch.h"
+#include "Util.h"
+#include "Debug.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+void ResultBatch::clear() {
+    dbKey.clear();
+    score.clear();
+    qcov.clear();
+    dbcov.clear();
+    seqId.clear();
+    eval.clear();
+    alnLength.clear();
+    qStartPos.clear();
+    qEndPos.clear();
+    qLen.clear();
+    dbStartPos.clear();
+    dbEndPos.clear();
+    dbLen.clear();
+    arena.clear();
+    backtraceOffset.clear();
+    backtraceLength.clear();
+}
+
+void ResultBatch::reserve(size_t entries, size_t backtraceBytes) {
+    dbKey.reserve(entries);
+    score.reserve(entries);
+    qcov.reserve(entries);
+    dbcov.reserve(entries);
+    seqId.reserve(entries);
+    eval.reserve(entries);
+    alnLength.reserve(entries);
+    qStartPos.reserve(entries);
+    qEndPos.reserve(entries);
+    qLen.reserve(entries);
+    dbStartPos.reserve(entries);
+    dbEndPos.reserve(entries);
+    dbLen.reserve(entries);
+    backtraceOffset.reserve(entries);
+    backtraceLength.reserve(entries);
+    arena.reserve(backtraceBytes);
+}
+
+void ResultBatch::push(unsigned int dbKey, int score, float qcov, float dbcov, float seqId, double eval,
+                       unsigned int alnLength, int qStartPos, int qEndPos, unsigned int qLen,
+                       int dbStartPos, int dbEndPos, unsigned int dbLen, const char *backtrace, size_t backtraceLen) {
+    this->dbKey.push_back(dbKey);
+    this->score.push_back(score);
+    this->qcov.push_back(qcov);
+    this->dbcov.push_back(dbcov);
+    this->seqId.push_back(seqId);
+    this->eval.push_back(eval);
+    this->alnLength.push_back(alnLength);
+    this->qStartPos.push_back(qStartPos);
+    this->qEndPos.push_back(qEndPos);
+    this->qLen.push_back(qLen);
+    this->dbStartPos.push_back(dbStartPos);
+    this->dbEndPos.push_back(dbEndPos);
+    this->dbLen.push_back(dbLen);
+    backtraceOffset.push_back(arena.size());
+    backtraceLength.push_back(backtraceLen);
+    arena.insert(arena.end(), backtrace, backtrace + backtraceLen);
+}
+
+void ResultBatch::push(const Matcher::result_t &res) {
+    push(res.dbKey, res.score, res.qcov, res.dbcov, res.seqId, res.eval, res.alnLength,
+         res.qStartPos, res.qEndPos, res.qLen, res.dbStartPos, res.dbEndPos, res.dbLen,
+         res.backtrace.c_str(), res.backtrace.length());
+}
+
+void ResultBatch::pushCompressed(const Matcher::result_t &res, bool withBacktrace) {
+    push(res.dbKey, res.score, res.qcov, res.dbcov, res.seqId, res.eval, res.alnLength,
+         res.qStartPos, res.qEndPos, res.qLen, res.dbStartPos, res.dbEndPos, res.dbLen, NULL, 0);
+    if (withBacktrace == false) {
+        return;
+    }
+    // same CIGAR as compressAlignment, written straight into the arena
+    const std::string &backtrace = res.backtrace;
+    char state = 'M';
+    size_t counter = 0;
+    for (size_t i = 0; i < backtrace.size(); i++) {
+        if (backtrace[i] != state) {
+            appendCount(counter);
+            arena.push_back(state);
+            state = backtrace[i];
+            counter = 1;
+        } else {
+            counter++;
+        }
+    }
+    appendCount(counter);
+    arena.push_back(state);
+    backtraceLength.back() = arena.size() - backtraceOffset.back();
+}
+
+void ResultBatch::appendCount(size_t count) {
+    char digits[20];
+    size_t length = 0;
+    do {
+        digits[length++] = '0' + (count % 10);
+        count /= 10;
+    } while (count > 0);
+    while (length > 0) {
+        arena.push_back(digits[--length]);
+    }
+}
+
+void ResultBatch::pop() {
+    dbKey.pop_back();
+    score.pop_back();
+    qcov.pop_back();
+    dbcov.pop_back();
+    seqId.pop_back();
+    eval.pop_back();
+    alnLength.pop_back();
+    qStartPos.pop_back();
+    qEndPos.pop_back();
+    qLen.pop_back();
+    dbStartPos.pop_back();
+    dbEndPos.pop_back();
+    dbLen.pop_back();
+    arena.resize(backtraceOffset.back());
+    backtraceOffset.pop_back();
+    backtraceLength.pop_back();
+}
+
+void ResultBatch::parseRecord(const char *data, const char **entry, size_t columns) {
+    if (columns < Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
+        Debug(Debug::ERROR) << "Invalid alignment result record.\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    // same conversions as Matcher::parseAlignmentRecord
+    unsigned int targetId = Util::fast_atoi<unsigned int>(data);
+    int alnScore = Util::fast_atoi<int>(entry[1]);
+    double identity = strtod(entry[2], NULL);
+    double evalue = strtod(entry[3], NULL);
+    int qStart = Util::fast_atoi<int>(entry[4]);
+    int qEnd = Util::fast_atoi<int>(entry[5]);
+    int queryLen = Util::fast_atoi<int>(entry[6]);
+    int dbStart = Util::fast_atoi<int>(entry[7]);
+    int dbEnd = Util::fast_atoi<int>(entry[8]);
+    int targetLen = Util::fast_atoi<int>(entry[9]);
+    int adjustQstart = (qStart == -1) ? 0 : qStart;
+    int adjustDBstart = (dbStart == -1) ? 0 : dbStart;
+    double qCov = SmithWaterman::computeCov(adjustQstart, qEnd, queryLen);
+    double dbCov = SmithWaterman::computeCov(adjustDBstart, dbEnd, targetLen);
+    size_t alnLen = Matcher::computeAlnLength(adjustQstart, qEnd, adjustDBstart, dbEnd);
+
+    const char *backtrace = NULL;
+    size_t backtraceLen = 0;
+    if (columns >= Matcher::ALN_RES_WITH_BT_COL_CNT) {
+        backtrace = entry[10];
+        backtraceLen = entry[11] - entry[10];
+    }
+    push(targetId, alnScore, qCov, dbCov, identity, evalue, alnLen,
+         qStart, qEnd, queryLen, dbStart, dbEnd, targetLen, backtrace, backtraceLen);
+}
+
+void ResultBatch::readResults(char *data) {
+    if (data == NULL) {
+        return;
+    }
+    const char *entry[255];
+    while (*data != '\0') {
+        const size_t columns = Util::getWordsOfLine(data, entry, 255);
+        parseRecord(data, entry, columns);
+        data = Util::skipLine(data);
+    }
+}
+
+Matcher::result_t ResultBatch::get(size_t i) const {
+    return Matcher::result_t(dbKey[i], score[i], qcov[i], dbcov[i], seqId[i], eval[i], alnLength[i],
+                             qStartPos[i], qEndPos[i], qLen[i], dbStartPos[i], dbEndPos[i], dbLen[i],
+                             std::string(getBacktrace(i), backtraceLength[i]));
+}
+
+void ResultBatch::swapResult(size_t i, EvalueComputation &evaluer, bool hasBacktrace) {
+    double rawScore = evaluer.computeRawScoreFromBitScore(score[i]);
+    eval[i] = evaluer.computeEvalue(rawScore, dbLen[i]);
+
+    std::swap(qStartPos[i], dbStartPos[i]);
+    std::swap(qEndPos[i], dbEndPos[i]);
+    std::swap(qLen[i], dbLen[i]);
+    if (hasBacktrace) {
+        char *backtrace = arena.data() + backtraceOffset[i];
+        for (size_t j = 0; j < backtraceLength[i]; j++) {
+            if (backtrace[j] == 'I') {
+                backtrace[j] = 'D';
+            } else if (backtrace[j] == 'D') {
+                backtrace[j] = 'I';
+            }
+        }
+    }
+}
+
+bool ResultBatch::compareHits(unsigned int first, unsigned int second) const {
+    if (eval[first] < eval[second])
+        return true;
+    if (eval[second] < eval[first])
+        return false;
+    if (score[first] > score[second])
+        return true;
+    if (score[second] > score[first])
+        return false;
+    if (dbLen[first] < dbLen[second])
+        return true;
+    if (dbLen[second] < dbLen[first])
+        return false;
+    return dbKey[first] < dbKey[second];
+}
+
+template <typename T>
+void ResultBatch::permute(std::vector<T> &column) {
+    scratch.resize(column.size() * sizeof(T));
+    T *sorted = reinterpret_cast<T *>(scratch.data());
+    for (size_t i = 0; i < order.size(); i++) {
+        sorted[i] = column[order[i]];
+    }
+    std::copy(sorted, sorted + order.size(), column.begin());
+}
+
+void ResultBatch::sort() {
+    if (size() < 2) {
+        return;
+    }
+    order.resize(size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    // sorting the indices takes the same steps as sorting result_t objects, ties end up in the same order
+    HitComparator comparator = { this };
+    std::sort(order.begin(), order.end(), comparator);
+
+    // the arena itself is not moved, only the offsets into it
+    permute(dbKey);
+    permute(score);
+    permute(qcov);
+    permute(dbcov);
+    permute(seqId);
+    permute(eval);
+    permute(alnLength);
+    permute(qStartPos);
+    permute(qEndPos);
+    permute(qLen);
+    permute(dbStartPos);
+    permute(dbEndPos);
+    permute(dbLen);
+    permute(backtraceOffset);
+    permute(backtraceLength);
+}
+
+size_t ResultBatch::toBuffer(char *buffer, size_t i, bool addBacktrace) const {
+    return Matcher::resultToBuffer(buffer, dbKey[i], score[i], seqId[i], eval[i], qStartPos[i], qEndPos[i], qLen[i],
+                                   dbStartPos[i], dbEndPos[i], dbLen[i],
+                                   addBacktrace ? getBacktrace(i) : NULL, backtraceLength[i]);
+}
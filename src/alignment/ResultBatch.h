@@ -0,0 +1,105 @@
+#ifndef RESULTBATCH_H
+#define RESULTBATCH_H
+
+// Holds the alignment results of one query as structure of arrays.
+// Backtraces are kept as written in the result database (compressed CIGAR) in one shared arena,
+// so parsing, sorting and writing a batch does not allocate once its capacity has grown.
+
+#include <cstddef>
+#include <vector>
+
+#include "Matcher.h"
+
+class ResultBatch {
+public:
+    std::vector<unsigned int> dbKey;
+    std::vector<int> score;
+    std::vector<float> qcov;
+    std::vector<float> dbcov;
+    std::vector<float> seqId;
+    std::vector<double> eval;
+    std::vector<unsigned int> alnLength;
+    std::vector<int> qStartPos;
+    std::vector<int> qEndPos;
+    std::vector<unsigned int> qLen;
+    std::vector<int> dbStartPos;
+    std::vector<int> dbEndPos;
+    std::vector<unsigned int> dbLen;
+
+    ResultBatch() {}
+
+    size_t size() const {
+        return dbKey.size();
+    }
+
+    bool empty() const {
+        return dbKey.empty();
+    }
+
+    // keeps the allocated capacity
+    void clear();
+
+    void reserve(size_t entries, size_t backtraceBytes);
+
+    void push(unsigned int dbKey, int score, float qcov, float dbcov, float seqId, double eval,
+              unsigned int alnLength, int qStartPos, int qEndPos, unsigned int qLen,
+              int dbStartPos, int dbEndPos, unsigned int dbLen, const char *backtrace, size_t backtraceLen);
+
+    // takes the backtrace of res unchanged
+    void push(const Matcher::result_t &res);
+
+    // compresses the backtrace of res like Matcher::compressAlignment, or leaves it out
+    void pushCompressed(const Matcher::result_t &res, bool withBacktrace);
+
+    // removes the last entry
+    void pop();
+
+    // parses one line of an alignment result, entry and columns as returned by Util::getWordsOfLine
+    void parseRecord(const char *data, const char **entry, size_t columns);
+
+    // parses all lines of an alignment result entry
+    void readResults(char *data);
+
+    const char *getBacktrace(size_t i) const {
+        return arena.data() + backtraceOffset[i];
+    }
+
+    size_t getBacktraceLength(size_t i) const {
+        return backtraceLength[i];
+    }
+
+    Matcher::result_t get(size_t i) const;
+
+    // exchanges query and target of entry i, see Matcher::result_t::swapResult
+    void swapResult(size_t i, EvalueComputation &evaluer, bool hasBacktrace);
+
+    // orders the entries like std::sort with Matcher::compareHits
+    void sort();
+
+    // writes entry i like Matcher::resultToBuffer with compress=false
+    size_t toBuffer(char *buffer, size_t i, bool addBacktrace) const;
+
+private:
+    std::vector<char> arena;
+    std::vector<size_t> backtraceOffset;
+    std::vector<unsigned int> backtraceLength;
+
+    std::vector<unsigned int> order;
+    std::vector<char> scratch;
+
+    bool compareHits(unsigned int first, unsigned int second) const;
+
+    void appendCount(size_t count);
+
+    template <typename T>
+    void permute(std::vector<T> &column);
+
+    struct HitComparator {
+        const ResultBatch *batch;
+        bool operator() (unsigned int first, unsigned int second) const {
+            return batch->compareHits(first, second);
+        }
+    };
+};
+
+#endif
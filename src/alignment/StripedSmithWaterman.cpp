@@ -30,6 +30,9 @@
 #include "SubstitutionMatrix.h"
 #include "Debug.h"
 
+#include <algorithm>
+#include <vector>
+
 
 SmithWaterman::SmithWaterman(size_t maxSequenceLength, int aaSize, bool aaBiasCorrection) {
 	maxSequenceLength += 1;
@@ -56,6 +59,31 @@ SmithWaterman::SmithWaterman(size_t maxSequenceLength, int aaSize, bool aaBiasCo
 	/* array to record the largest score of each reference position */
 	maxColumn = new uint8_t[maxSequenceLength*sizeof(uint16_t)];
 	memset(maxColumn, 0, maxSequenceLength*sizeof(uint16_t));
+	bandScores = NULL;
+	bandScoresSize = 0;
+	/* workspace of the traceback, a cigar has at most one operation per query and target residue */
+	cigarBufferSize = 2 * maxSequenceLength;
+	cigarBuffer = (uint32_t *) malloc(cigarBufferSize * sizeof(uint32_t));
+	bandedRowSize = 2 * maxSequenceLength + 3;
+	bandedH = (int32_t *) malloc(bandedRowSize * sizeof(int32_t));
+	bandedE = (int32_t *) malloc(bandedRowSize * sizeof(int32_t));
+	bandedHc = (int32_t *) malloc(bandedRowSize * sizeof(int32_t));
+	bandedDirection = NULL;
+	bandedDirectionSize = 0;
+	xdropRowsSize = 8 * (maxSequenceLength + 3 * VECSIZE_INT * 2);
+	xdropRows = (int16_t *) malloc(xdropRowsSize * sizeof(int16_t));
+	xdropTrace = NULL;
+	xdropTraceSize = 0;
+	xdropAntiDiagonals = 2 * maxSequenceLength;
+	xdropTraceStart = new int32_t[xdropAntiDiagonals];
+	xdropTraceLow = new int32_t[xdropAntiDiagonals];
+	batchProfile = NULL;
+	batchProfileSize = 0;
+	batchProfileValid = false;
+	profile->rev_byte_length = -1;
+	profile->rev_word_length = -1;
+	batchBorder = NULL;
+	batchBorderSize = 0;
 
 	memset(profile->query_sequence, 0, maxSequenceLength * sizeof(int8_t));
 	memset(profile->query_rev_sequence, 0, maxSequenceLength * sizeof(int8_t));
@@ -83,6 +111,18 @@ SmithWaterman::~SmithWaterman(){
 	delete [] profile->mat;
 	delete [] tmp_composition_bias;
 	delete [] maxColumn;
+	free(bandScores);
+	free(cigarBuffer);
+	free(bandedH);
+	free(bandedE);
+	free(bandedHc);
+	free(bandedDirection);
+	free(batchProfile);
+	free(batchBorder);
+	free(xdropRows);
+	free(xdropTrace);
+	delete [] xdropTraceStart;
+	delete [] xdropTraceLow;
 	delete profile;
 }
 
@@ -140,7 +180,7 @@ s_align SmithWaterman::ssw_align (
 	alignment_end* bests = 0, *bests_reverse = 0;
 	int32_t word = 0, query_length = profile->query_length;
 	int32_t band_width = 0;
-	cigar* path;
+	cigar path;
 	s_align r;
 	r.dbStartPos1 = -1;
 	r.qStartPos1 = -1;
@@ -155,7 +195,6 @@ s_align SmithWaterman::ssw_align (
 		bests = sw_sse2_byte(db_sequence, 0, db_length, query_length, gap_open, gap_extend, profile->profile_byte, -1, profile->bias, maskLen);
 
 		if (profile->profile_word && bests[0].score == 255) {
-			free(bests);
 			bests = sw_sse2_word(db_sequence, 0, db_length, query_length, gap_open, gap_extend, profile->profile_word, -1, maskLen);
 			word = 1;
 		} else if (bests[0].score == 255) {
@@ -179,7 +218,6 @@ s_align SmithWaterman::ssw_align (
 		r.score2 = 0;
 		r.ref_end2 = -1;
 	}
-	free(bests);
 	int32_t queryOffset = query_length - r.qEndPos1;
 	r.evalue = evaluer->computeEvalue(r.score1, query_length);
 	bool hasLowerEvalue = r.evalue > evalueThr;
@@ -192,18 +230,24 @@ s_align SmithWaterman::ssw_align (
 	}
 
 	// Find the beginning position of the best alignment.
+	// the reverse profiles only depend on the query end, targets ending at the same query position share them
 	if (word == 0) {
-		if(Parameters::isEqualDbtype(profile->sequence_type, Parameters::DBTYPE_HMM_PROFILE) || Parameters::isEqualDbtype(profile->sequence_type, Parameters::DBTYPE_PROFILE_STATE_PROFILE)) {
+		if (profile->rev_byte_length == r.qEndPos1 + 1) {
+			// profile_rev_byte is still valid
+		} else if(Parameters::isEqualDbtype(profile->sequence_type, Parameters::DBTYPE_HMM_PROFILE) || Parameters::isEqualDbtype(profile->sequence_type, Parameters::DBTYPE_PROFILE_STATE_PROFILE)) {
 			createQueryProfile<int8_t, VECSIZE_INT * 4, PROFILE>(profile->profile_rev_byte, profile->query_rev_sequence, NULL, profile->mat_rev,
 																 r.qEndPos1 + 1, profile->alphabetSize, profile->bias, queryOffset, profile->query_length);
 		}else{
 			createQueryProfile<int8_t, VECSIZE_INT * 4, SUBSTITUTIONMATRIX>(profile->profile_rev_byte, profile->query_rev_sequence, profile->composition_bias_rev, profile->mat,
 																			r.qEndPos1 + 1, profile->alphabetSize, profile->bias, queryOffset, 0);
 		}
+		profile->rev_byte_length = r.qEndPos1 + 1;
 		bests_reverse = sw_sse2_byte(db_sequence, 1, r.dbEndPos1 + 1, r.qEndPos1 + 1, gap_open, gap_extend, profile->profile_rev_byte,
 									 r.score1, profile->bias, maskLen);
 	} else {
-		if(Parameters::isEqualDbtype(profile->sequence_type, Parameters::DBTYPE_HMM_PROFILE) || Parameters::isEqualDbtype(profile->sequence_type, Parameters::DBTYPE_PROFILE_STATE_PROFILE)) {
+		if (profile->rev_word_length == r.qEndPos1 + 1) {
+			// profile_rev_word is still valid
+		} else if(Parameters::isEqualDbtype(profile->sequence_type, Parameters::DBTYPE_HMM_PROFILE) || Parameters::isEqualDbtype(profile->sequence_type, Parameters::DBTYPE_PROFILE_STATE_PROFILE)) {
 			createQueryProfile<int16_t, VECSIZE_INT * 2, PROFILE>(profile->profile_rev_word, profile->query_rev_sequence, NULL, profile->mat_rev,
 																  r.qEndPos1 + 1, profile->alphabetSize, 0, queryOffset, profile->query_length);
 
@@ -211,6 +255,7 @@ s_align SmithWaterman::ssw_align (
 			createQueryProfile<int16_t, VECSIZE_INT * 2, SUBSTITUTIONMATRIX>(profile->profile_rev_word, profile->query_rev_sequence, profile->composition_bias_rev, profile->mat,
 																			 r.qEndPos1 + 1, profile->alphabetSize, 0, queryOffset, 0);
 		}
+		profile->rev_word_length = r.qEndPos1 + 1;
 		bests_reverse = sw_sse2_word(db_sequence, 1, r.dbEndPos1 + 1, r.qEndPos1 + 1, gap_open, gap_extend, profile->profile_rev_word,
 									 r.score1, maskLen);
 	}
@@ -224,7 +269,6 @@ s_align SmithWaterman::ssw_align (
 	r.qCov = computeCov(r.qStartPos1, r.qEndPos1, query_length);
 	r.tCov = computeCov(r.dbStartPos1, r.dbEndPos1, db_length);
 	hasLowerCoverage = !(Util::hasCoverage(covThr, covMode, r.qCov, r.tCov));
-	free(bests_reverse);
 	if (alignmentMode == 1 || hasLowerCoverage) // just start and end point are needed
 		goto end;
 
@@ -246,13 +290,8 @@ s_align SmithWaterman::ssw_align (
 											 gap_open, gap_extend, band_width,
 											 profile->mat, profile->alphabetSize);
 	}
-	if (path == 0) {
-		;
-	}
-	else {
-		r.cigar = path->seq;
-		r.cigarLen = path->length;
-	}	delete(path);
+	r.cigar = path.seq;
+	r.cigarLen = path.length;
 
 
 	end:
@@ -260,6 +299,466 @@ s_align SmithWaterman::ssw_align (
 }
 
 
+s_align SmithWaterman::ssw_align_single_pass (
+		const int *db_sequence,
+		int32_t db_length,
+		const uint8_t gap_open,
+		const uint8_t gap_extend,
+		const uint8_t alignmentMode,
+		const double  evalueThr,
+		EvalueComputation * evaluer,
+		const int covMode, const float covThr,
+		const int32_t maskLen,
+		const int diagonal) {
+	int32_t query_length = profile->query_length;
+	if (alignmentMode == 0 || profile->profile_word == NULL) {
+		return ssw_align(db_sequence, db_length, gap_open, gap_extend, alignmentMode, evalueThr, evaluer, covMode, covThr, maskLen);
+	}
+
+	// keep the whole matrix in the striped layout if it fits into maxBandCells scores,
+	// otherwise as large a band around the diagonal as fits
+	const int32_t SIMD_SIZE = VECSIZE_INT * 2;
+	const int32_t segLen = (query_length + SIMD_SIZE - 1) / SIMD_SIZE;
+	int32_t bandSize = 0;
+	int32_t bandOffset = 0;
+	size_t cells = static_cast<size_t>(segLen) * SIMD_SIZE * db_length;
+	if (cells > maxBandCells) {
+		int32_t center = (diagonal == INT_MAX) ? 0 : std::min(std::max(diagonal, -(db_length - 1)), query_length - 1);
+		int32_t halfWidth = std::min(std::max(query_length - 1 - center, db_length - 1 + center),
+									 static_cast<int32_t>(maxBandCells / db_length / 2));
+		bandSize = 2 * halfWidth + 1;
+		bandOffset = center - halfWidth;
+		cells = static_cast<size_t>(bandSize) * db_length;
+	}
+	if (cells > bandScoresSize) {
+		free(bandScores);
+		bandScores = (int16_t *) malloc(cells * sizeof(int16_t));
+		bandScoresSize = cells;
+	}
+
+	s_align r;
+	r.dbStartPos1 = -1;
+	r.qStartPos1 = -1;
+	r.cigar = 0;
+	r.cigarLen = 0;
+
+	alignment_end* bests = sw_sse2_word(db_sequence, 0, db_length, query_length, gap_open, gap_extend, profile->profile_word, -1, maskLen,
+										bandScores, bandOffset, bandSize);
+	r.score1 = bests[0].score;
+	r.dbEndPos1 = bests[0].ref;
+	r.qEndPos1 = bests[0].read;
+	if (maskLen >= 15) {
+		r.score2 = bests[1].score;
+		r.ref_end2 = bests[1].ref;
+	} else {
+		r.score2 = 0;
+		r.ref_end2 = -1;
+	}
+	r.evalue = evaluer->computeEvalue(r.score1, query_length);
+	bool hasLowerEvalue = r.evalue > evalueThr;
+	r.qCov = computeCov(0, r.qEndPos1, query_length);
+	r.tCov = computeCov(0, r.dbEndPos1, db_length);
+	bool hasLowerCoverage = !(Util::hasCoverage(covThr, covMode, r.qCov, r.tCov));
+	if ((alignmentMode == 2 || alignmentMode == 1) && hasLowerEvalue && hasLowerCoverage) {
+		return r;
+	}
+
+	if (band_traceback(r, db_sequence, gap_open, gap_extend, bandOffset, bandSize) == false) {
+		return ssw_align(db_sequence, db_length, gap_open, gap_extend, alignmentMode, evalueThr, evaluer, covMode, covThr, maskLen);
+	}
+	r.qCov = computeCov(r.qStartPos1, r.qEndPos1, query_length);
+	r.tCov = computeCov(r.dbStartPos1, r.dbEndPos1, db_length);
+	hasLowerCoverage = !(Util::hasCoverage(covThr, covMode, r.qCov, r.tCov));
+	if (alignmentMode == 1 || hasLowerCoverage) {
+		r.cigar = 0;
+		r.cigarLen = 0;
+	}
+	return r;
+}
+
+bool SmithWaterman::band_traceback(s_align &r, const int *db_sequence, const uint8_t gap_open, const uint8_t gap_extend,
+								   int32_t bandOffset, int32_t bandSize) {
+	/* Score of query position q and target position t, 0 before the matrix and -1 outside of the band.
+	   Without a band (bandSize 0) all columns are stored in the striped layout. */
+#define band_score(q, t) (((q) < 0 || (t) < 0) ? 0 : \
+	(bandSize == 0) ? bandScores[((size_t) (t) * segLen + (q) % segLen) * SIMD_SIZE + (q) / segLen] : \
+	((q) - (t) - bandOffset < 0 || (q) - (t) - bandOffset >= bandSize) ? -1 : bandScores[(size_t) (t) * bandSize + ((q) - (t) - bandOffset)])
+
+	const int32_t SIMD_SIZE = VECSIZE_INT * 2;
+	const int32_t segLen = (profile->query_length + SIMD_SIZE - 1) / SIMD_SIZE;
+
+	const bool isProfile = Parameters::isEqualDbtype(profile->sequence_type, Parameters::DBTYPE_HMM_PROFILE)
+						   || Parameters::isEqualDbtype(profile->sequence_type, Parameters::DBTYPE_PROFILE_STATE_PROFILE);
+	int32_t q = r.qEndPos1;
+	int32_t t = r.dbEndPos1;
+	int32_t h = r.score1;
+	if (h == 0 || band_score(q, t) != h) {
+		return false;
+	}
+
+	// cigar operations from the end to the start
+	size_t pathLength = 0;
+	char op = 'M';
+	uint32_t length = 0;
+	while (true) {
+		char nextOp = 0;
+		uint32_t steps = 1;
+		int32_t next = -1;
+		int32_t s = isProfile ? profile->mat[db_sequence[t] * profile->query_length + q]
+							  : profile->mat[db_sequence[t] * profile->alphabetSize + profile->query_sequence[q]] + profile->composition_bias[q];
+		// prefer the shortest alignment, it can start here once the score of the cell is its substitution score
+		int32_t diag = (s == h) ? 0 : band_score(q - 1, t - 1);
+		if (diag != -1 && diag + s == h) {
+			nextOp = 'M';
+			next = diag;
+		}
+		// gap in the query, consumes target residues
+		int32_t gap = gap_open;
+		for (int32_t k = 1; nextOp == 0 && t - k >= 0 && h + gap <= r.score1; ++k, gap += gap_extend) {
+			int32_t prev = band_score(q, t - k);
+			if (prev == -1) {
+				break;
+			}
+			if (prev - gap == h) {
+				nextOp = 'D';
+				steps = k;
+				next = prev;
+			}
+		}
+		// gap in the target, consumes query residues
+		gap = gap_open;
+		for (int32_t k = 1; nextOp == 0 && q - k >= 0 && h + gap <= r.score1; ++k, gap += gap_extend) {
+			int32_t prev = band_score(q - k, t);
+			if (prev == -1) {
+				break;
+			}
+			if (prev - gap == h) {
+				nextOp = 'I';
+				steps = k;
+				next = prev;
+			}
+		}
+		if (nextOp == 0) {
+			return false;
+		}
+
+		if (nextOp != op) {
+			if (length > 0) {
+				cigarBuffer[pathLength++] = to_cigar_int(length, op);
+			}
+			op = nextOp;
+			length = 0;
+		}
+		length += steps;
+		if (nextOp == 'M') {
+			if (next == 0) {
+				break;
+			}
+			--q;
+			--t;
+		} else if (nextOp == 'D') {
+			t -= steps;
+		} else {
+			q -= steps;
+		}
+		h = next;
+	}
+	cigarBuffer[pathLength++] = to_cigar_int(length, op);
+
+	r.qStartPos1 = q;
+	r.dbStartPos1 = t;
+	std::reverse(cigarBuffer, cigarBuffer + pathLength);
+	r.cigar = cigarBuffer;
+	r.cigarLen = pathLength;
+	return true;
+#undef band_score
+}
+
+bool SmithWaterman::ssw_align_banded(s_align &r,
+									 const int *db_sequence,
+									 int32_t db_length,
+									 const uint8_t gap_open,
+									 const uint8_t gap_extend,
+									 const uint8_t alignmentMode,
+									 const double evalueThr,
+									 EvalueComputation * evaluer,
+									 const int covMode, const float covThr,
+									 const int diagonal,
+									 const int32_t bandWidth) {
+	const int32_t query_length = profile->query_length;
+	// substitution scores are looked up in the linear word profile
+	if (diagonal == INT_MAX || bandWidth <= 0 || profile->profile_word == NULL) {
+		return false;
+	}
+	const int32_t center = std::min(std::max(diagonal, -(db_length - 1)), query_length - 1);
+	// a band of this half width covers the whole matrix
+	const int32_t fullWidth = std::max(query_length - 1 - center, db_length - 1 + center);
+	const size_t matrixCells = static_cast<size_t>(query_length) * db_length;
+	int status = BANDED_BORDER;
+	for (int32_t w = bandWidth; status == BANDED_BORDER; w *= 2) {
+		// the striped full matrix is faster once the band covers about half of it
+		size_t bandCells = static_cast<size_t>(2 * w + 1) * std::min(query_length, db_length);
+		if (w >= fullWidth || 2 * bandCells > matrixCells) {
+			return false;
+		}
+		status = banded_xdrop(r, db_sequence, db_length, gap_open, gap_extend, center, w);
+	}
+	if (status == BANDED_FAILED) {
+		return false;
+	}
+	r.score2 = 0;
+	r.ref_end2 = -1;
+	r.evalue = evaluer->computeEvalue(r.score1, query_length);
+	bool hasLowerEvalue = r.evalue > evalueThr;
+	r.qCov = computeCov(0, r.qEndPos1, query_length);
+	r.tCov = computeCov(0, r.dbEndPos1, db_length);
+	bool hasLowerCoverage = !(Util::hasCoverage(covThr, covMode, r.qCov, r.tCov));
+	// report the same fields as ssw_align
+	if (alignmentMode == 0 || ((alignmentMode == 2 || alignmentMode == 1) && hasLowerEvalue && hasLowerCoverage)) {
+		r.qStartPos1 = -1;
+		r.dbStartPos1 = -1;
+		r.cigar = 0;
+		r.cigarLen = 0;
+		return true;
+	}
+	r.qCov = computeCov(r.qStartPos1, r.qEndPos1, query_length);
+	r.tCov = computeCov(r.dbStartPos1, r.dbEndPos1, db_length);
+	hasLowerCoverage = !(Util::hasCoverage(covThr, covMode, r.qCov, r.tCov));
+	if (alignmentMode == 1 || hasLowerCoverage) {
+		r.cigar = 0;
+		r.cigarLen = 0;
+	}
+	return true;
+}
+
+int SmithWaterman::banded_xdrop(s_align &r, const int *db_sequence, int32_t db_length, const uint8_t gap_open, const uint8_t gap_extend,
+								int32_t center, int32_t bandWidth) {
+	const int32_t query_length = profile->query_length;
+	const int32_t SIMD_SIZE = VECSIZE_INT * 2;
+	const int16_t NEG = -16384;
+	// cells of anti-diagonal k = q + t are indexed by their target position t, every anti-diagonal has at most bandWidth + 1 band cells
+	const int32_t antiDiagonals = query_length + db_length - 1;
+	const size_t traceCells = static_cast<size_t>(antiDiagonals) * (bandWidth + 1) + SIMD_SIZE;
+	if (traceCells > maxBandCells) {
+		return BANDED_FAILED;
+	}
+	// rows start one vector early so that t - 1 = -1 can be read
+	const size_t rowSize = db_length + 3 * SIMD_SIZE;
+	if (traceCells > xdropTraceSize) {
+		free(xdropTrace);
+		xdropTrace = (int16_t *) malloc(traceCells * sizeof(int16_t));
+		xdropTraceSize = traceCells;
+	}
+	int16_t *H[3];
+	int16_t *E[2];
+	int16_t *F[2];
+	for (int32_t i = 0; i < 3; i++) {
+		H[i] = xdropRows + i * rowSize + SIMD_SIZE;
+		std::fill(H[i] - SIMD_SIZE, H[i] - SIMD_SIZE + rowSize, 0);
+	}
+	for (int32_t i = 0; i < 2; i++) {
+		E[i] = xdropRows + (3 + i) * rowSize + SIMD_SIZE;
+		F[i] = xdropRows + (5 + i) * rowSize + SIMD_SIZE;
+		std::fill(E[i] - SIMD_SIZE, E[i] - SIMD_SIZE + rowSize, NEG);
+		std::fill(F[i] - SIMD_SIZE, F[i] - SIMD_SIZE + rowSize, NEG);
+	}
+	int16_t *S = xdropRows + 7 * rowSize + SIMD_SIZE;
+	std::fill(S - SIMD_SIZE, S - SIMD_SIZE + rowSize, NEG);
+
+	const simd_int vZero = simdi16_set(0);
+	const simd_int vGapO = simdi16_set(-gap_open);
+	const simd_int vGapE = simdi16_set(-gap_extend);
+	// directions: bits 0-1 source of H (1 diagonal, 2 E, 3 F), bit 2 E extended, bit 3 F extended, bit 4 diagonal starts the alignment
+	const simd_int vDiag = simdi16_set(1);
+	const simd_int vFromE = simdi16_set(2);
+	const simd_int vFromF = simdi16_set(3);
+	const simd_int vExtE = simdi16_set(4);
+	const simd_int vExtF = simdi16_set(8);
+	const simd_int vStart = simdi16_set(16);
+
+	// the border only restricts the alignment where it lies inside the matrix
+	const bool hasLowerBorder = center - bandWidth > -(db_length - 1);
+	const bool hasUpperBorder = center + bandWidth < query_length - 1;
+	int32_t borderMax = 0;
+	int32_t best = 0;
+	int32_t bestQ = -1;
+	int32_t bestT = -1;
+	int32_t prevMax = 0;
+	size_t traceOffset = 0;
+	int32_t lastK = -1;
+	for (int32_t k = 0; k < antiDiagonals; k++) {
+		// t range of the band: q = k - t, center - bandWidth <= q - t <= center + bandWidth
+		const int32_t tLow = std::max(std::max(0, k - query_length + 1), (k - center - bandWidth + 1) >> 1);
+		const int32_t tHigh = std::min(std::min(db_length - 1, k), (k - center + bandWidth) >> 1);
+		xdropTraceStart[k] = traceOffset;
+		xdropTraceLow[k] = tLow;
+		if (tLow > tHigh) {
+			if (lastK != -1) {
+				break;
+			}
+			continue;
+		}
+		lastK = k;
+		int16_t *Hn = H[k % 3];
+		int16_t *H1 = H[(k + 2) % 3];
+		int16_t *H2 = H[(k + 1) % 3];
+		int16_t *En = E[k & 1];
+		int16_t *E1 = E[(k + 1) & 1];
+		int16_t *Fn = F[k & 1];
+		int16_t *F1 = F[(k + 1) & 1];
+
+		for (int32_t t = tLow; t <= tHigh; t++) {
+			S[t] = profile->profile_word_linear[db_sequence[t]][k - t];
+		}
+		for (int32_t t = tHigh + 1; t <= tHigh + SIMD_SIZE; t++) {
+			S[t] = NEG;
+		}
+
+		simd_int vMax = vZero;
+		int16_t *trace = xdropTrace + traceOffset - tLow;
+		for (int32_t t = tLow; t <= tHigh; t += SIMD_SIZE) {
+			simd_int vH2 = simdi_loadu((simd_int *) (H2 + t - 1));
+			simd_int vEOpen = simdi16_adds(simdi_loadu((simd_int *) (H1 + t - 1)), vGapO);
+			simd_int vEExt = simdi16_adds(simdi_loadu((simd_int *) (E1 + t - 1)), vGapE);
+			simd_int vFOpen = simdi16_adds(simdi_loadu((simd_int *) (H1 + t)), vGapO);
+			simd_int vFExt = simdi16_adds(simdi_loadu((simd_int *) (F1 + t)), vGapE);
+			simd_int vD = simdi16_adds(vH2, simdi_loadu((simd_int *) (S + t)));
+			simd_int vE = simdi16_max(vEOpen, vEExt);
+			simd_int vF = simdi16_max(vFOpen, vFExt);
+			simd_int vH = simdi16_max(simdi16_max(vD, vZero), simdi16_max(vE, vF));
+			simdi_storeu((simd_int *) (Hn + t), vH);
+			simdi_storeu((simd_int *) (En + t), vE);
+			simdi_storeu((simd_int *) (Fn + t), vF);
+			vMax = simdi16_max(vMax, vH);
+
+			simd_int vPositive = simdi16_gt(vH, vZero);
+			simd_int vIsDiag = simdi_and(simdi16_eq(vH, vD), vPositive);
+			simd_int vIsE = simdi_andnot(vIsDiag, simdi_and(simdi16_eq(vH, vE), vPositive));
+			simd_int vIsF = simdi_andnot(simdi_or(vIsDiag, vIsE), simdi_and(simdi16_eq(vH, vF), vPositive));
+			simd_int vCode = simdi_or(simdi_and(vIsDiag, vDiag), simdi_or(simdi_and(vIsE, vFromE), simdi_and(vIsF, vFromF)));
+			vCode = simdi_or(vCode, simdi_and(simdi16_eq(vH2, vZero), vStart));
+			vCode = simdi_or(vCode, simdi_and(simdi16_gt(vEExt, vEOpen), vExtE));
+			vCode = simdi_or(vCode, simdi_and(simdi16_gt(vFExt, vFOpen), vExtF));
+			simdi_storeu((simd_int *) (trace + t), vCode);
+		}
+		traceOffset += tHigh - tLow + 1;
+		if ((hasUpperBorder && k - 2 * tLow == center + bandWidth) || (hasLowerBorder && k - 2 * tLow == center - bandWidth)) {
+			borderMax = std::max(borderMax, static_cast<int32_t>(Hn[tLow]));
+		}
+		if ((hasUpperBorder && k - 2 * tHigh == center + bandWidth) || (hasLowerBorder && k - 2 * tHigh == center - bandWidth)) {
+			borderMax = std::max(borderMax, static_cast<int32_t>(Hn[tHigh]));
+		}
+
+		// cells next to the band must not contribute to the following anti-diagonals
+		Hn[tLow - 1] = 0;
+		En[tLow - 1] = NEG;
+		Fn[tLow - 1] = NEG;
+		for (int32_t t = tHigh + 1; t <= tHigh + SIMD_SIZE; t++) {
+			Hn[t] = 0;
+			En[t] = NEG;
+			Fn[t] = NEG;
+		}
+
+		// lanes behind the band cannot exceed the best score, see the reset above
+		const int32_t antiDiagonalMax = simdi16_hmax(vMax);
+		if (antiDiagonalMax > best) {
+			best = antiDiagonalMax;
+			for (int32_t t = tLow; t <= tHigh; t++) {
+				if (Hn[t] == best) {
+					bestT = t;
+					bestQ = k - t;
+					break;
+				}
+			}
+			if (best >= SHRT_MAX - 255) {
+				return BANDED_FAILED;
+			}
+		}
+		if (antiDiagonalMax + xDrop < best && prevMax + xDrop < best) {
+			break;
+		}
+		prevMax = antiDiagonalMax;
+	}
+
+	r.score1 = best;
+	r.qEndPos1 = bestQ;
+	r.dbEndPos1 = bestT;
+	r.qStartPos1 = -1;
+	r.dbStartPos1 = -1;
+	r.cigar = 0;
+	r.cigarLen = 0;
+	if (best == 0) {
+		return BANDED_OK;
+	}
+	// a border cell scoring about as high as the best cell means that the alignment continues outside of the band
+	if (borderMax >= best - gap_open) {
+		return BANDED_BORDER;
+	}
+
+	bool touchesBorder = false;
+	size_t pathLength = 0;
+	char op = 'M';
+	uint32_t length = 0;
+	int32_t q = bestQ;
+	int32_t t = bestT;
+	char state = 'H';
+	while (true) {
+		const int32_t k = q + t;
+		const int16_t code = xdropTrace[xdropTraceStart[k] + t - xdropTraceLow[k]];
+		const int32_t d = q - t;
+		touchesBorder |= (hasLowerBorder && d == center - bandWidth) || (hasUpperBorder && d == center + bandWidth);
+		char nextOp = 0;
+		if (state == 'H') {
+			switch (code & 3) {
+				case 1:
+					nextOp = 'M';
+					break;
+				case 2:
+					state = 'E';
+					continue;
+				case 3:
+					state = 'F';
+					continue;
+				default:
+					return BANDED_FAILED;
+			}
+		} else {
+			nextOp = (state == 'E') ? 'D' : 'I';
+		}
+		if (nextOp != op) {
+			if (length > 0) {
+				cigarBuffer[pathLength++] = to_cigar_int(length, op);
+			}
+			op = nextOp;
+			length = 0;
+		}
+		length++;
+		if (nextOp == 'M') {
+			if (code & 16) {
+				break;
+			}
+			--q;
+			--t;
+		} else if (nextOp == 'D') {
+			state = (code & 4) ? 'E' : 'H';
+			--t;
+		} else {
+			state = (code & 8) ? 'F' : 'H';
+			--q;
+		}
+	}
+	cigarBuffer[pathLength++] = to_cigar_int(length, op);
+	if (touchesBorder) {
+		return BANDED_BORDER;
+	}
+
+	r.qStartPos1 = q;
+	r.dbStartPos1 = t;
+	std::reverse(cigarBuffer, cigarBuffer + pathLength);
+	r.cigar = cigarBuffer;
+	r.cigarLen = pathLength;
+	return BANDED_OK;
+}
 
 char SmithWaterman::cigar_int_to_op (uint32_t cigar_int)
 {
@@ -289,6 +788,113 @@ uint32_t SmithWaterman::cigar_int_to_len (uint32_t cigar_int)
 	return res;
 }
 
+bool SmithWaterman::ssw_score_batch(const uint8_t *batch, int32_t db_length, const uint8_t gap_open,
+									const uint8_t gap_extend, uint8_t *maxima) {
+	const int32_t query_length = profile->query_length;
+	if (profile->alphabetSize > 32) {
+		return false;
+	}
+	if (query_length > batchProfileSize) {
+		free(batchProfile);
+		batchProfileSize = query_length;
+		batchProfile = (simd_int*) mem_align(ALIGN_INT, 4 * batchProfileSize * sizeof(simd_int));
+	}
+	simd_int *pvH = batchProfile + 2 * query_length;
+	simd_int *pvE = batchProfile + 3 * query_length;
+
+	// transpose the striped byte profile so that a shuffle looks up the scores of all lanes at a query position
+	if (batchProfileValid == false) {
+		const int32_t segLen = (query_length + BATCH_SIZE - 1) / BATCH_SIZE;
+		const uint8_t *striped = (const uint8_t *) profile->profile_byte;
+		for (int32_t i = 0; i < query_length; i++) {
+			uint8_t *low = (uint8_t *) (batchProfile + 2 * i);
+			uint8_t *high = (uint8_t *) (batchProfile + 2 * i + 1);
+			for (int32_t k = 0; k < BATCH_SIZE; k++) {
+				const int32_t residue = k % 16;
+				const size_t offset = (i % segLen) * BATCH_SIZE + i / segLen;
+				low[k] = (residue < profile->alphabetSize) ? striped[residue * segLen * BATCH_SIZE + offset] : 0;
+				high[k] = (residue + 16 < profile->alphabetSize) ? striped[(residue + 16) * segLen * BATCH_SIZE + offset] : 0;
+			}
+		}
+		batchProfileValid = true;
+	}
+	// H and F of the last query position of the previous block for every target position
+	if (db_length > batchBorderSize) {
+		free(batchBorder);
+		batchBorderSize = db_length;
+		batchBorder = (simd_int*) mem_align(ALIGN_INT, 2 * batchBorderSize * sizeof(simd_int));
+	}
+	memset(batchBorder, 0, 2 * db_length * sizeof(simd_int));
+	simd_int *pvMax = (simd_int *) maxima;
+	memset(pvMax, 0, db_length * sizeof(simd_int));
+
+	const simd_int vZero = simdi32_set(0);
+	const simd_int vGapO = simdi8_set(gap_open);
+	const simd_int vGapE = simdi8_set(gap_extend);
+	const simd_int vBias = simdi8_set(profile->bias);
+	const simd_int vResidueMask = simdi8_set(BATCH_PAD);
+	const simd_int vStartMask = simdi8_set(BATCH_START);
+	// shuffles return 0 for indices with the high bit set, the residues of the other half and BATCH_PAD get it
+	const simd_int vIndex = simdi8_set(0x70);
+	const simd_int vHalf = simdi8_set(0x10);
+	// the query is processed in blocks so that profile and rows of a block stay in the L1 cache
+	for (int32_t blockStart = 0; blockStart < query_length; blockStart += batchBlockSize) {
+		const int32_t blockEnd = std::min(blockStart + batchBlockSize, query_length);
+		memset(pvH + blockStart, 0, (blockEnd - blockStart) * sizeof(simd_int));
+		memset(pvE + blockStart, 0, (blockEnd - blockStart) * sizeof(simd_int));
+		simd_int vBorderDiagonal = vZero;
+		for (int32_t j = 0; j < db_length; j++) {
+			const simd_int vColumn = simdi_load((const simd_int *) (batch + j * BATCH_SIZE));
+			const simd_int vResidue = simdi_and(vColumn, vResidueMask);
+			const simd_int vLow = simdui8_adds(vResidue, vIndex);
+			const simd_int vHigh = simdui8_adds(simdi_xor(vResidue, vHalf), vIndex);
+			simd_int vDiagonal = vBorderDiagonal;
+			vBorderDiagonal = simdi_load(batchBorder + 2 * j);
+			simd_int vF = simdi_load(batchBorder + 2 * j + 1);
+
+			// lanes starting a new target forget the previous target position
+			const simd_int vStart = simdi8_eq(simdi_and(vColumn, vStartMask), vStartMask);
+			if (simdi8_movemask(vStart) != 0) {
+				vDiagonal = simdi_andnot(vStart, vDiagonal);
+				for (int32_t i = blockStart; i < blockEnd; i++) {
+					simdi_store(pvH + i, simdi_andnot(vStart, simdi_load(pvH + i)));
+					simdi_store(pvE + i, simdi_andnot(vStart, simdi_load(pvE + i)));
+				}
+			}
+
+			simd_int vH = vZero;
+			simd_int vColumnMax = simdi_load(pvMax + j);
+			for (int32_t i = blockStart; i < blockEnd; i++) {
+				const simd_int vScore = simdi_or(simdi8_shuffle(simdi_load(batchProfile + 2 * i), vLow),
+												 simdi8_shuffle(simdi_load(batchProfile + 2 * i + 1), vHigh));
+				vH = simdui8_adds(vDiagonal, vScore);
+				vH = simdui8_subs(vH, vBias);
+				const simd_int e = simdi_load(pvE + i);
+				vH = simdui8_max(vH, e);
+				vH = simdui8_max(vH, vF);
+				vColumnMax = simdui8_max(vColumnMax, vH);
+				vDiagonal = simdi_load(pvH + i);
+				simdi_store(pvH + i, vH);
+
+				const simd_int vHGap = simdui8_subs(vH, vGapO);
+				simdi_store(pvE + i, simdui8_max(simdui8_subs(e, vGapE), vHGap));
+				vF = simdui8_max(simdui8_subs(vF, vGapE), vHGap);
+			}
+			simdi_store(pvMax + j, vColumnMax);
+			simdi_store(batchBorder + 2 * j, vH);
+			simdi_store(batchBorder + 2 * j + 1, vF);
+		}
+	}
+
+	// a saturated cell scores at least 255 - bias, like in sw_sse2_byte these scores are reported as 255
+	const simd_int vSaturated = simdi8_set(-1);
+	for (int32_t j = 0; j < db_length; j++) {
+		const simd_int vColumnMax = simdi_load(pvMax + j);
+		simdi_store(pvMax + j, simdi_or(vColumnMax, simdi8_eq(simdui8_adds(vColumnMax, vBias), vSaturated)));
+	}
+	return true;
+}
+
 SmithWaterman::alignment_end* SmithWaterman::sw_sse2_byte (const int* db_sequence,
 														   int8_t ref_dir,	// 0: forward ref; 1: reverse ref
 														   int32_t db_length,
@@ -485,7 +1091,7 @@ SmithWaterman::alignment_end* SmithWaterman::sw_sse2_byte (const int* db_sequenc
 	}
 
 	/* Find the most possible 2nd best alignment. */
-	alignment_end* bests = (alignment_end*) calloc(2, sizeof(alignment_end));
+	alignment_end* bests = alignmentEnds;
 	bests[0].score = max + bias >= 255 ? 255 : max;
 	bests[0].ref = end_db;
 	bests[0].read = end_query;
@@ -524,7 +1130,10 @@ SmithWaterman::alignment_end* SmithWaterman::sw_sse2_word (const int* db_sequenc
 														   const uint8_t gap_extend, /* will be used as - */
 														   const simd_int*query_profile_word,
 														   uint16_t terminate,
-														   int32_t maskLen) {
+														   int32_t maskLen,
+														   int16_t *band,
+														   int32_t bandOffset,
+														   int32_t bandSize) {
 
 #define max8(m, vm) ((m) = simdi16_hmax((vm)));
 
@@ -624,6 +1233,26 @@ SmithWaterman::alignment_end* SmithWaterman::sw_sse2_word (const int* db_sequenc
 		}
 
 		end:
+		if (band != NULL && bandSize == 0) {
+			/* The band covers the whole column, keep it in the striped layout. */
+			memcpy(band + (size_t) i * segLen * SIMD_SIZE, pvHStore, segLen * sizeof(simd_int));
+		} else if (band != NULL) {
+			/* Copy the band of column i out of the striped layout. */
+			const int16_t *h = (const int16_t *) pvHStore;
+			int16_t *bandColumn = band + (size_t) i * bandSize - (i + bandOffset);
+			int32_t first = std::max(i + bandOffset, 0);
+			int32_t last = std::min(i + bandOffset + bandSize, query_lenght);
+			int32_t segment = first % segLen;
+			int32_t lane = first / segLen;
+			for (int32_t pos = first; pos < last; ++pos) {
+				bandColumn[pos] = h[segment * SIMD_SIZE + lane];
+				if (++segment == segLen) {
+					segment = 0;
+					++lane;
+				}
+			}
+		}
+
 		vMaxScore = simdi16_max(vMaxScore, vMaxColumn);
 		vTemp = simdi16_eq(vMaxMark, vMaxScore);
 		int32_t cmp = simdi8_movemask(vTemp);
@@ -662,7 +1291,7 @@ SmithWaterman::alignment_end* SmithWaterman::sw_sse2_word (const int* db_sequenc
 	}
 
 	/* Find the most possible 2nd best alignment. */
-	SmithWaterman::alignment_end* bests = (alignment_end*) calloc(2, sizeof(alignment_end));
+	SmithWaterman::alignment_end* bests = alignmentEnds;
 	bests[0].score = max;
 	bests[0].ref = end_ref;
 	bests[0].read = end_read;
@@ -698,6 +1327,9 @@ void SmithWaterman::ssw_init (const Sequence* q,
 
 	profile->bias = 0;
 	profile->sequence_type = q->getSequenceType();
+	batchProfileValid = false;
+	profile->rev_byte_length = -1;
+	profile->rev_word_length = -1;
 	int32_t compositionBias = 0;
 	bool isProfile = Parameters::isEqualDbtype(q->getSequenceType(), Parameters::DBTYPE_HMM_PROFILE) || Parameters::isEqualDbtype(q->getSequenceType(), Parameters::DBTYPE_PROFILE_STATE_PROFILE);
 	if(isProfile == false && aaBiasCorrection == true) {
@@ -786,7 +1418,7 @@ void SmithWaterman::ssw_init (const Sequence* q,
 	profile->alphabetSize = alphabetSize;
 }
 template <const unsigned int type>
-SmithWaterman::cigar * SmithWaterman::banded_sw(const int *db_sequence, const int8_t *query_sequence, const int8_t * compositionBias,
+SmithWaterman::cigar SmithWaterman::banded_sw(const int *db_sequence, const int8_t *query_sequence, const int8_t * compositionBias,
 												int32_t db_length, int32_t query_length, int32_t queryStart,
 												int32_t score, const uint32_t gap_open,
 												const uint32_t gap_extend, int32_t band_width, const int8_t *mat, int32_t n) {
@@ -803,27 +1435,27 @@ SmithWaterman::cigar * SmithWaterman::banded_sw(const int *db_sequence, const in
 	/* Convert the coordinate in the direction matrix into the coordinate in one line of the band. */
 #define set_d(u, w, i, j, p) { int x=(i)-(w); x=x>0?x:0; x=(j)-x; (u)=x*3+p; }
 
-	uint32_t *c = (uint32_t*)malloc(16 * sizeof(uint32_t)), *c1;
-	int32_t i, j, e, f, temp1, temp2, s = 16, s1 = 8, l, max = 0;
-	int64_t s2 = 1024;
+	// rows, directions and cigar are kept in the workspace of the aligner and only grow
+	uint32_t *c = cigarBuffer;
+	int32_t i, j, e, f, temp1, temp2, l, max = 0;
+	int64_t s = cigarBufferSize, s1 = bandedRowSize, s2 = bandedDirectionSize;
 	char op, prev_op;
 	int64_t width, width_d;
-	int32_t *h_b, *e_b, *h_c;
-	int8_t *direction, *direction_line;
-	cigar* result = new cigar();
-	h_b = (int32_t*)malloc(s1 * sizeof(int32_t));
-	e_b = (int32_t*)malloc(s1 * sizeof(int32_t));
-	h_c = (int32_t*)malloc(s1 * sizeof(int32_t));
-	direction = (int8_t*)malloc(s2 * sizeof(int8_t));
+	int32_t *h_b = bandedH, *e_b = bandedE, *h_c = bandedHc;
+	int8_t *direction = bandedDirection, *direction_line;
+	cigar result;
+	result.seq = NULL;
+	result.length = 0;
 
 	do {
 		width = band_width * 2 + 3, width_d = band_width * 2 + 1;
 		while (width >= s1) {
 			++s1;
 			kroundup32(s1);
-			h_b = (int32_t*)realloc(h_b, s1 * sizeof(int32_t));
-			e_b = (int32_t*)realloc(e_b, s1 * sizeof(int32_t));
-			h_c = (int32_t*)realloc(h_c, s1 * sizeof(int32_t));
+			h_b = bandedH = (int32_t*)realloc(h_b, s1 * sizeof(int32_t));
+			e_b = bandedE = (int32_t*)realloc(e_b, s1 * sizeof(int32_t));
+			h_c = bandedHc = (int32_t*)realloc(h_c, s1 * sizeof(int32_t));
+			bandedRowSize = s1;
 		}
 		int64_t targetSize = width_d * query_length * 3;
 		while (targetSize >= s2) {
@@ -833,7 +1465,8 @@ SmithWaterman::cigar * SmithWaterman::banded_sw(const int *db_sequence, const in
 				fprintf(stderr, "Alignment score and position are not consensus.\n");
 				EXIT(1);
 			}
-			direction = (int8_t*)realloc(direction, s2 * sizeof(int8_t));
+			direction = bandedDirection = (int8_t*)realloc(direction, s2 * sizeof(int8_t));
+			bandedDirectionSize = s2;
 		}
 		direction_line = direction;
 		for (j = 1; LIKELY(j < width - 1); j ++) h_b[j] = 0;
@@ -927,13 +1560,7 @@ SmithWaterman::cigar * SmithWaterman::banded_sw(const int *db_sequence, const in
 				break;
 			default:
 				fprintf(stderr, "Trace back error: %d.\n", direction_line[temp1 - 1]);
-				free(direction);
-				free(h_c);
-				free(e_b);
-				free(h_b);
-				free(c);
-				delete result;
-				return 0;
+				return result;
 		}
 		if (op == prev_op) ++e;
 		else {
@@ -941,7 +1568,8 @@ SmithWaterman::cigar * SmithWaterman::banded_sw(const int *db_sequence, const in
 			while (l >= s) {
 				++s;
 				kroundup32(s);
-				c = (uint32_t*)realloc(c, s * sizeof(uint32_t));
+				c = cigarBuffer = (uint32_t*)realloc(c, s * sizeof(uint32_t));
+				cigarBufferSize = s;
 			}
 			c[l - 1] = to_cigar_int(e, prev_op);
 			prev_op = op;
@@ -968,23 +1596,9 @@ SmithWaterman::cigar * SmithWaterman::banded_sw(const int *db_sequence, const in
 	}
 
 	// reverse cigar
-	c1 = (uint32_t*)new uint32_t[l * sizeof(uint32_t)];
-	s = 0;
-	e = l - 1;
-	while (LIKELY(s <= e)) {
-		c1[s] = c[e];
-		c1[e] = c[s];
-		++ s;
-		-- e;
-	}
-	result->seq = c1;
-	result->length = l;
-
-	free(direction);
-	free(h_c);
-	free(e_b);
-	free(h_b);
-	free(c);
+	std::reverse(c, c + l);
+	result.seq = c;
+	result.length = l;
 	return result;
 #undef kroundup32
 #undef set_u
@@ -1087,7 +1701,7 @@ s_align SmithWaterman::scoreIdentical(int *dbSeq, int L, EvalueComputation * eva
 	r.cigarLen = L;
 	r.qCov =  1.0;
 	r.tCov = 1.0;
-	r.cigar = new uint32_t[L];
+	r.cigar = cigarBuffer;
 	short score = 0;
 	for(int pos = 0; pos < L; pos++){
 		int currScore = profile->profile_word_linear[dbSeq[pos]][pos];
@@ -65,6 +65,7 @@ typedef struct {
     int32_t ref_end2;
     float qCov;
     float tCov;
+    // owned by the aligner that computed the alignment, valid until its next alignment
     uint32_t* cigar;
     int32_t cigarLen;
     double evalue;
@@ -143,6 +144,69 @@ public:
                         const int32_t maskLen);
 
 
+    /*!	@function	Striped Smith-Waterman alignment with a single forward pass.
+
+     @discussion	Runs the 16 bit forward pass of ssw_align and keeps the scores of a band around the given diagonal
+     (query position - target position). Start position and cigar are traced back through these scores instead of
+     a reverse pass and a banded realignment. The band is limited to maxBandCells scores, smaller matrices are kept
+     completely. If the traceback leaves the
+     band the alignment is computed again with ssw_align. Scores and end positions are identical to ssw_align,
+     start positions and cigars can differ between equally scoring alignments.
+     */
+    s_align ssw_align_single_pass(const int *db_sequence,
+                                  int32_t db_length,
+                                  const uint8_t gap_open,
+                                  const uint8_t gap_extend,
+                                  const uint8_t alignmentMode,
+                                  const double filters,
+                                  EvalueComputation * filterd,
+                                  const int covMode, const float covThr,
+                                  const int32_t maskLen,
+                                  const int diagonal);
+
+    /*!	@function	Banded Smith-Waterman alignment with X-drop around a diagonal.
+
+     @discussion	Aligns only the cells within bandWidth of the given diagonal (query position - target position),
+     anti-diagonal by anti-diagonal, and stops once the scores of two consecutive anti-diagonals dropped by more than
+     xDrop below the best score. The start position and cigar are traced back from stored directions. While the
+     alignment touches the border of the band, the band is doubled. Returns false if the band would cover most of
+     the matrix, the diagonal is unknown or the score does not fit 16 bit; the caller then has to compute the full
+     Smith-Waterman alignment. Scores can be lower than the ones of ssw_align if the best alignment is outside the band.
+     */
+    bool ssw_align_banded(s_align &r,
+                          const int *db_sequence,
+                          int32_t db_length,
+                          const uint8_t gap_open,
+                          const uint8_t gap_extend,
+                          const uint8_t alignmentMode,
+                          const double filters,
+                          EvalueComputation * filterd,
+                          const int covMode, const float covThr,
+                          const int diagonal,
+                          const int32_t bandWidth);
+
+    // number of lanes of ssw_score_batch, one per byte of a SIMD register
+    static const int32_t BATCH_SIZE = VECSIZE_INT * 4;
+    // marks the first residue of a target in a lane of ssw_score_batch
+    static const uint8_t BATCH_START = 0x40;
+    // residue of lane positions after the last target, scores below every other residue
+    static const uint8_t BATCH_PAD = 0x3F;
+
+    /*!	@function	8 bit Smith-Waterman scores of many targets at once.
+
+     @discussion	Inter-sequence layout: each byte of a SIMD register belongs to another lane, residue j of lane l
+     is batch[j * BATCH_SIZE + l]. A lane holds several targets one after another, the first residue of each target
+     is or-ed with BATCH_START and lanes shorter than db_length are filled with BATCH_PAD. maxima (aligned, same
+     layout) receives the best score of the cells of each target position, 255 if it does not fit into 8 bit. The
+     score of the 8 bit pass of ssw_align for a target is the maximum over its positions. Returns false without
+     computing scores if the alphabet has more than 32 letters.
+     */
+    bool ssw_score_batch(const uint8_t *batch,
+                         int32_t db_length,
+                         const uint8_t gap_open,
+                         const uint8_t gap_extend,
+                         uint8_t *maxima);
+
     /*!	@function computed ungapped alignment score
 
    @param	db_sequence	pointer to the target sequence; the target sequence needs to be numbers and corresponding to the mat parameter of
@@ -204,6 +268,9 @@ private:
         simd_int* profile_word;	// 0: none
         simd_int* profile_rev_byte;	// 0: none
         simd_int* profile_rev_word;	// 0: none
+        // query end + 1 the reverse profiles were built for, they are reused while it stays the same; -1: none
+        int32_t rev_byte_length;
+        int32_t rev_word_length;
         int8_t* query_sequence;
         int8_t* query_rev_sequence;
         int8_t* composition_bias;
@@ -275,10 +342,69 @@ private:
                                  const uint8_t gap_extend, /* will be used as - */
                                  const simd_int*query_profile_byte,
                                  uint16_t terminate,
-                                 int32_t maskLen);
+                                 int32_t maskLen,
+                                 int16_t *band = NULL, /* if set, stores the scores of query positions i + bandOffset to i + bandOffset + bandSize - 1 of column i,
+                                                          the whole striped column if bandSize is 0 */
+                                 int32_t bandOffset = 0,
+                                 int32_t bandSize = 0);
+
+    // ends of the best alignments of the last sw_sse2_byte or sw_sse2_word call
+    alignment_end alignmentEnds[2];
+
+    // cigar of the last alignment, s_align::cigar points into it
+    uint32_t *cigarBuffer;
+    size_t cigarBufferSize;
+
+    // rows and directions of banded_sw
+    int32_t *bandedH;
+    int32_t *bandedE;
+    int32_t *bandedHc;
+    size_t bandedRowSize;
+    int8_t *bandedDirection;
+    size_t bandedDirectionSize;
+
+    // scores of the band kept by ssw_align_single_pass
+    int16_t *bandScores;
+    size_t bandScoresSize;
+    const static size_t maxBandCells = 1 << 22;
+
+    // traces the alignment back from its end through the band scores, returns false if the path leaves the band
+    bool band_traceback(s_align &r, const int *db_sequence, const uint8_t gap_open, const uint8_t gap_extend,
+                        int32_t bandOffset, int32_t bandSize);
+
+    // per query position the byte profile scores of residues 0-15 and 16-31, each repeated to fill a register,
+    // followed by the H and E rows of ssw_score_batch
+    simd_int *batchProfile;
+    int32_t batchProfileSize;
+    bool batchProfileValid;
+    // H and F between two blocks of query positions of ssw_score_batch
+    simd_int *batchBorder;
+    int32_t batchBorderSize;
+    const static int32_t batchBlockSize = 64;
+
+    // H, E, F rows of the last anti-diagonals and the substitution scores of banded_xdrop
+    int16_t *xdropRows;
+    size_t xdropRowsSize;
+    // directions of all band cells, per anti-diagonal the first cell and its target position
+    int16_t *xdropTrace;
+    size_t xdropTraceSize;
+    int32_t *xdropTraceStart;
+    int32_t *xdropTraceLow;
+    size_t xdropAntiDiagonals;
+    const static int32_t xDrop = 100;
+
+    enum {
+        BANDED_OK,
+        BANDED_BORDER,
+        BANDED_FAILED
+    };
+
+    // one banded alignment with a fixed band, BANDED_BORDER if the traceback touches the border of the band
+    int banded_xdrop(s_align &r, const int *db_sequence, int32_t db_length, const uint8_t gap_open, const uint8_t gap_extend,
+                     int32_t center, int32_t bandWidth);
 
     template <const unsigned int type>
-    SmithWaterman::cigar *banded_sw(const int *db_sequence, const int8_t *query_sequence, const int8_t * compositionBias, int32_t db_length, int32_t query_length, int32_t queryStart, int32_t score, const uint32_t gap_open, const uint32_t gap_extend, int32_t band_width, const int8_t *mat, int32_t n);
+    SmithWaterman::cigar banded_sw(const int *db_sequence, const int8_t *query_sequence, const int8_t * compositionBias, int32_t db_length, int32_t query_length, int32_t queryStart, int32_t score, const uint32_t gap_open, const uint32_t gap_extend, int32_t band_width, const int8_t *mat, int32_t n);
 
     /*!	@function		Produce CIGAR 32-bit unsigned integer from CIGAR operation and CIGAR length
      @param	length		length of CIGAR
@@ -50,7 +50,7 @@ int doRescorediagonal(Parameters &par,
     IndexReader * qDbrIdx = NULL;
     DBReader<unsigned int> * qdbr = NULL;
     DBReader<unsigned int> * tdbr = NULL;
-    bool touch = (par.preloadMode != Parameters::PRELOAD_MODE_MMAP);
+    bool touch = Parameters::shouldTouchData(par.preloadMode);
     IndexReader * tDbrIdx = new IndexReader(par.db2, par.threads, IndexReader::SEQUENCES, (touch) ? (IndexReader::PRELOAD_INDEX | IndexReader::PRELOAD_DATA) : 0 );
     int querySeqType = 0;
     tdbr = tDbrIdx->sequenceReader;
@@ -0,0 +1,182 @@
+#include "ChunkDispenser.h"
+#include "MMseqsMPI.h"
+#include "Debug.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+ChunkDispenser::ChunkDispenser(const unsigned int *weights, size_t entries, size_t chunkCount)
+        : mode(MODE_LOCAL), localNext(0), lockFd(-1) {
+    chunkCount = std::max(static_cast<size_t>(1), std::min(chunkCount, entries));
+    size_t totalWeight = 0;
+    for (size_t i = 0; i < entries; ++i) {
+        totalWeight += weights[i];
+    }
+
+    chunkStarts.reserve(chunkCount + 1);
+    chunkStarts.push_back(0);
+    const double chunkWeight = static_cast<double>(totalWeight) / static_cast<double>(chunkCount);
+    size_t currentWeight = 0;
+    for (size_t i = 0; i < entries; ++i) {
+        if (i > chunkStarts.back() && currentWeight >= chunkWeight * chunkStarts.size() && chunkStarts.size() < chunkCount) {
+            chunkStarts.push_back(i);
+        }
+        currentWeight += weights[i];
+    }
+    if (entries > 0) {
+        chunkStarts.push_back(entries);
+    }
+}
+
+ChunkDispenser::~ChunkDispenser() {
+    if (lockFd != -1) {
+        close(lockFd);
+    }
+}
+
+void ChunkDispenser::useMpiWorkQueue() {
+#ifdef HAVE_MPI
+    MMseqsMPI::initWorkQueue();
+    mode = MODE_MPI;
+#else
+    Debug(Debug::ERROR) << "MMseqs2 was compiled without MPI support.\n";
+    EXIT(EXIT_FAILURE);
+#endif
+}
+
+void ChunkDispenser::useLockFile(const std::string &file, bool owner) {
+    lockFile = file;
+    lockFd = open(lockFile.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    if (lockFd == -1) {
+        Debug(Debug::ERROR) << "Can not open lock file " << lockFile << ". Error " << strerror(errno) << ".\n";
+        EXIT(EXIT_FAILURE);
+    }
+    mode = MODE_LOCK_FILE;
+
+    if (owner) {
+        // counters of a crashed run must not leak into this one
+        LockFileState state = lockAndRead();
+        memset(&state, 0, sizeof(LockFileState));
+        struct flock lock;
+        memset(&lock, 0, sizeof(struct flock));
+        lock.l_type = F_WRLCK;
+        lock.l_whence = SEEK_SET;
+        lock.l_start = OWNER_LOCK_OFFSET;
+        lock.l_len = 1;
+        if (fcntl(lockFd, F_SETLK, &lock) == -1) {
+            Debug(Debug::ERROR) << "Can not lock " << lockFile << ". Is another process 0 running? Error " << strerror(errno) << ".\n";
+            EXIT(EXIT_FAILURE);
+        }
+        writeAndUnlock(state);
+    } else {
+        // the lock of the owner vanishes with its process, so a live lock means the counters belong to this run
+        while (isOwnerAlive() == false) {
+            sleep(1);
+        }
+    }
+}
+
+bool ChunkDispenser::isOwnerAlive() {
+    struct flock lock;
+    memset(&lock, 0, sizeof(struct flock));
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = OWNER_LOCK_OFFSET;
+    lock.l_len = 1;
+    if (fcntl(lockFd, F_GETLK, &lock) == -1) {
+        Debug(Debug::ERROR) << "Can not check lock of " << lockFile << ". Error " << strerror(errno) << ".\n";
+        EXIT(EXIT_FAILURE);
+    }
+    return lock.l_type != F_UNLCK;
+}
+
+ChunkDispenser::LockFileState ChunkDispenser::lockAndRead() {
+    struct flock lock;
+    memset(&lock, 0, sizeof(struct flock));
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    lock.l_len = sizeof(LockFileState);
+    while (fcntl(lockFd, F_SETLKW, &lock) == -1) {
+        if (errno != EINTR) {
+            Debug(Debug::ERROR) << "Can not lock " << lockFile << ". Error " << strerror(errno) << ".\n";
+            EXIT(EXIT_FAILURE);
+        }
+    }
+
+    // a new lock file is empty and starts with zero counters
+    LockFileState state;
+    memset(&state, 0, sizeof(LockFileState));
+    ssize_t readBytes = pread(lockFd, &state, sizeof(LockFileState), 0);
+    if (readBytes != 0 && readBytes != sizeof(LockFileState)) {
+        Debug(Debug::ERROR) << "Lock file " << lockFile << " is corrupted.\n";
+        EXIT(EXIT_FAILURE);
+    }
+    return state;
+}
+
+void ChunkDispenser::writeAndUnlock(const LockFileState &state) {
+    if (pwrite(lockFd, &state, sizeof(LockFileState), 0) != sizeof(LockFileState)) {
+        Debug(Debug::ERROR) << "Can not write lock file " << lockFile << ".\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    struct flock lock;
+    memset(&lock, 0, sizeof(struct flock));
+    lock.l_type = F_UNLCK;
+    lock.l_whence = SEEK_SET;
+    lock.l_len = sizeof(LockFileState);
+    fcntl(lockFd, F_SETLK, &lock);
+}
+
+bool ChunkDispenser::next(size_t *from, size_t *size) {
+    size_t chunk = 0;
+    if (mode == MODE_LOCAL) {
+        chunk = localNext++;
+    } else if (mode == MODE_MPI) {
+#ifdef HAVE_MPI
+        chunk = MMseqsMPI::nextWorkItem(1);
+#endif
+    } else {
+        LockFileState state = lockAndRead();
+        chunk = state.nextChunk;
+        state.nextChunk++;
+        writeAndUnlock(state);
+    }
+
+    if (chunk >= getChunkCount()) {
+        return false;
+    }
+    *from = chunkStarts[chunk];
+    *size = chunkStarts[chunk + 1] - chunkStarts[chunk];
+    return true;
+}
+
+void ChunkDispenser::finish() {
+    if (mode == MODE_MPI) {
+#ifdef HAVE_MPI
+        MMseqsMPI::freeWorkQueue();
+#endif
+    } else if (mode == MODE_LOCK_FILE) {
+        LockFileState state = lockAndRead();
+        state.finished++;
+        writeAndUnlock(state);
+    }
+}
+
+void ChunkDispenser::waitForProcesses(unsigned int processes) {
+    if (mode != MODE_LOCK_FILE) {
+        return;
+    }
+    while (true) {
+        LockFileState state = lockAndRead();
+        writeAndUnlock(state);
+        if (state.finished >= processes) {
+            break;
+        }
+        sleep(1);
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef CHUNKDISPENSER_H
+#define CHUNKDISPENSER_H
+
+// Hands out chunks of database entries on demand to the processes of a distributed run.
+// Chunks are cut so that each one carries about the same weight (e.g. the size of the prefilter result lists).
+// Processes pull the next chunk either from the MPI work queue of the master or,
+// without MPI, from a counter file that is shared by all processes on one node.
+
+#include <cstddef>
+#include <sys/types.h>
+#include <string>
+#include <vector>
+
+class ChunkDispenser {
+public:
+    ChunkDispenser(const unsigned int *weights, size_t entries, size_t chunkCount);
+    ~ChunkDispenser();
+
+    // all MPI ranks have to call this collectively
+    void useMpiWorkQueue();
+
+    // the owner (process 0) resets the counters left behind by an aborted run and holds a lock as long as it lives,
+    // the other processes wait for that lock before they take chunks
+    void useLockFile(const std::string &lockFile, bool owner);
+
+    // returns false once all chunks are handed out
+    bool next(size_t *from, size_t *size);
+
+    // marks this process as done, the MPI mode is collective
+    void finish();
+
+    // blocks until the given number of processes called finish (lock file mode)
+    void waitForProcesses(unsigned int processes);
+
+    size_t getChunkCount() {
+        return chunkStarts.size() - 1;
+    }
+
+private:
+    static const int MODE_LOCAL = 0;
+    static const int MODE_MPI = 1;
+    static const int MODE_LOCK_FILE = 2;
+
+    std::vector<size_t> chunkStarts;
+    int mode;
+    size_t localNext;
+
+    std::string lockFile;
+    int lockFd;
+
+    // counters stored in the lock file
+    struct LockFileState {
+        size_t nextChunk;
+        size_t finished;
+    };
+    LockFileState lockAndRead();
+    void writeAndUnlock(const LockFileState &state);
+
+    // byte of the lock file that the owner keeps locked, behind the counters
+    static const off_t OWNER_LOCK_OFFSET = 4096;
+    bool isOwnerAlive();
+};
+
+#endif
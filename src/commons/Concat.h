@@ -14,6 +14,12 @@
 #include <algorithm>
 #include <fcntl.h>
 #include <limits.h>
+#include <errno.h>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
 
 #include "Debug.h"
 #include "Util.h"
@@ -144,6 +150,72 @@ public:
     }
 
 
+    /* Copy the first SIZE bytes of INPUT_DESC to OUT_DESC starting at OUT_OFFSET.
+       File positions are not used, so several inputs can be copied into one output in parallel.
+       The extents are shared (reflink) if the file system supports it and OUT_OFFSET is block aligned,
+       otherwise the data is copied inside the kernel and only then through a user space buffer.  */
+    static bool copyFileRange(int input_desc, int out_desc, size_t size, off_t out_offset) {
+#ifdef FICLONERANGE
+        struct stat stat_buf;
+        if (fstat(out_desc, &stat_buf) == 0 && stat_buf.st_blksize > 0 && out_offset % stat_buf.st_blksize == 0) {
+            struct file_clone_range range;
+            range.src_fd = input_desc;
+            range.src_offset = 0;
+            // zero clones up to the end of the input
+            range.src_length = 0;
+            range.dest_offset = out_offset;
+            if (ioctl(out_desc, FICLONERANGE, &range) == 0) {
+                return true;
+            }
+        }
+#endif
+        off_t in_offset = 0;
+#ifdef HAVE_COPY_FILE_RANGE
+        loff_t copy_in = 0;
+        loff_t copy_out = out_offset;
+        while ((size_t) copy_in < size) {
+            ssize_t copied = copy_file_range(input_desc, &copy_in, out_desc, &copy_out, size - copy_in, 0);
+            if (copied < 0 && errno == EINTR) {
+                continue;
+            }
+            if (copied <= 0) {
+                // e.g. different file systems on older kernels, copy the rest through user space
+                break;
+            }
+        }
+        in_offset = copy_in;
+        out_offset = copy_out;
+#endif
+        const size_t bufsize = 1024 * 1024;
+        char *buf = (char *) malloc(bufsize);
+        while ((size_t) in_offset < size) {
+            ssize_t n_read = pread(input_desc, buf, std::min(bufsize, size - in_offset), in_offset);
+            if (n_read < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n_read <= 0) {
+                free(buf);
+                return false;
+            }
+            ssize_t n_written = 0;
+            while (n_written < n_read) {
+                ssize_t cc = pwrite(out_desc, buf + n_written, n_read - n_written, out_offset + n_written);
+                if (cc < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (cc <= 0) {
+                    free(buf);
+                    return false;
+                }
+                n_written += cc;
+            }
+            in_offset += n_read;
+            out_offset += n_read;
+        }
+        free(buf);
+        return true;
+    }
+
     static bool doConcat(int input_desc, int out_desc, const char *buf, size_t bufsize) {
         while (true) {
             /* Read a block of input.  */
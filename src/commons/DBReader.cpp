@@ -12,11 +12,13 @@
 #include <sys/stat.h>
 #include <omptl/omptl_algorithm>
 #include <fcntl.h>
+#include <unistd.h>
 
 #include "MemoryMapped.h"
 #include "Debug.h"
 #include "Util.h"
 #include "FileUtil.h"
+#include "SharedMemoryDB.h"
 
 #ifdef OPENMP
 #include <omp.h>
@@ -27,7 +29,9 @@ DBReader<T>::DBReader(const char* dataFileName_, const char* indexFileName_, int
 threads(threads), dataMode(dataMode), dataFileName(strdup(dataFileName_)),
         indexFileName(strdup(indexFileName_)), size(0), dataFiles(NULL), dataSizeOffset(NULL), dataFileCnt(0),
         totalDataSize(0), dataSize(0), lastKey(T()), closed(1), dbtype(Parameters::DBTYPE_GENERIC_DB),
-        compressedBuffers(NULL), compressedBufferSizes(NULL), index(NULL), seqLens(NULL), id2local(NULL), local2id(NULL),
+        compressedBuffers(NULL), compressedBufferSizes(NULL), ddict(NULL), index(NULL), seqLens(NULL), id2local(NULL), local2id(NULL),
+        keyToLocal(NULL), keyLookupBase(T()), keyLookupSize(0), eytzingerKeys(NULL), eytzingerIds(NULL),
+        binaryIndexData(NULL), binaryIndexSize(0),
         dataMapped(false), accessType(0), externalData(false), didMlock(false)
 {}
 
@@ -36,8 +40,10 @@ DBReader<T>::DBReader(DBReader<T>::Index *index, unsigned int *seqLens, size_t s
         int dbType, unsigned int maxSeqLen, int threads) :
         threads(threads), dataMode(USE_INDEX), dataFileName(NULL), indexFileName(NULL),
         size(size), dataFiles(NULL), dataSizeOffset(NULL), dataFileCnt(0), totalDataSize(0), dataSize(dataSize), lastKey(lastKey),
-        maxSeqLen(maxSeqLen), closed(1), dbtype(dbType), compressedBuffers(NULL), compressedBufferSizes(NULL), index(index), sortedByOffset(true),
-        seqLens(seqLens), id2local(NULL), local2id(NULL), dataMapped(false), accessType(NOSORT), externalData(true), didMlock(false)
+        maxSeqLen(maxSeqLen), closed(1), dbtype(dbType), compressedBuffers(NULL), compressedBufferSizes(NULL), ddict(NULL), index(index), sortedByOffset(true),
+        seqLens(seqLens), id2local(NULL), local2id(NULL),
+        keyToLocal(NULL), keyLookupBase(T()), keyLookupSize(0), eytzingerKeys(NULL), eytzingerIds(NULL),
+        binaryIndexData(NULL), binaryIndexSize(0), dataMapped(false), accessType(NOSORT), externalData(true), didMlock(false)
 {}
 
 template <typename T>
@@ -58,6 +64,10 @@ void DBReader<T>::readMmapedDataInMemory(){
     if ((dataMode & USE_DATA) && (dataMode & USE_FREAD) == 0) {
         //Debug(Debug::INFO) << "Touch data file " << dataFileName << "\n";
         for(size_t fileIdx = 0; fileIdx < dataFileCnt; fileIdx++){
+            // already resident
+            if (sharedDataFiles[fileIdx]) {
+                continue;
+            }
             size_t dataSize = dataSizeOffset[fileIdx+1]-dataSizeOffset[fileIdx];
             magicBytes += Util::touchMemory(dataFiles[fileIdx], dataSize);
         }
@@ -118,6 +128,7 @@ template <typename T> bool DBReader<T>::open(int accessType){
         dataFileCnt = dataFileNames.size();
         dataSizeOffset = new size_t[dataFileNames.size() + 1];
         dataFiles = new char*[dataFileNames.size()];
+        sharedDataFiles.assign(dataFileNames.size(), false);
         for(size_t fileIdx = 0; fileIdx < dataFileNames.size(); fileIdx++){
             FILE* dataFile = fopen(dataFileNames[fileIdx].c_str(), "r");
             if (dataFile == NULL) {
@@ -125,7 +136,9 @@ template <typename T> bool DBReader<T>::open(int accessType){
                 EXIT(EXIT_FAILURE);
             }
             size_t dataSize;
-            dataFiles[fileIdx] = mmapData(dataFile, &dataSize);
+            bool isShared = false;
+            dataFiles[fileIdx] = mmapData(dataFile, &dataSize, &isShared);
+            sharedDataFiles[fileIdx] = isShared;
             dataSizeOffset[fileIdx]=totalDataSize;
             totalDataSize += dataSize;
             fclose(dataFile);
@@ -156,6 +169,8 @@ template <typename T> bool DBReader<T>::open(int accessType){
             Debug(Debug::ERROR) << "Can not open index file " << indexFileName << "!\n";
             EXIT(EXIT_FAILURE);
         }
+    }
+    if (externalData == false && openBinaryIndex() == false) {
         MemoryMapped indexData(indexFileName, MemoryMapped::WholeFile, MemoryMapped::SequentialScan);
         if (!indexData.isValid()){
             Debug(Debug::ERROR) << "Can not open index file " << indexFileName << "\n";
@@ -209,12 +224,104 @@ template <typename T> bool DBReader<T>::open(int accessType){
                 EXIT(EXIT_FAILURE);
             }
         }
+
+        // entries compressed with a trained dictionary need it for decompression
+        std::string dictFile = (dataFileName != NULL) ? std::string(dataFileName) + ".dict" : "";
+        if (dictFile.empty() == false && FileUtil::fileExists(dictFile.c_str())) {
+            MemoryMapped dictData(dictFile, MemoryMapped::WholeFile, MemoryMapped::SequentialScan);
+            if (!dictData.isValid()) {
+                Debug(Debug::ERROR) << "Can not open dictionary file " << dictFile << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            ddict = ZSTD_createDDict(dictData.getData(), dictData.size());
+            dictData.close();
+            if (ddict == NULL) {
+                Debug(Debug::ERROR) << "ZSTD_createDDict() error for " << dictFile << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            for (int i = 0; i < threads; i++) {
+                size_t initResult = ZSTD_initDStream_usingDDict(dstream[i], ddict);
+                if (ZSTD_isError(initResult)) {
+                    Debug(Debug::ERROR) << "ZSTD_initDStream_usingDDict() error " << ZSTD_getErrorName(initResult) << "\n";
+                    EXIT(EXIT_FAILURE);
+                }
+            }
+        }
+    }
+
+    if (accessType != HARDNOSORT) {
+        buildKeyLookup();
     }
 
     closed = 0;
     return isSortedById;
 }
 
+template<typename T>
+void DBReader<T>::buildKeyLookup() {
+}
+
+// an in-order walk over the implicit tree visits the nodes in key order
+static size_t fillEytzinger(const DBReader<unsigned int>::Index *index, const unsigned int *id2local, size_t size,
+                            unsigned int *keys, unsigned int *ids, size_t pos, size_t node) {
+    if (node <= size) {
+        pos = fillEytzinger(index, id2local, size, keys, ids, pos, 2 * node);
+        keys[node] = index[pos].id;
+        ids[node] = (id2local != NULL) ? id2local[pos] : pos;
+        pos = fillEytzinger(index, id2local, size, keys, ids, pos + 1, 2 * node + 1);
+    }
+    return pos;
+}
+
+template<>
+void DBReader<unsigned int>::buildKeyLookup() {
+    if (size == 0) {
+        return;
+    }
+    bool hasMapping = (accessType == SORT_BY_LENGTH || accessType == LINEAR_ACCCESS || accessType == SORT_BY_LINE || accessType == SHUFFLE);
+
+    // keys from createdb are consecutive, a table with a few holes is still smaller than the index itself
+    size_t keyRange = static_cast<size_t>(index[size - 1].id) - index[0].id + 1;
+    if (keyRange <= 2 * size) {
+        keyLookupBase = index[0].id;
+        keyLookupSize = keyRange;
+        keyToLocal = new(std::nothrow) unsigned int[keyLookupSize];
+        Util::checkAllocation(keyToLocal, "Can not allocate key lookup memory in DBReader");
+#pragma omp parallel num_threads(threads)
+        {
+#pragma omp for schedule(static)
+            for (size_t i = 0; i < keyLookupSize; i++) {
+                keyToLocal[i] = UINT_MAX;
+            }
+#pragma omp for schedule(static)
+            for (size_t i = 0; i < size; i++) {
+                // duplicated keys resolve to their first entry like the binary search
+                if (i == 0 || index[i - 1].id != index[i].id) {
+                    keyToLocal[index[i].id - keyLookupBase] = hasMapping ? id2local[i] : i;
+                }
+            }
+        }
+        return;
+    }
+
+    eytzingerKeys = new(std::nothrow) unsigned int[size + 1];
+    Util::checkAllocation(eytzingerKeys, "Can not allocate key lookup memory in DBReader");
+    eytzingerIds = new(std::nothrow) unsigned int[size + 1];
+    Util::checkAllocation(eytzingerIds, "Can not allocate key lookup memory in DBReader");
+    fillEytzinger(index, hasMapping ? id2local : NULL, size, eytzingerKeys, eytzingerIds, 0, 1);
+}
+
+template<typename T>
+void DBReader<T>::freeKeyLookup() {
+    delete[] keyToLocal;
+    keyToLocal = NULL;
+    keyLookupSize = 0;
+    delete[] eytzingerKeys;
+    eytzingerKeys = NULL;
+    delete[] eytzingerIds;
+    eytzingerIds = NULL;
+}
+
 template<typename T>
 void DBReader<T>::sortIndex(bool) {
 }
@@ -387,7 +494,7 @@ void DBReader<unsigned int>::sortIndex(bool isSortedById) {
     }
 }
 
-template <typename T> char* DBReader<T>::mmapData(FILE * file, size_t *dataSize) {
+template <typename T> char* DBReader<T>::mmapData(FILE * file, size_t *dataSize, bool *isShared) {
     struct stat sb;
     if (fstat(fileno(file), &sb) < 0) {
         int errsv = errno;
@@ -399,8 +506,12 @@ template <typename T> char* DBReader<T>::mmapData(FILE * file, size_t *dataSize)
     int fd =  fileno(file);
 
     char *ret;
+    *isShared = false;
     if(*dataSize > 0){
-        if ((dataMode & USE_FREAD) == 0) {
+        if ((dataMode & USE_WRITABLE) == 0 && (ret = SharedMemoryDB::attach(sb)) != NULL) {
+            // resident segments need neither a private mapping nor a fread copy
+            *isShared = true;
+        } else if ((dataMode & USE_FREAD) == 0) {
             int mode;
             if (dataMode & USE_WRITABLE) {
                 mode = PROT_READ | PROT_WRITE;
@@ -434,7 +545,9 @@ template <typename T> void DBReader<T>::remapData(){
         for(size_t fileIdx = 0; fileIdx < dataFileNames.size(); fileIdx++){
             FILE* dataFile = fopen(dataFileNames[fileIdx].c_str(), "r");
             size_t dataSize = 0;
-            dataFiles[fileIdx] = mmapData(dataFile, &dataSize);
+            bool isShared = false;
+            dataFiles[fileIdx] = mmapData(dataFile, &dataSize, &isShared);
+            sharedDataFiles[fileIdx] = isShared;
             fclose(dataFile);
 
         }
@@ -450,7 +563,8 @@ template <typename T> void DBReader<T>::close(){
     if(dataMode & USE_DATA){
         unmapData();
     }
-    if(accessType == SORT_BY_LENGTH || accessType == LINEAR_ACCCESS || accessType == SORT_BY_LINE || accessType == SHUFFLE){
+    freeKeyLookup();
+    if(binaryIndexData == NULL && (accessType == SORT_BY_LENGTH || accessType == LINEAR_ACCCESS || accessType == SORT_BY_LINE || accessType == SHUFFLE)){
         delete [] id2local;
         delete [] local2id;
     }
@@ -458,14 +572,19 @@ template <typename T> void DBReader<T>::close(){
     if(compressedBuffers){
         for(int i = 0; i < threads; i++){
             ZSTD_freeDStream(dstream[i]);
-            delete [] compressedBuffers[i];
+            free(compressedBuffers[i]);
         }
         delete [] compressedBuffers;
         delete [] compressedBufferSizes;
         delete [] dstream;
+        ZSTD_freeDDict(ddict);
+        ddict = NULL;
     }
 
-    if(externalData == false) {
+    if(binaryIndexData != NULL) {
+        munmap(binaryIndexData, binaryIndexSize);
+        binaryIndexData = NULL;
+    } else if(externalData == false) {
         delete[] index;
         delete[] seqLens;
     }
@@ -490,15 +609,26 @@ template <typename T> char* DBReader<T>::getDataCompressed(size_t id, int thrIdx
     bool isCompressed = (dataStart[cSize] == 0) ? true : false;
     if(isCompressed){
         ZSTD_inBuffer input = {cBuff, cSize, 0};
-        while (input.pos < input.size) {
-            ZSTD_outBuffer output = {compressedBuffers[thrIdx], compressedBufferSizes[thrIdx], 0};
-            // size of next compressed block
-            size_t toRead = ZSTD_decompressStream(dstream[thrIdx], &output, &input);
+        size_t toRead = 1;
+        while (input.pos < input.size || toRead != 0) {
+            // the buffer is sized by the compressed entry lengths, decompressed entries can be much larger
+            if (totalSize + 1 >= compressedBufferSizes[thrIdx]) {
+                compressedBufferSizes[thrIdx] *= 2;
+                compressedBuffers[thrIdx] = (char*) realloc(compressedBuffers[thrIdx], compressedBufferSizes[thrIdx]);
+                Util::checkAllocation(compressedBuffers[thrIdx], "Can not reallocate compressedBuffer in DBReader");
+            }
+            // keep one byte free for the terminating null byte
+            ZSTD_outBuffer output = {compressedBuffers[thrIdx] + totalSize, compressedBufferSizes[thrIdx] - totalSize - 1, 0};
+            toRead = ZSTD_decompressStream(dstream[thrIdx], &output, &input);
             if (ZSTD_isError(toRead)) {
                 Debug(Debug::ERROR) << id << " ZSTD_decompressStream " << ZSTD_getErrorName(toRead) << "\n";
                 EXIT(EXIT_FAILURE);
             }
             totalSize += output.pos;
+            if (toRead != 0 && input.pos == input.size && output.pos < output.size) {
+                Debug(Debug::ERROR) << id << " ZSTD_decompressStream truncated entry\n";
+                EXIT(EXIT_FAILURE);
+            }
         }
         compressedBuffers[thrIdx][totalSize] = '\0';
     }else{
@@ -571,6 +701,41 @@ void DBReader<T>::touchData(size_t id) {
     }
 }
 
+template<typename T>
+void DBReader<T>::prefetch(const T *keys, size_t count) {
+#if HAVE_POSIX_MADVISE
+    if ((dataMode & USE_DATA) == 0 || (dataMode & USE_FREAD) || count == 0) {
+        return;
+    }
+    const uintptr_t pageMask = ~(static_cast<uintptr_t>(Util::getPageSize()) - 1);
+    std::vector<std::pair<uintptr_t, uintptr_t> > ranges;
+    ranges.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        size_t id = getId(keys[i]);
+        if (id == UINT_MAX) {
+            continue;
+        }
+        uintptr_t start = reinterpret_cast<uintptr_t>(getDataUncompressed(id));
+        uintptr_t end = start + getSeqLens(id);
+        ranges.push_back(std::make_pair(start & pageMask, end));
+    }
+    // entries that share or neighbour pages are requested with a single call
+    std::sort(ranges.begin(), ranges.end());
+    size_t i = 0;
+    while (i < ranges.size()) {
+        uintptr_t start = ranges[i].first;
+        uintptr_t end = ranges[i].second;
+        for (i++; i < ranges.size() && ranges[i].first <= end; i++) {
+            end = std::max(end, ranges[i].second);
+        }
+        posix_madvise(reinterpret_cast<void *>(start), end - start, POSIX_MADV_WILLNEED);
+    }
+#else
+    (void) keys;
+    (void) count;
+#endif
+}
+
 template <typename T> char* DBReader<T>::getDataByDBKey(T dbKey, int thrIdx) {
     size_t id = getId(dbKey);
     if(compression == COMPRESSED ){
@@ -642,6 +807,28 @@ template <typename T> size_t DBReader<T>::getId (T dbKey){
     return (id < size && index[id].id == dbKey ) ? id : UINT_MAX;
 }
 
+template <> size_t DBReader<unsigned int>::getId (unsigned int dbKey){
+    if (keyToLocal != NULL) {
+        size_t pos = static_cast<size_t>(dbKey) - keyLookupBase;
+        return (dbKey >= keyLookupBase && pos < keyLookupSize) ? keyToLocal[pos] : UINT_MAX;
+    }
+    if (eytzingerKeys != NULL) {
+        // branchless lower bound, the first matching node is the first entry with dbKey
+        size_t k = 1;
+        while (k <= size) {
+            __builtin_prefetch(eytzingerKeys + 16 * k);
+            k = 2 * k + (eytzingerKeys[k] < dbKey);
+        }
+        k >>= __builtin_ffsll(~k);
+        return (k != 0 && eytzingerKeys[k] == dbKey) ? eytzingerIds[k] : UINT_MAX;
+    }
+    size_t id = bsearch(index, size, dbKey);
+    if(accessType == SORT_BY_LENGTH || accessType == LINEAR_ACCCESS || accessType == SORT_BY_LINE || accessType == SHUFFLE){
+        return  (id < size && index[id].id == dbKey) ? id2local[id] : UINT_MAX;
+    }
+    return (id < size && index[id].id == dbKey ) ? id : UINT_MAX;
+}
+
 template <typename T> unsigned int* DBReader<T>::getSeqLens(){
     return seqLens;
 }
@@ -764,7 +951,9 @@ template <typename T> void DBReader<T>::unmapData() {
                 if (didMlock == true) {
                     munlock(dataFiles[fileIdx], fileSize);
                 }
-                if ((dataMode & USE_FREAD) == 0) {
+                if (sharedDataFiles[fileIdx]) {
+                    SharedMemoryDB::detach(dataFiles[fileIdx], fileSize);
+                } else if ((dataMode & USE_FREAD) == 0) {
                     if (munmap(dataFiles[fileIdx], fileSize) < 0) {
                         Debug(Debug::ERROR) << "Failed to munmap memory dataSize=" << fileSize << " File=" << dataFileName
                                             << "\n";
@@ -841,6 +1030,164 @@ DBReader<unsigned int> *DBReader<unsigned int>::unserialize(const char* data, in
     return new DBReader<unsigned int>(idx, seqLens, size, dataSize, lastKey, dbType, maxSeqLen, threads);
 }
 
+static size_t binaryIndexFileSize(size_t headerSize, size_t entries, size_t indexEntrySize, bool linearAccess) {
+    size_t fileSize = headerSize + entries * indexEntrySize + entries * sizeof(unsigned int);
+    if (linearAccess) {
+        // local2id, id2local and seqLens in offset order
+        fileSize += 3 * entries * sizeof(unsigned int);
+    }
+    return fileSize;
+}
+
+template <>
+void DBReader<unsigned int>::writeBinaryIndex(const char* indexFileName, DBReader<unsigned int> &reader) {
+    if (reader.accessType != NOSORT && reader.accessType != SORT_BY_ID) {
+        Debug(Debug::ERROR) << "Binary index can only be written from an index sorted by id\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    struct stat indexStat;
+    if (stat(indexFileName, &indexStat) != 0) {
+        Debug(Debug::ERROR) << "Failed to stat index file " << indexFileName << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    BinaryIndexHeader header;
+    memset(&header, 0, sizeof(BinaryIndexHeader));
+    memcpy(header.magic, "MMSBIDX1", sizeof(header.magic));
+    header.size = reader.size;
+    header.dataSize = reader.dataSize;
+    header.lastKey = reader.lastKey;
+    header.maxSeqLen = reader.maxSeqLen;
+    header.indexFileSize = indexStat.st_size;
+    header.indexInode = indexStat.st_ino;
+    struct timespec indexMtime = FileUtil::getModificationTime(indexStat);
+    header.indexMtimeSec = indexMtime.tv_sec;
+    header.indexMtimeNsec = indexMtime.tv_nsec;
+    bool sortedByOffset = true;
+    for (size_t i = 1; i < reader.size && sortedByOffset; i++) {
+        sortedByOffset = reader.index[i].offset >= reader.index[i - 1].offset;
+    }
+    if (sortedByOffset) {
+        // the LINEAR_ACCCESS order is the id order
+        header.flags |= BINARY_INDEX_SORTED_BY_OFFSET;
+    } else {
+        header.flags |= BINARY_INDEX_LINEAR_ACCESS;
+    }
+
+    std::string binaryIndexFile = std::string(indexFileName) + ".bin";
+    FILE *file = FileUtil::openAndDelete(binaryIndexFile.c_str(), "wb");
+    bool success = fwrite(&header, sizeof(BinaryIndexHeader), 1, file) == 1;
+    success = success && fwrite(reader.index, sizeof(Index), reader.size, file) == reader.size;
+    success = success && fwrite(reader.seqLens, sizeof(unsigned int), reader.size, file) == reader.size;
+    if (header.flags & BINARY_INDEX_LINEAR_ACCESS) {
+        std::pair<unsigned int, size_t> *sortForMapping = new std::pair<unsigned int, size_t>[reader.size];
+        for (size_t i = 0; i < reader.size; i++) {
+            sortForMapping[i] = std::make_pair(i, reader.index[i].offset);
+        }
+        omptl::sort(sortForMapping, sortForMapping + reader.size, comparePairByOffset());
+        unsigned int *permutation = new unsigned int[reader.size];
+        for (size_t i = 0; i < reader.size; i++) {
+            permutation[i] = sortForMapping[i].first;
+        }
+        success = success && fwrite(permutation, sizeof(unsigned int), reader.size, file) == reader.size;
+        for (size_t i = 0; i < reader.size; i++) {
+            permutation[sortForMapping[i].first] = i;
+        }
+        success = success && fwrite(permutation, sizeof(unsigned int), reader.size, file) == reader.size;
+        for (size_t i = 0; i < reader.size; i++) {
+            permutation[i] = reader.seqLens[sortForMapping[i].first];
+        }
+        success = success && fwrite(permutation, sizeof(unsigned int), reader.size, file) == reader.size;
+        delete[] permutation;
+        delete[] sortForMapping;
+    }
+    if (success == false) {
+        Debug(Debug::ERROR) << "Can not write to binary index file " << binaryIndexFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    fclose(file);
+}
+
+template <typename T>
+bool DBReader<T>::openBinaryIndex() {
+    return false;
+}
+
+template <>
+bool DBReader<unsigned int>::openBinaryIndex() {
+    std::string binaryIndexFile = std::string(indexFileName) + ".bin";
+    int fd = ::open(binaryIndexFile.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    BinaryIndexHeader header;
+    struct stat indexStat;
+    struct stat binaryStat;
+    bool isValid = stat(indexFileName, &indexStat) == 0 && fstat(fd, &binaryStat) == 0
+                   && pread(fd, &header, sizeof(BinaryIndexHeader), 0) == sizeof(BinaryIndexHeader)
+                   && memcmp(header.magic, "MMSBIDX1", sizeof(header.magic)) == 0
+                   && header.indexFileSize == static_cast<size_t>(indexStat.st_size)
+                   && header.indexInode == static_cast<size_t>(indexStat.st_ino)
+                   && header.indexMtimeSec == static_cast<long long>(FileUtil::getModificationTime(indexStat).tv_sec)
+                   && header.indexMtimeNsec == static_cast<long long>(FileUtil::getModificationTime(indexStat).tv_nsec)
+                   && static_cast<size_t>(binaryStat.st_size) == binaryIndexFileSize(sizeof(BinaryIndexHeader), header.size, sizeof(Index),
+                                                                                    header.flags & BINARY_INDEX_LINEAR_ACCESS);
+    if (isValid == false || header.size == 0) {
+        // the text index was changed after the sidecar was written
+        ::close(fd);
+        return false;
+    }
+
+    // private mapping, some callers modify the index in place
+    char *data = static_cast<char*>(mmap(NULL, binaryStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0));
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    size = header.size;
+    dataSize = header.dataSize;
+    lastKey = header.lastKey;
+    maxSeqLen = header.maxSeqLen;
+    sortedByOffset = (header.flags & BINARY_INDEX_SORTED_BY_OFFSET) != 0;
+    Index *mappedIndex = reinterpret_cast<Index*>(data + sizeof(BinaryIndexHeader));
+    unsigned int *mappedSeqLens = reinterpret_cast<unsigned int*>(mappedIndex + size);
+
+    // the sidecar is sorted by id and only written for indices that are sorted by id,
+    // hence the line order is the id order and the offset order might be too
+    if (accessType == SORT_BY_ID || accessType == HARDNOSORT || accessType == SORT_BY_LINE || accessType == SORT_BY_ID_OFFSET
+        || (accessType == LINEAR_ACCCESS && sortedByOffset)) {
+        accessType = NOSORT;
+    }
+
+    if (accessType == NOSORT) {
+        binaryIndexData = data;
+        binaryIndexSize = binaryStat.st_size;
+        index = mappedIndex;
+        seqLens = mappedSeqLens;
+    } else if (accessType == LINEAR_ACCCESS && (header.flags & BINARY_INDEX_LINEAR_ACCESS)) {
+        binaryIndexData = data;
+        binaryIndexSize = binaryStat.st_size;
+        index = mappedIndex;
+        local2id = mappedSeqLens + size;
+        id2local = local2id + size;
+        seqLens = id2local + size;
+    } else {
+        // the remaining sort modes still profit from skipping the text parsing
+        index = new(std::nothrow) Index[size];
+        Util::checkAllocation(index, "Can not allocate index memory in DBReader");
+        seqLens = new(std::nothrow) unsigned int[size];
+        Util::checkAllocation(seqLens, "Can not allocate seqLens memory in DBReader");
+        memcpy(index, mappedIndex, size * sizeof(Index));
+        memcpy(seqLens, mappedSeqLens, size * sizeof(unsigned int));
+        munmap(data, binaryStat.st_size);
+        sortIndex(true);
+    }
+    return true;
+}
+
 template <typename T>
 int DBReader<T>::parseDbType(const char *name) {
     std::string dbTypeFile = std::string(name) + ".dbtype";
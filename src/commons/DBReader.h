@@ -73,6 +73,9 @@ public:
 
     void touchData(size_t id);
 
+    // asynchronously reads the entries of the given keys into the page cache (mmap mode only)
+    void prefetch(const T *keys, size_t count);
+
     char* getDataByDBKey(T key, int thrIdx);
 
     char * getDataByOffset(size_t offset);
@@ -94,8 +97,8 @@ public:
 
     size_t bsearch(const Index * index, size_t size, T value);
 
-    // does a binary search in the index and returns index of the entry with dbKey
-    // returns UINT_MAX if the key is not contained in index
+    // returns the local id of the entry with dbKey or UINT_MAX if the key is not contained in index
+    // dense keys are resolved through a direct key table, sparse keys by a search in Eytzinger layout
     size_t getId (T dbKey);
 
     // does a binary search in the lookup and returns index of the entry
@@ -141,15 +144,23 @@ public:
         return totalDataSize;
     }
 
+    // removes a text index together with its binary sidecar
+    static void removeIndex(std::string indexName){
+        if (FileUtil::fileExists(indexName.c_str())) {
+            FileUtil::remove(indexName.c_str());
+        }
+        std::string binaryIndex = indexName + ".bin";
+        if (FileUtil::fileExists(binaryIndex.c_str())) {
+            FileUtil::remove(binaryIndex.c_str());
+        }
+    }
+
     static void removeDb(std::string  databaseName){
         std::vector<std::string> files = FileUtil::findDatafiles(databaseName.c_str());
         for (size_t i = 0; i < files.size(); ++i) {
             FileUtil::remove(files[i].c_str());
         }
-        std::string index = databaseName + ".index";
-        if (FileUtil::fileExists(index.c_str())) {
-            FileUtil::remove(index.c_str());
-        }
+        removeIndex(databaseName + ".index");
         std::string dbTypeFile = databaseName + ".dbtype";
         if (FileUtil::fileExists(dbTypeFile.c_str())) {
             FileUtil::remove(dbTypeFile.c_str());
@@ -159,9 +170,14 @@ public:
         if (FileUtil::fileExists(lookupFile.c_str())) {
             FileUtil::remove(lookupFile.c_str());
         }
+        std::string dictFile = databaseName + ".dict";
+        if (FileUtil::fileExists(dictFile.c_str())) {
+            FileUtil::remove(dictFile.c_str());
+        }
     }
 
-    char *mmapData(FILE *file, size_t *dataSize);
+    // attaches to a segment resident in shared memory (see dbd) if there is one for the file
+    char *mmapData(FILE *file, size_t *dataSize, bool *isShared);
 
     bool readIndex(char *data, size_t dataSize, Index *index, unsigned int *entryLength);
 
@@ -186,7 +202,8 @@ public:
     }
 
     Index* getIndex(size_t id) {
-        return index + local2id[id];
+        // identity permutations are not materialized
+        return index + ((local2id != NULL) ? local2id[id] : id);
     }
     
 
@@ -200,6 +217,10 @@ public:
 
     static DBReader<unsigned int> *unserialize(const char* data, int threads);
 
+    // writes the id sorted index of reader as mmapable binary sidecar <indexFileName>.bin
+    // the sidecar is only used as long as the text index is unchanged
+    static void writeBinaryIndex(const char* indexFileName, DBReader<unsigned int> &reader);
+
     static int parseDbType(const char *name);
 
     int getDbtype(){
@@ -298,6 +319,29 @@ private:
 
     void checkClosed();
 
+    bool openBinaryIndex();
+
+    // builds the lookup tables used by getId, requires an index sorted by id
+    void buildKeyLookup();
+    void freeKeyLookup();
+
+    struct BinaryIndexHeader {
+        char magic[8];
+        size_t size;
+        size_t dataSize;
+        unsigned int lastKey;
+        unsigned int maxSeqLen;
+        unsigned int flags;
+        unsigned int padding;
+        // identifies the text index the sidecar was created from
+        size_t indexFileSize;
+        size_t indexInode;
+        long long indexMtimeSec;
+        long long indexMtimeNsec;
+    };
+    static const unsigned int BINARY_INDEX_SORTED_BY_OFFSET = 1;
+    static const unsigned int BINARY_INDEX_LINEAR_ACCESS = 2;
+
 
     int threads;
 
@@ -315,6 +359,8 @@ private:
     size_t dataFileCnt;
     size_t totalDataSize;
     std::vector<std::string> dataFileNames;
+    // data files attached from shared memory
+    std::vector<bool> sharedDataFiles;
 
 
     // summed up size of all entries
@@ -331,6 +377,7 @@ private:
     char ** compressedBuffers;
     size_t * compressedBufferSizes;
     ZSTD_DStream ** dstream;
+    ZSTD_DDict * ddict;
 
     Index * index;
     size_t lookupSize;
@@ -341,6 +388,18 @@ private:
     unsigned int * id2local;
     unsigned int * local2id;
 
+    // key - keyLookupBase -> local id, UINT_MAX for missing keys (dense keys)
+    unsigned int * keyToLocal;
+    T keyLookupBase;
+    size_t keyLookupSize;
+    // 1-based Eytzinger layout of the sorted keys and the local id of each node (sparse keys)
+    T * eytzingerKeys;
+    unsigned int * eytzingerIds;
+
+    // index, seqLens and the LINEAR_ACCCESS permutation point into this mapping if set
+    char * binaryIndexData;
+    size_t binaryIndexSize;
+
     bool dataMapped;
     int accessType;
 
@@ -8,9 +8,12 @@
 #include "Timer.h"
 #include "Parameters.h"
 
+#include <zstd/lib/dictBuilder/zdict.h>
+
 #include <cstdlib>
 #include <cstdio>
 #include <sstream>
+#include <queue>
 #include <unistd.h>
 
 #ifdef OPENMP
@@ -18,7 +21,7 @@
 #endif
 
 DBWriter::DBWriter(const char *dataFileName_, const char *indexFileName_, unsigned int threads, size_t mode, int dbtype)
-        : threads(threads), mode(mode), dbtype(dbtype) {
+        : cdict(NULL), threads(threads), mode(mode), dbtype(dbtype) {
     dataFileName = strdup(dataFileName_);
     indexFileName = strdup(indexFileName_);
 
@@ -214,9 +217,81 @@ void DBWriter::open(size_t bufferSize) {
         }
     }
 
+    if ((mode & Parameters::WRITER_COMPRESSED_MODE) != 0 && dictionary.empty() == false) {
+        cdict = ZSTD_createCDict(dictionary.c_str(), dictionary.size(), COMPRESSION_LEVEL);
+        if (cdict == NULL) {
+            Debug(Debug::ERROR) << "ZSTD_createCDict() error for " << dataFileName << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+    }
+
     closed = false;
 }
 
+void DBWriter::trainDictionary(DBReader<unsigned int> &reader, size_t dictCapacity) {
+    if ((mode & Parameters::WRITER_COMPRESSED_MODE) == 0 || reader.getSize() == 0) {
+        return;
+    }
+
+    // zstd recommends about a hundred times the dictionary size as training input
+    const size_t sampleBudget = 100 * dictCapacity;
+    // larger entries compress well on their own and would only crowd out other samples
+    const size_t maxSampleSize = 128 * 1024;
+    const size_t stride = std::max(static_cast<size_t>(1), reader.getDataSize() / sampleBudget);
+
+    std::string samples;
+    std::vector<size_t> sampleSizes;
+    for (size_t id = 0; id < reader.getSize() && samples.size() < sampleBudget; id += stride) {
+        size_t length = reader.getSeqLens(id);
+        if (length <= 1) {
+            continue;
+        }
+        length = std::min(length - 1, maxSampleSize);
+        samples.append(reader.getData(id, 0), length);
+        sampleSizes.push_back(length);
+    }
+
+    char *buffer = new char[dictCapacity];
+    size_t dictSize = ZDICT_trainFromBuffer(buffer, dictCapacity, samples.c_str(), sampleSizes.data(), sampleSizes.size());
+    if (ZDICT_isError(dictSize)) {
+        Debug(Debug::WARNING) << "Can not train compression dictionary for " << dataFileName << ": "
+                              << ZDICT_getErrorName(dictSize) << ". Compressing without dictionary.\n";
+    } else {
+        Debug(Debug::INFO) << "Trained compression dictionary of " << dictSize << " bytes on " << sampleSizes.size() << " entries\n";
+        dictionary.assign(buffer, dictSize);
+    }
+    delete[] buffer;
+}
+
+void DBWriter::writeDictionaryFile(const char* path, const std::string &dictionary) {
+    std::string name = std::string(path) + ".dict";
+    if (dictionary.empty()) {
+        // a stale dictionary would not match the newly compressed entries
+        if (FileUtil::fileExists(name.c_str())) {
+            FileUtil::remove(name.c_str());
+        }
+        return;
+    }
+
+    FILE* file = FileUtil::openAndDelete(name.c_str(), "wb");
+    size_t written = fwrite(dictionary.c_str(), sizeof(char), dictionary.size(), file);
+    if (written != dictionary.size()) {
+        Debug(Debug::ERROR) << "Can not write to dictionary file " << name << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    fclose(file);
+}
+
+void DBWriter::linkDictionaryFile(const std::string &source, const std::string &target) {
+    std::string sourceDict = source + ".dict";
+    std::string targetDict = target + ".dict";
+    if (FileUtil::fileExists(sourceDict.c_str())) {
+        FileUtil::symlinkAbs(sourceDict, targetDict);
+    } else if (FileUtil::fileExists(targetDict.c_str())) {
+        FileUtil::remove(targetDict.c_str());
+    }
+}
+
 void DBWriter::writeDbtypeFile(const char* path, int dbtype, bool isCompressed) {
     if (dbtype == Parameters::DBTYPE_OMIT_FILE) {
         return;
@@ -247,6 +322,8 @@ void DBWriter::close(bool merge) {
             free(threadBuffer[i]);
             ZSTD_freeCStream(cstream[i]);
         }
+        ZSTD_freeCDict(cdict);
+        cdict = NULL;
     }
 
     if(merge == true) {
@@ -260,6 +337,9 @@ void DBWriter::close(bool merge) {
     }
 
     writeDbtypeFile(dataFileName, dbtype, (mode & Parameters::WRITER_COMPRESSED_MODE) != 0);
+    if ((mode & Parameters::WRITER_COMPRESSED_MODE) != 0) {
+        writeDictionaryFile(dataFileName, dictionary);
+    }
 
     for (unsigned int i = 0; i < threads; i++) {
         delete [] dataFilesBuffer[i];
@@ -279,8 +359,8 @@ void DBWriter::writeStart(unsigned int thrIdx) {
     if((mode & Parameters::WRITER_COMPRESSED_MODE) != 0){
         state[thrIdx] = INIT_STATE;
         threadBufferOffset[thrIdx]=0;
-        int cLevel = 3;
-        size_t const initResult = ZSTD_initCStream(cstream[thrIdx], cLevel);
+        size_t const initResult = (cdict != NULL) ? ZSTD_initCStream_usingCDict(cstream[thrIdx], cdict)
+                                                  : ZSTD_initCStream(cstream[thrIdx], COMPRESSION_LEVEL);
         if (ZSTD_isError(initResult)) {
             Debug(Debug::ERROR) << "ZSTD_initCStream() error in thread " << thrIdx << ". Error "
                                 << ZSTD_getErrorName(initResult) << "\n";
@@ -296,7 +376,8 @@ size_t DBWriter::writeAdd(const char* data, size_t dataSize, unsigned int thrIdx
         EXIT(EXIT_FAILURE);
     }
     bool isCompressedDB = (mode & Parameters::WRITER_COMPRESSED_MODE) != 0;
-    if(isCompressedDB && state[thrIdx] == INIT_STATE && dataSize < 60){
+    // with a dictionary even short entries compress well
+    if(isCompressedDB && state[thrIdx] == INIT_STATE && dataSize < ((cdict != NULL) ? 16 : 60)){
         state[thrIdx] = NOTCOMPRESSED;
     }
     size_t totalWriten = 0;
@@ -548,33 +629,22 @@ void DBWriter::mergeResultsNormal(const char *outFileName, const char *outFileNa
     Timer timer;
     // merge results from each thread into one result file
     if (fileCount > 1) {
-        FILE *outFile = fopen(outFileName, "w");
-        FILE **infiles = new FILE *[fileCount];
         std::vector<size_t> threadDataFileSizes;
         for (unsigned int i = 0; i < fileCount; i++) {
-            infiles[i] = fopen(dataFileNames[i], "r");
-            if (infiles[i] == NULL) {
-                Debug(Debug::ERROR) << "Can not open result file " << dataFileNames[i] << "!\n";
-                EXIT(EXIT_FAILURE);
-            }
-            struct stat sb;
-            if (fstat(fileno(infiles[i]), &sb) < 0) {
-                int errsv = errno;
-                Debug(Debug::ERROR) << "Failed to fstat file " << dataFileNames[i] << ". Error " << errsv << ".\n";
-                EXIT(EXIT_FAILURE);
-            }
-            threadDataFileSizes.push_back(sb.st_size);
+            threadDataFileSizes.push_back(FileUtil::getFileSize(dataFileNames[i]));
         }
-        Concat::concatFiles(infiles, fileCount, outFile);
+        concatDataFiles(outFileName, dataFileNames, threadDataFileSizes, fileCount);
         for (unsigned int i = 0; i < fileCount; i++) {
-            fclose(infiles[i]);
             if (std::remove(dataFileNames[i]) != 0) {
                 Debug(Debug::WARNING) << "Can not remove file " << dataFileNames[i] << "\n";
             }
         }
-        delete[] infiles;
-        fclose(outFile);
 
+        if (lexicographicOrder == false) {
+            mergeSortedIndices(outFileNameIndex, indexFileNames, threadDataFileSizes, fileCount);
+            Debug(Debug::INFO) << "Time for merging files: " << timer.lap() << "\n";
+            return;
+        }
         // merge index
         mergeIndex(indexFileNames, threadDataFileSizes, fileCount);
     } else {
@@ -589,6 +659,174 @@ void DBWriter::mergeResultsNormal(const char *outFileName, const char *outFileNa
     Debug(Debug::INFO) << "Time for merging files: " << timer.lap() << "\n";
 }
 
+void DBWriter::concatDataFiles(const char *outFileName, const char **dataFileNames,
+                               const std::vector<size_t> &dataFileSizes, const unsigned long fileCount) {
+    int outFd = ::open(outFileName, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+    if (outFd == -1) {
+        Debug(Debug::ERROR) << "Can not open result file " << outFileName << "!\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    std::vector<size_t> fileOffsets(fileCount, 0);
+    for (unsigned long i = 1; i < fileCount; i++) {
+        fileOffsets[i] = fileOffsets[i - 1] + dataFileSizes[i - 1];
+    }
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (unsigned long i = 0; i < fileCount; i++) {
+        int inFd = ::open(dataFileNames[i], O_RDONLY);
+        if (inFd == -1) {
+            Debug(Debug::ERROR) << "Can not open result file " << dataFileNames[i] << "!\n";
+            EXIT(EXIT_FAILURE);
+        }
+#if HAVE_POSIX_FADVISE
+        if (posix_fadvise(inFd, 0, 0, POSIX_FADV_SEQUENTIAL) != 0) {
+            Debug(Debug::ERROR) << "posix_fadvise returned an error\n";
+        }
+#endif
+        if (Concat::copyFileRange(inFd, outFd, dataFileSizes[i], fileOffsets[i]) == false) {
+            Debug(Debug::ERROR) << "Can not copy " << dataFileNames[i] << " to " << outFileName << "!\n";
+            EXIT(EXIT_FAILURE);
+        }
+        ::close(inFd);
+    }
+
+    if (::close(outFd) != 0) {
+        Debug(Debug::ERROR) << "Can not close result file " << outFileName << "!\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
+
+static bool compareIndexById(const DBReader<unsigned int>::Index &x, const DBReader<unsigned int>::Index &y) {
+    return x.id < y.id;
+}
+
+void DBWriter::mergeSortedIndices(const char *outFileNameIndex, const char **indexFileNames,
+                                  const std::vector<size_t> &dataFileSizes, const unsigned long fileCount) {
+    typedef DBReader<unsigned int>::Index Index;
+    std::vector<DBReader<unsigned int> *> runs(fileCount);
+    // each run is sorted by key when opened
+#pragma omp parallel for schedule(dynamic, 1)
+    for (unsigned long i = 0; i < fileCount; i++) {
+        runs[i] = new DBReader<unsigned int>(indexFileNames[i], indexFileNames[i], 1, DBReader<unsigned int>::USE_INDEX);
+        runs[i]->open(DBReader<unsigned int>::NOSORT);
+    }
+
+    std::vector<size_t> fileOffsets(fileCount, 0);
+    size_t totalSize = runs[0]->getSize();
+    for (unsigned long i = 1; i < fileCount; i++) {
+        fileOffsets[i] = fileOffsets[i - 1] + dataFileSizes[i - 1];
+        totalSize += runs[i]->getSize();
+    }
+
+    unsigned int threads = 1;
+#ifdef OPENMP
+    threads = omp_get_max_threads();
+#endif
+    // split the key space into one partition per thread, the splitters come from a sample of all keys
+    const size_t partitionCount = std::max(1u, std::min(threads, static_cast<unsigned int>(totalSize / 1024 + 1)));
+    std::vector<unsigned int> sample;
+    for (unsigned long i = 0; i < fileCount; i++) {
+        size_t step = std::max(static_cast<size_t>(1), runs[i]->getSize() / (partitionCount * 16));
+        for (size_t j = 0; j < runs[i]->getSize(); j += step) {
+            sample.push_back(runs[i]->getIndex()[j].id);
+        }
+    }
+    std::sort(sample.begin(), sample.end());
+    // bounds[p * fileCount + i] is the first entry of run i in partition p
+    std::vector<size_t> bounds((partitionCount + 1) * fileCount);
+    std::vector<size_t> partitionStarts(partitionCount + 1, 0);
+    for (size_t p = 0; p <= partitionCount; p++) {
+        for (unsigned long i = 0; i < fileCount; i++) {
+            size_t bound = runs[i]->getSize();
+            if (p == 0) {
+                bound = 0;
+            } else if (p < partitionCount) {
+                Index splitter;
+                splitter.id = sample[(p * sample.size()) / partitionCount];
+                bound = std::lower_bound(runs[i]->getIndex(), runs[i]->getIndex() + runs[i]->getSize(), splitter, compareIndexById) - runs[i]->getIndex();
+            }
+            bounds[p * fileCount + i] = bound;
+            partitionStarts[p] += bound;
+        }
+    }
+
+    Index *index = new Index[totalSize];
+    unsigned int *seqLens = new unsigned int[totalSize];
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t p = 0; p < partitionCount; p++) {
+        // min heap of the current key of each run, ties are resolved by the run number
+        std::priority_queue<std::pair<unsigned int, unsigned long>,
+                std::vector<std::pair<unsigned int, unsigned long> >,
+                std::greater<std::pair<unsigned int, unsigned long> > > heads;
+        std::vector<size_t> positions(fileCount);
+        for (unsigned long i = 0; i < fileCount; i++) {
+            positions[i] = bounds[p * fileCount + i];
+            if (positions[i] < bounds[(p + 1) * fileCount + i]) {
+                heads.push(std::make_pair(runs[i]->getIndex()[positions[i]].id, i));
+            }
+        }
+        size_t out = partitionStarts[p];
+        while (heads.empty() == false) {
+            unsigned long i = heads.top().second;
+            heads.pop();
+            index[out].id = runs[i]->getIndex()[positions[i]].id;
+            index[out].offset = runs[i]->getIndex()[positions[i]].offset + fileOffsets[i];
+            seqLens[out] = runs[i]->getSeqLens()[positions[i]];
+            out++;
+            positions[i]++;
+            if (positions[i] < bounds[(p + 1) * fileCount + i]) {
+                heads.push(std::make_pair(runs[i]->getIndex()[positions[i]].id, i));
+            }
+        }
+    }
+
+    size_t dataSize = 0;
+    unsigned int maxSeqLen = 0;
+    for (unsigned long i = 0; i < fileCount; i++) {
+        dataSize += runs[i]->getDataSize();
+        runs[i]->close();
+        delete runs[i];
+        FileUtil::remove(indexFileNames[i]);
+    }
+    for (size_t i = 0; i < totalSize; i++) {
+        maxSeqLen = std::max(maxSeqLen, seqLens[i]);
+    }
+
+    // format blocks of the index in parallel and write them in order
+    FILE *indexFile = FileUtil::openAndDelete(outFileNameIndex, "w");
+    const size_t blockSize = 1024 * 1024;
+    std::vector<std::string> buffers(threads);
+    for (size_t blockStart = 0; blockStart < totalSize; blockStart += threads * blockSize) {
+#pragma omp parallel for schedule(static, 1)
+        for (unsigned int t = 0; t < threads; t++) {
+            char buffer[1024];
+            buffers[t].clear();
+            size_t start = std::min(totalSize, blockStart + t * blockSize);
+            size_t end = std::min(totalSize, start + blockSize);
+            for (size_t i = start; i < end; i++) {
+                size_t len = indexToBuffer(buffer, index[i].id, index[i].offset, seqLens[i]);
+                buffers[t].append(buffer, len);
+            }
+        }
+        for (unsigned int t = 0; t < threads; t++) {
+            if (fwrite(buffers[t].c_str(), sizeof(char), buffers[t].size(), indexFile) != buffers[t].size()) {
+                Debug(Debug::ERROR) << "Can not write to index file " << outFileNameIndex << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+        }
+    }
+    fclose(indexFile);
+
+    unsigned int lastKey = (totalSize > 0) ? index[totalSize - 1].id : 0;
+    DBReader<unsigned int> reader(index, seqLens, totalSize, dataSize, lastKey, Parameters::DBTYPE_GENERIC_DB, maxSeqLen, 1);
+    reader.open(DBReader<unsigned int>::NOSORT);
+    DBReader<unsigned int>::writeBinaryIndex(outFileNameIndex, reader);
+    reader.close();
+    delete[] seqLens;
+    delete[] index;
+}
+
 void DBWriter::mergeIndex(const char **indexFileNames,
                           std::vector<size_t> threadDataFileSizes,
                          const unsigned long fileCount){
@@ -643,9 +881,13 @@ void DBWriter::mergeResultsIndexOnly(const char *outFileName, const char *outFil
             threadDataFileSizes.push_back(sb.st_size);
             fclose(infile);
         }
-        mergeIndex(indexFileNames, threadDataFileSizes, fileCount);
-        DBWriter::sortIndex(indexFileNames[0], outFileNameIndex, lexicographicOrder);
-        FileUtil::remove(indexFileNames[0]);
+        if (lexicographicOrder == false) {
+            mergeSortedIndices(outFileNameIndex, indexFileNames, threadDataFileSizes, fileCount);
+        } else {
+            mergeIndex(indexFileNames, threadDataFileSizes, fileCount);
+            DBWriter::sortIndex(indexFileNames[0], outFileNameIndex, lexicographicOrder);
+            FileUtil::remove(indexFileNames[0]);
+        }
     } else {
         if (std::rename(dataFileNames[0], outFileName) != 0) {
             Debug(Debug::ERROR) << "Can not move result " << dataFileNames[0] << " to final location " << outFileName << "!\n";
@@ -672,6 +914,7 @@ void DBWriter::sortIndex(const char *inFileNameIndex, const char *outFileNameInd
         FILE *index_file  = FileUtil::openAndDelete(outFileNameIndex, "w");
         writeIndex(index_file, indexReader.getSize(), index, indexReader.getSeqLens());
         fclose(index_file);
+        DBReader<unsigned int>::writeBinaryIndex(outFileNameIndex, indexReader);
         indexReader.close();
 
     } else {
@@ -682,6 +925,11 @@ void DBWriter::sortIndex(const char *inFileNameIndex, const char *outFileNameInd
         writeIndex(index_file, indexReader.getSize(), index, indexReader.getSeqLens());
         fclose(index_file);
         indexReader.close();
+        // lexicographically sorted indices have no binary sidecar
+        std::string binaryIndexFile = std::string(outFileNameIndex) + ".bin";
+        if (FileUtil::fileExists(binaryIndexFile.c_str())) {
+            FileUtil::remove(binaryIndexFile.c_str());
+        }
     }
 }
 
@@ -25,6 +25,10 @@ public:
 
     void open(size_t bufferSize = 64 * 1024 * 1024);
 
+    // trains a zstd dictionary on a sample of the entries in reader
+    // must be called before open, the dictionary is written next to the data file as <data>.dict
+    void trainDictionary(DBReader<unsigned int> &reader, size_t dictCapacity = 112640);
+
     void close(bool merge = false);
 
     char* getDataFileName() { return dataFileName; }
@@ -59,6 +63,15 @@ public:
     static void mergeIndex(const char **indexFileNames, std::vector<size_t> threadDataFileSizes,
                            const unsigned long fileCount);
 
+    // copies the data files into one file in parallel, each starts at the summed size of the files before it
+    static void concatDataFiles(const char *outFileName, const char **dataFileNames,
+                                const std::vector<size_t> &dataFileSizes, const unsigned long fileCount);
+
+    // merges the per-thread indices with a parallel k-way merge into one index sorted by key
+    // offsets of file i are shifted by the summed size of the data files before it
+    static void mergeSortedIndices(const char *outFileNameIndex, const char **indexFileNames,
+                                   const std::vector<size_t> &dataFileSizes, const unsigned long fileCount);
+
     static void sortIndex(const char *inFileNameIndex, const char *outFileNameIndex, const bool lexicographicOrder);
 
 
@@ -72,6 +85,11 @@ public:
 
     static void writeDbtypeFile(const char* path, int dbtype, bool isCompressed);
 
+    static void writeDictionaryFile(const char* path, const std::string &dictionary);
+
+    // entries copied or linked without decompressing them need the dictionary of their source database
+    static void linkDictionaryFile(const std::string &source, const std::string &target);
+
     size_t getStart(unsigned int threadIdx){
         return starts[threadIdx];
     }
@@ -114,8 +132,11 @@ private:
     static const int INIT_STATE=0;
     static const int NOTCOMPRESSED=1;
     static const int COMPRESSED=2;
+    static const int COMPRESSION_LEVEL=3;
 
     ZSTD_CStream** cstream;
+    std::string dictionary;
+    ZSTD_CDict* cdict;
 
     const unsigned int threads;
     const size_t mode;
@@ -0,0 +1,370 @@
+#include "DecompressionStream.h"
+#include "FileUtil.h"
+#include "Debug.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+// large enough for many BGZF blocks or zstd frames of the usual parallel compressors
+static const size_t INPUT_BUFFER_SIZE = 16 * 1024 * 1024;
+
+static unsigned int readLittleEndian32(const unsigned char *data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<unsigned int>(data[3]) << 24);
+}
+
+int DecompressionStream::detectFormat(const std::string &file) {
+    FILE *handle = FileUtil::openFileOrDie(file.c_str(), "rb", true);
+    unsigned char header[18];
+    size_t bytes = fread(header, 1, sizeof(header), handle);
+    fclose(handle);
+
+    if (bytes >= 2 && header[0] == 0x1f && header[1] == 0x8b) {
+        // a BGZF block is a gzip member with a BC extra field
+        if (bytes == sizeof(header) && (header[3] & 4) != 0 && header[12] == 'B' && header[13] == 'C') {
+            return FORMAT_BGZF;
+        }
+        return FORMAT_GZIP;
+    }
+    if (bytes >= 4) {
+        unsigned int magic = readLittleEndian32(header);
+        if (magic == ZSTD_MAGICNUMBER || (magic & 0xFFFFFFF0) == ZSTD_MAGIC_SKIPPABLE_START) {
+            return FORMAT_ZSTD;
+        }
+    }
+    return FORMAT_NONE;
+}
+
+DecompressionStream::DecompressionStream(const std::string &name, int format) :
+        fileName(name), format(format), inputPos(0), inputEnd(0), inputEof(false), readPos(0), finished(false),
+        zstdStream(NULL), inZstdFrame(false) {
+#ifndef HAVE_ZLIB
+    if (format == FORMAT_GZIP || format == FORMAT_BGZF) {
+        Debug(Debug::ERROR) << "MMseqs was not compiled with zlib support. Can not read compressed input!\n";
+        EXIT(EXIT_FAILURE);
+    }
+#else
+    memset(&gzipStream, 0, sizeof(z_stream));
+    if (format == FORMAT_GZIP && inflateInit2(&gzipStream, 15 + 32) != Z_OK) {
+        Debug(Debug::ERROR) << "Can not initialize gzip decompression for " << fileName << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+#endif
+    if (format == FORMAT_ZSTD) {
+        zstdStream = ZSTD_createDStream();
+    }
+    file = FileUtil::openFileOrDie(fileName.c_str(), "rb", true);
+    input.resize(INPUT_BUFFER_SIZE);
+}
+
+DecompressionStream::~DecompressionStream() {
+#ifdef HAVE_ZLIB
+    if (format == FORMAT_GZIP) {
+        inflateEnd(&gzipStream);
+    }
+#endif
+    if (zstdStream != NULL) {
+        ZSTD_freeDStream(zstdStream);
+    }
+    fclose(file);
+}
+
+size_t DecompressionStream::refillInput() {
+    if (inputPos > 0) {
+        memmove(&input[0], &input[inputPos], inputEnd - inputPos);
+        inputEnd -= inputPos;
+        inputPos = 0;
+    }
+    if (inputEof || inputEnd == input.size()) {
+        return 0;
+    }
+    size_t bytes = fread(&input[inputEnd], 1, input.size() - inputEnd, file);
+    if (bytes < input.size() - inputEnd) {
+        if (ferror(file)) {
+            Debug(Debug::ERROR) << "Can not read " << fileName << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        inputEof = true;
+    }
+    inputEnd += bytes;
+    return bytes;
+}
+
+bool DecompressionStream::fill(std::string &buffer, size_t size) {
+    const size_t target = buffer.size() + size;
+    if (pending.empty() == false) {
+        buffer.append(pending);
+        pending.clear();
+    }
+    if (finished == false && buffer.size() < target) {
+        switch (format) {
+#ifdef HAVE_ZLIB
+            case FORMAT_GZIP:
+                fillGzip(buffer, target);
+                break;
+            case FORMAT_BGZF:
+                fillBgzf(buffer, target);
+                break;
+#endif
+            case FORMAT_ZSTD:
+                fillZstd(buffer, target);
+                break;
+            default:
+                Debug(Debug::ERROR) << "Unknown compression format of " << fileName << "\n";
+                EXIT(EXIT_FAILURE);
+        }
+    }
+    return finished == false;
+}
+
+size_t DecompressionStream::read(char *buffer, size_t size) {
+    // kseq takes a short read as the end of the input
+    size_t bytes = 0;
+    while (bytes < size) {
+        if (readPos == readBuffer.size()) {
+            readBuffer.clear();
+            readPos = 0;
+            fill(readBuffer, 1024 * 1024);
+            if (readBuffer.empty()) {
+                break;
+            }
+        }
+        size_t available = std::min(size - bytes, readBuffer.size() - readPos);
+        memcpy(buffer + bytes, readBuffer.data() + readPos, available);
+        readPos += available;
+        bytes += available;
+    }
+    return bytes;
+}
+
+void DecompressionStream::unread(const char *data, size_t size) {
+    std::string rest(data, size);
+    rest.append(readBuffer, readPos, std::string::npos);
+    rest.append(pending);
+    pending.swap(rest);
+    readBuffer.clear();
+    readPos = 0;
+}
+
+#ifdef HAVE_ZLIB
+bool DecompressionStream::fillGzip(std::string &buffer, size_t target) {
+    while (buffer.size() < target) {
+        if (inputPos == inputEnd && refillInput() == 0) {
+            if (gzipStream.total_in > 0) {
+                Debug(Debug::ERROR) << "Unexpected end of gzip file " << fileName << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            finished = true;
+            break;
+        }
+        const size_t oldSize = buffer.size();
+        buffer.resize(target);
+        gzipStream.next_in = (Bytef *) &input[inputPos];
+        gzipStream.avail_in = inputEnd - inputPos;
+        gzipStream.next_out = (Bytef *) &buffer[oldSize];
+        gzipStream.avail_out = target - oldSize;
+        int result = inflate(&gzipStream, Z_NO_FLUSH);
+        buffer.resize(target - gzipStream.avail_out);
+        inputPos = inputEnd - gzipStream.avail_in;
+        if (result == Z_STREAM_END) {
+            // gzip files can consist of several concatenated members
+            if (inputPos == inputEnd && refillInput() == 0) {
+                finished = true;
+                break;
+            }
+            inflateReset(&gzipStream);
+        } else if (result != Z_OK && result != Z_BUF_ERROR) {
+            Debug(Debug::ERROR) << "Can not decompress " << fileName << ": " << (gzipStream.msg != NULL ? gzipStream.msg : "") << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+    }
+    return finished == false;
+}
+
+bool DecompressionStream::fillBgzf(std::string &buffer, size_t target) {
+    struct Block {
+        size_t compressedOffset;
+        size_t compressedSize;
+        size_t offset;
+        unsigned int size;
+        unsigned int crc;
+    };
+    // collect whole blocks until their uncompressed sizes reach the target, they are independent of each other
+    std::vector<Block> blocks;
+    std::vector<char> compressed;
+    size_t outSize = buffer.size();
+    while (outSize < target) {
+        if (inputEnd - inputPos < 18) {
+            refillInput();
+            if (inputPos == inputEnd) {
+                finished = true;
+                break;
+            }
+        }
+        const unsigned char *header = (const unsigned char *) &input[inputPos];
+        size_t blockSize = 0;
+        size_t extraSize = 0;
+        if (inputEnd - inputPos >= 18 && header[0] == 0x1f && header[1] == 0x8b && header[2] == 8 && (header[3] & 4) != 0) {
+            extraSize = header[10] | (header[11] << 8);
+            for (size_t pos = 12; pos + 6 <= 12 + extraSize && pos + 6 <= inputEnd - inputPos; pos += 4 + (header[pos + 2] | (header[pos + 3] << 8))) {
+                if (header[pos] == 'B' && header[pos + 1] == 'C') {
+                    blockSize = (header[pos + 4] | (header[pos + 5] << 8)) + 1;
+                    break;
+                }
+            }
+        }
+        if (blockSize < 12 + extraSize + 8) {
+            Debug(Debug::ERROR) << fileName << " is not a valid BGZF file\n";
+            EXIT(EXIT_FAILURE);
+        }
+        if (inputEnd - inputPos < blockSize) {
+            refillInput();
+            if (inputEnd - inputPos < blockSize) {
+                Debug(Debug::ERROR) << "Unexpected end of BGZF file " << fileName << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            header = (const unsigned char *) &input[inputPos];
+        }
+
+        Block block;
+        block.compressedOffset = compressed.size();
+        block.compressedSize = blockSize - 12 - extraSize - 8;
+        block.offset = outSize;
+        block.crc = readLittleEndian32(header + blockSize - 8);
+        block.size = readLittleEndian32(header + blockSize - 4);
+        compressed.insert(compressed.end(), header + 12 + extraSize, header + 12 + extraSize + block.compressedSize);
+        blocks.push_back(block);
+        outSize += block.size;
+        inputPos += blockSize;
+    }
+    if (blocks.empty()) {
+        return finished == false;
+    }
+
+    buffer.resize(outSize);
+    char *out = &buffer[0];
+    const char *compressedData = compressed.empty() ? NULL : &compressed[0];
+    const Block *blockData = &blocks[0];
+    const std::string *name = &fileName;
+#pragma omp taskgroup
+    {
+        for (size_t i = 0; i < blocks.size(); i++) {
+#pragma omp task firstprivate(i, out, compressedData, blockData, name)
+            {
+                const Block &block = blockData[i];
+                z_stream stream;
+                memset(&stream, 0, sizeof(z_stream));
+                inflateInit2(&stream, -15);
+                stream.next_in = (Bytef *) (compressedData + block.compressedOffset);
+                stream.avail_in = block.compressedSize;
+                stream.next_out = (Bytef *) (out + block.offset);
+                stream.avail_out = block.size;
+                int result = inflate(&stream, Z_FINISH);
+                inflateEnd(&stream);
+                if (result != Z_STREAM_END || stream.avail_out != 0
+                    || crc32(crc32(0L, Z_NULL, 0), (const Bytef *) (out + block.offset), block.size) != block.crc) {
+                    Debug(Debug::ERROR) << "Corrupt BGZF block in " << *name << "\n";
+                    EXIT(EXIT_FAILURE);
+                }
+            }
+        }
+    }
+    return finished == false;
+}
+#endif
+
+bool DecompressionStream::fillZstd(std::string &buffer, size_t target) {
+    struct Frame {
+        size_t compressedOffset;
+        size_t compressedSize;
+        size_t offset;
+        size_t size;
+    };
+    while (buffer.size() < target) {
+        if (inputPos == inputEnd && refillInput() == 0) {
+            if (inZstdFrame) {
+                Debug(Debug::ERROR) << "Unexpected end of zstd file " << fileName << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            finished = true;
+            break;
+        }
+
+        if (inZstdFrame) {
+            const size_t oldSize = buffer.size();
+            buffer.resize(target);
+            ZSTD_inBuffer in = { &input[inputPos], inputEnd - inputPos, 0 };
+            ZSTD_outBuffer out = { &buffer[0], target, oldSize };
+            size_t result = ZSTD_decompressStream(zstdStream, &out, &in);
+            if (ZSTD_isError(result)) {
+                Debug(Debug::ERROR) << "Can not decompress " << fileName << ": " << ZSTD_getErrorName(result) << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            buffer.resize(out.pos);
+            inputPos += in.pos;
+            if (result == 0) {
+                inZstdFrame = false;
+            }
+            continue;
+        }
+
+        // frames that are complete in the input buffer and store their size are decompressed in parallel
+        std::vector<Frame> frames;
+        size_t pos = inputPos;
+        size_t outSize = buffer.size();
+        while (pos < inputEnd && outSize < target) {
+            size_t frameSize = ZSTD_findFrameCompressedSize(&input[pos], inputEnd - pos);
+            if (ZSTD_isError(frameSize)) {
+                break;
+            }
+            unsigned long long contentSize = ZSTD_getFrameContentSize(&input[pos], inputEnd - pos);
+            if (contentSize == ZSTD_CONTENTSIZE_UNKNOWN || contentSize == ZSTD_CONTENTSIZE_ERROR) {
+                break;
+            }
+            Frame frame;
+            frame.compressedOffset = pos;
+            frame.compressedSize = frameSize;
+            frame.offset = outSize;
+            frame.size = contentSize;
+            frames.push_back(frame);
+            pos += frameSize;
+            outSize += contentSize;
+        }
+        if (frames.empty()) {
+            // wait for the rest of the frame unless the input buffer is full already
+            if (inputEof == false && (inputPos > 0 || inputEnd < input.size())) {
+                refillInput();
+                continue;
+            }
+            ZSTD_initDStream(zstdStream);
+            inZstdFrame = true;
+            continue;
+        }
+
+        buffer.resize(outSize);
+        char *out = &buffer[0];
+        const char *in = &input[0];
+        const Frame *frameData = &frames[0];
+        const std::string *name = &fileName;
+#pragma omp taskgroup
+        {
+            for (size_t i = 0; i < frames.size(); i++) {
+#pragma omp task firstprivate(i, out, in, frameData, name)
+                {
+                    const Frame &frame = frameData[i];
+                    size_t result = ZSTD_decompress(out + frame.offset, frame.size, in + frame.compressedOffset, frame.compressedSize);
+                    if (ZSTD_isError(result) || result != frame.size) {
+                        Debug(Debug::ERROR) << "Corrupt zstd frame in " << *name << "\n";
+                        EXIT(EXIT_FAILURE);
+                    }
+                }
+            }
+        }
+        inputPos = pos;
+    }
+    return finished == false;
+}
@@ -0,0 +1,71 @@
+#ifndef DECOMPRESSIONSTREAM_H
+#define DECOMPRESSIONSTREAM_H
+
+// Decompresses gzip, BGZF and zstd input files into memory buffers.
+// BGZF blocks and zstd frames with a known content size are decompressed on all threads of the enclosing
+// OpenMP team, plain gzip streams on the calling thread. Callers can keep one buffer decompressing in a task
+// while they work on the previous one.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#define ZSTD_STATIC_LINKING_ONLY // ZSTD_findFrameCompressedSize
+#include <zstd/lib/zstd.h>
+
+class DecompressionStream {
+public:
+    static const int FORMAT_NONE = 0;
+    static const int FORMAT_GZIP = 1;
+    static const int FORMAT_BGZF = 2;
+    static const int FORMAT_ZSTD = 3;
+
+    // inspects the magic bytes of a file
+    static int detectFormat(const std::string &file);
+
+    DecompressionStream(const std::string &name, int format);
+    ~DecompressionStream();
+
+    // appends at least size decompressed bytes to buffer, returns false once the input is exhausted
+    bool fill(std::string &buffer, size_t size);
+
+    // returns size bytes unless the input ends
+    size_t read(char *buffer, size_t size);
+
+    // the given bytes are returned again before any further data
+    void unread(const char *data, size_t size);
+
+private:
+    std::string fileName;
+    int format;
+    FILE *file;
+
+    // compressed input
+    std::vector<char> input;
+    size_t inputPos;
+    size_t inputEnd;
+    bool inputEof;
+    size_t refillInput();
+
+    // returned by unread, then by read
+    std::string pending;
+    std::string readBuffer;
+    size_t readPos;
+    bool finished;
+
+#ifdef HAVE_ZLIB
+    z_stream gzipStream;
+    bool fillGzip(std::string &buffer, size_t target);
+    bool fillBgzf(std::string &buffer, size_t target);
+#endif
+
+    ZSTD_DStream *zstdStream;
+    bool inZstdFrame;
+    bool fillZstd(std::string &buffer, size_t target);
+};
+
+#endif
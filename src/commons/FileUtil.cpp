@@ -331,3 +331,11 @@ void FileUtil::move(const char * src, const char * dst) {
     }
 }
 
+
+struct timespec FileUtil::getModificationTime(const struct stat &fileStat) {
+#ifdef __APPLE__
+    return fileStat.st_mtimespec;
+#else
+    return fileStat.st_mtim;
+#endif
+}
@@ -5,6 +5,8 @@
 #include <list>
 #include <string>
 #include <vector>
+#include <ctime>
+#include <sys/stat.h>
 
 class FileUtil {
 
@@ -51,6 +53,9 @@ public:
     static void remove(const char * file);
 
     static void move(const char * src, const char * dst);
+
+    // modification time with nanoseconds, the stat field is named differently on macOS
+    static struct timespec getModificationTime(const struct stat &fileStat);
 };
 
 
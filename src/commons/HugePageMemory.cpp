@@ -0,0 +1,56 @@
+#include "HugePageMemory.h"
+#include "Debug.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+char *HugePageMemory::copy(const char *src, size_t size, size_t *mappedSize) {
+    size_t alignedSize = ((size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+    if (alignedSize == 0) {
+        alignedSize = HUGE_PAGE_SIZE;
+    }
+
+    void *memory = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    memory = mmap(NULL, alignedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    bool explicitPages = (memory != MAP_FAILED);
+    if (memory == MAP_FAILED) {
+        memory = mmap(NULL, alignedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return NULL;
+        }
+#ifdef MADV_HUGEPAGE
+        // has to happen before the first touch so the pages fault in as huge pages
+        madvise(memory, alignedSize, MADV_HUGEPAGE);
+#endif
+    }
+
+    char *dst = static_cast<char *>(memory);
+    // first touch from all threads spreads the pages over the NUMA nodes like the later random accesses
+    const size_t blockSize = HUGE_PAGE_SIZE;
+#pragma omp parallel for schedule(static)
+    for (size_t pos = 0; pos < size; pos += blockSize) {
+        memcpy(dst + pos, src + pos, std::min(blockSize, size - pos));
+    }
+
+    // transparent huge pages could still be swapped out or split by khugepaged
+    if (explicitPages == false && mlock(memory, alignedSize) != 0) {
+        Debug(Debug::INFO) << "Could not lock huge page memory, check ulimit -l\n";
+    }
+
+    Debug(Debug::INFO) << "Copied " << size << " bytes into " << (explicitPages ? "explicit" : "transparent") << " huge pages\n";
+    *mappedSize = alignedSize;
+    return dst;
+}
+
+void HugePageMemory::release(char *memory, size_t mappedSize) {
+    if (memory != NULL) {
+        munmap(memory, mappedSize);
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef HUGEPAGEMEMORY_H
+#define HUGEPAGEMEMORY_H
+
+// Anonymous memory backed by huge pages to reduce TLB misses on large randomly accessed tables.
+// Explicit huge pages (MAP_HUGETLB) are used if the system has reserved enough of them,
+// otherwise transparent huge pages are requested with madvise(MADV_HUGEPAGE).
+
+#include <cstddef>
+
+class HugePageMemory {
+public:
+    // copies size bytes of src into locked huge page memory, returns NULL if no memory could be mapped
+    // mappedSize receives the size that has to be passed to release
+    static char *copy(const char *src, size_t size, size_t *mappedSize);
+
+    static void release(char *memory, size_t mappedSize);
+
+private:
+    static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+};
+
+#endif
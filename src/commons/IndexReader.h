@@ -5,6 +5,8 @@
 #include "Debug.h"
 #include "PrefilteringIndexReader.h"
 
+#include <cstring>
+
 class IndexReader {
 public:
 
@@ -22,7 +24,8 @@ public:
                 PrefilteringIndexData data = PrefilteringIndexReader::getMetadata(index);
                 seqType = data.seqType;
                 bool touchIndex = preloadMode & PRELOAD_INDEX;
-                bool touchData = preloadMode & PRELOAD_DATA;
+                // headers are only read for the entries of a result, they are paged in on first access
+                bool touchData = (preloadMode & PRELOAD_DATA) && (databaseType & (SEQUENCES | SRC_SEQUENCES)) != 0;
                 if (databaseType & SRC_SEQUENCES) {
                     sequenceReader = PrefilteringIndexReader::openNewReader(index,
                             PrefilteringIndexReader::DBR2DATA, PrefilteringIndexReader::DBR2INDEX, dataMode & DBReader<unsigned int>::USE_DATA, threads, touchIndex, touchData);
@@ -41,7 +44,11 @@ public:
                                                                                 PrefilteringIndexReader::HDR1DATA, PrefilteringIndexReader::HDR1INDEX, threads, touchIndex, touchData);
                 }
                 if (sequenceReader == NULL) {
-                    Debug(Debug::INFO) << "Index does not contain plain sequences. Using normal database instead.\n";
+                    if ((databaseType & (SEQUENCES | SRC_SEQUENCES)) == 0) {
+                        Debug(Debug::INFO) << "Index does not contain headers. Using normal database instead.\n";
+                    } else {
+                        Debug(Debug::INFO) << "Index does not contain plain sequences. Using normal database instead.\n";
+                    }
                 }
                 seqType = Parameters::DBTYPE_INDEX_DB;
             } else {
@@ -53,13 +60,16 @@ public:
         }
 
         if (sequenceReader == NULL) {
-            if(databaseType & (HEADERS | SRC_HEADERS)){
-                sequenceReader = new DBReader<unsigned int>((dataName+"_h").c_str(), ((dataName+"_h") + ".index").c_str(), threads, dataMode);
+            // an index without the requested entries falls back to the database it was built from
+            std::string dbName = Parameters::isEqualDbtype(targetDbtype, Parameters::DBTYPE_INDEX_DB) ? databaseName(dataName) : dataName;
+            bool isHeader = (databaseType & (HEADERS | SRC_HEADERS)) != 0;
+            if(isHeader){
+                sequenceReader = new DBReader<unsigned int>((dbName+"_h").c_str(), ((dbName+"_h") + ".index").c_str(), threads, dataMode);
             }else{
-                sequenceReader = new DBReader<unsigned int>(dataName.c_str(), (dataName + ".index").c_str(), threads, dataMode);
+                sequenceReader = new DBReader<unsigned int>(dbName.c_str(), (dbName + ".index").c_str(), threads, dataMode);
             }
             sequenceReader->open(DBReader<unsigned int>::NOSORT);
-            bool touchData = preloadMode & PRELOAD_DATA;
+            bool touchData = (preloadMode & PRELOAD_DATA) && isHeader == false;
             if (touchData) {
                 sequenceReader->readMmapedDataInMemory();
             }
@@ -76,6 +86,18 @@ public:
         return seqType;
     }
 
+    // strips the .idx or .linidx extension of an index
+    static std::string databaseName(const std::string &indexName) {
+        const char *extensions[] = { ".idx", ".linidx" };
+        for (size_t i = 0; i < sizeof(extensions) / sizeof(extensions[0]); i++) {
+            size_t length = strlen(extensions[i]);
+            if (indexName.size() > length && indexName.compare(indexName.size() - length, length, extensions[i]) == 0) {
+                return indexName.substr(0, indexName.size() - length);
+            }
+        }
+        return indexName;
+    }
+
     ~IndexReader() {
         if (sequenceReader != NULL) {
             sequenceReader->close();
@@ -3,7 +3,10 @@
 #include "FileUtil.h"
 #include "Util.h"
 #include "Debug.h"
+#include "DecompressionStream.h"
 #include <unistd.h>
+#include <algorithm>
+#include <cstring>
 
 namespace KSEQFILE {
     KSEQ_INIT(int, read)
@@ -33,6 +36,77 @@ KSeqFile::~KSeqFile() {
     fclose(file);
 }
 
+namespace KSEQBUFFER {
+    int kseq_buffer_reader(KSeqBuffer::stream *data, void *buffer, int size) {
+        size_t bytes = std::min(static_cast<size_t>(size), data->length - data->position);
+        memcpy(buffer, data->buffer + data->position, bytes);
+        data->position += bytes;
+        return static_cast<int>(bytes);
+    }
+
+    KSEQ_INIT(KSeqBuffer::stream*, kseq_buffer_reader)
+}
+
+KSeqBuffer::KSeqBuffer(const char* buffer, size_t length) : qualities(false) {
+    data.buffer = buffer;
+    data.length = length;
+    data.position = 0;
+    seq = (void*) KSEQBUFFER::kseq_init(&data);
+}
+
+bool KSeqBuffer::ReadEntry() {
+    KSEQBUFFER::kseq_t* s = (KSEQBUFFER::kseq_t*) seq;
+    int result = KSEQBUFFER::kseq_read(s);
+    // kseq only resets the header character after reading a quality string
+    if (result == -2 || (result >= 0 && s->last_char == 0)) {
+        qualities = true;
+    }
+    if (result < 0)
+        return false;
+
+    entry.name = s->name;
+    entry.comment = s->comment;
+    entry.sequence = s->seq;
+    entry.qual = s->qual;
+
+    return true;
+}
+
+KSeqBuffer::~KSeqBuffer() {
+    kseq_destroy((KSEQBUFFER::kseq_t*)seq);
+}
+
+namespace KSEQSTREAM {
+    int kseq_stream_reader(DecompressionStream *stream, void *buffer, int size) {
+        return static_cast<int>(stream->read(static_cast<char *>(buffer), size));
+    }
+
+    KSEQ_INIT(DecompressionStream*, kseq_stream_reader)
+}
+
+KSeqStream::KSeqStream(DecompressionStream* stream) : stream(stream) {
+    seq = (void*) KSEQSTREAM::kseq_init(stream);
+}
+
+bool KSeqStream::ReadEntry() {
+    KSEQSTREAM::kseq_t* s = (KSEQSTREAM::kseq_t*) seq;
+    int result = KSEQSTREAM::kseq_read(s);
+    if (result < 0)
+        return false;
+
+    entry.name = s->name;
+    entry.comment = s->comment;
+    entry.sequence = s->seq;
+    entry.qual = s->qual;
+
+    return true;
+}
+
+KSeqStream::~KSeqStream() {
+    kseq_destroy((KSEQSTREAM::kseq_t*)seq);
+    delete stream;
+}
+
 #ifdef HAVE_ZLIB
 namespace KSEQGZIP {
     KSEQ_INIT(gzFile, gzread)
@@ -118,9 +192,12 @@ KSeqBzip::~KSeqBzip() {
 
 KSeqWrapper* KSeqFactory(const char* file) {
     KSeqWrapper* kseq = NULL;
-    if(Util::endsWith(".gz", file) == false && Util::endsWith(".bz2", file) == false ) {
+    if(Util::endsWith(".gz", file) == false && Util::endsWith(".bz2", file) == false && Util::endsWith(".zst", file) == false) {
         kseq = new KSeqFile(file);
     }
+    else if(Util::endsWith(".zst", file) == true) {
+        kseq = new KSeqStream(new DecompressionStream(file, DecompressionStream::FORMAT_ZSTD));
+    }
 #ifdef HAVE_ZLIB
     else if(Util::endsWith(".gz", file) == true) {
         kseq = new KSeqGzip(file);
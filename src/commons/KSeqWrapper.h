@@ -29,6 +29,39 @@ private:
     FILE* file;
 };
 
+class KSeqBuffer : public KSeqWrapper {
+public:
+    KSeqBuffer(const char* buffer, size_t length);
+    bool ReadEntry();
+    ~KSeqBuffer();
+
+    // true once an entry was read as FASTQ, the input can not be split at FASTA headers then
+    bool hasQualities() {
+        return qualities;
+    }
+
+    struct stream {
+        const char* buffer;
+        size_t length;
+        size_t position;
+    };
+private:
+    stream data;
+    bool qualities;
+};
+
+class DecompressionStream;
+
+class KSeqStream : public KSeqWrapper {
+public:
+    // takes ownership of the stream
+    KSeqStream(DecompressionStream* stream);
+    bool ReadEntry();
+    ~KSeqStream();
+private:
+    DecompressionStream* stream;
+};
+
 #ifdef HAVE_ZLIB
 #include <zlib.h>
 
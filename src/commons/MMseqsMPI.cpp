@@ -7,10 +7,28 @@ int MMseqsMPI::rank = -1;
 int MMseqsMPI::numProc = -1;
 
 #ifdef HAVE_MPI
+MPI_Comm MMseqsMPI::nodeComm = MPI_COMM_NULL;
+int MMseqsMPI::nodeRank = -1;
+int MMseqsMPI::nodeSize = -1;
+
+static MPI_Win workQueueWin = MPI_WIN_NULL;
+static unsigned long *workQueueCounter = NULL;
+
 void MMseqsMPI::init(int argc, const char **argv) {
-    MPI_Init(&argc, const_cast<char ***>(&argv));
+    // only the master thread of each rank communicates
+    int provided;
+    MPI_Init_thread(&argc, const_cast<char ***>(&argv), MPI_THREAD_FUNNELED, &provided);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &numProc);
+    // OpenMP threads run next to MPI calls of the master thread, e.g. the work queue of the prefilter
+    if (provided < MPI_THREAD_FUNNELED) {
+        Debug(Debug::ERROR) << "The MPI library does not support MPI_THREAD_FUNNELED, provided thread level: " << provided << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodeComm);
+    MPI_Comm_rank(nodeComm, &nodeRank);
+    MPI_Comm_size(nodeComm, &nodeSize);
 
     active = true;
 
@@ -23,6 +41,30 @@ void MMseqsMPI::init(int argc, const char **argv) {
     Debug(Debug::INFO) << "MPI Init\n";
     Debug(Debug::INFO) << "Rank: " << rank << " Size: " << numProc << "\n";
 }
+
+void MMseqsMPI::initWorkQueue() {
+    MPI_Aint size = isMaster() ? sizeof(unsigned long) : 0;
+    MPI_Win_allocate(size, sizeof(unsigned long), MPI_INFO_NULL, MPI_COMM_WORLD, &workQueueCounter, &workQueueWin);
+    if (isMaster()) {
+        *workQueueCounter = 0;
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Win_lock_all(0, workQueueWin);
+}
+
+size_t MMseqsMPI::nextWorkItem(size_t workSize) {
+    unsigned long step = workSize;
+    unsigned long item = 0;
+    MPI_Fetch_and_op(&step, &item, MPI_UNSIGNED_LONG, MASTER, 0, MPI_SUM, workQueueWin);
+    MPI_Win_flush(MASTER, workQueueWin);
+    return item;
+}
+
+void MMseqsMPI::freeWorkQueue() {
+    MPI_Win_unlock_all(workQueueWin);
+    MPI_Win_free(&workQueueWin);
+    workQueueCounter = NULL;
+}
 #else
 void MMseqsMPI::init(int, const char **) {
     rank = 0;
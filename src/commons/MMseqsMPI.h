@@ -14,6 +14,18 @@ public:
     static int numProc;
 
     static void init(int argc, const char **argv);
+
+#ifdef HAVE_MPI
+    // ranks running on the same node
+    static MPI_Comm nodeComm;
+    static int nodeRank;
+    static int nodeSize;
+
+    // work queue held by the master, each call hands out the next workSize items
+    static void initWorkQueue();
+    static size_t nextWorkItem(size_t workSize);
+    static void freeWorkQueue();
+#endif
     static inline bool isMaster() {
 #ifdef HAVE_MPI
         return rank == MASTER;
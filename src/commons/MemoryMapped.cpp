@@ -50,7 +50,8 @@ MemoryMapped::MemoryMapped()
 #ifdef _MSC_VER
         _mappedFile (NULL),
 #endif
-          _mappedView (NULL)
+          _mappedView (NULL),
+          openned(false)
 {
 }
 
@@ -190,6 +191,7 @@ void MemoryMapped::close()
     }
 
     _filesize = 0;
+    openned = false;
 }
 
 
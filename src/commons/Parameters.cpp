@@ -36,6 +36,7 @@ Parameters::Parameters():
         PARAM_EXACT_KMER_MATCHING(PARAM_EXACT_KMER_MATCHING_ID,"--exact-kmer-matching", "Exact k-mer matching", "only exact k-mer matching [0,1]", typeid(int),(void *) &exactKmerMatching, "^[0-1]{1}$", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
         PARAM_MASK_RESIDUES(PARAM_MASK_RESIDUES_ID,"--mask", "Mask residues", "mask sequences in k-mer stage 0: w/o low complexity masking, 1: with low complexity masking", typeid(int),(void *) &maskMode, "^[0-1]{1}", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
         PARAM_MASK_LOWER_CASE(PARAM_MASK_LOWER_CASE_ID,"--mask-lower-case", "Mask lower case residues", "lowercase letters will be excluded from k-mer search 0: include region, 1: exclude region", typeid(int),(void *) &maskLowerCaseMode, "^[0-1]{1}", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_MASK_CACHE(PARAM_MASK_CACHE_ID,"--mask-cache", "Mask cache", "keep the low complexity mask of the target database in <targetDB>.mask and reuse it when the index table is built again 0: mask every time, 1: use the cache", typeid(int),(void *) &maskCache, "^[0-1]{1}", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
         PARAM_MIN_DIAG_SCORE(PARAM_MIN_DIAG_SCORE_ID,"--min-ungapped-score", "Minimum diagonal score", "accept only matches with ungapped alignment score above this threshold", typeid(int),(void *) &minDiagScoreThr, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
         PARAM_K_SCORE(PARAM_K_SCORE_ID,"--k-score", "K-score", "K-mer threshold for generating similar k-mer lists",typeid(int),(void *) &kmerScore,  "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
         PARAM_MAX_SEQS(PARAM_MAX_SEQS_ID,"--max-seqs", "Max results per query", "Maximum result sequences per query allowed to pass the prefilter (this parameter affects sensitivity)",typeid(int),(void *) &maxResListLen, "^[1-9]{1}[0-9]*$", MMseqsParameter::COMMAND_PREFILTER),
@@ -51,8 +52,8 @@ Parameters::Parameters():
         PARAM_SPACED_KMER_MODE(PARAM_SPACED_KMER_MODE_ID,"--spaced-kmer-mode", "Spaced k-mers", "0: use consecutive positions a k-mers; 1: use spaced k-mers",typeid(int), (void *) &spacedKmer,  "^[0-1]{1}", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
         PARAM_REMOVE_TMP_FILES(PARAM_REMOVE_TMP_FILES_ID, "--remove-tmp-files", "Remove temporary files" , "Delete temporary files", typeid(bool), (void *) &removeTmpFiles, "",MMseqsParameter::COMMAND_MISC|MMseqsParameter::COMMAND_EXPERT),
         PARAM_INCLUDE_IDENTITY(PARAM_INCLUDE_IDENTITY_ID,"--add-self-matches", "Include identical seq. id.","artificially add entries of queries with themselves (for clustering)",typeid(bool), (void *) &includeIdentity, "", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
-        PARAM_PRELOAD_MODE(PARAM_PRELOAD_MODE_ID, "--db-load-mode", "Preload mode", "Database preload mode 0: auto, 1: fread, 2: mmap, 3: mmap+touch", typeid(int), (void*) &preloadMode, "[0-3]{1}", MMseqsParameter::COMMAND_MISC|MMseqsParameter::COMMAND_EXPERT),
-        PARAM_SPACED_KMER_PATTERN(PARAM_SPACED_KMER_PATTERN_ID, "--spaced-kmer-pattern", "Spaced k-mer pattern", "User-specified spaced k-mer pattern", typeid(std::string), (void *) &spacedKmerPattern, "^1[01]*1$", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_PRELOAD_MODE(PARAM_PRELOAD_MODE_ID, "--db-load-mode", "Preload mode", "Database preload mode 0: auto, 1: fread, 2: mmap, 3: mmap+touch, 4: mmap+prefetch, 5: huge pages", typeid(int), (void*) &preloadMode, "[0-5]{1}", MMseqsParameter::COMMAND_MISC|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_SPACED_KMER_PATTERN(PARAM_SPACED_KMER_PATTERN_ID, "--spaced-kmer-pattern", "Spaced k-mer pattern", "User-specified spaced k-mer pattern. A comma separated list of patterns with equal k-mer size (e.g. 1101011,1110101) searches all patterns in one pass", typeid(std::string), (void *) &spacedKmerPattern, "^1[01]*1(,1[01]*1)*$", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
         PARAM_LOCAL_TMP(PARAM_LOCAL_TMP_ID, "--local-tmp", "Local temporary path", "Path where some of the temporary files will be created", typeid(std::string), (void *) &localTmp, "", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
         // alignment
         PARAM_ALIGNMENT_MODE(PARAM_ALIGNMENT_MODE_ID,"--alignment-mode", "Alignment mode", "How to compute the alignment: 0: automatic; 1: only score and end_pos; 2: also start_pos and cov; 3: also seq.id; 4: only ungapped alignment",typeid(int), (void *) &alignmentMode, "^[0-4]{1}$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
@@ -64,6 +65,12 @@ Parameters::Parameters():
         PARAM_MAX_ACCEPT(PARAM_MAX_ACCEPT_ID,"--max-accept", "Max accept", "maximum accepted alignments before alignment calculation for a query is stopped",typeid(int),(void *) &maxAccept, "^[1-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN),
         PARAM_ADD_BACKTRACE(PARAM_ADD_BACKTRACE_ID, "-a", "Add backtrace", "add backtrace string (convert to alignments with mmseqs convertalis utility)", typeid(bool), (void *) &addBacktrace, "", MMseqsParameter::COMMAND_ALIGN),
         PARAM_REALIGN(PARAM_REALIGN_ID, "--realign", "Realign hits", "compute more conservative, shorter alignments (scores and E-values not changed)", typeid(bool), (void *) &realign, "", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_TRACEBACK_MODE(PARAM_TRACEBACK_MODE_ID, "--traceback-mode", "Traceback mode", "How to compute start position and backtrace: 0: reverse pass and banded realignment; 1: single pass keeping the scores around the prefilter diagonal (same scores, ties can resolve differently)", typeid(int), (void *) &tracebackMode, "^[0-1]{1}$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_BAND_WIDTH(PARAM_BAND_WIDTH_ID, "--band-width", "Band width", "Align amino acid and profile sequences only within this distance of the prefilter diagonal, widened while the alignment touches the band border, with X-drop termination (0: full matrix)", typeid(int), (void *) &bandWidth, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_PRESCREEN(PARAM_PRESCREEN_ID, "--prescreen", "Prescreen hits", "Score amino acid prefilter hits in batches with 8 bit SIMD and only align those that can reach the E-value threshold (same results)", typeid(bool), (void *) &prescreen, "", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_PROC_COUNT(PARAM_PROC_COUNT_ID, "--proc-count", "Process count", "Number of align processes on this node that share the queries of one run without MPI, start each with its own --proc-id", typeid(int), (void *) &procCount, "^[1-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_PROC_ID(PARAM_PROC_ID_ID, "--proc-id", "Process id", "Id of this align process [0, --proc-count), process 0 merges the results", typeid(int), (void *) &procId, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_FUSED_LCA(PARAM_FUSED_LCA_ID, "--fused-lca", "Fused LCA", "Write the taxonomic LCA of the accepted hits of each query (lca format, --lca-mode 1 or 4) instead of the alignments, the target database needs a taxonomy mapping", typeid(bool), (void *) &fusedLca, "", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
         PARAM_MIN_SEQ_ID(PARAM_MIN_SEQ_ID_ID,"--min-seq-id", "Seq. id. threshold","list matches above this sequence identity (for clustering) [0.0,1.0]",typeid(float), (void *) &seqIdThr, "^0(\\.[0-9]+)?|1(\\.0+)?$", MMseqsParameter::COMMAND_ALIGN),
         PARAM_MIN_ALN_LEN(PARAM_MIN_ALN_LEN_ID,"--min-aln-len", "Min. alignment length","minimum alignment length [0,INT_MAX]",typeid(int), (void *) &alnLenThr, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN),
         PARAM_SCORE_BIAS(PARAM_SCORE_BIAS_ID,"--score-bias", "Score bias", "Score bias when computing the SW alignment (in bits)",typeid(float), (void *) &scoreBias, "^-?[0-9]*(\\.[0-9]+)?$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
@@ -157,6 +164,7 @@ Parameters::Parameters():
         PARAM_USE_ALL_TABLE_STARTS(PARAM_USE_ALL_TABLE_STARTS_ID,"--use-all-table-starts", "Use all table starts", "use all alteratives for a start codon in the genetic table, if false - only ATG (AUG)",typeid(bool),(void *) &useAllTableStarts, ""),
         // indexdb
         PARAM_CHECK_COMPATIBLE(PARAM_CHECK_COMPATIBLE_ID, "--check-compatible", "Check compatible", "skip recreating an index if it is compatible with the specified parameters", typeid(bool), (void*) &checkCompatible, "", MMseqsParameter::COMMAND_MISC),
+        PARAM_INDEX_HEADERS(PARAM_INDEX_HEADERS_ID, "--index-headers", "Index headers", "include the header DBs in the index, without them modules read the _h DBs next to the index", typeid(bool), (void*) &indexHeaders, "", MMseqsParameter::COMMAND_MISC),
         PARAM_SEARCH_TYPE(PARAM_SEARCH_TYPE_ID, "--search-type", "Search type", "search type 0: auto 1: amino acid, 2: translated, 3: nucleotide", typeid(int),(void *) &searchType, "^[0-3]{1}"),
         // createdb
         PARAM_USE_HEADER(PARAM_USE_HEADER_ID,"--use-fasta-header", "Use fasta header", "use the id parsed from the fasta header as the index key instead of using incrementing numeric identifiers",typeid(bool),(void *) &useHeader, ""),
@@ -276,6 +284,16 @@ Parameters::Parameters():
     align.push_back(&PARAM_MAX_SEQ_LEN);
     align.push_back(&PARAM_NO_COMP_BIAS_CORR);
     align.push_back(&PARAM_REALIGN);
+    align.push_back(&PARAM_TRACEBACK_MODE);
+    align.push_back(&PARAM_BAND_WIDTH);
+    align.push_back(&PARAM_PRESCREEN);
+    align.push_back(&PARAM_PROC_COUNT);
+    align.push_back(&PARAM_PROC_ID);
+    align.push_back(&PARAM_FUSED_LCA);
+    align.push_back(&PARAM_LCA_MODE);
+    align.push_back(&PARAM_LCA_RANKS);
+    align.push_back(&PARAM_BLACKLIST);
+    align.push_back(&PARAM_TAXON_ADD_LINEAGE);
     align.push_back(&PARAM_MAX_REJECTED);
     align.push_back(&PARAM_MAX_ACCEPT);
     align.push_back(&PARAM_INCLUDE_IDENTITY);
@@ -309,6 +327,7 @@ Parameters::Parameters():
     prefilter.push_back(&PARAM_EXACT_KMER_MATCHING);
     prefilter.push_back(&PARAM_MASK_RESIDUES);
     prefilter.push_back(&PARAM_MASK_LOWER_CASE);
+    prefilter.push_back(&PARAM_MASK_CACHE);
     prefilter.push_back(&PARAM_MIN_DIAG_SCORE);
     prefilter.push_back(&PARAM_INCLUDE_IDENTITY);
     prefilter.push_back(&PARAM_SPACED_KMER_MODE);
@@ -596,11 +615,13 @@ Parameters::Parameters():
     indexdb.push_back(&PARAM_MAX_SEQ_LEN);
     indexdb.push_back(&PARAM_MASK_RESIDUES);
     indexdb.push_back(&PARAM_MASK_LOWER_CASE);
+    indexdb.push_back(&PARAM_MASK_CACHE);
     indexdb.push_back(&PARAM_SPACED_KMER_MODE);
     indexdb.push_back(&PARAM_SPACED_KMER_PATTERN);
     indexdb.push_back(&PARAM_S);
     indexdb.push_back(&PARAM_K_SCORE);
     indexdb.push_back(&PARAM_CHECK_COMPATIBLE);
+    indexdb.push_back(&PARAM_INDEX_HEADERS);
     indexdb.push_back(&PARAM_SEARCH_TYPE);
     indexdb.push_back(&PARAM_SPLIT);
     indexdb.push_back(&PARAM_SPLIT_MEMORY_LIMIT);
@@ -633,6 +654,7 @@ Parameters::Parameters():
     createdb.push_back(&PARAM_DB_TYPE);
     createdb.push_back(&PARAM_DONT_SHUFFLE);
     createdb.push_back(&PARAM_ID_OFFSET);
+    createdb.push_back(&PARAM_THREADS);
     createdb.push_back(&PARAM_COMPRESSED);
     createdb.push_back(&PARAM_V);
 
@@ -889,6 +911,10 @@ Parameters::Parameters():
     addtaxonomy.push_back(&PARAM_THREADS);
     addtaxonomy.push_back(&PARAM_V);
 
+    // createbintaxonomy
+    createbintaxonomy.push_back(&PARAM_MAPPING_FILE);
+    createbintaxonomy.push_back(&PARAM_V);
+
     // view
     view.push_back(&PARAM_ID_LIST);
     view.push_back(&PARAM_IDX_ENTRY_TYPE);
@@ -993,8 +1019,8 @@ Parameters::Parameters():
     easyclusterworkflow = combineList(clusterworkflow, createdb);
 
     // taxonomy
+    // --lca-mode is part of the align parameters for --fused-lca
     taxonomy = combineList(searchworkflow, lca);
-    taxonomy.push_back(&PARAM_LCA_MODE);
     taxonomy.push_back(&PARAM_TAX_OUTPUT_MODE);
     taxonomy.push_back(&PARAM_USESEQID);
 
@@ -1523,6 +1549,7 @@ void Parameters::setDefaults() {
     exactKmerMatching = 0;
     maskMode = 1;
     maskLowerCaseMode = 0;
+    maskCache = 0;
     minDiagScoreThr = 15;
     spacedKmer = true;
     includeIdentity = false;
@@ -1540,6 +1567,12 @@ void Parameters::setDefaults() {
     gapExtend = 1;
     addBacktrace = false;
     realign = false;
+    tracebackMode = TRACEBACK_MODE_THREE_PASS;
+    bandWidth = 0;
+    prescreen = false;
+    procCount = 1;
+    procId = 0;
+    fusedLca = false;
     clusteringMode = SET_COVER;
     cascaded = true;
     clusterSteps = 3;
@@ -1566,6 +1599,7 @@ void Parameters::setDefaults() {
 
     // indexdb
     checkCompatible = false;
+    indexHeaders = true;
     searchType = SEARCH_TYPE_AUTO;
 
     // createdb
@@ -1857,13 +1891,14 @@ void Parameters::overrideParameterDescription(Command &command, const int uid,
 
 }
 
-std::vector<int> Parameters::getOutputFormat(const std::string &outformat, bool &needSequences, bool &needBacktrace, bool &needFullHeaders) {
+std::vector<int> Parameters::getOutputFormat(const std::string &outformat, bool &needSequences, bool &needBacktrace, bool &needFullHeaders,
+                                             bool &needQueryHeaders, bool &needTargetHeaders) {
     std::vector<std::string> outformatSplit = Util::split(outformat, ",");
     std::vector<int> formatCodes;
     int code = 0;
     for (size_t i = 0; i < outformatSplit.size(); ++i) {
-        if(outformatSplit[i].compare("query") == 0){ code = Parameters::OUTFMT_QUERY;}
-        else if (outformatSplit[i].compare("target") == 0){ code = Parameters::OUTFMT_TARGET;}
+        if(outformatSplit[i].compare("query") == 0){ needQueryHeaders = true; code = Parameters::OUTFMT_QUERY;}
+        else if (outformatSplit[i].compare("target") == 0){ needTargetHeaders = true; code = Parameters::OUTFMT_TARGET;}
         else if (outformatSplit[i].compare("evalue") == 0){ code = Parameters::OUTFMT_EVALUE;}
         else if (outformatSplit[i].compare("gapopen") == 0){ code = Parameters::OUTFMT_GAPOPEN;}
         else if (outformatSplit[i].compare("pident") == 0){ code = Parameters::OUTFMT_PIDENT;}
@@ -1880,8 +1915,8 @@ std::vector<int> Parameters::getOutputFormat(const std::string &outformat, bool
         else if (outformatSplit[i].compare("cigar") == 0){ needBacktrace = true; code = Parameters::OUTFMT_CIGAR;}
         else if (outformatSplit[i].compare("qseq") == 0){ needSequences = true; code = Parameters::OUTFMT_QSEQ;}
         else if (outformatSplit[i].compare("tseq") == 0){ needSequences = true; code = Parameters::OUTFMT_TSEQ;}
-        else if (outformatSplit[i].compare("qheader") == 0){ needFullHeaders = true; code = Parameters::OUTFMT_QHEADER;}
-        else if (outformatSplit[i].compare("theader") == 0){ needFullHeaders = true; code = Parameters::OUTFMT_THEADER;}
+        else if (outformatSplit[i].compare("qheader") == 0){ needFullHeaders = true; needQueryHeaders = true; code = Parameters::OUTFMT_QHEADER;}
+        else if (outformatSplit[i].compare("theader") == 0){ needFullHeaders = true; needTargetHeaders = true; code = Parameters::OUTFMT_THEADER;}
         else if (outformatSplit[i].compare("qaln") == 0){ needBacktrace = true; needSequences = true; code = Parameters::OUTFMT_QALN;}
         else if (outformatSplit[i].compare("taln") == 0){ needBacktrace = true; needSequences = true; code = Parameters::OUTFMT_TALN;}
         else if (outformatSplit[i].compare("qframe") == 0){ code = Parameters::OUTFMT_QFRAME;}
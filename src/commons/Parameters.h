@@ -89,6 +89,9 @@ public:
     static const unsigned int ALIGNMENT_MODE_SCORE_COV_SEQID = 3;
     static const unsigned int ALIGNMENT_MODE_UNGAPPED = 4;
 
+    static const int TRACEBACK_MODE_THREE_PASS = 0;
+    static const int TRACEBACK_MODE_SINGLE_PASS = 1;
+
 
     static const unsigned int WRITER_ASCII_MODE = 0;
     static const unsigned int WRITER_COMPRESSED_MODE = 1;
@@ -128,7 +131,8 @@ public:
     static const int OUTFMT_QCOV = 25;
     static const int OUTFMT_TCOV = 26;
     static const int OUTFMT_EMPTY = 27;
-    static std::vector<int> getOutputFormat(const std::string &outformat, bool &needSequences, bool &needBacktrace, bool &needFullHeaders);
+    static std::vector<int> getOutputFormat(const std::string &outformat, bool &needSequences, bool &needBacktrace, bool &needFullHeaders,
+                                            bool &needQueryHeaders, bool &needTargetHeaders);
 
     // convertprofiledb
     static const int PROFILE_MODE_HMM = 0;
@@ -167,6 +171,14 @@ public:
     static const int PRELOAD_MODE_FREAD = 1;
     static const int PRELOAD_MODE_MMAP = 2;
     static const int PRELOAD_MODE_MMAP_TOUCH = 3;
+    // mmap without touching, upcoming entries are prefetched into the page cache
+    static const int PRELOAD_MODE_MMAP_PREFETCH = 4;
+    // mmap+touch, the prefilter k-mer index and sequence lookup are copied into huge pages
+    static const int PRELOAD_MODE_HUGEPAGES = 5;
+
+    static bool shouldTouchData(int preloadMode) {
+        return preloadMode != PRELOAD_MODE_MMAP && preloadMode != PRELOAD_MODE_MMAP_PREFETCH;
+    }
 
 
     static std::string getSplitModeName(int splitMode) {
@@ -296,6 +308,7 @@ public:
     int    exactKmerMatching;            // only exact k-mer matching
     int    maskMode;                     // mask low complex areas
     int    maskLowerCaseMode;            // maske lowercase letters in prefilter and kmermatchers
+    int    maskCache;                    // keep the low complexity mask of the target database in <db>.mask
 
     int    minDiagScoreThr;              // min diagonal score
     int    spacedKmer;                   // Spaced Kmers
@@ -324,6 +337,12 @@ public:
     int    alnLenThr;                    // min. alignment length
     bool   addBacktrace;                 // store backtrace string (M=Match, D=deletion, I=insertion)
     bool   realign;                      // realign hit with more conservative score
+    int    tracebackMode;                // 0: forward, reverse and banded traceback pass, 1: single pass keeping a band of scores
+    int    bandWidth;                    // 0: full matrix, otherwise initial half width of the band around the prefilter diagonal
+    bool   prescreen;                    // drop prefilter hits by 8 bit scores of many targets at once before aligning them
+    int    procCount;                    // align processes on one node that share the queries without MPI
+    int    procId;                       // id of this align process
+    bool   fusedLca;                     // write the LCA of the hits of each query instead of the alignments
     int    gapOpen;                      // gap open
     int    gapExtend;                    // gap extend
 
@@ -427,6 +446,7 @@ public:
 
     // indexdb
     bool checkCompatible;
+    bool indexHeaders;
     int searchType;
 
     // createdb
@@ -571,6 +591,7 @@ public:
     PARAMETER(PARAM_EXACT_KMER_MATCHING)
     PARAMETER(PARAM_MASK_RESIDUES)
     PARAMETER(PARAM_MASK_LOWER_CASE)
+    PARAMETER(PARAM_MASK_CACHE)
 
     PARAMETER(PARAM_MIN_DIAG_SCORE)
     PARAMETER(PARAM_K_SCORE)
@@ -603,6 +624,12 @@ public:
     PARAMETER(PARAM_MAX_ACCEPT)
     PARAMETER(PARAM_ADD_BACKTRACE)
     PARAMETER(PARAM_REALIGN)
+    PARAMETER(PARAM_TRACEBACK_MODE)
+    PARAMETER(PARAM_BAND_WIDTH)
+    PARAMETER(PARAM_PRESCREEN)
+    PARAMETER(PARAM_PROC_COUNT)
+    PARAMETER(PARAM_PROC_ID)
+    PARAMETER(PARAM_FUSED_LCA)
     PARAMETER(PARAM_MIN_SEQ_ID)
     PARAMETER(PARAM_MIN_ALN_LEN)
     PARAMETER(PARAM_SCORE_BIAS)
@@ -716,6 +743,7 @@ public:
 
     // indexdb
     PARAMETER(PARAM_CHECK_COMPATIBLE)
+    PARAMETER(PARAM_INDEX_HEADERS)
     PARAMETER(PARAM_SEARCH_TYPE)
 
     // createdb
@@ -897,6 +925,7 @@ public:
     std::vector<MMseqsParameter*> tsv2db;
     std::vector<MMseqsParameter*> lca;
     std::vector<MMseqsParameter*> addtaxonomy;
+    std::vector<MMseqsParameter*> createbintaxonomy;
     std::vector<MMseqsParameter*> filtertaxdb;
     std::vector<MMseqsParameter*> taxonomy;
     std::vector<MMseqsParameter*> easytaxonomy;
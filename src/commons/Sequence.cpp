@@ -21,34 +21,46 @@ Sequence::Sequence(size_t maxLen, int seqType, const BaseMatrix *subMat, const u
     this->subMat = (BaseMatrix*)subMat;
     this->spaced = spaced;
     this->seqType = seqType;
-    std::pair<const char *, unsigned int> spacedKmerInformation;
-    if (spacedKmerPattern.size() == 0){
-        spacedKmerInformation = getSpacedPattern(spaced, kmerSize);
-    } else {
-        spacedKmerInformation = parseSpacedPattern(kmerSize, spaced, spacedKmerPattern);
-    }
-    this->spacedPattern = spacedKmerInformation.first;
-    this->spacedPatternSize = spacedKmerInformation.second;
     this->kmerSize = kmerSize;
     this->kmerWindow = NULL;
-    this->aaPosInSpacedPattern = NULL;
     this->shouldAddPC = shouldAddPC;
-    if(spacedPatternSize){
-        this->kmerWindow = new int[kmerSize];
-        this->aaPosInSpacedPattern = new unsigned char[kmerSize];
-        if(spacedPattern == NULL ) {
-            Debug(Debug::ERROR) << "Sequence does not have a kmerSize (kmerSize= " << spacedPatternSize << ") to use nextKmer.\n";
-            Debug(Debug::ERROR) << "Please report this bug to the developer\n";
-            EXIT(EXIT_FAILURE);
+
+    // a comma separated pattern list defines multiple seed patterns of the same weight
+    std::vector<std::string> patterns = Util::split(spacedKmerPattern, ",");
+    this->patternCount = std::max(patterns.size(), (size_t) 1);
+    this->spacedPatterns = new const char*[patternCount];
+    this->spacedPatternSizes = new int[patternCount];
+    this->aaPosInSpacedPatterns = new unsigned char*[patternCount];
+    for (size_t patternIdx = 0; patternIdx < patternCount; patternIdx++) {
+        std::pair<const char *, unsigned int> spacedKmerInformation;
+        if (patterns.size() == 0){
+            spacedKmerInformation = getSpacedPattern(spaced, kmerSize);
+        } else {
+            spacedKmerInformation = parseSpacedPattern(kmerSize, spaced, patterns[patternIdx]);
         }
-        size_t pos = 0;
-        for(int i = 0; i < this->spacedPatternSize; i++) {
-            if(spacedPattern[i]){
-                aaPosInSpacedPattern[pos] = i;
-                pos++;
+        spacedPatterns[patternIdx] = spacedKmerInformation.first;
+        spacedPatternSizes[patternIdx] = spacedKmerInformation.second;
+        aaPosInSpacedPatterns[patternIdx] = NULL;
+        if(spacedPatternSizes[patternIdx]){
+            if(spacedPatterns[patternIdx] == NULL ) {
+                Debug(Debug::ERROR) << "Sequence does not have a kmerSize (kmerSize= " << spacedPatternSizes[patternIdx] << ") to use nextKmer.\n";
+                Debug(Debug::ERROR) << "Please report this bug to the developer\n";
+                EXIT(EXIT_FAILURE);
+            }
+            aaPosInSpacedPatterns[patternIdx] = new unsigned char[kmerSize];
+            size_t pos = 0;
+            for(int i = 0; i < spacedPatternSizes[patternIdx]; i++) {
+                if(spacedPatterns[patternIdx][i]){
+                    aaPosInSpacedPatterns[patternIdx][pos] = i;
+                    pos++;
+                }
             }
         }
     }
+    if(spacedPatternSizes[0]){
+        this->kmerWindow = new int[kmerSize];
+    }
+    setActivePattern(0);
 
     // init memory for profile search
     if (Parameters::isEqualDbtype(seqType, Parameters::DBTYPE_HMM_PROFILE) || Parameters::isEqualDbtype(seqType, Parameters::DBTYPE_PROFILE_STATE_PROFILE)) {
@@ -78,15 +90,20 @@ Sequence::Sequence(size_t maxLen, int seqType, const BaseMatrix *subMat, const u
 }
 
 Sequence::~Sequence() {
-    delete[] spacedPattern;
+    for (size_t patternIdx = 0; patternIdx < patternCount; patternIdx++) {
+        delete[] spacedPatterns[patternIdx];
+        if (aaPosInSpacedPatterns[patternIdx]) {
+            delete[] aaPosInSpacedPatterns[patternIdx];
+        }
+    }
+    delete[] spacedPatterns;
+    delete[] spacedPatternSizes;
+    delete[] aaPosInSpacedPatterns;
     delete[] int_sequence;
     delete[] int_consensus_sequence;
     if (kmerWindow) {
         delete[] kmerWindow;
     }
-    if (aaPosInSpacedPattern){
-        delete[] aaPosInSpacedPattern;
-    }
     if (Parameters::isEqualDbtype(seqType, Parameters::DBTYPE_HMM_PROFILE)|| Parameters::isEqualDbtype(seqType, Parameters::DBTYPE_PROFILE_STATE_PROFILE)) {
         for (size_t i = 0; i < kmerSize; ++i) {
             delete profile_matrix[i];
@@ -213,7 +230,7 @@ std::pair<const char *, unsigned int> Sequence::getSpacedPattern(bool spaced, un
     }
     char * pattern = new char[pair.second];
     memcpy(pattern, pair.first, pair.second * sizeof(char));
-    return std::make_pair<const char *, unsigned int>(pattern, static_cast<unsigned int>(pair.second));
+    return std::make_pair<const char *, unsigned int>((const char *) pattern, static_cast<unsigned int>(pair.second));
 }
 
 std::pair<const char *, unsigned int> Sequence::parseSpacedPattern(unsigned int kmerSize, bool spaced, const std::string& spacedKmerPattern) {
@@ -653,6 +670,16 @@ unsigned int Sequence::getEffectiveKmerSize() {
     return spacedPatternSize;
 }
 
+void Sequence::setActivePattern(size_t patternIdx) {
+    spacedPattern = spacedPatterns[patternIdx];
+    spacedPatternSize = spacedPatternSizes[patternIdx];
+    aaPosInSpacedPattern = aaPosInSpacedPatterns[patternIdx];
+}
+
+size_t Sequence::countSpacedPatterns(const std::string& spacedKmerPattern) {
+    return std::max(Util::split(spacedKmerPattern, ",").size(), (size_t) 1);
+}
+
 const float *Sequence::getProfile() {
     return profile;
 }
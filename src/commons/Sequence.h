@@ -344,9 +344,28 @@ public:
         return (const int *)kmerWindow;
     }
 
+    // returns the k-mer of the active seed pattern starting at query position pos
+    inline const int * kmerAtPosition(int pos) {
+        currItPos = pos - 1;
+        return nextKmer();
+    }
+
+    // checks if the active seed pattern fits at position pos
+    bool hasKmerAtPosition(int pos) {
+        return (pos + this->spacedPatternSize) <= this->L;
+    }
+
     // resets the sequence position pointer to the start of the sequence
     void resetCurrPos() { currItPos = -1; }
 
+    // number of seed patterns (> 1 for a comma separated --spaced-kmer-pattern)
+    size_t getPatternCount() { return patternCount; }
+
+    // switch nextKmer to another seed pattern, does not reset the position
+    void setActivePattern(size_t patternIdx);
+
+    static size_t countSpacedPatterns(const std::string& spacedKmerPattern);
+
     void print(); // for debugging
 
     static void extractProfileSequence(const char* data, const BaseMatrix &submat, std::string &result);
@@ -485,6 +504,12 @@ private:
     // stores position of residues in sequence
     unsigned char *aaPosInSpacedPattern;
 
+    // all seed patterns, spacedPattern/spacedPatternSize/aaPosInSpacedPattern point to the active one
+    size_t patternCount;
+    const char **spacedPatterns;
+    int *spacedPatternSizes;
+    unsigned char **aaPosInSpacedPatterns;
+
     // buffer for background null probability for global aa bias correction
     float *pNullBuffer;
 
@@ -0,0 +1,128 @@
+#include "SharedMemoryDB.h"
+#include "Debug.h"
+#include "FileUtil.h"
+#include "Util.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static const char SEGMENT_MAGIC[8] = { 'M', 'M', 'S', 'H', 'M', 'D', 'B', '1' };
+
+std::string SharedMemoryDB::segmentName(const struct stat &fileStat) {
+    return "/mmseqs-" + SSTR(static_cast<size_t>(fileStat.st_dev)) + "-" + SSTR(static_cast<size_t>(fileStat.st_ino));
+}
+
+bool SharedMemoryDB::matches(const SharedMemoryDB::SegmentHeader &header, const struct stat &fileStat) {
+    struct timespec mtime = FileUtil::getModificationTime(fileStat);
+    return memcmp(header.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) == 0
+           && header.dataSize == static_cast<size_t>(fileStat.st_size)
+           && header.device == static_cast<size_t>(fileStat.st_dev)
+           && header.inode == static_cast<size_t>(fileStat.st_ino)
+           && header.mtimeSec == static_cast<long long>(mtime.tv_sec)
+           && header.mtimeNsec == static_cast<long long>(mtime.tv_nsec);
+}
+
+bool SharedMemoryDB::create(const std::string &file, std::string &createdSegment) {
+    FILE *handle = fopen(file.c_str(), "r");
+    if (handle == NULL) {
+        Debug(Debug::ERROR) << "Can not open " << file << " for reading\n";
+        return false;
+    }
+    struct stat fileStat;
+    if (fstat(fileno(handle), &fileStat) != 0) {
+        Debug(Debug::ERROR) << "Failed to stat " << file << "\n";
+        fclose(handle);
+        return false;
+    }
+
+    std::string name = segmentName(fileStat);
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        Debug(Debug::ERROR) << "Failed to create shared memory segment " << name << ". Error " << errno << "\n";
+        fclose(handle);
+        return false;
+    }
+    size_t segmentSize = HEADER_SIZE + fileStat.st_size;
+    if (ftruncate(fd, segmentSize) != 0) {
+        Debug(Debug::ERROR) << "Failed to resize shared memory segment " << name << ". Error " << errno << "\n";
+        ::close(fd);
+        shm_unlink(name.c_str());
+        fclose(handle);
+        return false;
+    }
+    char *segment = static_cast<char *>(mmap(NULL, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    ::close(fd);
+    if (segment == MAP_FAILED) {
+        Debug(Debug::ERROR) << "Failed to map shared memory segment " << name << ". Error " << errno << "\n";
+        shm_unlink(name.c_str());
+        fclose(handle);
+        return false;
+    }
+
+    size_t read = fread(segment + HEADER_SIZE, 1, fileStat.st_size, handle);
+    fclose(handle);
+    if (read != static_cast<size_t>(fileStat.st_size)) {
+        Debug(Debug::ERROR) << "Failed to read " << file << "\n";
+        munmap(segment, segmentSize);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // the magic is written last, readers never attach to a partially filled segment
+    SegmentHeader *header = reinterpret_cast<SegmentHeader *>(segment);
+    header->dataSize = fileStat.st_size;
+    header->device = fileStat.st_dev;
+    header->inode = fileStat.st_ino;
+    struct timespec mtime = FileUtil::getModificationTime(fileStat);
+    header->mtimeSec = mtime.tv_sec;
+    header->mtimeNsec = mtime.tv_nsec;
+    __sync_synchronize();
+    memcpy(header->magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+    munmap(segment, segmentSize);
+    createdSegment = name;
+    return true;
+}
+
+void SharedMemoryDB::remove(const std::string &segment) {
+    shm_unlink(segment.c_str());
+}
+
+char *SharedMemoryDB::attach(const struct stat &fileStat) {
+    int fd = shm_open(segmentName(fileStat).c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat segmentStat;
+    size_t segmentSize = HEADER_SIZE + fileStat.st_size;
+    if (fstat(fd, &segmentStat) != 0 || static_cast<size_t>(segmentStat.st_size) != segmentSize) {
+        ::close(fd);
+        return NULL;
+    }
+    // the name is predictable, a segment created by another user could hold anything
+    if (segmentStat.st_uid != fileStat.st_uid && segmentStat.st_uid != geteuid()) {
+        ::close(fd);
+        return NULL;
+    }
+    char *segment = static_cast<char *>(mmap(NULL, segmentSize, PROT_READ, MAP_SHARED, fd, 0));
+    ::close(fd);
+    if (segment == MAP_FAILED) {
+        return NULL;
+    }
+    if (matches(*reinterpret_cast<SegmentHeader *>(segment), fileStat) == false) {
+        munmap(segment, segmentSize);
+        return NULL;
+    }
+    return segment + HEADER_SIZE;
+}
+
+void SharedMemoryDB::detach(char *data, size_t dataSize) {
+    if (munmap(data - HEADER_SIZE, HEADER_SIZE + dataSize) < 0) {
+        Debug(Debug::ERROR) << "Failed to unmap shared memory segment. Error " << errno << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef SHAREDMEMORYDB_H
+#define SHAREDMEMORYDB_H
+
+// Database data files held resident in named POSIX shared memory by the dbd module.
+// A segment is named after the device and inode of its file and starts with a header page identifying
+// the file version, DBReader attaches read-only to a segment if it matches the file it would otherwise map.
+// Segments are only readable by their creator and are ignored unless owned by the reader or the owner of the file.
+
+#include <cstddef>
+#include <string>
+#include <sys/stat.h>
+
+class SharedMemoryDB {
+public:
+    // copies a file into a new segment, replacing an older segment of the same file,
+    // the segment name is returned in segment to remove it later
+    static bool create(const std::string &file, std::string &segment);
+
+    // removes a segment returned by create, processes that already attached keep their mapping
+    static void remove(const std::string &segment);
+
+    // maps the segment of the file described by fileStat, returns NULL if there is none or if it is stale
+    static char *attach(const struct stat &fileStat);
+
+    static void detach(char *data, size_t dataSize);
+
+private:
+    static const size_t HEADER_SIZE = 4096;
+
+    struct SegmentHeader {
+        char magic[8];
+        size_t dataSize;
+        size_t device;
+        size_t inode;
+        long long mtimeSec;
+        long long mtimeNsec;
+    };
+
+    static std::string segmentName(const struct stat &fileStat);
+    static bool matches(const SegmentHeader &header, const struct stat &fileStat);
+};
+
+#endif
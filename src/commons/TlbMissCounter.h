@@ -0,0 +1,59 @@
+#ifndef MMSEQS_TLBMISSCOUNTER_H
+#define MMSEQS_TLBMISSCOUNTER_H
+
+// Counts the data TLB load misses of the calling thread with a hardware performance counter.
+// The counter is unavailable if the kernel or CPU do not expose it (e.g. perf_event_paranoid, containers).
+
+#include <cstddef>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+class TlbMissCounter {
+public:
+    TlbMissCounter() : fd(-1) {
+#ifdef __linux__
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd != -1) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    ~TlbMissCounter() {
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+
+    bool isAvailable() {
+        return fd != -1;
+    }
+
+    // misses since construction
+    size_t read() {
+        long long count = 0;
+        if (fd == -1 || ::read(fd, &count, sizeof(count)) != sizeof(count)) {
+            return 0;
+        }
+        return static_cast<size_t>(count);
+    }
+
+private:
+    int fd;
+};
+
+#endif
@@ -1,6 +1,7 @@
 // Copyright 2010 Martin C. Frith
 
 #include "tantan.h"
+#include "simd.h"
 
 #include <algorithm>  // fill, max
 #include <cassert>
@@ -26,12 +27,12 @@ namespace tantan {
             return 1.0 / maxRepeatOffset;
     }
 
-    void checkForwardAndBackwardTotals(double fTot, double bTot) {
+    void checkForwardAndBackwardTotals(double fTot, double bTot, double maxRelativeError = 1e-6) {
         double x = std::abs(fTot);
         double y = std::abs(bTot);
 
         // ??? Is 1e6 suitable here ???
-        if (std::abs(fTot - bTot) > std::max(x, y) / 1e6)
+        if (std::abs(fTot - bTot) > std::max(x, y) * maxRelativeError)
             std::cerr << "tantan: warning: possible numeric inaccuracy\n"
                       << "tantan:          forward algorithm total: " << fTot << "\n"
                       << "tantan:          backward algorithm total: " << bTot << "\n";
@@ -337,6 +338,178 @@ namespace tantan {
 
     };
 
+    // Without gaps the foreground states of different repeat offsets only interact through the
+    // background state, so the forward and backward algorithms process VECSIZE_FLOAT offsets
+    // at once in single precision.
+    struct TantanGapless {
+        enum { scaleStepSize = 16 };
+
+        const char *seqBeg;
+        int seqLen;
+        int offsetCount;  // maxRepeatOffset rounded up to full vectors
+
+        float b2b;
+        float f2f0;
+        float *b2f;  // background to foreground per offset, zero for the padding
+        float *f2b;  // foreground to background per offset, zero for the padding
+        float *foregroundProbs;
+        float *sums;
+
+        // emissionRows[letterRow[x]][j] holds the likelihood ratio of x and the
+        // letter at seqLen - 1 - j, zero before the sequence start
+        int letterRow[256];
+        std::vector<float> emissionRows;
+        std::vector<float> scaleFactors;
+
+        TantanGapless(const char *seqBeg,
+                      const char *seqEnd,
+                      int maxRepeatOffset,
+                      const const_double_ptr *likelihoodRatioMatrix,
+                      double repeatProb,
+                      double repeatEndProb,
+                      double repeatOffsetProbDecay) {
+            assert(maxRepeatOffset > 0);
+            assert(repeatProb >= 0 && repeatProb < 1);
+            assert(repeatEndProb >= 0 && repeatEndProb <= 1);
+            assert(repeatOffsetProbDecay > 0 && repeatOffsetProbDecay <= 1);
+
+            this->seqBeg = seqBeg;
+            seqLen = static_cast<int>(seqEnd - seqBeg);
+            offsetCount = (maxRepeatOffset + VECSIZE_FLOAT - 1) / VECSIZE_FLOAT * VECSIZE_FLOAT;
+
+            b2b = static_cast<float>(1 - repeatProb);
+            f2f0 = static_cast<float>(1 - repeatEndProb);
+
+            b2f = (float *) malloc_simd_float(offsetCount * sizeof(float));
+            f2b = (float *) malloc_simd_float(offsetCount * sizeof(float));
+            foregroundProbs = (float *) malloc_simd_float(offsetCount * sizeof(float));
+            sums = (float *) malloc_simd_float(VECSIZE_FLOAT * sizeof(float));
+            std::fill(b2f, b2f + offsetCount, 0.0f);
+            std::fill(f2b, f2b + offsetCount, 0.0f);
+            std::fill(f2b, f2b + maxRepeatOffset, static_cast<float>(repeatEndProb));
+            double b2fGrowth = 1 / repeatOffsetProbDecay;
+            double fromBackground = repeatProb * firstRepeatOffsetProb(b2fGrowth, maxRepeatOffset);
+            for (int i = maxRepeatOffset - 1; i >= 0; --i) {
+                b2f[i] = static_cast<float>(fromBackground);
+                fromBackground *= b2fGrowth;
+            }
+
+            const int rowSize = seqLen + offsetCount;
+            std::fill(letterRow, letterRow + 256, -1);
+            int rowCount = 0;
+            for (const char *seqPtr = seqBeg; seqPtr < seqEnd; ++seqPtr) {
+                int &row = letterRow[static_cast<unsigned char>(*seqPtr)];
+                if (row == -1) {
+                    row = rowCount++;
+                }
+            }
+            emissionRows.resize(static_cast<size_t>(rowCount) * rowSize);
+            for (int x = 0; x < 256; ++x) {
+                if (letterRow[x] == -1) {
+                    continue;
+                }
+                const double *lrRow = likelihoodRatioMatrix[static_cast<int>(static_cast<char>(x))];
+                float *row = &emissionRows[static_cast<size_t>(letterRow[x]) * rowSize];
+                for (int j = 0; j < seqLen; ++j) {
+                    row[j] = static_cast<float>(lrRow[static_cast<int>(seqBeg[seqLen - 1 - j])]);
+                }
+                std::fill(row + seqLen, row + rowSize, 0.0f);
+            }
+
+            scaleFactors.resize(seqLen / scaleStepSize);
+        }
+
+        ~TantanGapless() {
+            free(b2f);
+            free(f2b);
+            free(foregroundProbs);
+            free(sums);
+        }
+
+        // emission probabilities of all offsets at position pos
+        const float *emissionProbs(int pos) {
+            const int rowSize = seqLen + offsetCount;
+            const int row = letterRow[static_cast<unsigned char>(seqBeg[pos])];
+            return &emissionRows[static_cast<size_t>(row) * rowSize + (seqLen - pos)];
+        }
+
+        float horizontalSum(simd_float sum) {
+            simdf32_store(sums, sum);
+            float total = 0;
+            for (int i = 0; i < VECSIZE_FLOAT; ++i) {
+                total += sums[i];
+            }
+            return total;
+        }
+
+        void rescale(float &backgroundProb, float scale) {
+            backgroundProb *= scale;
+            const simd_float scaleVec = simdf32_set(scale);
+            for (int i = 0; i < offsetCount; i += VECSIZE_FLOAT) {
+                simdf32_store(foregroundProbs + i, simdf32_mul(simdf32_load(foregroundProbs + i), scaleVec));
+            }
+        }
+
+        void calcRepeatProbs(float *letterProbs) {
+            const simd_float f2f0Vec = simdf32_set(f2f0);
+
+            // forward algorithm: transition then emission per position
+            float backgroundProb = 1.0f;
+            std::fill(foregroundProbs, foregroundProbs + offsetCount, 0.0f);
+            for (int pos = 0; pos < seqLen; ++pos) {
+                const float *emission = emissionProbs(pos);
+                const simd_float backgroundVec = simdf32_set(backgroundProb);
+                simd_float fromForeground = simdf32_setzero(0);
+                for (int i = 0; i < offsetCount; i += VECSIZE_FLOAT) {
+                    simd_float f = simdf32_load(foregroundProbs + i);
+                    fromForeground = simdf32_add(fromForeground, simdf32_mul(f, simdf32_load(f2b + i)));
+                    f = simdf32_add(simdf32_mul(backgroundVec, simdf32_load(b2f + i)), simdf32_mul(f, f2f0Vec));
+                    simdf32_store(foregroundProbs + i, simdf32_mul(f, simdf32_loadu(emission + i)));
+                }
+                backgroundProb = backgroundProb * b2b + horizontalSum(fromForeground);
+                if (pos % scaleStepSize == scaleStepSize - 1) {
+                    assert(backgroundProb > 0);
+                    float scale = 1 / backgroundProb;
+                    scaleFactors[pos / scaleStepSize] = scale;
+                    rescale(backgroundProb, scale);
+                }
+                letterProbs[pos] = backgroundProb;
+            }
+
+            simd_float fromForeground = simdf32_setzero(0);
+            for (int i = 0; i < offsetCount; i += VECSIZE_FLOAT) {
+                fromForeground = simdf32_add(fromForeground, simdf32_mul(simdf32_load(foregroundProbs + i), simdf32_load(f2b + i)));
+            }
+            float z = backgroundProb * b2b + horizontalSum(fromForeground);
+            assert(z > 0);
+
+            // backward algorithm: emission then transition per position
+            backgroundProb = b2b;
+            std::copy(f2b, f2b + offsetCount, foregroundProbs);
+            for (int pos = seqLen - 1; pos >= 0; --pos) {
+                float nonRepeatProb = letterProbs[pos] * backgroundProb / z;
+                letterProbs[pos] = 1 - nonRepeatProb;
+                if (pos % scaleStepSize == scaleStepSize - 1) {
+                    rescale(backgroundProb, scaleFactors[pos / scaleStepSize]);
+                }
+
+                const float *emission = emissionProbs(pos);
+                const simd_float backgroundVec = simdf32_set(backgroundProb);
+                simd_float toForeground = simdf32_setzero(0);
+                for (int i = 0; i < offsetCount; i += VECSIZE_FLOAT) {
+                    simd_float f = simdf32_mul(simdf32_load(foregroundProbs + i), simdf32_loadu(emission + i));
+                    toForeground = simdf32_add(toForeground, simdf32_mul(f, simdf32_load(b2f + i)));
+                    simdf32_store(foregroundProbs + i, simdf32_add(simdf32_mul(simdf32_load(f2b + i), backgroundVec), simdf32_mul(f2f0Vec, f)));
+                }
+                backgroundProb = b2b * backgroundProb + horizontalSum(toForeground);
+            }
+
+            assert(backgroundProb > 0);
+            // single precision accumulates more rounding error over long sequences
+            checkForwardAndBackwardTotals(z, backgroundProb, 1e-3);
+        }
+    };
+
     int maskSequences(char *seqBeg,
                        char *seqEnd,
                        int maxRepeatOffset,
@@ -369,6 +542,12 @@ namespace tantan {
                           double firstGapProb,
                           double otherGapProb,
                           float *probabilities) {
+        if (firstGapProb <= 0) {
+            TantanGapless tantan(seqBeg, seqEnd, maxRepeatOffset, likelihoodRatioMatrix,
+                                 repeatProb, repeatEndProb, repeatOffsetProbDecay);
+            tantan.calcRepeatProbs(probabilities);
+            return;
+        }
         Tantan tantan(seqBeg, seqEnd, maxRepeatOffset, likelihoodRatioMatrix,
                       repeatProb, repeatEndProb, repeatOffsetProbDecay,
                       firstGapProb, otherGapProb);
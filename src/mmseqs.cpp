@@ -191,6 +191,17 @@ std::vector<struct Command> commands = {
                 "Martin Steinegger <martin.steinegger@mpibpc.mpg.de>",
                 "<i:sequenceDB> [<i:taxMappingFile> <i:ncbi-taxdump-folder>]  <tmpDir>",
                 CITATION_MMSEQS2,{{"",DbType::ACCESS_MODE_INPUT, NULL}}},
+        {"createbintaxonomy",    createbintaxonomy,    &par.createbintaxonomy,     COMMAND_TAXONOMY,
+                "Create binary taxonomy from NCBI input",
+                "Parses the NCBI taxdump files and writes nodes, names and the precomputed LCA tables to one file. "
+                "lca, addtaxonomy, filtertaxdb and taxonomyreport map <i:sequenceDB>_taxonomy instead of parsing the dump files. "
+                "With --mapping-file <i:sequenceDB>_mapping the taxon of every sequence key is also written as a dense array to <i:sequenceDB>_mapping.bin. createtaxdb writes both automatically.",
+                "Martin Steinegger <martin.steinegger@mpibpc.mpg.de>",
+                "<i:names.dmp> <i:nodes.dmp> <i:merged.dmp> <o:taxonomyFile>",
+                CITATION_MMSEQS2, {{"names.dmp", DbType::ACCESS_MODE_INPUT, &DbValidator::flatfile },
+                                   {"nodes.dmp", DbType::ACCESS_MODE_INPUT, &DbValidator::flatfile },
+                                   {"merged.dmp", DbType::ACCESS_MODE_INPUT, &DbValidator::flatfile },
+                                   {"taxonomyFile", DbType::ACCESS_MODE_OUTPUT, &DbValidator::flatfile }}},
         {"addtaxonomy",          addtaxonomy,          &par.addtaxonomy, COMMAND_TAXONOMY,
                 "Add taxonomy information to result database.",
                 NULL,
@@ -428,6 +439,14 @@ std::vector<struct Command> commands = {
                 "Martin Steinegger <martin.steinegger@mpibpc.mpg.de> ",
                 "<i:DB>",
                 CITATION_MMSEQS2, {{"DB", DbType::ACCESS_MODE_INPUT,  &DbValidator::allDb }}},
+        {"dbd",                  dbd,                  &par.onlyverbosity,        COMMAND_DB,
+                "Keep databases resident in shared memory",
+                "Loads the data of the given DBs, their header DBs and precomputed indices into named shared memory segments until it receives SIGTERM, SIGINT or SIGHUP. "
+                "Other modules attach to these segments read-only instead of mapping or reading the files, so a workflow loads each DB once. "
+                "Segments of changed files are ignored. A daemon killed with SIGKILL leaves its segments in /dev/shm",
+                "Martin Steinegger <martin.steinegger@mpibpc.mpg.de>",
+                "<i:DB1> ... <i:DBn>",
+                CITATION_MMSEQS2, {{"DB", DbType::ACCESS_MODE_INPUT, &DbValidator::allDb }}},
         {"translatenucs",        translatenucs,        &par.translatenucs,        COMMAND_DB,
                 "Translate nucleotide sequence DB into protein sequence DB",
                 NULL,
@@ -1,10 +1,33 @@
 #include "IndexBuilder.h"
+#include "MaskCache.h"
 #include "tantan.h"
 
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
+// tantan parameters of the index table masking
+const int maskMaxRepeatOffset = 50;
+const double maskRepeatProb = 0.005;
+const double maskRepeatEndProb = 0.05;
+const double maskRepeatOffsetProbDecay = 0.9;
+const double maskMinMaskProb = 0.9;
+
+// identifies everything that decides which residues get masked
+static size_t getMaskFingerprint(ProbabilityMatrix &probMatrix, int alphabetSize) {
+    std::vector<double> values;
+    values.push_back(maskMaxRepeatOffset);
+    values.push_back(maskRepeatProb);
+    values.push_back(maskRepeatEndProb);
+    values.push_back(maskRepeatOffsetProbDecay);
+    values.push_back(maskMinMaskProb);
+    for (int i = 0; i < alphabetSize; ++i) {
+        values.insert(values.end(), probMatrix.probMatrixPointers[i], probMatrix.probMatrixPointers[i] + alphabetSize);
+    }
+    size_t fingerprint = Util::hash(reinterpret_cast<const unsigned char*>(values.data()), values.size() * sizeof(double));
+    return fingerprint * 31 + Util::hash(reinterpret_cast<const unsigned char*>(probMatrix.hardMaskTable), 256);
+}
+
 char* getScoreLookup(BaseMatrix &matrix) {
     char *idScoreLookup = NULL;
     idScoreLookup = new char[matrix.alphabetSize];
@@ -60,7 +83,7 @@ public:
 void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedLookup,
                                 SequenceLookup **unmaskedLookup,BaseMatrix &subMat, Sequence *seq,
                                 DBReader<unsigned int> *dbr, size_t dbFrom, size_t dbTo, int kmerThr,
-                                bool mask, bool maskLowerCaseMode) {
+                                bool mask, bool maskLowerCaseMode, bool maskCache) {
     Debug(Debug::INFO) << "Index table: counting k-mers\n";
 
     const bool isProfile = Parameters::isEqualDbtype(seq->getSeqType(), Parameters::DBTYPE_HMM_PROFILE);
@@ -91,6 +114,25 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
         probMatrix = new ProbabilityMatrix(subMat);
     }
 
+    // reuse the tantan mask of an earlier run, or keep it for the next run if the whole database is indexed
+    MaskCache *readCache = NULL;
+    MaskCache *writeCache = NULL;
+    if (maskCache && mask && maskedLookup != NULL && isProfile == false) {
+        size_t fingerprint = getMaskFingerprint(*probMatrix, subMat.alphabetSize);
+        readCache = MaskCache::openCache(dbr->getDataFileName(), dbr->getIndexFileName(), fingerprint);
+        if (readCache != NULL) {
+            Debug(Debug::INFO) << "Index table: using mask cache " << MaskCache::getCacheFile(dbr->getDataFileName()) << "\n";
+        } else if (dbFrom == 0 && dbTo == dbr->getSize()) {
+            std::vector<unsigned int> keys(dbSize);
+            std::vector<unsigned int> maxLengths(dbSize);
+            for (size_t id = 0; id < dbSize; ++id) {
+                keys[id] = dbr->getDbKey(id);
+                maxLengths[id] = std::max(static_cast<int>(dbr->getSeqLens(id)) - 2, 0);
+            }
+            writeCache = new MaskCache(dbr->getDataFileName(), dbr->getIndexFileName(), keys.data(), maxLengths.data(), dbSize, fingerprint);
+        }
+    }
+
     // identical scores for memory reduction code
     char *idScoreLookup = NULL;
     if (Parameters::isEqualDbtype(seq->getSeqType(), Parameters::DBTYPE_PROFILE_STATE_SEQ) == false) {
@@ -116,7 +158,7 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
             generator->setDivideStrategy(s.profile_matrix);
         }
 
-        unsigned int *buffer = new unsigned int[seq->getMaxLen()];
+        unsigned int *buffer = new unsigned int[seq->getMaxLen() * s.getPatternCount()];
         char *charSequence = new char[seq->getMaxLen()];
 
         #pragma omp for schedule(dynamic, 100) reduction(+:totalKmerCount, maskedResidues)
@@ -138,23 +180,37 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
                 if (unmaskedLookup != NULL) {
                     (*unmaskedLookup)->addSequence(s.int_sequence, s.L, id - dbFrom, info->sequenceOffsets[id - dbFrom]);
                 }
-                if (mask == true) {
+                const uint64_t *cachedMask = (readCache != NULL) ? readCache->getMask(qKey, s.L) : NULL;
+                if (mask == true && cachedMask != NULL) {
+                    for (int i = 0; i < s.L; ++i) {
+                        if (MaskCache::isMasked(cachedMask, i)) {
+                            s.int_sequence[i] = probMatrix->hardMaskTable[s.int_sequence[i]];
+                            maskedResidues++;
+                        }
+                    }
+                } else if (mask == true) {
                     for (int i = 0; i < s.L; ++i) {
                         charSequence[i] = (char) s.int_sequence[i];
                     }
                     // s.print();
                     maskedResidues += tantan::maskSequences(charSequence,
                                                             charSequence + s.L,
-                                                            50 /*options.maxCycleLength*/,
+                                                            maskMaxRepeatOffset,
                                                             probMatrix->probMatrixPointers,
-                                                            0.005 /*options.repeatProb*/,
-                                                            0.05 /*options.repeatEndProb*/,
-                                                            0.9 /*options.repeatOffsetProbDecay*/,
+                                                            maskRepeatProb,
+                                                            maskRepeatEndProb,
+                                                            maskRepeatOffsetProbDecay,
                                                             0, 0,
-                                                            0.9 /*options.minMaskProb*/,
+                                                            maskMinMaskProb,
                                                             probMatrix->hardMaskTable);
 
+                    if (writeCache != NULL) {
+                        writeCache->setLength(id, s.L);
+                    }
                     for (int i = 0; i < s.L; i++) {
+                        if (writeCache != NULL && charSequence[i] != s.int_sequence[i]) {
+                            writeCache->setMasked(id, i);
+                        }
                         s.int_sequence[i] = charSequence[i];
                     }
                 }
@@ -190,6 +246,19 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
         delete probMatrix;
     }
 
+    if (readCache != NULL) {
+        delete readCache;
+    }
+    if (writeCache != NULL) {
+        std::string cacheFile = MaskCache::getCacheFile(dbr->getDataFileName());
+        if (writeCache->writeCache(cacheFile)) {
+            Debug(Debug::INFO) << "Index table: wrote mask cache " << cacheFile << "\n";
+        } else {
+            Debug(Debug::WARNING) << "Could not write mask cache " << cacheFile << "\n";
+        }
+        delete writeCache;
+    }
+
     Debug(Debug::INFO) << "Index table: Masked residues: " << maskedResidues << "\n";
     if(totalKmerCount == 0) {
         Debug(Debug::ERROR) << "No k-mer could be extracted for the database " << dbr->getDataFileName() << ".\n"
@@ -232,7 +301,7 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
 #endif
         Sequence s(seq->getMaxLen(), seq->getSeqType(), &subMat, seq->getKmerSize(), seq->isSpaced(), false, true, seq->getSpacedKmerPattern());
         Indexer idxer(static_cast<unsigned int>(indexTable->getAlphabetSize()), seq->getKmerSize());
-        IndexEntryLocalTmp *buffer = new IndexEntryLocalTmp[seq->getMaxLen()];
+        IndexEntryLocalTmp *buffer = new IndexEntryLocalTmp[seq->getMaxLen() * s.getPatternCount()];
 
         KmerGenerator *generator = NULL;
         if (isProfile) {
@@ -15,6 +15,7 @@
 #include "SequenceLookup.h"
 #include "MathUtil.h"
 #include "KmerGenerator.h"
+#include "HugePageMemory.h"
 #include "Parameters.h"
 
 #include <algorithm>
@@ -63,10 +64,18 @@ struct __attribute__((__packed__)) IndexEntryLocalTmp {
 
 class IndexTable {
 public:
-    IndexTable(int alphabetSize, int kmerSize, bool externalData)
-            : tableSize(MathUtil::ipow<size_t>(alphabetSize, kmerSize)), alphabetSize(alphabetSize),
-              kmerSize(kmerSize), externalData(externalData), tableEntriesNum(0), size(0),
-              indexer(new Indexer(alphabetSize, kmerSize)), entries(NULL), offsets(NULL) {
+    // multiple seed patterns share one table, the k-mers of pattern p are stored at p * alphabetSize**kmerSize
+    IndexTable(int alphabetSize, int kmerSize, bool externalData, size_t patternCount = 1)
+            : tableSize(MathUtil::ipow<size_t>(alphabetSize, kmerSize) * patternCount), alphabetSize(alphabetSize),
+              kmerSize(kmerSize), kmerTableSize(MathUtil::ipow<size_t>(alphabetSize, kmerSize)), patternCount(patternCount),
+              externalData(externalData), tableEntriesNum(0), size(0),
+              indexer(new Indexer(alphabetSize, kmerSize)), entries(NULL), offsets(NULL),
+              hugeEntriesSize(0), hugeOffsetsSize(0) {
+        if (patternCount > 1 && tableSize > UINT_MAX) {
+            Debug(Debug::ERROR) << "The k-mer space of " << patternCount << " seed patterns with k-mer size " << kmerSize << " is too large.\n"
+                                << "Use less patterns or a smaller k-mer size.\n";
+            EXIT(EXIT_FAILURE);
+        }
         if (externalData == false) {
             offsets = new(std::nothrow) size_t[tableSize + 1];
             memset(offsets, 0, (tableSize + 1) * sizeof(size_t));
@@ -81,7 +90,14 @@ public:
     }
 
     void deleteEntries() {
-        if (externalData == false) {
+        if (hugeEntriesSize != 0) {
+            HugePageMemory::release(reinterpret_cast<char *>(entries), hugeEntriesSize);
+            HugePageMemory::release(reinterpret_cast<char *>(offsets), hugeOffsetsSize);
+            entries = NULL;
+            offsets = NULL;
+            hugeEntriesSize = 0;
+            hugeOffsetsSize = 0;
+        } else if (externalData == false) {
             if (entries != NULL) {
                 delete[] entries;
                 entries = NULL;
@@ -96,19 +112,24 @@ public:
     // count k-mers in the sequence, so enough memory for the sequence lists can be allocated in the end
     size_t addSimilarKmerCount(Sequence* s, KmerGenerator* kmerGenerator){
 
-        s->resetCurrPos();
         std::vector<unsigned int> seqKmerPosBuffer;
 
         //idxer->reset();
-        while(s->hasNextKmer()){
-            const int * kmer = s->nextKmer();
-            const std::pair<size_t *, size_t> kmerList = kmerGenerator->generateKmerList(kmer);
-
-            //unsigned int kmerIdx = idxer->int2index(kmer, 0, kmerSize);
-            for(size_t i = 0; i < kmerList.second; i++){
-                seqKmerPosBuffer.push_back(kmerList.first[i]);
+        for (size_t pattern = 0; pattern < patternCount; pattern++) {
+            s->setActivePattern(pattern);
+            s->resetCurrPos();
+            const size_t patternOffset = pattern * kmerTableSize;
+            while(s->hasNextKmer()){
+                const int * kmer = s->nextKmer();
+                const std::pair<size_t *, size_t> kmerList = kmerGenerator->generateKmerList(kmer);
+
+                //unsigned int kmerIdx = idxer->int2index(kmer, 0, kmerSize);
+                for(size_t i = 0; i < kmerList.second; i++){
+                    seqKmerPosBuffer.push_back(patternOffset + kmerList.first[i]);
+                }
             }
         }
+        s->setActivePattern(0);
         if(seqKmerPosBuffer.size() > 1){
             std::sort(seqKmerPosBuffer.begin(), seqKmerPosBuffer.end());
         }
@@ -128,37 +149,43 @@ public:
     }
 
     // count k-mers in the sequence, so enough memory for the sequence lists can be allocated in the end
+    // seqKmerPosBuffer needs space for maxSeqLen * patternCount k-mers
     size_t addKmerCount(Sequence *s, Indexer *idxer, unsigned int *seqKmerPosBuffer,
                         int threshold, char *diagonalScore) {
-        s->resetCurrPos();
         size_t countKmer = 0;
         bool removeX = (Parameters::isEqualDbtype(s->getSequenceType(), Parameters::DBTYPE_NUCLEOTIDES) ||
                         Parameters::isEqualDbtype(s->getSequenceType(), Parameters::DBTYPE_AMINO_ACIDS));
         const int xIndex = s->subMat->aa2int[(int)'X'];
-        while(s->hasNextKmer()){
-            const int * kmer = s->nextKmer();
-            if(removeX){
-                int xCount = 0;
-                for(int pos = 0; pos < kmerSize; pos++){
-                    xCount += (kmer[pos] == xIndex);
+        for (size_t pattern = 0; pattern < patternCount; pattern++) {
+            s->setActivePattern(pattern);
+            s->resetCurrPos();
+            const size_t patternOffset = pattern * kmerTableSize;
+            while(s->hasNextKmer()){
+                const int * kmer = s->nextKmer();
+                if(removeX){
+                    int xCount = 0;
+                    for(int pos = 0; pos < kmerSize; pos++){
+                        xCount += (kmer[pos] == xIndex);
+                    }
+                    if(xCount > 0){
+                        continue;
+                    }
                 }
-                if(xCount > 0){
-                    continue;
-                }
-            }
-            if(threshold > 0){
-                int score = 0;
-                for(int pos = 0; pos < kmerSize; pos++){
-                    score += diagonalScore[kmer[pos]];
-                }
-                if(score < threshold){
-                    continue;
+                if(threshold > 0){
+                    int score = 0;
+                    for(int pos = 0; pos < kmerSize; pos++){
+                        score += diagonalScore[kmer[pos]];
+                    }
+                    if(score < threshold){
+                        continue;
+                    }
                 }
+                unsigned int kmerIdx = patternOffset + idxer->int2index(kmer, 0, kmerSize);
+                seqKmerPosBuffer[countKmer] = kmerIdx;
+                countKmer++;
             }
-            unsigned int kmerIdx = idxer->int2index(kmer, 0, kmerSize);
-            seqKmerPosBuffer[countKmer] = kmerIdx;
-            countKmer++;
         }
+        s->setActivePattern(0);
         if(countKmer > 1){
             std::sort(seqKmerPosBuffer, seqKmerPosBuffer + countKmer);
         }
@@ -243,6 +270,25 @@ public:
         this->offsets = entryOffsets;
     }
 
+    // copies the entries and offsets into huge pages, the posting lists are accessed randomly by the k-mer matching
+    void moveToHugePages() {
+        size_t entriesSize = 0;
+        size_t offsetsSize = 0;
+        char *hugeEntries = HugePageMemory::copy(reinterpret_cast<const char *>(entries), tableEntriesNum * sizeof(IndexEntryLocal), &entriesSize);
+        char *hugeOffsets = HugePageMemory::copy(reinterpret_cast<const char *>(offsets), (tableSize + 1) * sizeof(size_t), &offsetsSize);
+        if (hugeEntries == NULL || hugeOffsets == NULL) {
+            Debug(Debug::WARNING) << "Could not allocate huge pages for the index table\n";
+            HugePageMemory::release(hugeEntries, entriesSize);
+            HugePageMemory::release(hugeOffsets, offsetsSize);
+            return;
+        }
+        deleteEntries();
+        entries = reinterpret_cast<IndexEntryLocal *>(hugeEntries);
+        offsets = reinterpret_cast<size_t *>(hugeOffsets);
+        hugeEntriesSize = entriesSize;
+        hugeOffsetsSize = offsetsSize;
+    }
+
     void revertPointer() {
         for (size_t i = tableSize; i > 0; i--) {
             offsets[i] = offsets[i - 1];
@@ -286,7 +332,7 @@ public:
         Debug(Debug::INFO) << "Top " << top_N << " k-mers\n";
         for (size_t j = 0; j < top_N; j++) {
             Debug(Debug::INFO) << "    ";
-            indexer->printKmer(topElements[j].second, kmerSize, int2aa);
+            indexer->printKmer(topElements[j].second % kmerTableSize, kmerSize, int2aa);
             Debug(Debug::INFO) << "\t" << topElements[j].first << "\n";
         }
     }
@@ -296,22 +342,27 @@ public:
     void addSimilarSequence(Sequence* s, KmerGenerator* kmerGenerator, Indexer * idxer) {
         std::vector<IndexEntryLocalTmp> buffer;
         // iterate over all k-mers of the sequence and add the id of s to the sequence list of the k-mer (tableDummy)
-        s->resetCurrPos();
         idxer->reset();
         size_t kmerPos = 0;
-        while(s->hasNextKmer()){
-            const int * kmer = s->nextKmer();
-            std::pair<size_t *, size_t> scoreMatrix = kmerGenerator->generateKmerList(kmer);
-            for(size_t i = 0; i < scoreMatrix.second; i++) {
-                unsigned int kmerIdx = scoreMatrix.first[i];
-
-                // if region got masked do not add kmer
-                if (offsets[kmerIdx + 1] - offsets[kmerIdx] == 0)
-                    continue;
-                buffer.push_back(IndexEntryLocalTmp(kmerIdx,s->getId(), s->getCurrentPosition()));
-                kmerPos++;
+        for (size_t pattern = 0; pattern < patternCount; pattern++) {
+            s->setActivePattern(pattern);
+            s->resetCurrPos();
+            const size_t patternOffset = pattern * kmerTableSize;
+            while(s->hasNextKmer()){
+                const int * kmer = s->nextKmer();
+                std::pair<size_t *, size_t> scoreMatrix = kmerGenerator->generateKmerList(kmer);
+                for(size_t i = 0; i < scoreMatrix.second; i++) {
+                    unsigned int kmerIdx = patternOffset + scoreMatrix.first[i];
+
+                    // if region got masked do not add kmer
+                    if (offsets[kmerIdx + 1] - offsets[kmerIdx] == 0)
+                        continue;
+                    buffer.push_back(IndexEntryLocalTmp(kmerIdx,s->getId(), s->getCurrentPosition()));
+                    kmerPos++;
+                }
             }
         }
+        s->setActivePattern(0);
 
         if(kmerPos>1){
             std::sort(buffer.begin(), buffer.end(), IndexEntryLocalTmp::comapreByIdAndPos);
@@ -330,46 +381,52 @@ public:
     }
 
     // add k-mers of the sequence to the index table
+    // buffer needs space for maxSeqLen * patternCount k-mers
     void addSequence (Sequence* s, Indexer * idxer,
                       IndexEntryLocalTmp * buffer,
                       int threshold, char * diagonalScore){
         // iterate over all k-mers of the sequence and add the id of s to the sequence list of the k-mer (tableDummy)
-        s->resetCurrPos();
         idxer->reset();
         size_t kmerPos = 0;
         bool removeX = (Parameters::isEqualDbtype(s->getSequenceType(), Parameters::DBTYPE_NUCLEOTIDES) ||
                         Parameters::isEqualDbtype(s->getSequenceType(), Parameters::DBTYPE_AMINO_ACIDS));
         const int xIndex = s->subMat->aa2int[(int)'X'];
-        while (s->hasNextKmer()){
-            const int * kmer = s->nextKmer();
-            if(removeX){
-                int xCount = 0;
-                for(int pos = 0; pos < kmerSize; pos++){
-                    xCount += (kmer[pos] == xIndex);
-                }
-                if(xCount > 0){
-                    continue;
+        for (size_t pattern = 0; pattern < patternCount; pattern++) {
+            s->setActivePattern(pattern);
+            s->resetCurrPos();
+            const size_t patternOffset = pattern * kmerTableSize;
+            while (s->hasNextKmer()){
+                const int * kmer = s->nextKmer();
+                if(removeX){
+                    int xCount = 0;
+                    for(int pos = 0; pos < kmerSize; pos++){
+                        xCount += (kmer[pos] == xIndex);
+                    }
+                    if(xCount > 0){
+                        continue;
+                    }
                 }
-            }
-            if(threshold > 0) {
-                int score = 0;
-                for (int pos = 0; pos < kmerSize; pos++) {
-                    score += diagonalScore[kmer[pos]];
+                if(threshold > 0) {
+                    int score = 0;
+                    for (int pos = 0; pos < kmerSize; pos++) {
+                        score += diagonalScore[kmer[pos]];
+                    }
+                    if (score < threshold) {
+                        continue;
+                    }
                 }
-                if (score < threshold) {
+                unsigned int kmerIdx = patternOffset + idxer->int2index(kmer, 0, kmerSize);
+                // if region got masked do not add kmer
+                if (offsets[kmerIdx + 1] - offsets[kmerIdx] == 0)
                     continue;
-                }
-            }
-            unsigned int kmerIdx = idxer->int2index(kmer, 0, kmerSize);
-            // if region got masked do not add kmer
-            if (offsets[kmerIdx + 1] - offsets[kmerIdx] == 0)
-                continue;
 
-            buffer[kmerPos].kmer = kmerIdx;
-            buffer[kmerPos].seqId      = s->getId();
-            buffer[kmerPos].position_j = s->getCurrentPosition();
-            kmerPos++;
+                buffer[kmerPos].kmer = kmerIdx;
+                buffer[kmerPos].seqId      = s->getId();
+                buffer[kmerPos].position_j = s->getCurrentPosition();
+                kmerPos++;
+            }
         }
+        s->setActivePattern(0);
 
         if(kmerPos>1){
             std::sort(buffer, buffer+kmerPos, IndexEntryLocalTmp::comapreByIdAndPos);
@@ -393,7 +450,7 @@ public:
         for (size_t i = 0; i < tableSize; i++) {
             ptrdiff_t entrySize = offsets[i + 1] - offsets[i];
             if (entrySize > 0) {
-                indexer->printKmer(i, kmerSize, int2aa);
+                indexer->printKmer(i % kmerTableSize, kmerSize, int2aa);
 
                 Debug(Debug::INFO) << "\n";
                 IndexEntryLocal *e = &entries[offsets[i]];
@@ -413,6 +470,11 @@ public:
     // returns table size
     size_t getTableSize() { return tableSize; };
 
+    // returns the k-mer space of a single seed pattern
+    size_t getKmerTableSize() { return kmerTableSize; };
+
+    size_t getPatternCount() { return patternCount; };
+
     // returns the size of the entry (int for global) (IndexEntryLocal for local)
     size_t getSizeOfEntry() { return sizeof(IndexEntryLocal); }
 
@@ -443,10 +505,14 @@ public:
 
 
 protected:
-    // alphabetSize**kmerSize
+    // alphabetSize**kmerSize * patternCount
     const size_t tableSize;
     const int alphabetSize;
     const int kmerSize;
+    // alphabetSize**kmerSize
+    const size_t kmerTableSize;
+    // number of seed patterns
+    const size_t patternCount;
 
     // external data from mmap
     const bool externalData;
@@ -461,6 +527,9 @@ protected:
     // Index table entries: ids of sequences containing a certain k-mer, stored sequentially in the memory
     IndexEntryLocal *entries;
     size_t *offsets;
+    // mapped sizes if entries and offsets were moved to huge pages
+    size_t hugeEntriesSize;
+    size_t hugeOffsetsSize;
 
     // sequence lookup
     SequenceLookup *sequenceLookup;
@@ -0,0 +1,176 @@
+#include "MaskCache.h"
+#include "Debug.h"
+#include "FileUtil.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+static const char CACHE_MAGIC[8] = { 'M', 'M', 'S', 'M', 'S', 'K', '0', '2' };
+
+bool MaskCache::getStamps(const std::string &database, const std::string &indexFile, FileStamp &data, FileStamp &index) {
+    struct stat fileStat;
+    if (stat(indexFile.c_str(), &fileStat) != 0) {
+        return false;
+    }
+    index.size = fileStat.st_size;
+    index.inode = fileStat.st_ino;
+    struct timespec mtime = FileUtil::getModificationTime(fileStat);
+    index.mtimeSec = mtime.tv_sec;
+    index.mtimeNsec = mtime.tv_nsec;
+
+    // a database split over several data files is identified by their total size and the latest change
+    std::vector<std::string> dataFiles = FileUtil::findDatafiles(database.c_str());
+    if (dataFiles.empty()) {
+        return false;
+    }
+    memset(&data, 0, sizeof(FileStamp));
+    for (size_t i = 0; i < dataFiles.size(); ++i) {
+        if (stat(dataFiles[i].c_str(), &fileStat) != 0) {
+            return false;
+        }
+        data.size += fileStat.st_size;
+        data.inode ^= fileStat.st_ino;
+        mtime = FileUtil::getModificationTime(fileStat);
+        if (mtime.tv_sec > data.mtimeSec || (mtime.tv_sec == data.mtimeSec && mtime.tv_nsec > data.mtimeNsec)) {
+            data.mtimeSec = mtime.tv_sec;
+            data.mtimeNsec = mtime.tv_nsec;
+        }
+    }
+    return true;
+}
+
+MaskCache::MaskCache(const std::string &database, const std::string &indexFile,
+                     const unsigned int *keys, const unsigned int *maxLengths, size_t size, size_t fingerprint)
+        : size(size), fingerprint(fingerprint), mappedData(NULL), mappedSize(0) {
+    memset(&dataStamp, 0, sizeof(FileStamp));
+    memset(&indexStamp, 0, sizeof(FileStamp));
+    hasStamps = getStamps(database, indexFile, dataStamp, indexStamp);
+    entries = new Entry[size];
+    wordCount = 0;
+    for (size_t id = 0; id < size; ++id) {
+        entries[id].key = keys[id];
+        entries[id].length = 0;
+        entries[id].offset = wordCount;
+        wordCount += (maxLengths[id] + 63) / 64;
+    }
+    words = new uint64_t[wordCount];
+    memset(words, 0, wordCount * sizeof(uint64_t));
+}
+
+MaskCache::MaskCache(char *data, size_t dataSize) : mappedData(data), mappedSize(dataSize) {
+    CacheHeader *header = reinterpret_cast<CacheHeader*>(data);
+    size = header->size;
+    wordCount = header->wordCount;
+    fingerprint = header->fingerprint;
+    hasStamps = true;
+    dataStamp = header->data;
+    indexStamp = header->index;
+    entries = reinterpret_cast<Entry*>(data + sizeof(CacheHeader));
+    words = reinterpret_cast<uint64_t*>(data + sizeof(CacheHeader) + size * sizeof(Entry));
+}
+
+MaskCache::~MaskCache() {
+    if (mappedData != NULL) {
+        munmap(mappedData, mappedSize);
+        return;
+    }
+    delete[] entries;
+    delete[] words;
+}
+
+bool MaskCache::writeCache(const std::string &fileName) const {
+    if (hasStamps == false) {
+        return false;
+    }
+    CacheHeader header;
+    memset(&header, 0, sizeof(CacheHeader));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.fingerprint = fingerprint;
+    header.data = dataStamp;
+    header.index = indexStamp;
+    header.size = size;
+    header.wordCount = wordCount;
+
+    Entry *sorted = new Entry[size];
+    std::copy(entries, entries + size, sorted);
+    std::stable_sort(sorted, sorted + size, Entry::compareByKey);
+
+    // other processes only ever see a complete file, processes writing at the same time each use their own
+    std::string tmpFile = fileName + ".tmp." + SSTR(getpid());
+    FILE *file = fopen(tmpFile.c_str(), "wb");
+    bool success = file != NULL;
+    success = success && fwrite(&header, sizeof(CacheHeader), 1, file) == 1;
+    success = success && fwrite(sorted, sizeof(Entry), size, file) == size;
+    success = success && fwrite(words, sizeof(uint64_t), wordCount, file) == wordCount;
+    delete[] sorted;
+    if (file != NULL) {
+        success = (fclose(file) == 0) && success;
+    }
+    success = success && rename(tmpFile.c_str(), fileName.c_str()) == 0;
+    if (success == false) {
+        remove(tmpFile.c_str());
+    }
+    return success;
+}
+
+MaskCache* MaskCache::openCache(const std::string &database, const std::string &indexFile, size_t fingerprint) {
+    std::string cacheFile = getCacheFile(database);
+    struct stat cacheStat;
+    if (stat(cacheFile.c_str(), &cacheStat) != 0) {
+        return NULL;
+    }
+    FileStamp dataStamp;
+    FileStamp indexStamp;
+    if (getStamps(database, indexFile, dataStamp, indexStamp) == false) {
+        return NULL;
+    }
+
+    int fd = open(cacheFile.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return NULL;
+    }
+    size_t fileSize = cacheStat.st_size;
+    CacheHeader header;
+    if (fileSize < sizeof(CacheHeader)
+        || pread(fd, &header, sizeof(CacheHeader), 0) != sizeof(CacheHeader)
+        || memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+        || fileSize != sizeof(CacheHeader) + header.size * sizeof(Entry) + header.wordCount * sizeof(uint64_t)) {
+        close(fd);
+        Debug(Debug::WARNING) << "Mask cache " << cacheFile << " is invalid, masking again.\n";
+        return NULL;
+    }
+    if (header.fingerprint != fingerprint) {
+        close(fd);
+        Debug(Debug::INFO) << cacheFile << " was written with other masking parameters, masking again.\n";
+        return NULL;
+    }
+    if ((header.data == dataStamp) == false || (header.index == indexStamp) == false) {
+        close(fd);
+        Debug(Debug::INFO) << cacheFile << " was written for another version of " << database << ", masking again.\n";
+        return NULL;
+    }
+    char *data = static_cast<char*>(mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0));
+    close(fd);
+    if (data == MAP_FAILED) {
+        Debug(Debug::WARNING) << "Failed to mmap mask cache " << cacheFile << ", masking again.\n";
+        return NULL;
+    }
+    return new MaskCache(data, fileSize);
+}
+
+const uint64_t *MaskCache::getMask(unsigned int key, unsigned int length) const {
+    Entry search;
+    search.key = key;
+    Entry *entry = std::lower_bound(entries, entries + size, search, Entry::compareByKey);
+    if (entry == entries + size || entry->key != key || entry->length != length) {
+        return NULL;
+    }
+    return words + entry->offset;
+}
@@ -0,0 +1,94 @@
+#ifndef MMSEQS_MASKCACHE_H
+#define MMSEQS_MASKCACHE_H
+
+// One bit per residue of a sequence database that tells if tantan masked the residue,
+// so the index table can be built again without running tantan.
+
+#include <cstddef>
+#include <string>
+#include <stdint.h>
+
+class MaskCache {
+public:
+    // empty cache for all sequences of a database, every sequence gets enough bits for its length.
+    // The database files are identified before masking, a database changed in the meantime is not reused later.
+    MaskCache(const std::string &database, const std::string &indexFile,
+              const unsigned int *keys, const unsigned int *maxLengths, size_t size, size_t fingerprint);
+    ~MaskCache();
+
+    // maps <database>.mask if it was written with the same fingerprint for the same database and index files,
+    // returns NULL otherwise
+    static MaskCache* openCache(const std::string &database, const std::string &indexFile, size_t fingerprint);
+    static std::string getCacheFile(const std::string &database) {
+        return database + ".mask";
+    }
+    // returns false if the file can not be written
+    bool writeCache(const std::string &fileName) const;
+
+    // mask of a sequence, NULL if the key is missing or was cached with another length
+    const uint64_t *getMask(unsigned int key, unsigned int length) const;
+
+    static bool isMasked(const uint64_t *mask, int pos) {
+        return (mask[pos / 64] >> (pos % 64)) & 1;
+    }
+
+    // each sequence starts at its own word so threads can fill different sequences at the same time
+    void setLength(size_t id, unsigned int length) {
+        entries[id].length = length;
+    }
+    void setMasked(size_t id, int pos) {
+        words[entries[id].offset + pos / 64] |= static_cast<uint64_t>(1) << (pos % 64);
+    }
+
+private:
+    MaskCache(char *data, size_t dataSize);
+
+    // size and modification time of the data files, also the inode of the index file
+    struct FileStamp {
+        size_t size;
+        size_t inode;
+        long long mtimeSec;
+        long long mtimeNsec;
+
+        bool operator==(const FileStamp &other) const {
+            return size == other.size && inode == other.inode && mtimeSec == other.mtimeSec && mtimeNsec == other.mtimeNsec;
+        }
+    };
+    static bool getStamps(const std::string &database, const std::string &indexFile, FileStamp &data, FileStamp &index);
+
+    struct CacheHeader {
+        char magic[8];
+        size_t fingerprint;
+        FileStamp data;
+        FileStamp index;
+        size_t size;
+        size_t wordCount;
+    };
+
+    struct Entry {
+        unsigned int key;
+        unsigned int length;
+        // in words
+        size_t offset;
+
+        static bool compareByKey(const Entry &a, const Entry &b) {
+            return a.key < b.key;
+        }
+    };
+
+    // either owned or pointing into the mapped file, mapped entries are sorted by key
+    Entry *entries;
+    uint64_t *words;
+    size_t size;
+    size_t wordCount;
+    size_t fingerprint;
+    // false if the database files could not be identified, the cache is not written then
+    bool hasStamps;
+    FileStamp dataStamp;
+    FileStamp indexStamp;
+
+    char *mappedData;
+    size_t mappedSize;
+};
+
+#endif
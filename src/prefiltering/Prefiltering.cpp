@@ -7,6 +7,13 @@
 #include "FileUtil.h"
 #include "IndexBuilder.h"
 #include "Timer.h"
+#include "TlbMissCounter.h"
+#include "MMseqsMPI.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace prefilter {
 #include "ExpOpt3_8_polished.cs32.lib.h"
@@ -32,6 +39,7 @@ Prefiltering::Prefiltering(const std::string &targetDB,
         alphabetSize(par.alphabetSize),
         maskMode(par.maskMode),
         maskLowerCaseMode(par.maskLowerCaseMode),
+        maskCache(par.maskCache),
         splitMode(par.splitMode),
         scoringMatrixFile(par.scoringMatrixFile),
         seedScoringMatrixFile(par.seedScoringMatrixFile),
@@ -47,7 +55,8 @@ Prefiltering::Prefiltering(const std::string &targetDB,
         aaBiasCorrection(par.compBiasCorrection != 0),
         covThr(par.covThr), covMode(par.covMode), includeIdentical(par.includeIdentity),
         preloadMode(par.preloadMode),
-        threads(static_cast<unsigned int>(par.threads)), compressed(par.compressed) {
+        threads(static_cast<unsigned int>(par.threads)), compressed(par.compressed),
+        useWorkQueue(false), sharedIndexData(NULL), sharedIndexSize(0) {
 #ifdef OPENMP
     Debug(Debug::INFO) << "Using " << threads << " threads.\n";
 #endif
@@ -104,6 +113,9 @@ Prefiltering::Prefiltering(const std::string &targetDB,
             if (preloadMode == Parameters::PRELOAD_MODE_MMAP_TOUCH) {
                 touch = true;
                 tidxdbr->readMmapedDataInMemory();
+            } else if (preloadMode == Parameters::PRELOAD_MODE_HUGEPAGES) {
+                // the index table and sequence lookup are read once when they are copied into huge pages
+                touch = true;
             }
             tdbr = PrefilteringIndexReader::openNewReader(tdbr, PrefilteringIndexReader::DBR1DATA, PrefilteringIndexReader::DBR1INDEX, false, threads, touch, touch);
             PrefilteringIndexReader::printSummary(tidxdbr);
@@ -160,7 +172,7 @@ Prefiltering::Prefiltering(const std::string &targetDB,
         tdbr = new DBReader<unsigned int>(targetDB.c_str(), targetDBIndex.c_str(), threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
         tdbr->open(DBReader<unsigned int>::NOSORT);
 
-        if (par.preloadMode != Parameters::PRELOAD_MODE_MMAP) {
+        if (Parameters::shouldTouchData(par.preloadMode)) {
             tdbr->readMmapedDataInMemory();
             tdbr->mlock();
         }
@@ -217,8 +229,15 @@ Prefiltering::Prefiltering(const std::string &targetDB,
     Debug(Debug::INFO) << "Target database size: " << tdbr->getSize() << " type: " << DBReader<unsigned int>::getDbTypeName(targetSeqType) << "\n";
 
     if (splitMode == Parameters::QUERY_DB_SPLIT) {
-        // create the whole index table
-        getIndexTable(0, 0, tdbr->getSize());
+#ifdef HAVE_MPI
+        if (MMseqsMPI::active && MMseqsMPI::nodeSize > 1 && templateDBIsIndex == false) {
+            getSharedIndexTable();
+        } else
+#endif
+        {
+            // create the whole index table
+            getIndexTable(0, 0, tdbr->getSize());
+        }
     } else if (splitMode == Parameters::TARGET_DB_SPLIT) {
         sequenceLookup = NULL;
         indexTable = NULL;
@@ -237,6 +256,10 @@ Prefiltering::~Prefiltering() {
         delete sequenceLookup;
     }
 
+    if (sharedIndexData != NULL) {
+        munmap(sharedIndexData, sharedIndexSize);
+    }
+
     tdbr->close();
     delete tdbr;
 
@@ -272,7 +295,7 @@ void Prefiltering::reopenTargetDb() {
     tdbr = new DBReader<unsigned int>(targetDB.c_str(), targetDBIndex.c_str(), threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
     tdbr->open(DBReader<unsigned int>::NOSORT);
 
-    if (preloadMode != Parameters::PRELOAD_MODE_MMAP) {
+    if (Parameters::shouldTouchData(preloadMode)) {
         tdbr->readMmapedDataInMemory();
         tdbr->mlock();
     }
@@ -351,42 +374,34 @@ void Prefiltering::setupSplit(DBReader<unsigned int>& dbr, const int alphabetSiz
 }
 
 void Prefiltering::mergeOutput(const std::string &outDB, const std::string &outDBIndex,
-                               const std::vector<std::pair<std::string, std::string>> &filenames) {
+                               const std::vector<std::pair<std::string, std::string>> &filenames, bool writeRuns) {
     Timer timer;
-    if (filenames.size() < 2) {
+    bool isRun = Parameters::isEqualDbtype(DBReader<unsigned int>::parseDbType(filenames[0].first.c_str()), Parameters::DBTYPE_GENERIC_DB);
+    if (filenames.size() < 2 && (writeRuns == true || isRun == false)) {
         std::rename(filenames[0].first.c_str(), outDB.c_str());
         std::rename(filenames[0].second.c_str(), outDBIndex.c_str());
+        std::rename((filenames[0].second + ".bin").c_str(), (outDBIndex + ".bin").c_str());
+        std::rename((filenames[0].first + ".dbtype").c_str(), (outDB + ".dbtype").c_str());
         Debug(Debug::INFO) << "No merging needed.\n";
         return;
     }
-    std::list<std::pair<std::string, std::string>> files(filenames.begin(), filenames.end());
-
-    const std::pair<std::string, std::string> out = std::make_pair((outDB + "_merged" ),
-                                                                   (outDBIndex + "_merged"));
 
-
-    DBWriter writer(out.first.c_str(), out.second.c_str(), 1, compressed, Parameters::DBTYPE_PREFILTER_RES);
-    writer.open(1024 * 1024 * 1024); // 1 GB buffer
-    writer.mergeFilePair(filenames);
-    writer.close();
-    for(size_t i = 0; i < filenames.size(); i++){
-        // remove split
-        int error = remove(filenames[i].first.c_str());
-        if(error != 0){
-            Debug(Debug::ERROR) << "Can not delete " << filenames[i].first << " in mergeOutput!\n";
-            EXIT(EXIT_FAILURE);
-        }
-        error = remove(filenames[i].second.c_str());
-        if(error != 0){
-            Debug(Debug::ERROR) << "Can not delete " << filenames[i].second << " in mergeOutput!\n";
+    // each split contains one run per query: binary hit_t entries sorted by score with target keys
+    const size_t runCount = filenames.size();
+    DBReader<unsigned int> **runs = new DBReader<unsigned int>*[runCount];
+    for (size_t i = 0; i < runCount; i++) {
+        if (Parameters::isEqualDbtype(DBReader<unsigned int>::parseDbType(filenames[i].first.c_str()), Parameters::DBTYPE_GENERIC_DB) == false) {
+            Debug(Debug::ERROR) << "Split result " << filenames[i].first << " is not a prefilter run and can not be merged!\n";
             EXIT(EXIT_FAILURE);
         }
+        runs[i] = new DBReader<unsigned int>(filenames[i].first.c_str(), filenames[i].second.c_str(), threads,
+                                             DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+        runs[i]->open(DBReader<unsigned int>::NOSORT);
     }
-    // sort merged entries by evalue
-    DBReader<unsigned int> dbr(out.first.c_str(), out.second.c_str(), threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
-    dbr.open(DBReader<unsigned int>::LINEAR_ACCCESS);
-    DBWriter dbw(outDB.c_str(), outDBIndex.c_str(), threads, compressed, Parameters::DBTYPE_PREFILTER_RES);
-    dbw.open(1024 * 1024 * 1024);
+
+    const int dbtype = writeRuns ? Parameters::DBTYPE_GENERIC_DB : Parameters::DBTYPE_PREFILTER_RES;
+    DBWriter dbw(outDB.c_str(), outDBIndex.c_str(), threads, compressed, dbtype);
+    dbw.open();
 #pragma omp parallel
     {
         int thread_idx = 0;
@@ -397,35 +412,66 @@ void Prefiltering::mergeOutput(const std::string &outDB, const std::string &outD
         std::string result;
         result.reserve(BUFFER_SIZE);
         char buffer[100];
-#pragma omp  for schedule(dynamic, 2)
-        for (size_t id = 0; id < dbr.getSize(); id++) {
-            unsigned int dbKey = dbr.getDbKey(id);
-            char *data = dbr.getData(id, thread_idx);
-            std::vector<hit_t> hits = QueryMatcher::parsePrefilterHits(data);
-            if (hits.size() > 1) {
-                std::sort(hits.begin(), hits.end(), hit_t::compareHitsByScoreAndId);
+        std::vector<const char *> runData(runCount);
+        std::vector<size_t> runPos(runCount);
+        std::vector<size_t> runSize(runCount);
+        std::vector<hit_t> heads(runCount);
+#pragma omp for schedule(dynamic, 10)
+        for (size_t id = 0; id < runs[0]->getSize(); id++) {
+            unsigned int dbKey = runs[0]->getDbKey(id);
+            for (size_t i = 0; i < runCount; i++) {
+                size_t runId = (i == 0) ? id : runs[i]->getId(dbKey);
+                runPos[i] = 0;
+                runSize[i] = 0;
+                if (runId == UINT_MAX) {
+                    continue;
+                }
+                runData[i] = runs[i]->getData(runId, thread_idx);
+                runSize[i] = (runs[i]->getSeqLens(runId) - 1) / sizeof(hit_t);
+                if (runSize[i] > 0) {
+                    memcpy(&heads[i], runData[i], sizeof(hit_t));
+                }
             }
-            for(size_t hit_id = 0; hit_id < hits.size(); hit_id++){
-                int len = QueryMatcher::prefilterHitToBuffer(buffer, hits[hit_id]);
-                result.append(buffer, len);
+
+            // k-way merge of the score sorted runs, stop after the best maxResListLen hits
+            for (size_t hitCount = 0; hitCount < maxResListLen; hitCount++) {
+                size_t best = runCount;
+                for (size_t i = 0; i < runCount; i++) {
+                    if (runPos[i] < runSize[i] && (best == runCount || hit_t::compareHitsByScoreAndId(heads[i], heads[best]))) {
+                        best = i;
+                    }
+                }
+                if (best == runCount) {
+                    break;
+                }
+                if (writeRuns) {
+                    result.append(reinterpret_cast<const char *>(&heads[best]), sizeof(hit_t));
+                } else {
+                    int len = QueryMatcher::prefilterHitToBuffer(buffer, heads[best]);
+                    result.append(buffer, len);
+                }
+                runPos[best]++;
+                if (runPos[best] < runSize[best]) {
+                    memcpy(&heads[best], runData[best] + runPos[best] * sizeof(hit_t), sizeof(hit_t));
+                }
             }
             dbw.writeData(result.c_str(), result.size(), dbKey, thread_idx);
             result.clear();
         }
     }
-    Debug(Debug::INFO) << out.first << " " << out.second << "\n";
     dbw.close();
-    dbr.close();
-    int error = remove(out.first.c_str());
-    if(error != 0){
-        Debug(Debug::ERROR) << "Can not delete " << out.first << " in mergeOutput!\n";
-        EXIT(EXIT_FAILURE);
-    }
-    error = remove(out.second.c_str());
-    if(error != 0){
-        Debug(Debug::ERROR) << "Can not delete " << out.second << " in mergeOutput!\n";
-        EXIT(EXIT_FAILURE);
+
+    for (size_t i = 0; i < runCount; i++) {
+        runs[i]->close();
+        delete runs[i];
+        FileUtil::remove(filenames[i].first.c_str());
+        DBReader<unsigned int>::removeIndex(filenames[i].second);
+        std::string dbtypeFile = filenames[i].first + ".dbtype";
+        if (FileUtil::fileExists(dbtypeFile.c_str())) {
+            FileUtil::remove(dbtypeFile.c_str());
+        }
     }
+    delete[] runs;
 
     Debug(Debug::INFO) << "\nTime for merging results: " << timer.lap() << "\n";
 }
@@ -477,12 +523,12 @@ void Prefiltering::getIndexTable(int /*split*/, size_t dbFrom, size_t dbSize) {
         int adjustAlphabetSize = (Parameters::isEqualDbtype(targetSeqType, Parameters::DBTYPE_NUCLEOTIDES) ||
                                   Parameters::isEqualDbtype(targetSeqType,Parameters::DBTYPE_AMINO_ACIDS))
                            ? alphabetSize -1 : alphabetSize;
-        indexTable = new IndexTable(adjustAlphabetSize, kmerSize, false);
+        indexTable = new IndexTable(adjustAlphabetSize, kmerSize, false, tseq.getPatternCount());
         SequenceLookup **maskedLookup   = maskMode == 1 || maskLowerCaseMode == 1 ? &sequenceLookup : NULL;
         SequenceLookup **unmaskedLookup = maskMode == 0 ? &sequenceLookup : NULL;
 
         Debug(Debug::INFO) << "Index table k-mer threshold: " << localKmerThr << " at k-mer size " << kmerSize << " \n";
-        IndexBuilder::fillDatabase(indexTable, maskedLookup, unmaskedLookup, *kmerSubMat,  &tseq, tdbr, dbFrom, dbFrom + dbSize, localKmerThr, maskMode, maskLowerCaseMode);
+        IndexBuilder::fillDatabase(indexTable, maskedLookup, unmaskedLookup, *kmerSubMat,  &tseq, tdbr, dbFrom, dbFrom + dbSize, localKmerThr, maskMode, maskLowerCaseMode, maskCache);
 
         if (diagonalScoring == false) {
             delete sequenceLookup;
@@ -494,6 +540,19 @@ void Prefiltering::getIndexTable(int /*split*/, size_t dbFrom, size_t dbSize) {
         Debug(Debug::INFO) << "Time for index table init: " << timer.lap() << "\n";
     }
 
+    if (preloadMode == Parameters::PRELOAD_MODE_HUGEPAGES) {
+        Timer timer;
+        indexTable->moveToHugePages();
+        if (sequenceLookup != NULL) {
+            sequenceLookup->moveToHugePages();
+        }
+        Debug(Debug::INFO) << "Time for huge page copy: " << timer.lap() << "\n";
+    }
+
+    initKmerScoreMatrices();
+}
+
+void Prefiltering::initKmerScoreMatrices() {
     // init the substitution matrices
     switch (querySeqType  & 0x7FFFFFFF) {
         case Parameters::DBTYPE_AMINO_ACIDS:
@@ -534,6 +593,141 @@ bool Prefiltering::isSameQTDB(const std::string &queryDB) {
     return (queryDB.compare(targetDB) == 0 || (match == true));
 }
 
+#ifdef HAVE_MPI
+struct SharedIndexHeader {
+    int64_t alphabetSize;
+    int64_t kmerSize;
+    int64_t patternCount;
+    int64_t sequenceCount;
+    int64_t tableEntriesNum;
+    int64_t tableSize;
+    int64_t lookupSequenceCount;
+    int64_t lookupDataSize;
+};
+
+static size_t alignToWord(size_t size) {
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+void Prefiltering::getSharedIndexTable() {
+    // segment name has to be unique per job and node
+    int jobId = static_cast<int>(getpid());
+    MPI_Bcast(&jobId, 1, MPI_INT, MMseqsMPI::MASTER, MPI_COMM_WORLD);
+    int leaderRank = MMseqsMPI::rank;
+    MPI_Bcast(&leaderRank, 1, MPI_INT, 0, MMseqsMPI::nodeComm);
+    std::string shmName = "/mmseqs_index_" + SSTR(jobId) + "_" + SSTR(leaderRank);
+
+    if (MMseqsMPI::nodeRank == 0) {
+        getIndexTable(0, 0, tdbr->getSize());
+
+        SharedIndexHeader header;
+        header.alphabetSize = indexTable->getAlphabetSize();
+        header.kmerSize = indexTable->getKmerSize();
+        header.patternCount = indexTable->getPatternCount();
+        header.sequenceCount = indexTable->getSize();
+        header.tableEntriesNum = indexTable->getTableEntriesNum();
+        header.tableSize = indexTable->getTableSize();
+        header.lookupSequenceCount = (sequenceLookup != NULL) ? sequenceLookup->getSequenceCount() : -1;
+        header.lookupDataSize = (sequenceLookup != NULL) ? sequenceLookup->getDataSize() : 0;
+
+        const size_t entriesSize = alignToWord(header.tableEntriesNum * sizeof(IndexEntryLocal));
+        const size_t offsetsSize = (header.tableSize + 1) * sizeof(size_t);
+        const size_t lookupDataSize = (sequenceLookup != NULL) ? alignToWord(header.lookupDataSize + 1) : 0;
+        const size_t lookupOffsetsSize = (sequenceLookup != NULL) ? (header.lookupSequenceCount + 1) * sizeof(size_t) : 0;
+        sharedIndexSize = sizeof(SharedIndexHeader) + entriesSize + offsetsSize + lookupDataSize + lookupOffsetsSize;
+
+        int fd = shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+        if (fd < 0) {
+            Debug(Debug::ERROR) << "Can not create shared memory segment " << shmName << ". Error " << errno << ".\n";
+            EXIT(EXIT_FAILURE);
+        }
+        if (ftruncate(fd, sharedIndexSize) != 0) {
+            Debug(Debug::ERROR) << "Can not resize shared memory segment " << shmName << " to " << sharedIndexSize << " bytes.\n";
+            shm_unlink(shmName.c_str());
+            EXIT(EXIT_FAILURE);
+        }
+        void *mem = mmap(NULL, sharedIndexSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED) {
+            Debug(Debug::ERROR) << "Can not map shared memory segment " << shmName << ".\n";
+            shm_unlink(shmName.c_str());
+            EXIT(EXIT_FAILURE);
+        }
+        sharedIndexData = static_cast<char *>(mem);
+
+        char *pos = sharedIndexData;
+        memcpy(pos, &header, sizeof(SharedIndexHeader));
+        pos += sizeof(SharedIndexHeader);
+        memcpy(pos, indexTable->getEntries(), header.tableEntriesNum * sizeof(IndexEntryLocal));
+        pos += entriesSize;
+        memcpy(pos, indexTable->getOffsets(), offsetsSize);
+        pos += offsetsSize;
+        if (sequenceLookup != NULL) {
+            memcpy(pos, sequenceLookup->getData(), header.lookupDataSize + 1);
+            pos += lookupDataSize;
+            memcpy(pos, sequenceLookup->getOffsets(), lookupOffsetsSize);
+        }
+
+        // release the private copy, the leader continues on the shared segment
+        delete indexTable;
+        indexTable = NULL;
+        if (sequenceLookup != NULL) {
+            delete sequenceLookup;
+            sequenceLookup = NULL;
+        }
+    }
+    MPI_Barrier(MMseqsMPI::nodeComm);
+
+    if (MMseqsMPI::nodeRank != 0) {
+        int fd = shm_open(shmName.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            Debug(Debug::ERROR) << "Can not open shared memory segment " << shmName << ". Error " << errno << ".\n";
+            EXIT(EXIT_FAILURE);
+        }
+        struct stat sb;
+        if (fstat(fd, &sb) < 0) {
+            Debug(Debug::ERROR) << "Failed to fstat shared memory segment " << shmName << ".\n";
+            EXIT(EXIT_FAILURE);
+        }
+        sharedIndexSize = sb.st_size;
+        void *mem = mmap(NULL, sharedIndexSize, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED) {
+            Debug(Debug::ERROR) << "Can not map shared memory segment " << shmName << ".\n";
+            EXIT(EXIT_FAILURE);
+        }
+        sharedIndexData = static_cast<char *>(mem);
+    }
+
+    // all ranks attached, the segment is freed once the last rank unmaps it
+    MPI_Barrier(MMseqsMPI::nodeComm);
+    if (MMseqsMPI::nodeRank == 0) {
+        shm_unlink(shmName.c_str());
+    }
+
+    SharedIndexHeader header;
+    memcpy(&header, sharedIndexData, sizeof(SharedIndexHeader));
+    char *pos = sharedIndexData + sizeof(SharedIndexHeader);
+    IndexEntryLocal *entries = reinterpret_cast<IndexEntryLocal *>(pos);
+    pos += alignToWord(header.tableEntriesNum * sizeof(IndexEntryLocal));
+    size_t *offsets = reinterpret_cast<size_t *>(pos);
+    pos += (header.tableSize + 1) * sizeof(size_t);
+    indexTable = new IndexTable(header.alphabetSize, header.kmerSize, true, header.patternCount);
+    indexTable->initTableByExternalData(header.sequenceCount, header.tableEntriesNum, entries, offsets);
+    if (header.lookupSequenceCount >= 0) {
+        char *lookupData = pos;
+        pos += alignToWord(header.lookupDataSize + 1);
+        sequenceLookup = new SequenceLookup(header.lookupSequenceCount);
+        sequenceLookup->initLookupByExternalData(lookupData, header.lookupDataSize, reinterpret_cast<size_t *>(pos));
+    }
+
+    if (MMseqsMPI::nodeRank != 0) {
+        initKmerScoreMatrices();
+    }
+    Debug(Debug::INFO) << "Index table shared by " << MMseqsMPI::nodeSize << " ranks on node\n";
+}
+#endif
+
 void Prefiltering::runAllSplits(const std::string &queryDB, const std::string &queryDBIndex,
                                 const std::string &resultDB, const std::string &resultDBIndex) {
     runSplits(queryDB, queryDBIndex, resultDB, resultDBIndex, 0, splits, false);
@@ -543,7 +737,15 @@ void Prefiltering::runAllSplits(const std::string &queryDB, const std::string &q
 void Prefiltering::runMpiSplits(const std::string &queryDB, const std::string &queryDBIndex,
                                 const std::string &resultDB, const std::string &resultDBIndex,
                                 const std::string &localTmpPath) {
-    splits = std::max(MMseqsMPI::numProc, splits);
+    // in query split mode every rank processes the whole query database and
+    // receives chunks of queries from the work queue of the master
+    useWorkQueue = (splitMode == Parameters::QUERY_DB_SPLIT && MMseqsMPI::numProc > 1);
+    if (useWorkQueue) {
+        splits = 1;
+        MMseqsMPI::initWorkQueue();
+    } else {
+        splits = std::max(MMseqsMPI::numProc, splits);
+    }
     if(compressed == true && splitMode == Parameters::TARGET_DB_SPLIT){
             Debug(Debug::ERROR) << "The output of the prefilter cannot be compressed during target split mode. Please remove --compress.\n";
             EXIT(EXIT_FAILURE);
@@ -564,6 +766,10 @@ void Prefiltering::runMpiSplits(const std::string &queryDB, const std::string &q
 
     size_t splitCount = splitCntPerProc[MMseqsMPI::rank];
     delete[] splitCntPerProc;
+    if (useWorkQueue) {
+        fromSplit = 0;
+        splitCount = 1;
+    }
 
     std::string procTmpResultDB = localTmpPath;
     std::string procTmpResultDBIndex = localTmpPath;
@@ -590,15 +796,20 @@ void Prefiltering::runMpiSplits(const std::string &queryDB, const std::string &q
 
     // target split do not need to be merged
     int hasTmpResult = runSplits(queryDB, queryDBIndex, result.first, result.second, fromSplit, splitCount, merge) == true ? 1 : 0;
+    if (useWorkQueue) {
+        MMseqsMPI::freeWorkQueue();
+    }
 
     // if result is on a local drive - copy it to shared drive and delete from local
     if ((localTmpPath != "") && (FileUtil::fileExists(result.first.c_str())) && (FileUtil::fileExists(result.second.c_str()))) {
         std::pair<std::string, std::string> resultShared = Util::createTmpFileNames(resultDB, resultDBIndex, MMseqsMPI::rank);
         FileUtil::copyFile(result.first.c_str(), resultShared.first.c_str());
         FileUtil::copyFile(result.second.c_str(), resultShared.second.c_str());
+        FileUtil::copyFile((result.first + ".dbtype").c_str(), (resultShared.first + ".dbtype").c_str());
         // copy exits on failure so if here - copy succeeded, local can be deleted
         FileUtil::remove(result.first.c_str());
-        FileUtil::remove(result.second.c_str());
+        DBReader<unsigned int>::removeIndex(result.second);
+        FileUtil::remove((result.first + ".dbtype").c_str());
     }
     int hasResult = hasTmpResult;
 
@@ -679,7 +890,9 @@ bool Prefiltering::runSplits(const std::string &queryDB, const std::string &quer
             }
         }
         if (splitFiles.size() > 0) {
-            mergeFiles(resultDB, resultDBIndex, splitFiles);
+            // MPI ranks that only compute a subset of the target splits keep their merged result as run
+            bool writeRuns = (fromSplit > 0 || fromSplit + splitProcessCount < totalSplits);
+            mergeFiles(resultDB, resultDBIndex, splitFiles, writeRuns);
             hasResult = true;
         }
     } else if (splitProcessCount == 1) {
@@ -772,7 +985,10 @@ bool Prefiltering::runSplit(DBReader<unsigned int>* qdbr, const std::string &res
     localThreads = std::min((unsigned int)threads, (unsigned int)querySize);
 #endif
 
-    DBWriter tmpDbw(resultDB.c_str(), resultDBIndex.c_str(), localThreads, compressed, Parameters::DBTYPE_PREFILTER_RES);
+    // target splits are written as binary runs which are merged by mergeOutput
+    const bool writeRuns = (splitMode == Parameters::TARGET_DB_SPLIT && splitCount > 1);
+    DBWriter tmpDbw(resultDB.c_str(), resultDBIndex.c_str(), localThreads, compressed,
+                    writeRuns ? Parameters::DBTYPE_GENERIC_DB : Parameters::DBTYPE_PREFILTER_RES);
     tmpDbw.open();
 
     // init all thread-specific data structures
@@ -789,6 +1005,14 @@ bool Prefiltering::runSplit(DBReader<unsigned int>* qdbr, const std::string &res
     Debug(Debug::INFO) << "Target db start  " << (dbFrom + 1) << " to " << dbFrom + dbSize << "\n";
     Debug::Progress progress(querySize);
 
+    // queries are processed in chunks, either all at once or handed out by the MPI work queue
+    const size_t workSize = useWorkQueue ? static_cast<size_t>(localThreads) * 64 : querySize;
+    size_t nextChunk = queryFrom;
+    size_t chunkFrom = queryFrom;
+    size_t queryCount = 0;
+    size_t tlbMisses = 0;
+    unsigned int tlbCountedThreads = 0;
+
 #pragma omp parallel num_threads(localThreads)
     {
         unsigned int thread_idx = 0;
@@ -796,6 +1020,7 @@ bool Prefiltering::runSplit(DBReader<unsigned int>* qdbr, const std::string &res
         thread_idx = static_cast<unsigned int>(omp_get_thread_num());
 #endif
         Sequence seq(maxSeqLen, querySeqType, kmerSubMat, kmerSize, spacedKmer, aaBiasCorrection, true, spacedKmerPattern);
+        TlbMissCounter tlbCounter;
 
         QueryMatcher matcher(indexTable, sequenceLookup, kmerSubMat,  ungappedSubMat,
                             kmerThr, kmerSize, dbSize, maxSeqLen, maxResults, aaBiasCorrection,
@@ -807,50 +1032,79 @@ bool Prefiltering::runSplit(DBReader<unsigned int>* qdbr, const std::string &res
             matcher.setSubstitutionMatrix(_3merSubMatrix, _2merSubMatrix);
         }
 
-#pragma omp for schedule(dynamic, 2) reduction (+: kmersPerPos, resSize, dbMatches, doubleMatches, querySeqLenSum, diagonalOverflow)
-        for (size_t id = queryFrom; id < queryFrom + querySize; id++) {
-            progress.updateProgress();
-            // get query sequence
-            char *seqData = qdbr->getData(id, thread_idx);
-            unsigned int qKey = qdbr->getDbKey(id);
-            seq.mapSequence(id, qKey, seqData);
-            size_t targetSeqId = UINT_MAX;
-            if (sameQTDB || includeIdentical) {
-                targetSeqId = tdbr->getId(seq.getDbKey());
-                // only the corresponding split should include the id (hack for the hack)
-                if (targetSeqId >= dbFrom && targetSeqId < (dbFrom + dbSize) && targetSeqId != UINT_MAX) {
-                    targetSeqId = targetSeqId - dbFrom;
-                    if(targetSeqId > tdbr->getSize()){
-                        Debug(Debug::ERROR) << "targetSeqId: " << targetSeqId << " > target database size: "  << tdbr->getSize() <<  "\n";
-                        EXIT(EXIT_FAILURE);
-                    }
-                }else{
-                    targetSeqId = UINT_MAX;
+        while (true) {
+#pragma omp master
+            {
+                if (useWorkQueue) {
+#ifdef HAVE_MPI
+                    chunkFrom = queryFrom + MMseqsMPI::nextWorkItem(workSize);
+#endif
+                } else {
+                    chunkFrom = nextChunk;
+                    nextChunk += workSize;
                 }
             }
-            // calculate prefiltering results
-            std::pair<hit_t *, size_t> prefResults = matcher.matchQuery(&seq, targetSeqId);
-            size_t resultSize = prefResults.second;
-            // write
-            writePrefilterOutput(qdbr, &tmpDbw, thread_idx, id, prefResults, dbFrom);
-
-            // update statistics counters
-            if (resultSize != 0) {
-                notEmpty[id - queryFrom] = 1;
+#pragma omp barrier
+            if (chunkFrom >= queryFrom + querySize) {
+                break;
             }
+            const size_t chunkTo = std::min(chunkFrom + workSize, queryFrom + querySize);
+
+#pragma omp for schedule(dynamic, 2) reduction (+: kmersPerPos, resSize, dbMatches, doubleMatches, querySeqLenSum, diagonalOverflow, queryCount)
+            for (size_t id = chunkFrom; id < chunkTo; id++) {
+                progress.updateProgress();
+                // get query sequence
+                char *seqData = qdbr->getData(id, thread_idx);
+                unsigned int qKey = qdbr->getDbKey(id);
+                seq.mapSequence(id, qKey, seqData);
+                size_t targetSeqId = UINT_MAX;
+                if (sameQTDB || includeIdentical) {
+                    targetSeqId = tdbr->getId(seq.getDbKey());
+                    // only the corresponding split should include the id (hack for the hack)
+                    if (targetSeqId >= dbFrom && targetSeqId < (dbFrom + dbSize) && targetSeqId != UINT_MAX) {
+                        targetSeqId = targetSeqId - dbFrom;
+                        if(targetSeqId > tdbr->getSize()){
+                            Debug(Debug::ERROR) << "targetSeqId: " << targetSeqId << " > target database size: "  << tdbr->getSize() <<  "\n";
+                            EXIT(EXIT_FAILURE);
+                        }
+                    }else{
+                        targetSeqId = UINT_MAX;
+                    }
+                }
+                // calculate prefiltering results
+                std::pair<hit_t *, size_t> prefResults = matcher.matchQuery(&seq, targetSeqId);
+                size_t resultSize = prefResults.second;
+                // write
+                writePrefilterOutput(qdbr, &tmpDbw, thread_idx, id, prefResults, dbFrom, writeRuns);
+
+                // update statistics counters
+                if (resultSize != 0) {
+                    notEmpty[id - queryFrom] = 1;
+                }
 
-            kmersPerPos += matcher.getStatistics()->kmersPerPos;
-            dbMatches += matcher.getStatistics()->dbMatches;
-            doubleMatches += matcher.getStatistics()->doubleMatches;
-            querySeqLenSum += seq.L;
-            diagonalOverflow += matcher.getStatistics()->diagonalOverflow;
-            resSize += resultSize;
-            realResSize += std::min(resultSize, maxResults);
-            reslens[thread_idx]->emplace_back(resultSize);
-        } // step end
+                kmersPerPos += matcher.getStatistics()->kmersPerPos;
+                dbMatches += matcher.getStatistics()->dbMatches;
+                doubleMatches += matcher.getStatistics()->doubleMatches;
+                querySeqLenSum += seq.L;
+                diagonalOverflow += matcher.getStatistics()->diagonalOverflow;
+                resSize += resultSize;
+                realResSize += std::min(resultSize, maxResults);
+                reslens[thread_idx]->emplace_back(resultSize);
+                queryCount++;
+            } // step end
+        }
+
+        if (tlbCounter.isAvailable()) {
+            size_t misses = tlbCounter.read();
+#pragma omp atomic
+            tlbMisses += misses;
+#pragma omp atomic
+            tlbCountedThreads++;
+        }
     }
+    totalQueryDBSize = queryCount;
 
-    if (Debug::debugLevel >= Debug::INFO) {
+    if (Debug::debugLevel >= Debug::INFO && totalQueryDBSize > 0) {
         statistics_t stats(kmersPerPos / static_cast<double>(totalQueryDBSize),
                            dbMatches / totalQueryDBSize,
                            doubleMatches / totalQueryDBSize,
@@ -863,32 +1117,22 @@ bool Prefiltering::runSplit(DBReader<unsigned int>* qdbr, const std::string &res
                 empty++;
             }
         }
+        // queries processed by other ranks
+        empty -= querySize - totalQueryDBSize;
 
         printStatistics(stats, reslens, localThreads, empty, maxResults);
+        if (tlbCountedThreads == localThreads) {
+            Debug(Debug::INFO) << tlbMisses << " data TLB misses\n";
+        }
     }
-    tmpDbw.close(merge); // sorts the index
+    tmpDbw.close(merge || writeRuns); // sorts the index
 
-    // sort by ids
-    // needed to speed up merge later one
-    // sorts this datafile according to the index file
-    if (splitCount > 1 && splitMode == Parameters::TARGET_DB_SPLIT) {
-        // delete indexTable to free memory:
+    if (writeRuns) {
+        // delete indexTable to free memory for the merge
         if (indexTable != NULL) {
             delete indexTable;
             indexTable = NULL;
         }
-        DBReader<unsigned int> resultReader(tmpDbw.getDataFileName(), tmpDbw.getIndexFileName(), threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
-        resultReader.open(DBReader<unsigned int>::NOSORT);
-        resultReader.readMmapedDataInMemory();
-        DBWriter resultWriter((resultDB + "_tmp").c_str(), (resultDBIndex + "_tmp").c_str(), localThreads, compressed, Parameters::DBTYPE_PREFILTER_RES);
-        resultWriter.open();
-        resultWriter.sortDatafileByIdOrder(resultReader);
-        resultWriter.close(true);
-        resultReader.close();
-        remove(resultDB.c_str());
-        remove(resultDBIndex.c_str());
-        std::rename((resultDB + "_tmp").c_str(), resultDB.c_str());
-        std::rename((resultDBIndex + "_tmp").c_str(), resultDBIndex.c_str());
     }
 
     for (unsigned int i = 0; i < localThreads; i++) {
@@ -902,8 +1146,9 @@ bool Prefiltering::runSplit(DBReader<unsigned int>* qdbr, const std::string &res
 }
 
 void Prefiltering::writePrefilterOutput(DBReader<unsigned int> *qdbr, DBWriter *dbWriter, unsigned int thread_idx, size_t id,
-                                        const std::pair<hit_t *, size_t> &prefResults, size_t seqIdOffset) {
+                                        const std::pair<hit_t *, size_t> &prefResults, size_t seqIdOffset, bool writeRun) {
     hit_t *resultVector = prefResults.first;
+    size_t runSize = 0;
     std::string prefResultsOutString;
     prefResultsOutString.reserve(BUFFER_SIZE);
     char buffer[100];
@@ -927,11 +1172,22 @@ void Prefiltering::writePrefilterOutput(DBReader<unsigned int> *qdbr, DBWriter *
             }
         }
 
+        if (writeRun) {
+            resultVector[runSize++] = *res;
+            continue;
+        }
+
         // write prefiltering results to a string
         int len = QueryMatcher::prefilterHitToBuffer(buffer, *res);
         // TODO: error handling for len
         prefResultsOutString.append(buffer, len);
     }
+    if (writeRun) {
+        // runs have to be sorted by score and target key for the k-way merge
+        std::sort(resultVector, resultVector + runSize, hit_t::compareHitsByScoreAndId);
+        dbWriter->writeData(reinterpret_cast<const char *>(resultVector), runSize * sizeof(hit_t), qdbr->getDbKey(id), thread_idx);
+        return;
+    }
     dbWriter->writeData(prefResultsOutString.c_str(), prefResultsOutString.length(), qdbr->getDbKey(id), thread_idx);
 }
 
@@ -979,9 +1235,9 @@ BaseMatrix *Prefiltering::getSubstitutionMatrix(const std::string &scoringMatrix
 }
 
 void Prefiltering::mergeFiles(const std::string &outDB, const std::string &outDBIndex,
-                              const std::vector<std::pair<std::string, std::string>> &splitFiles) {
+                              const std::vector<std::pair<std::string, std::string>> &splitFiles, bool writeRuns) {
     if (splitMode == Parameters::TARGET_DB_SPLIT) {
-        mergeOutput(outDB, outDBIndex, splitFiles);
+        mergeOutput(outDB, outDBIndex, splitFiles, writeRuns);
     } else if (splitMode == Parameters::QUERY_DB_SPLIT) {
         DBWriter::mergeResults(outDB, outDBIndex, splitFiles);
     }
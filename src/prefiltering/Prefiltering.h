@@ -40,7 +40,7 @@ public:
 
     // merge file
     void mergeFiles(const std::string &outDb, const std::string &outDBIndex,
-                    const std::vector<std::pair<std::string, std::string>> &splitFiles);
+                    const std::vector<std::pair<std::string, std::string>> &splitFiles, bool writeRuns = false);
 
     // get substitution matrix
     static BaseMatrix *getSubstitutionMatrix(const std::string &scoringMatrixFile, size_t alphabetSize, float bitFactor, bool profileState, bool isNucl);
@@ -76,6 +76,7 @@ private:
     bool templateDBIsIndex;
     int maskMode;
     int maskLowerCaseMode;
+    int maskCache;
     int splitMode;
     int kmerThr;
     std::string scoringMatrixFile;
@@ -100,6 +101,12 @@ private:
     const unsigned int threads;
     const int compressed;
 
+    // queries are handed out by the MPI work queue instead of static splits
+    bool useWorkQueue;
+    // index table shared between the ranks of a node
+    char *sharedIndexData;
+    size_t sharedIndexSize;
+
     bool runSplit(DBReader<unsigned int> *qdbr, const std::string &resultDB, const std::string &resultDBIndex,
                   size_t split, size_t splitCount, bool sameQTDB, bool merge);
 
@@ -121,14 +128,22 @@ private:
     // needed for index lookup
     void getIndexTable(int split, size_t dbFrom, size_t dbSize);
 
+    void initKmerScoreMatrices();
+
+#ifdef HAVE_MPI
+    // the first rank of each node computes the index table, all others attach to it
+    void getSharedIndexTable();
+#endif
+
     void writePrefilterOutput(DBReader<unsigned int> *qdbr, DBWriter *dbWriter, unsigned int thread_idx, size_t id,
-                              const std::pair<hit_t *, size_t> &prefResults, size_t seqIdOffset);
+                              const std::pair<hit_t *, size_t> &prefResults, size_t seqIdOffset, bool writeRun);
 
     void printStatistics(const statistics_t &stats, std::list<int> **reslens,
                          unsigned int resLensSize, size_t empty, size_t maxResults);
 
+    // k-way merge of the score sorted binary runs of each target split
     void mergeOutput(const std::string &outDb, const std::string &outDBIndex,
-                     const std::vector<std::pair<std::string, std::string>> &filenames);
+                     const std::vector<std::pair<std::string, std::string>> &filenames, bool writeRuns);
 
     bool isSameQTDB(const std::string &queryDB);
 
@@ -52,7 +52,7 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
                                               BaseMatrix *subMat, int maxSeqLen,
                                               bool hasSpacedKmer, const std::string &spacedKmerPattern,
                                               bool compBiasCorrection, int alphabetSize, int kmerSize,
-                                              int maskMode, int maskLowerCase, int kmerThr) {
+                                              int maskMode, int maskLowerCase, int maskCache, int kmerThr) {
     DBWriter writer(outDB.c_str(), std::string(outDB).append(".index").c_str(), 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_INDEX_DB);
     writer.open();
 
@@ -101,12 +101,12 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
     int adjustAlphabetSize = (Parameters::isEqualDbtype(seqType, Parameters::DBTYPE_NUCLEOTIDES) || Parameters::isEqualDbtype(seqType, Parameters::DBTYPE_AMINO_ACIDS))
                              ? alphabetSize -1: alphabetSize;
 
-    IndexTable *indexTable = new IndexTable(adjustAlphabetSize, kmerSize, false);
+    IndexTable *indexTable = new IndexTable(adjustAlphabetSize, kmerSize, false, seq.getPatternCount());
     SequenceLookup *sequenceLookup = NULL;
     IndexBuilder::fillDatabase(indexTable,
                                (maskMode == 1 || maskLowerCase == 1) ? &sequenceLookup : NULL,
                                (maskMode == 0 ) ? &sequenceLookup : NULL,
-                               *subMat, &seq, dbr1, 0, dbr1->getSize(), kmerThr, maskMode, maskLowerCase);
+                               *subMat, &seq, dbr1, 0, dbr1->getSize(), kmerThr, maskMode, maskLowerCase, maskCache);
     indexTable->printStatistics(subMat->int2aa);
 
     if (sequenceLookup == NULL) {
@@ -169,7 +169,7 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
     writer.alignToPageSize();
     free(subData);
 
-    if (spacedKmerPattern.empty() != false) {
+    if (spacedKmerPattern.empty() == false) {
         Debug(Debug::INFO) << "Write SPACEDPATTERN (" << SPACEDPATTERN << ")\n";
         writer.writeData(spacedKmerPattern.c_str(), spacedKmerPattern.length(), SPACEDPATTERN, 0);
         writer.alignToPageSize();
@@ -253,6 +253,10 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
 
 DBReader<unsigned int> *PrefilteringIndexReader::openNewHeaderReader(DBReader<unsigned int>*dbr, unsigned int dataIdx, unsigned int indexIdx, int threads,  bool touchIndex, bool touchData) {
     size_t indexId = dbr->getId(indexIdx);
+    // created with --index-headers 0
+    if (indexId == UINT_MAX) {
+        return NULL;
+    }
     char *indexData = dbr->getData(indexId, 0);
     if (touchIndex) {
         dbr->touchData(indexId);
@@ -345,7 +349,7 @@ IndexTable *PrefilteringIndexReader::generateIndexTable(DBReader<unsigned int> *
     } else {
         adjustAlphabetSize = data.alphabetSize;
     }
-    retTable = new IndexTable(adjustAlphabetSize, data.kmerSize, true);
+    retTable = new IndexTable(adjustAlphabetSize, data.kmerSize, true, Sequence::countSpacedPatterns(getSpacedPattern(dbr)));
 
     size_t entriesNumId = dbr->getId(ENTRIESNUM);
     int64_t entriesNum = *((int64_t *)dbr->getDataUncompressed(entriesNumId));
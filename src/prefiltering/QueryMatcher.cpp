@@ -186,100 +186,115 @@ size_t QueryMatcher::match(Sequence *seq, float *compositionBias) {
     Indexer idx(indexTable->getAlphabetSize(), kmerSize);
     const int xIndex = kmerSubMat->aa2int[(int)'X'];
 
-    while(seq->hasNextKmer()){
-        const int * kmer = seq->nextKmer();
-        const unsigned char * pos = seq->getAAPosInSpacedPattern();
-        const unsigned short current_i = seq->getCurrentPosition();
-
-        float biasCorrection = 0;
-        int xCount = 0;
-        for (int i = 0; i < kmerSize; i++){
-            xCount += (kmer[i] == xIndex);
-            biasCorrection += compositionBias[current_i + static_cast<short>(pos[i])];
-        }
-        if(xCount > 0){
-            indexTo = current_i;
-            indexPointer[current_i] = sequenceHits;
-            continue;
-        }
-        // round bias to next higher or lower value
-        short bias = static_cast<short>((biasCorrection < 0.0) ? biasCorrection - 0.5: biasCorrection + 0.5);
-        short kmerMatchScore = std::max(kmerThr - bias, 0);
-
-        // adjust kmer threshold based on composition bias
-        kmerGenerator->setThreshold(kmerMatchScore);
-
-        const size_t * index;
-        size_t exactKmer;
-        size_t kmerElementSize;
-        if(takeOnlyBestKmer){
-            kmerElementSize = 1;
-            exactKmer = idx.int2index(kmer);
-            index = &exactKmer;
-        }else{
-            std::pair<size_t*, size_t> kmerList = kmerGenerator->generateKmerList(kmer);
-            kmerElementSize = kmerList.second;
-            index = kmerList.first;
-        }
-        //std::cout << kmer << std::endl;
+    const size_t patternCount = seq->getPatternCount();
+    const size_t kmerTableSize = indexTable->getKmerTableSize();
+    // k-mers of all seed patterns starting at query position i are added to the same bins,
+    // so hits of multiple patterns are merged before the diagonal scoring
+    for (int queryPos = 0; queryPos < seq->L; queryPos++) {
+        const unsigned short current_i = queryPos;
+        bool hasKmer = false;
         indexPointer[current_i] = sequenceHits;
-        // match the index table
-
-        //idx.printKmer(kmerList.index[0], kmerSize, m->int2aa);
-        //std::cout  << "\t" << kmerMatchScore << std::endl;
-        kmerListLen += kmerElementSize;
-
-        for (unsigned int kmerPos = 0; kmerPos < kmerElementSize; kmerPos++) {
-            // generate k-mer list
-//                        idx.printKmer(index[kmerPos], kmerSize, m->int2aa);
-//                        std::cout << std::endl;
-
-            const IndexEntryLocal *entries = indexTable->getDBSeqList(index[kmerPos], &seqListSize);
-
-            /////DEBUG
-           /* 
-            idx.printKmer(index[kmerPos], kmerSize, m->int2aa);
-            std::cout << "\t" << current_i << "\t"<< index[kmerPos] << std::endl;
-            for(size_t i = 0; i < seqListSize; i++){
-                char diag = entries[i].position_j - current_i;
-                std::cout << "(" << entries[i].seqId << " " << (int) diag << ")\t";
+        for (size_t pattern = 0; pattern < patternCount; pattern++) {
+            seq->setActivePattern(pattern);
+            if (seq->hasKmerAtPosition(queryPos) == false) {
+                continue;
             }
-            std::cout << std::endl;
-            */
-            /////DEBUG
-            // detected overflow while matching
-            if ((sequenceHits + seqListSize) >= lastSequenceHit) {
-                stats->diagonalOverflow = true;
-                // last pointer
-                indexPointer[current_i + 1] = sequenceHits;
-//                std::cout << "Overflow in i=" << indexStart << std::endl;
-                const size_t hitCount = evaluateBins(indexPointer,
-                                                     foundDiagonals + overflowHitCount,
-                                                     counterResultSize - overflowHitCount,
-                                                     indexStart, current_i, (diagonalScoring == false));
-                if(overflowHitCount != 0){ //merge lists
-                    // hitCount is max. dbSize so there can be no overflow in mergeElemens
-                    overflowHitCount = mergeElements(diagonalScoring, foundDiagonals, overflowHitCount +  hitCount);
-                } else {
-                    overflowHitCount = hitCount;
-                }
-                // reset pointer position
-                sequenceHits = databaseHits;
-                indexPointer[current_i] = databaseHits;
-                indexStart = current_i;
-                overflowNumMatches += numMatches;
-                numMatches = 0;
-                if((sequenceHits + seqListSize) >= lastSequenceHit){
-                    goto outer;
+            hasKmer = true;
+            const int * kmer = seq->kmerAtPosition(queryPos);
+            const unsigned char * pos = seq->getAAPosInSpacedPattern();
+            const size_t patternOffset = pattern * kmerTableSize;
+
+            float biasCorrection = 0;
+            int xCount = 0;
+            for (int i = 0; i < kmerSize; i++){
+                xCount += (kmer[i] == xIndex);
+                biasCorrection += compositionBias[current_i + static_cast<short>(pos[i])];
+            }
+            if(xCount > 0){
+                continue;
+            }
+            // round bias to next higher or lower value
+            short bias = static_cast<short>((biasCorrection < 0.0) ? biasCorrection - 0.5: biasCorrection + 0.5);
+            short kmerMatchScore = std::max(kmerThr - bias, 0);
+
+            // adjust kmer threshold based on composition bias
+            kmerGenerator->setThreshold(kmerMatchScore);
+
+            const size_t * index;
+            size_t exactKmer;
+            size_t kmerElementSize;
+            if(takeOnlyBestKmer){
+                kmerElementSize = 1;
+                exactKmer = idx.int2index(kmer);
+                index = &exactKmer;
+            }else{
+                std::pair<size_t*, size_t> kmerList = kmerGenerator->generateKmerList(kmer);
+                kmerElementSize = kmerList.second;
+                index = kmerList.first;
+            }
+            //std::cout << kmer << std::endl;
+            // match the index table
+
+            //idx.printKmer(kmerList.index[0], kmerSize, m->int2aa);
+            //std::cout  << "\t" << kmerMatchScore << std::endl;
+            kmerListLen += kmerElementSize;
+
+            for (unsigned int kmerPos = 0; kmerPos < kmerElementSize; kmerPos++) {
+                // generate k-mer list
+//                            idx.printKmer(index[kmerPos], kmerSize, m->int2aa);
+//                            std::cout << std::endl;
+
+                const IndexEntryLocal *entries = indexTable->getDBSeqList(patternOffset + index[kmerPos], &seqListSize);
+
+                /////DEBUG
+               /*
+                idx.printKmer(index[kmerPos], kmerSize, m->int2aa);
+                std::cout << "\t" << current_i << "\t"<< index[kmerPos] << std::endl;
+                for(size_t i = 0; i < seqListSize; i++){
+                    char diag = entries[i].position_j - current_i;
+                    std::cout << "(" << entries[i].seqId << " " << (int) diag << ")\t";
                 }
-            };
-            memcpy(sequenceHits, entries, sizeof(IndexEntryLocal) * seqListSize);
-            sequenceHits += seqListSize;
-            numMatches += seqListSize;
+                std::cout << std::endl;
+                */
+                /////DEBUG
+                // detected overflow while matching
+                if ((sequenceHits + seqListSize) >= lastSequenceHit) {
+                    stats->diagonalOverflow = true;
+                    // last pointer
+                    indexPointer[current_i + 1] = sequenceHits;
+//                    std::cout << "Overflow in i=" << indexStart << std::endl;
+                    const size_t hitCount = evaluateBins(indexPointer,
+                                                         foundDiagonals + overflowHitCount,
+                                                         counterResultSize - overflowHitCount,
+                                                         indexStart, current_i, (diagonalScoring == false));
+                    if(overflowHitCount != 0){ //merge lists
+                        // hitCount is max. dbSize so there can be no overflow in mergeElemens
+                        overflowHitCount = mergeElements(diagonalScoring, foundDiagonals, overflowHitCount +  hitCount);
+                    } else {
+                        overflowHitCount = hitCount;
+                    }
+                    // reset pointer position
+                    sequenceHits = databaseHits;
+                    indexPointer[current_i] = databaseHits;
+                    indexStart = current_i;
+                    overflowNumMatches += numMatches;
+                    numMatches = 0;
+                    if((sequenceHits + seqListSize) >= lastSequenceHit){
+                        goto outer;
+                    }
+                };
+                memcpy(sequenceHits, entries, sizeof(IndexEntryLocal) * seqListSize);
+                sequenceHits += seqListSize;
+                numMatches += seqListSize;
+            }
+        }
+        if (hasKmer == false) {
+            break;
         }
         indexTo = current_i;
     }
     outer:
+    seq->setActivePattern(0);
     indexPointer[indexTo + 1] = databaseHits + numMatches;
     size_t hitCount = evaluateBins(indexPointer, foundDiagonals + overflowHitCount,
                                    counterResultSize - overflowHitCount, indexStart, indexTo,  (diagonalScoring == false));
@@ -7,9 +7,11 @@
 #include "Debug.h"
 #include "Util.h"
 #include "SequenceLookup.h"
+#include "HugePageMemory.h"
 
 SequenceLookup::SequenceLookup(size_t dbSize, size_t entrySize)
-        : sequenceCount(dbSize), dataSize(entrySize), currentIndex(0), currentOffset(0), externalData(false) {
+        : sequenceCount(dbSize), dataSize(entrySize), currentIndex(0), currentOffset(0), externalData(false),
+          hugeDataSize(0), hugeOffsetsSize(0) {
     data = new(std::nothrow) char[dataSize + 1];
     Util::checkAllocation(data, "Can not allocate data memory in SequenceLookup");
 
@@ -19,11 +21,15 @@ SequenceLookup::SequenceLookup(size_t dbSize, size_t entrySize)
 }
 
 SequenceLookup::SequenceLookup(size_t dbSize)
-        : sequenceCount(dbSize), data(NULL), dataSize(0), offsets(NULL), currentIndex(0), currentOffset(0), externalData(true) {
+        : sequenceCount(dbSize), data(NULL), dataSize(0), offsets(NULL), currentIndex(0), currentOffset(0), externalData(true),
+          hugeDataSize(0), hugeOffsetsSize(0) {
 }
 
 SequenceLookup::~SequenceLookup() {
-    if(externalData == false){
+    if (hugeDataSize != 0) {
+        HugePageMemory::release(data, hugeDataSize);
+        HugePageMemory::release(reinterpret_cast<char *>(offsets), hugeOffsetsSize);
+    } else if(externalData == false){
         delete[] data;
         delete[] offsets;
     }
@@ -71,3 +77,28 @@ void SequenceLookup::initLookupByExternalData(char *seqData, size_t seqDataSize,
     dataSize = seqDataSize;
     offsets = seqOffsets;
 }
+
+void SequenceLookup::moveToHugePages() {
+    size_t dataMappedSize = 0;
+    size_t offsetsMappedSize = 0;
+    // the owned buffer has one extra byte
+    char *hugeData = HugePageMemory::copy(data, dataSize + (externalData ? 0 : 1), &dataMappedSize);
+    char *hugeOffsets = HugePageMemory::copy(reinterpret_cast<const char *>(offsets), (sequenceCount + 1) * sizeof(size_t), &offsetsMappedSize);
+    if (hugeData == NULL || hugeOffsets == NULL) {
+        Debug(Debug::WARNING) << "Could not allocate huge pages for the sequence lookup\n";
+        HugePageMemory::release(hugeData, dataMappedSize);
+        HugePageMemory::release(hugeOffsets, offsetsMappedSize);
+        return;
+    }
+    if (hugeDataSize != 0) {
+        HugePageMemory::release(data, hugeDataSize);
+        HugePageMemory::release(reinterpret_cast<char *>(offsets), hugeOffsetsSize);
+    } else if (externalData == false) {
+        delete[] data;
+        delete[] offsets;
+    }
+    data = hugeData;
+    offsets = reinterpret_cast<size_t *>(hugeOffsets);
+    hugeDataSize = dataMappedSize;
+    hugeOffsetsSize = offsetsMappedSize;
+}
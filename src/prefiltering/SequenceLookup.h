@@ -35,6 +35,9 @@ public:
 
     void initLookupByExternalData(char *seqData, size_t dataSize, size_t *seqOffsets);
 
+    // copies data and offsets into huge pages, the diagonal scoring reads the sequences randomly
+    void moveToHugePages();
+
 private:
     size_t sequenceCount;
 
@@ -50,6 +53,10 @@ private:
 
     // if data are read from mmap
     bool externalData;
+
+    // mapped sizes if data and offsets were moved to huge pages
+    size_t hugeDataSize;
+    size_t hugeOffsetsSize;
 };
 
 
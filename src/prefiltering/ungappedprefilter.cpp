@@ -29,7 +29,7 @@ int doRescorealldiagonal(Parameters &par, DBReader<unsigned int> &qdbr, DBWriter
     } else {
         tdbr = new DBReader<unsigned int>(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
         tdbr->open(DBReader<unsigned int>::NOSORT);
-        if (par.preloadMode != Parameters::PRELOAD_MODE_MMAP) {
+        if (Parameters::shouldTouchData(par.preloadMode)) {
             tdbr->readMmapedDataInMemory();
         }
     }
@@ -162,7 +162,7 @@ int ungappedprefilter(int argc, const char **argv, const Command &command) {
     par.parseParameters(argc, argv, command, 3);
     DBReader<unsigned int> qdbr(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
     qdbr.open(DBReader<unsigned int>::NOSORT);
-    if (par.preloadMode != Parameters::PRELOAD_MODE_MMAP) {
+    if (Parameters::shouldTouchData(par.preloadMode)) {
         qdbr.readMmapedDataInMemory();
     }
 
@@ -11,61 +11,172 @@
 #include <fstream>
 #include <algorithm>
 #include <cassert>
-
-int **makeMatrix(size_t maxNodes) {
-    Debug(Debug::INFO) << "Making matrix ...";
-    size_t dimension = maxNodes * 2;
-    int **M = new int*[dimension];
-    int k = (int)(MathUtil::flog2(dimension)) + 1;
-    for (size_t i = 0; i < dimension; ++i) {
-        M[i] = new int[k]();
-    }
-    Debug(Debug::INFO) << " Done\n";
-    return M;
-}
-
-void deleteMatrix(int** M, size_t maxNodes) {
-    for (size_t i = 0; i < (maxNodes * 2); ++i) {
-        delete[] M[i];
-    }
-    delete[] M;
-}
-
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 NcbiTaxonomy::NcbiTaxonomy(const std::string &namesFile,  const std::string &nodesFile,
-                           const std::string &mergedFile) {
+                           const std::string &mergedFile) : mappedData(NULL), mappedSize(0) {
     InitLevels();
 
-    loadNodes(nodesFile);
+    std::vector<TaxonNode> tmpNodes;
+    // offset 0 is the empty name of taxa without scientific name
+    std::string tmpBlock(1, '\0');
+    loadNodes(tmpNodes, tmpBlock, nodesFile);
     loadMerged(mergedFile);
-    loadNames(namesFile);
+    loadNames(tmpNodes, tmpBlock, namesFile);
 
-    maxNodes = taxonNodes.size();
+    maxNodes = tmpNodes.size();
+    taxonNodes = new TaxonNode[maxNodes];
+    std::copy(tmpNodes.begin(), tmpNodes.end(), taxonNodes);
+    blockSize = tmpBlock.size();
+    block = new char[blockSize];
+    memcpy(block, tmpBlock.data(), blockSize);
 
-    E.reserve(maxNodes * 2);
-    L.reserve(maxNodes * 2);
+    std::vector<int> tmpE;
+    std::vector<int> tmpL;
+    tmpE.reserve(maxNodes * 2);
+    tmpL.reserve(maxNodes * 2);
 
     H = new int[maxNodes];
     std::fill(H, H + maxNodes, 0);
 
-    std::vector< std::vector<TaxID> > children(taxonNodes.size());
-    for (std::vector<TaxonNode>::iterator it = taxonNodes.begin(); it != taxonNodes.end(); ++it) {
-        if (it->parentTaxId != it->taxId) {
-            children[nodeId(it->parentTaxId)].push_back(it->taxId);
+    std::vector< std::vector<TaxID> > children(maxNodes);
+    for (size_t i = 0; i < maxNodes; ++i) {
+        if (taxonNodes[i].parentTaxId != taxonNodes[i].taxId) {
+            children[nodeId(taxonNodes[i].parentTaxId)].push_back(taxonNodes[i].taxId);
         }
     }
 
-    elh(children, 1, 0);
-    E.resize(maxNodes * 2, 0);
-    L.resize(maxNodes * 2, 0);
+    elh(children, 1, 0, tmpE, tmpL);
+    tmpE.resize(maxNodes * 2, 0);
+    tmpL.resize(maxNodes * 2, 0);
+    E = new int[maxNodes * 2];
+    L = new int[maxNodes * 2];
+    std::copy(tmpE.begin(), tmpE.end(), E);
+    std::copy(tmpL.begin(), tmpL.end(), L);
 
-    M = makeMatrix(maxNodes);
+    rmqLevels = (size_t)(MathUtil::flog2(maxNodes * 2)) + 1;
+    M = new int[maxNodes * 2 * rmqLevels]();
     InitRangeMinimumQuery();
 }
 
+NcbiTaxonomy::NcbiTaxonomy(char *data, size_t dataSize) : mappedData(data), mappedSize(dataSize) {
+    InitLevels();
+
+    TaxonomyHeader *header = reinterpret_cast<TaxonomyHeader*>(data);
+    maxNodes = header->maxNodes;
+    maxTaxID = header->maxTaxID;
+    rmqLevels = header->rmqLevels;
+    blockSize = header->blockSize;
+
+    char *p = data + sizeof(TaxonomyHeader);
+    taxonNodes = reinterpret_cast<TaxonNode*>(p);
+    p += maxNodes * sizeof(TaxonNode);
+    D = reinterpret_cast<int*>(p);
+    p += (maxTaxID + 1) * sizeof(int);
+    E = reinterpret_cast<int*>(p);
+    p += maxNodes * 2 * sizeof(int);
+    L = reinterpret_cast<int*>(p);
+    p += maxNodes * 2 * sizeof(int);
+    H = reinterpret_cast<int*>(p);
+    p += maxNodes * sizeof(int);
+    M = reinterpret_cast<int*>(p);
+    p += maxNodes * 2 * rmqLevels * sizeof(int);
+    block = p;
+}
+
 NcbiTaxonomy::~NcbiTaxonomy() {
+    if (mappedData != NULL) {
+        munmap(mappedData, mappedSize);
+        return;
+    }
+    delete[] taxonNodes;
+    delete[] D;
+    delete[] E;
+    delete[] L;
     delete[] H;
-    deleteMatrix(M, maxNodes);
+    delete[] M;
+    delete[] block;
+}
+
+static size_t taxonomyFileSize(size_t headerSize, size_t maxNodes, size_t maxTaxID, size_t rmqLevels, size_t blockSize) {
+    return headerSize + maxNodes * sizeof(TaxonNode) + (maxTaxID + 1) * sizeof(int)
+           + (maxNodes * 2 + maxNodes * 2 + maxNodes + maxNodes * 2 * rmqLevels) * sizeof(int) + blockSize;
+}
+
+void NcbiTaxonomy::writeTaxonomy(const std::string &fileName) const {
+    TaxonomyHeader header;
+    memset(&header, 0, sizeof(TaxonomyHeader));
+    memcpy(header.magic, "MMSTAX01", sizeof(header.magic));
+    header.maxNodes = maxNodes;
+    header.maxTaxID = maxTaxID;
+    header.rmqLevels = rmqLevels;
+    header.blockSize = blockSize;
+
+    FILE *file = FileUtil::openAndDelete(fileName.c_str(), "wb");
+    bool success = fwrite(&header, sizeof(TaxonomyHeader), 1, file) == 1;
+    success = success && fwrite(taxonNodes, sizeof(TaxonNode), maxNodes, file) == maxNodes;
+    success = success && fwrite(D, sizeof(int), maxTaxID + 1, file) == maxTaxID + 1;
+    success = success && fwrite(E, sizeof(int), maxNodes * 2, file) == maxNodes * 2;
+    success = success && fwrite(L, sizeof(int), maxNodes * 2, file) == maxNodes * 2;
+    success = success && fwrite(H, sizeof(int), maxNodes, file) == maxNodes;
+    success = success && fwrite(M, sizeof(int), maxNodes * 2 * rmqLevels, file) == maxNodes * 2 * rmqLevels;
+    success = success && fwrite(block, sizeof(char), blockSize, file) == blockSize;
+    if (success == false) {
+        Debug(Debug::ERROR) << "Can not write to taxonomy file " << fileName << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    fclose(file);
+}
+
+NcbiTaxonomy* NcbiTaxonomy::openTaxonomy(const std::string &database) {
+    std::string binFile = getTaxonomyFile(database);
+    if (FileUtil::fileExists(binFile.c_str())) {
+        int fd = open(binFile.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd == -1 || fstat(fd, &st) != 0) {
+            Debug(Debug::ERROR) << "Can not open taxonomy file " << binFile << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        size_t fileSize = st.st_size;
+        TaxonomyHeader header;
+        if (fileSize < sizeof(TaxonomyHeader)
+            || pread(fd, &header, sizeof(TaxonomyHeader), 0) != sizeof(TaxonomyHeader)
+            || memcmp(header.magic, "MMSTAX01", sizeof(header.magic)) != 0
+            || fileSize != taxonomyFileSize(sizeof(TaxonomyHeader), header.maxNodes, header.maxTaxID, header.rmqLevels, header.blockSize)) {
+            Debug(Debug::ERROR) << "Taxonomy file " << binFile << " is invalid. Please recreate it with createbintaxonomy!\n";
+            EXIT(EXIT_FAILURE);
+        }
+        // read only and shared, all processes using the same taxonomy share its pages
+        char *data = static_cast<char*>(mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0));
+        close(fd);
+        if (data == MAP_FAILED) {
+            Debug(Debug::ERROR) << "Failed to mmap taxonomy file " << binFile << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        return new NcbiTaxonomy(data, fileSize);
+    }
+
+    std::string nodesFile = database + "_nodes.dmp";
+    std::string namesFile = database + "_names.dmp";
+    std::string mergedFile = database + "_merged.dmp";
+    if (FileUtil::fileExists(nodesFile.c_str())
+        && FileUtil::fileExists(namesFile.c_str())
+        && FileUtil::fileExists(mergedFile.c_str())) {
+    } else if (FileUtil::fileExists("nodes.dmp")
+               && FileUtil::fileExists("names.dmp")
+               && FileUtil::fileExists("merged.dmp")) {
+        nodesFile = "nodes.dmp";
+        namesFile = "names.dmp";
+        mergedFile = "merged.dmp";
+    } else {
+        Debug(Debug::ERROR) << binFile << " or names.dmp, nodes.dmp and merged.dmp from NCBI taxdump could not be found!\n";
+        EXIT(EXIT_FAILURE);
+    }
+    return new NcbiTaxonomy(namesFile, nodesFile, mergedFile);
 }
 
 void NcbiTaxonomy::InitLevels() {
@@ -123,7 +234,7 @@ std::vector<std::string> splitByDelimiter(const std::string &s, const std::strin
     return result;
 }
 
-size_t NcbiTaxonomy::loadNodes(const std::string &nodesFile) {
+size_t NcbiTaxonomy::loadNodes(std::vector<TaxonNode> &tmpNodes, std::string &tmpBlock, const std::string &nodesFile) {
     Debug(Debug::INFO) << "Loading nodes file ...";
     std::ifstream ss(nodesFile);
     if (ss.fail()) {
@@ -132,37 +243,45 @@ size_t NcbiTaxonomy::loadNodes(const std::string &nodesFile) {
     }
 
     std::map<TaxID, int> Dm; // temporary map TaxID -> internal ID;
-    int maxTaxID = 0;
+    std::map<std::string, size_t> rankIdx; // ranks are stored once in the string block
+    int maxId = 0;
     int currentId = 0;
     std::string line;
     while (std::getline(ss, line)) {
         std::vector<std::string> result = splitByDelimiter(line, "\t|\t", 3);
         TaxID taxId = (TaxID) strtol(result[0].c_str(), NULL, 10);
         TaxID parentTaxId = (TaxID) strtol(result[1].c_str(), NULL, 10);
-        if (taxId > maxTaxID) {
-            maxTaxID = taxId;
+        if (taxId > maxId) {
+            maxId = taxId;
         }
-        taxonNodes.emplace_back(currentId, taxId, parentTaxId, result[2]);
+        std::map<std::string, size_t>::iterator it = rankIdx.find(result[2]);
+        if (it == rankIdx.end()) {
+            it = rankIdx.emplace(result[2], tmpBlock.size()).first;
+            tmpBlock.append(result[2]);
+            tmpBlock.push_back('\0');
+        }
+        tmpNodes.emplace_back(currentId, taxId, parentTaxId, it->second, 0);
         Dm.emplace(taxId, currentId);
         ++currentId;
     }
 
-    D.clear();
-    D.resize(maxTaxID, -1);
+    maxTaxID = maxId;
+    D = new int[maxTaxID + 1];
+    std::fill(D, D + maxTaxID + 1, -1);
     for (std::map<TaxID, int>::iterator it = Dm.begin(); it != Dm.end(); ++it) {
         D[it->first] = it->second;
     }
 
     // Loop over taxonNodes and check all parents exist
-    for (std::vector<TaxonNode>::iterator it = taxonNodes.begin(); it != taxonNodes.end(); ++it) {
+    for (std::vector<TaxonNode>::iterator it = tmpNodes.begin(); it != tmpNodes.end(); ++it) {
         if (!nodeExists(it->parentTaxId)) {
             Debug(Debug::ERROR) << "Inconsistent nodes.dmp taxonomy file! Cannot find parent taxon with ID " << it->parentTaxId << "!\n";
             EXIT(EXIT_FAILURE);
         }
     }
 
-    Debug(Debug::INFO) << " Done, got " << taxonNodes.size() << " nodes\n";
-    return taxonNodes.size();
+    Debug(Debug::INFO) << " Done, got " << tmpNodes.size() << " nodes\n";
+    return tmpNodes.size();
 }
 
 std::pair<int, std::string> parseName(const std::string &line) {
@@ -174,7 +293,7 @@ std::pair<int, std::string> parseName(const std::string &line) {
     return std::make_pair((int)strtol(result[0].c_str(), NULL, 10), result[1]);
 }
 
-void NcbiTaxonomy::loadNames(const std::string &namesFile) {
+void NcbiTaxonomy::loadNames(std::vector<TaxonNode> &tmpNodes, std::string &tmpBlock, const std::string &namesFile) {
     Debug(Debug::INFO) << "Loading names file ...";
     std::ifstream ss(namesFile);
     if (ss.fail()) {
@@ -193,45 +312,47 @@ void NcbiTaxonomy::loadNames(const std::string &namesFile) {
             Debug(Debug::ERROR) << "loadNames: Taxon " << entry.first << " not present in nodes file!\n";
             EXIT(EXIT_FAILURE);
         }
-        taxonNodes[nodeId(entry.first)].name = entry.second;
+        tmpNodes[nodeId(entry.first)].nameIdx = tmpBlock.size();
+        tmpBlock.append(entry.second);
+        tmpBlock.push_back('\0');
     }
     Debug(Debug::INFO) << " Done\n";
 }
 
 // Euler traversal of tree
-void NcbiTaxonomy::elh(std::vector< std::vector<TaxID> > const & children, TaxID taxId, int level) {
+void NcbiTaxonomy::elh(std::vector< std::vector<TaxID> > const & children, TaxID taxId, int level, std::vector<int> &tmpE, std::vector<int> &tmpL) {
     assert (taxId > 0);
     int id = nodeId(taxId);
 
     if (H[id] == 0) {
-        H[id] = E.size();
+        H[id] = tmpE.size();
     }
 
-    E.emplace_back(id);
-    L.emplace_back(level);
+    tmpE.emplace_back(id);
+    tmpL.emplace_back(level);
 
     for (std::vector<TaxID>::const_iterator child_it = children[id].begin(); child_it != children[id].end(); ++child_it) {
-        elh(children, *child_it, level + 1);
+        elh(children, *child_it, level + 1, tmpE, tmpL);
     }
-    E.emplace_back(nodeId(taxonNodes[id].parentTaxId));
-    L.emplace_back(level - 1);
+    tmpE.emplace_back(nodeId(taxonNodes[id].parentTaxId));
+    tmpL.emplace_back(level - 1);
 }
 
 void NcbiTaxonomy::InitRangeMinimumQuery() {
     Debug(Debug::INFO) << "Init RMQ ...";
 
     for (unsigned int i = 0; i < (maxNodes * 2); ++i) {
-        M[i][0] = i;
+        M[i * rmqLevels] = i;
     }
 
     for (unsigned int j = 1; (1ul << j) <= (maxNodes * 2); ++j) {
         for (unsigned int i = 0; (i + (1ul << j) - 1) < (maxNodes * 2); ++i) {
-            int A = M[i][j - 1];
-            int B = M[i + (1ul << (j - 1))][j - 1];
+            int A = M[i * rmqLevels + j - 1];
+            int B = M[(i + (1ul << (j - 1))) * rmqLevels + j - 1];
             if (L[A] < L[B]) {
-                M[i][j] = A;
+                M[i * rmqLevels + j] = A;
             } else {
-                M[i][j] = B;
+                M[i * rmqLevels + j] = B;
             }
         }
     }
@@ -241,8 +362,8 @@ void NcbiTaxonomy::InitRangeMinimumQuery() {
 int NcbiTaxonomy::RangeMinimumQuery(int i, int j) const {
     assert(j >= i);
     int k = (int)MathUtil::flog2(j - i + 1);
-    int A = M[i][k];
-    int B = M[j - MathUtil::ipow<int>(2, k) + 1][k];
+    int A = M[i * rmqLevels + k];
+    int B = M[(j - MathUtil::ipow<int>(2, k) + 1) * rmqLevels + k];
     if (L[A] <= L[B]) {
         return A;
     }
@@ -320,7 +441,7 @@ TaxonNode const * NcbiTaxonomy::LCA(const std::vector<TaxID>& taxa) const {
         }
     }
 
-    assert(red >= 0 && static_cast<unsigned int>(red) < taxonNodes.size());
+    assert(red >= 0 && static_cast<unsigned int>(red) < maxNodes);
 
     return &(taxonNodes[red]);
 }
@@ -330,8 +451,8 @@ TaxonNode const * NcbiTaxonomy::LCA(const std::vector<TaxID>& taxa) const {
 std::vector<std::string> NcbiTaxonomy::AtRanks(TaxonNode const *node, const std::vector<std::string> &levels) const {
     std::vector<std::string> result;
     std::map<std::string, std::string> allRanks = AllRanks(node);
-    int baseRankIndex = sortedLevels.at(node->rank);
-    std::string baseRank = "uc_" + node->name;
+    int baseRankIndex = sortedLevels.at(getString(node->rankIdx));
+    std::string baseRank = "uc_" + std::string(getString(node->nameIdx));
     for (std::vector<std::string>::const_iterator it = levels.begin(); it != levels.end(); ++it) {
         std::map<std::string, std::string>::iterator jt = allRanks.find(*it);
         if (jt != allRanks.end()) {
@@ -370,9 +491,9 @@ std::string NcbiTaxonomy::taxLineage(TaxonNode const *node) {
     } while (node->parentTaxId != node->taxId);
 
     for (int i = taxLineageVec.size() - 1; i >= 0; --i) {
-        taxLineage += getShortRank(taxLineageVec[i]->rank);
+        taxLineage += getShortRank(getString(taxLineageVec[i]->rankIdx));
         taxLineage += '_';
-        taxLineage += taxLineageVec[i]->name;
+        taxLineage += getString(taxLineageVec[i]->nameIdx);
         if (i > 0) {
             taxLineage += ";";
         }
@@ -389,7 +510,7 @@ int NcbiTaxonomy::nodeId(TaxID taxonId) const {
 }
 
 bool NcbiTaxonomy::nodeExists(TaxID taxonId) const {
-    return D[taxonId] != -1;
+    return taxonId >= 0 && static_cast<size_t>(taxonId) <= maxTaxID && D[taxonId] != -1;
 }
 
 TaxonNode const * NcbiTaxonomy::taxonNode(TaxID taxonId, bool fail) const {
@@ -403,12 +524,12 @@ std::map<std::string, std::string> NcbiTaxonomy::AllRanks(TaxonNode const *node)
     std::map<std::string, std::string> result;
     while (true) {
         if (node->taxId == 1) {
-            result.emplace(node->rank, node->name);
+            result.emplace(getString(node->rankIdx), getString(node->nameIdx));
             return result;
         }
 
-        if (node->rank != "no_rank") {
-            result.emplace(node->rank, node->name);
+        if (strcmp(getString(node->rankIdx), "no_rank") != 0) {
+            result.emplace(getString(node->rankIdx), getString(node->nameIdx));
         }
 
         node = taxonNode(node->parentTaxId);
@@ -424,7 +545,8 @@ size_t NcbiTaxonomy::loadMerged(const std::string &mergedFile) {
     }
 
     std::string line;
-    size_t count = 0;
+    std::vector<std::pair<unsigned int, unsigned int>> merged;
+    size_t maxId = maxTaxID;
     while (std::getline(ss, line)) {
         std::vector<std::string> result = splitByDelimiter(line, "\t|\t", 2);
         if (result.size() != 2) {
@@ -434,8 +556,24 @@ size_t NcbiTaxonomy::loadMerged(const std::string &mergedFile) {
 
         unsigned int oldId = (unsigned int)strtoul(result[0].c_str(), NULL, 10);
         unsigned int mergedId = (unsigned int)strtoul(result[1].c_str(), NULL, 10);
-        if (!nodeExists(oldId) && nodeExists(mergedId)) {
-            D[oldId] = D[mergedId];
+        merged.emplace_back(oldId, mergedId);
+        maxId = std::max(maxId, (size_t)oldId);
+    }
+
+    // merged taxa can have larger IDs than all current ones
+    if (maxId > maxTaxID) {
+        int *grown = new int[maxId + 1];
+        std::copy(D, D + maxTaxID + 1, grown);
+        std::fill(grown + maxTaxID + 1, grown + maxId + 1, -1);
+        delete[] D;
+        D = grown;
+        maxTaxID = maxId;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < merged.size(); ++i) {
+        if (!nodeExists(merged[i].first) && nodeExists(merged[i].second)) {
+            D[merged[i].first] = D[merged[i].second];
             ++count;
         }
     }
@@ -443,26 +581,20 @@ size_t NcbiTaxonomy::loadMerged(const std::string &mergedFile) {
     return count;
 }
 
-std::unordered_map<TaxID, TaxonCounts> NcbiTaxonomy::getCladeCounts(std::unordered_map<TaxID, unsigned int>& taxonCounts) const {
+std::vector<size_t> NcbiTaxonomy::getCladeCounts(const std::vector<size_t> &taxonCounts) const {
     Debug(Debug::INFO) << "Calculating clade counts ... ";
-    std::unordered_map<TaxID, TaxonCounts> cladeCounts;
-
-    for (std::unordered_map<TaxID, unsigned int>::const_iterator it = taxonCounts.begin(); it != taxonCounts.end(); ++it) {
-        cladeCounts[it->first].taxCount = it->second;
-        cladeCounts[it->first].cladeCount += it->second;
-        if (nodeExists(it->first)) {
-            TaxonNode const* taxon = taxonNode(it->first);
-            while (taxon->parentTaxId != taxon->taxId && nodeExists(taxon->parentTaxId)) {
-                taxon = taxonNode(taxon->parentTaxId);
-                cladeCounts[taxon->taxId].cladeCount += it->second;
-            }
-        }
-    }
+    std::vector<size_t> cladeCounts(taxonCounts);
 
-    for (const TaxonNode& tn : taxonNodes) {
-        if (tn.parentTaxId != tn.taxId && cladeCounts.count(tn.taxId)) {
-            std::unordered_map<TaxID, TaxonCounts>::iterator itp = cladeCounts.find(tn.parentTaxId);
-            itp->second.children.push_back(tn.taxId);
+    // the Euler tour visits every node first after its parent, so adding up the nodes
+    // in reverse order of their first visit finishes each clade before its parent
+    for (size_t i = maxNodes * 2; i > 0; --i) {
+        const int id = E[i - 1];
+        if (static_cast<size_t>(H[id]) != i - 1) {
+            continue;
+        }
+        const TaxonNode &tn = taxonNodes[id];
+        if (tn.parentTaxId != tn.taxId && nodeExists(tn.parentTaxId)) {
+            cladeCounts[nodeId(tn.parentTaxId)] += cladeCounts[id];
         }
     }
 
@@ -6,27 +6,23 @@
 #define MMSEQS_NCBITAXONOMY_H
 
 #include <map>
-#include <unordered_map>
 #include <vector>
 #include <string>
 
 typedef int TaxID;
 
+// fixed size to be mappable from the binary taxonomy, rank and name are offsets into the string block
 struct TaxonNode {
     int id;
     TaxID taxId;
     TaxID parentTaxId;
-    std::string rank;
-    std::string name;
+    size_t rankIdx;
+    size_t nameIdx;
 
-    TaxonNode(int id, TaxID taxId, TaxID parentTaxId, const std::string& rank)
-            : id(id), taxId(taxId), parentTaxId(parentTaxId), rank(rank), name("") {};
-};
+    TaxonNode() {};
 
-struct TaxonCounts {
-    unsigned int taxCount;       // number of reads/sequences matching to taxa
-    unsigned int cladeCount;     // number of reads/sequences matching to taxa or its children
-    std::vector<TaxID> children; // list of children
+    TaxonNode(int id, TaxID taxId, TaxID parentTaxId, size_t rankIdx, size_t nameIdx)
+            : id(id), taxId(taxId), parentTaxId(parentTaxId), rankIdx(rankIdx), nameIdx(nameIdx) {};
 };
 
 class NcbiTaxonomy {
@@ -35,6 +31,14 @@ public:
                  const std::string &mergedFile);
     ~NcbiTaxonomy();
 
+    // maps <database>_taxonomy written by createbintaxonomy,
+    // otherwise parses the NCBI dump files next to the database or in the working directory
+    static NcbiTaxonomy* openTaxonomy(const std::string &database);
+    static std::string getTaxonomyFile(const std::string &database) {
+        return database + "_taxonomy";
+    }
+    void writeTaxonomy(const std::string &fileName) const;
+
     TaxonNode const * LCA(const std::vector<TaxID>& taxa) const;
     TaxID LCA(TaxID taxonA, TaxID taxonB) const;
     std::vector<std::string> AtRanks(TaxonNode const * node, const std::vector<std::string> &levels) const;
@@ -43,15 +47,33 @@ public:
 
     bool IsAncestor(TaxID ancestor, TaxID child);
     TaxonNode const* taxonNode(TaxID taxonId, bool fail = true) const;
-    //std::unordered_map<TaxID, unsigned int> getCladeCounts(std::unordered_map<TaxID, unsigned int>& taxonCounts, TaxID taxon = 1) const;
-    std::unordered_map<TaxID, TaxonCounts> getCladeCounts(std::unordered_map<TaxID, unsigned int>& taxonCounts) const;
+    // taxonCounts holds the number of reads/sequences per internal node id, returns the number of reads/sequences
+    // of each node and all of its descendants
+    std::vector<size_t> getCladeCounts(const std::vector<size_t> &taxonCounts) const;
+
+    const char *getString(size_t blockIdx) const {
+        return block + blockIdx;
+    }
+
+    // internal node ids are positions in the node array, TaxonNode::id holds them
+    TaxonNode const* taxonNodeById(int nodeId) const {
+        return &taxonNodes[nodeId];
+    }
+    size_t getNodeCount() const {
+        return maxNodes;
+    }
+    size_t getMaxTaxID() const {
+        return maxTaxID;
+    }
 
 private:
+    NcbiTaxonomy(char *data, size_t dataSize);
+
     void InitLevels();
-    size_t loadNodes(const std::string &nodesFile);
+    size_t loadNodes(std::vector<TaxonNode> &tmpNodes, std::string &tmpBlock, const std::string &nodesFile);
     size_t loadMerged(const std::string &mergedFile);
-    void loadNames(const std::string &namesFile);
-    void elh(std::vector< std::vector<TaxID> > const & children, int node, int level);
+    void loadNames(std::vector<TaxonNode> &tmpNodes, std::string &tmpBlock, const std::string &namesFile);
+    void elh(std::vector< std::vector<TaxID> > const & children, int node, int level, std::vector<int> &tmpE, std::vector<int> &tmpL);
     void InitRangeMinimumQuery();
     int nodeId(TaxID taxId) const;
     bool nodeExists(TaxID taxId) const;
@@ -60,13 +82,29 @@ private:
     int lcaHelper(int i, int j) const;
     char getShortRank(const std::string& rank) const;
 
-    std::vector<TaxonNode> taxonNodes;
-    std::vector<int> D; // maps from taxID to node ID in taxonNodes
-    std::vector<int> E; // for Euler tour sequence (size 2N-1)
-    std::vector<int> L; // Level of nodes in tour sequence (size 2N-1)
-    int* H;
-    int **M;
+    struct TaxonomyHeader {
+        char magic[8];
+        size_t maxNodes;
+        size_t maxTaxID;
+        size_t rmqLevels;
+        size_t blockSize;
+    };
+
+    // either owned or pointing into the mapped binary taxonomy
+    TaxonNode *taxonNodes;
+    int *D; // maps from taxID to node ID in taxonNodes (size maxTaxID + 1)
+    int *E; // for Euler tour sequence (size 2N)
+    int *L; // Level of nodes in tour sequence (size 2N)
+    int *H; // first occurrence of a node in the tour (size N)
+    int *M; // sparse table over the tour, row i holds rmqLevels entries
+    char *block; // zero terminated ranks and names
     size_t maxNodes;
+    size_t maxTaxID;
+    size_t rmqLevels;
+    size_t blockSize;
+
+    char *mappedData;
+    size_t mappedSize;
 
     std::map<std::string, int> sortedLevels;
     std::map<std::string, char> shortRank;
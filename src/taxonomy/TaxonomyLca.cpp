@@ -0,0 +1,65 @@
+#include "TaxonomyLca.h"
+#include "Debug.h"
+#include "Util.h"
+
+TaxonomyLca::TaxonomyLca(const std::string &targetDb, const Parameters &par) : showTaxLineage(par.showTaxLineage) {
+    ranks = Util::split(par.lcaRanks, ":");
+
+    // a few NCBI taxa are blacklisted by default, they contain unclassified sequences (e.g. metagenomes) or other sequences (e.g. plasmids)
+    // if we do not remove those, a lot of sequences would be classified as Root, even though they have a sensible LCA
+    std::vector<std::string> list = Util::split(par.blacklist, ",");
+    for (size_t i = 0; i < list.size(); ++i) {
+        TaxID taxon = Util::fast_atoi<int>(list[i].c_str());
+        if (taxon != 0) {
+            blacklist.push_back(taxon);
+        }
+    }
+
+    Debug(Debug::INFO) << "Loading NCBI taxonomy\n";
+    taxonomy = NcbiTaxonomy::openTaxonomy(targetDb);
+    mapping = TaxonomyMapping::openMapping(targetDb, *taxonomy);
+}
+
+TaxonomyLca::~TaxonomyLca() {
+    delete mapping;
+    delete taxonomy;
+}
+
+bool TaxonomyLca::addTaxon(unsigned int key, std::vector<TaxID> &taxa) const {
+    int nodeId = mapping->nodeId(key);
+    if (nodeId == TaxonomyMapping::NOT_MAPPED) {
+        return false;
+    }
+    // the LCA ignores taxa without node
+    if (nodeId == TaxonomyMapping::NOT_IN_TAXONOMY) {
+        return true;
+    }
+    TaxID taxon = taxonomy->taxonNodeById(nodeId)->taxId;
+
+    // remove blacklisted taxa
+    for (size_t j = 0; j < blacklist.size(); ++j) {
+        if (taxonomy->IsAncestor(blacklist[j], taxon)) {
+            return true;
+        }
+    }
+    taxa.emplace_back(taxon);
+    return true;
+}
+
+void TaxonomyLca::writeLca(const std::vector<TaxID> &taxa, std::string &result) const {
+    TaxonNode const * node = taxonomy->LCA(taxa);
+    if (node == NULL) {
+        writeUnclassified(result);
+        return;
+    }
+
+    result += SSTR(node->taxId) + '\t' + taxonomy->getString(node->rankIdx) + '\t' + taxonomy->getString(node->nameIdx);
+    if (!ranks.empty()) {
+        std::string lcaRanks = Util::implode(taxonomy->AtRanks(node, ranks), ':');
+        result += '\t' + lcaRanks;
+    }
+    if (showTaxLineage) {
+        result += '\t' + taxonomy->taxLineage(node);
+    }
+    result += '\n';
+}
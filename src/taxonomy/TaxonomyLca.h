@@ -0,0 +1,40 @@
+#ifndef MMSEQS_TAXONOMYLCA_H
+#define MMSEQS_TAXONOMYLCA_H
+
+// Assigns the lowest common ancestor of the targets of an alignment result.
+// Shared by the lca module and the alignment module when it computes the LCA right after aligning (--fused-lca).
+
+#include "NcbiTaxonomy.h"
+#include "TaxonomyMapping.h"
+#include "Parameters.h"
+
+#include <string>
+#include <vector>
+
+class TaxonomyLca {
+public:
+    // loads the taxonomy and taxon mapping of targetDb, uses --lca-ranks, --blacklist and --tax-lineage
+    TaxonomyLca(const std::string &targetDb, const Parameters &par);
+    ~TaxonomyLca();
+
+    // adds the taxon of target key to taxa unless it is blacklisted
+    // returns false if the key has no taxon mapping
+    bool addTaxon(unsigned int key, std::vector<TaxID> &taxa) const;
+
+    // appends the result line of the LCA of taxa to result
+    void writeLca(const std::vector<TaxID> &taxa, std::string &result) const;
+
+    // appends the result line of an entry without hits to result
+    static void writeUnclassified(std::string &result) {
+        result.append("0\tno rank\tunclassified\n");
+    }
+
+private:
+    NcbiTaxonomy *taxonomy;
+    TaxonomyMapping *mapping;
+    std::vector<std::string> ranks;
+    std::vector<TaxID> blacklist;
+    bool showTaxLineage;
+};
+
+#endif
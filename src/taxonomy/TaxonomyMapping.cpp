@@ -0,0 +1,142 @@
+#include "TaxonomyMapping.h"
+#include "FileUtil.h"
+#include "Debug.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char MAPPING_MAGIC[8] = { 'M', 'M', 'S', 'M', 'A', 'P', '0', '2' };
+// written before the header had a taxonomy fingerprint
+static const char MAPPING_MAGIC_V1[8] = { 'M', 'M', 'S', 'M', 'A', 'P', '0', '1' };
+
+size_t TaxonomyMapping::getFingerprint(const NcbiTaxonomy &taxonomy) {
+    size_t fingerprint = 0;
+    for (size_t i = 0; i < taxonomy.getNodeCount(); ++i) {
+        TaxonNode const *node = taxonomy.taxonNodeById(i);
+        fingerprint = fingerprint * 31 + static_cast<size_t>(node->taxId);
+        fingerprint = fingerprint * 31 + static_cast<size_t>(node->parentTaxId);
+    }
+    return fingerprint;
+}
+
+TaxonomyMapping::TaxonomyMapping(const std::string &mappingFile, const NcbiTaxonomy &taxonomy)
+        : taxonomyNodes(taxonomy.getNodeCount()), taxonomyMaxTaxID(taxonomy.getMaxTaxID()),
+          taxonomyFingerprint(getFingerprint(taxonomy)), mappedData(NULL), mappedSize(0) {
+    std::vector<std::pair<unsigned int, unsigned int>> mapping;
+    Util::readMapping(mappingFile, mapping);
+    unsigned int maxKey = 0;
+    for (size_t i = 0; i < mapping.size(); ++i) {
+        maxKey = std::max(maxKey, mapping[i].first);
+    }
+    size = mapping.empty() ? 0 : static_cast<size_t>(maxKey) + 1;
+    nodeIds = new int[size];
+    std::fill(nodeIds, nodeIds + size, NOT_MAPPED);
+    // the first line of a key wins
+    for (size_t i = 0; i < mapping.size(); ++i) {
+        int &nodeId = nodeIds[mapping[i].first];
+        if (nodeId != NOT_MAPPED) {
+            continue;
+        }
+        TaxonNode const *node = taxonomy.taxonNode(mapping[i].second, false);
+        nodeId = (node != NULL) ? node->id : NOT_IN_TAXONOMY;
+    }
+}
+
+TaxonomyMapping::TaxonomyMapping(char *data, size_t dataSize) : mappedData(data), mappedSize(dataSize) {
+    MappingHeader *header = reinterpret_cast<MappingHeader*>(data);
+    size = header->size;
+    taxonomyNodes = header->taxonomyNodes;
+    taxonomyMaxTaxID = header->taxonomyMaxTaxID;
+    taxonomyFingerprint = header->taxonomyFingerprint;
+    nodeIds = reinterpret_cast<int*>(data + sizeof(MappingHeader));
+}
+
+TaxonomyMapping::~TaxonomyMapping() {
+    if (mappedData != NULL) {
+        munmap(mappedData, mappedSize);
+        return;
+    }
+    delete[] nodeIds;
+}
+
+void TaxonomyMapping::writeMapping(const std::string &fileName) const {
+    MappingHeader header;
+    memset(&header, 0, sizeof(MappingHeader));
+    memcpy(header.magic, MAPPING_MAGIC, sizeof(MAPPING_MAGIC));
+    header.size = size;
+    header.taxonomyNodes = taxonomyNodes;
+    header.taxonomyMaxTaxID = taxonomyMaxTaxID;
+    header.taxonomyFingerprint = taxonomyFingerprint;
+
+    FILE *file = FileUtil::openAndDelete(fileName.c_str(), "wb");
+    bool success = fwrite(&header, sizeof(MappingHeader), 1, file) == 1;
+    success = success && fwrite(nodeIds, sizeof(int), size, file) == size;
+    if (success == false) {
+        Debug(Debug::ERROR) << "Can not write to mapping file " << fileName << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    fclose(file);
+}
+
+TaxonomyMapping* TaxonomyMapping::openMapping(const std::string &database, const NcbiTaxonomy &taxonomy) {
+    std::string binFile = getMappingFile(database);
+    std::string mappingFile = database + "_mapping";
+    struct stat binStat;
+    struct stat mappingStat;
+    bool hasBin = stat(binFile.c_str(), &binStat) == 0;
+    bool hasMapping = stat(mappingFile.c_str(), &mappingStat) == 0;
+    if (hasBin && hasMapping && mappingStat.st_mtime > binStat.st_mtime) {
+        Debug(Debug::WARNING) << mappingFile << " is newer than " << binFile << ", ignoring the binary mapping.\n";
+        hasBin = false;
+    }
+
+    if (hasBin) {
+        int fd = open(binFile.c_str(), O_RDONLY);
+        if (fd == -1) {
+            Debug(Debug::ERROR) << "Can not open mapping file " << binFile << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        size_t fileSize = binStat.st_size;
+        MappingHeader header;
+        bool isOldVersion = fileSize >= sizeof(MAPPING_MAGIC_V1)
+                            && pread(fd, &header, sizeof(MAPPING_MAGIC_V1), 0) == sizeof(MAPPING_MAGIC_V1)
+                            && memcmp(header.magic, MAPPING_MAGIC_V1, sizeof(MAPPING_MAGIC_V1)) == 0;
+        if (isOldVersion == false
+            && (fileSize < sizeof(MappingHeader)
+                || pread(fd, &header, sizeof(MappingHeader), 0) != sizeof(MappingHeader)
+                || memcmp(header.magic, MAPPING_MAGIC, sizeof(MAPPING_MAGIC)) != 0
+                || fileSize != sizeof(MappingHeader) + header.size * sizeof(int))) {
+            Debug(Debug::ERROR) << "Mapping file " << binFile << " is invalid. Please recreate it with createbintaxonomy!\n";
+            EXIT(EXIT_FAILURE);
+        }
+        if (isOldVersion == false
+            && header.taxonomyNodes == taxonomy.getNodeCount() && header.taxonomyMaxTaxID == taxonomy.getMaxTaxID()
+            && header.taxonomyFingerprint == getFingerprint(taxonomy)) {
+            char *data = static_cast<char*>(mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0));
+            close(fd);
+            if (data == MAP_FAILED) {
+                Debug(Debug::ERROR) << "Failed to mmap mapping file " << binFile << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            return new TaxonomyMapping(data, fileSize);
+        }
+        close(fd);
+        if (isOldVersion) {
+            Debug(Debug::WARNING) << binFile << " was created by an older version, ignoring it. Please recreate it with createbintaxonomy.\n";
+        } else {
+            Debug(Debug::WARNING) << binFile << " was created for a different taxonomy, ignoring it.\n";
+        }
+    }
+
+    if (hasMapping == false) {
+        Debug(Debug::ERROR) << mappingFile << " does not exist. Please create the taxonomy mapping!\n";
+        EXIT(EXIT_FAILURE);
+    }
+    return new TaxonomyMapping(mappingFile, taxonomy);
+}
@@ -0,0 +1,60 @@
+#ifndef MMSEQS_TAXONOMYMAPPING_H
+#define MMSEQS_TAXONOMYMAPPING_H
+
+// Maps the keys of a sequence database to the internal node ids of its taxonomy,
+// so every hit resolves to its taxon with one array access.
+
+#include "NcbiTaxonomy.h"
+
+#include <string>
+
+class TaxonomyMapping {
+public:
+    // key without taxon in the mapping
+    static const int NOT_MAPPED = -1;
+    // key with a taxon that is not part of the taxonomy (e.g. deleted)
+    static const int NOT_IN_TAXONOMY = -2;
+
+    // reads a key to taxon TSV file
+    TaxonomyMapping(const std::string &mappingFile, const NcbiTaxonomy &taxonomy);
+    ~TaxonomyMapping();
+
+    // maps <database>_mapping.bin written by createbintaxonomy if it was built for this taxonomy,
+    // otherwise reads <database>_mapping
+    static TaxonomyMapping* openMapping(const std::string &database, const NcbiTaxonomy &taxonomy);
+    static std::string getMappingFile(const std::string &database) {
+        return database + "_mapping.bin";
+    }
+    void writeMapping(const std::string &fileName) const;
+
+    int nodeId(unsigned int key) const {
+        return (key < size) ? nodeIds[key] : NOT_MAPPED;
+    }
+
+private:
+    TaxonomyMapping(char *data, size_t dataSize);
+
+    struct MappingHeader {
+        char magic[8];
+        size_t size;
+        // the node ids are only valid for the taxonomy they were built with, they depend on the order of its nodes
+        size_t taxonomyNodes;
+        size_t taxonomyMaxTaxID;
+        size_t taxonomyFingerprint;
+    };
+
+    // hash of the taxa and their parents in node id order
+    static size_t getFingerprint(const NcbiTaxonomy &taxonomy);
+
+    // either owned or pointing into the mapped file
+    int *nodeIds;
+    size_t size;
+    size_t taxonomyNodes;
+    size_t taxonomyMaxTaxID;
+    size_t taxonomyFingerprint;
+
+    char *mappedData;
+    size_t mappedSize;
+};
+
+#endif
@@ -1,50 +1,19 @@
 #include "NcbiTaxonomy.h"
+#include "TaxonomyMapping.h"
 #include "Parameters.h"
 #include "DBWriter.h"
-#include "FileUtil.h"
 #include "Debug.h"
 #include "Util.h"
-#include <algorithm>
 
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
 
-static bool compareToFirstInt(const std::pair<unsigned int, unsigned int>& lhs, const std::pair<unsigned int, unsigned int>&  rhs){
-    return (lhs.first <= rhs.first);
-}
-
 int addtaxonomy(int argc, const char **argv, const Command& command) {
     Parameters& par = Parameters::getInstance();
     par.parseParameters(argc, argv, command, 3);
 
-    std::string nodesFile = par.db1 + "_nodes.dmp";
-    std::string namesFile = par.db1 + "_names.dmp";
-    std::string mergedFile = par.db1 + "_merged.dmp";
-    if (FileUtil::fileExists(nodesFile.c_str())
-        && FileUtil::fileExists(namesFile.c_str())
-           && FileUtil::fileExists(mergedFile.c_str())) {
-    } else if (FileUtil::fileExists("nodes.dmp")
-               && FileUtil::fileExists("names.dmp")
-		  && FileUtil::fileExists("merged.dmp")
-                     && FileUtil::fileExists("delnodes.dmp")) {
-        nodesFile = "nodes.dmp";
-        namesFile = "names.dmp";
-        mergedFile = "merged.dmp";
-    } else {
-        Debug(Debug::ERROR) << "names.dmp, nodes.dmp, merged.dmp or delnodes.dmp from NCBI taxdump could not be found!\n";
-        EXIT(EXIT_FAILURE);
-    }
-    std::vector< std::pair<unsigned int, unsigned int> > mapping;
-    if(FileUtil::fileExists(std::string(par.db1 + "_mapping").c_str()) == false){
-        Debug(Debug::ERROR) << par.db1 + "_mapping" << " does not exist. Please create the taxonomy mapping!\n";
-        EXIT(EXIT_FAILURE);
-    }
-    bool isSorted = Util::readMapping( par.db1 + "_mapping", mapping);
-    if(isSorted == false){
-        std::stable_sort(mapping.begin(), mapping.end(), compareToFirstInt);
-    }
     std::vector<std::string> ranks = Util::split(par.lcaRanks, ":");
 
     DBReader<unsigned int> reader(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
@@ -54,7 +23,8 @@ int addtaxonomy(int argc, const char **argv, const Command& command) {
     writer.open();
 
     Debug(Debug::INFO) << "Loading NCBI taxonomy\n";
-    NcbiTaxonomy t(namesFile, nodesFile, mergedFile);
+    NcbiTaxonomy * t = NcbiTaxonomy::openTaxonomy(par.db1);
+    TaxonomyMapping * mapping = TaxonomyMapping::openMapping(par.db1, *t);
 
     Debug(Debug::INFO) << "Add taxonomy information \n";
     size_t taxonNotFound=0;
@@ -91,32 +61,29 @@ int addtaxonomy(int argc, const char **argv, const Command& command) {
                     continue;
                 }
                 unsigned int id = Util::fast_atoi<unsigned int>(entry[0]);
-                std::pair<unsigned int, unsigned int> val;
-                val.first = id;
-                std::vector< std::pair<unsigned int, unsigned int> >::iterator mappingIt = std::upper_bound(mapping.begin(), mapping.end(), val, compareToFirstInt);
-                if (mappingIt->first != val.first) {
+                int nodeId = mapping->nodeId(id);
+                if (nodeId == TaxonomyMapping::NOT_MAPPED) {
                     taxonNotFound++;
 //                    Debug(Debug::WARNING) << "No taxon mapping provided for id " << id << "\n";
                     data = Util::skipLine(data);
                     continue;
                 }
-                unsigned int taxon = mappingIt->second;
-                TaxonNode const * node = t.taxonNode(taxon, false);
-                if(node == NULL){
+                if (nodeId == TaxonomyMapping::NOT_IN_TAXONOMY) {
                     deletedNodes++;
                     data = Util::skipLine(data);
                     continue;
                 }
+                TaxonNode const * node = t->taxonNodeById(nodeId);
                 char * nextData = Util::skipLine(data);
                 size_t dataSize = nextData - data;
                 resultData.append(data, dataSize-1);
-                resultData += '\t' + SSTR(node->taxId) + '\t' + node->rank + '\t' + node->name;
+                resultData += '\t' + SSTR(node->taxId) + '\t' + t->getString(node->rankIdx) + '\t' + t->getString(node->nameIdx);
                 if (!ranks.empty()) {
-                    std::string lcaRanks = Util::implode(t.AtRanks(node, ranks), ':');
+                    std::string lcaRanks = Util::implode(t->AtRanks(node, ranks), ':');
                     resultData += '\t' + lcaRanks;
                 }
                 if (par.showTaxLineage) {
-                    resultData += '\t' + t.taxLineage(node);
+                    resultData += '\t' + t->taxLineage(node);
                 }
                 resultData += '\n';
 
@@ -136,5 +103,7 @@ int addtaxonomy(int argc, const char **argv, const Command& command) {
 
     writer.close();
     reader.close();
+    delete mapping;
+    delete t;
     return EXIT_SUCCESS;
 }
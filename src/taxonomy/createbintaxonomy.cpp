@@ -0,0 +1,22 @@
+#include "NcbiTaxonomy.h"
+#include "TaxonomyMapping.h"
+#include "Parameters.h"
+#include "Debug.h"
+#include "Util.h"
+
+int createbintaxonomy(int argc, const char **argv, const Command& command) {
+    Parameters& par = Parameters::getInstance();
+    par.parseParameters(argc, argv, command, 4);
+
+    NcbiTaxonomy taxonomy(par.db1, par.db2, par.db3);
+    Debug(Debug::INFO) << "Writing binary taxonomy to " << par.db4 << "\n";
+    taxonomy.writeTaxonomy(par.db4);
+
+    if (par.mappingFile.empty() == false) {
+        TaxonomyMapping mapping(par.mappingFile, taxonomy);
+        Debug(Debug::INFO) << "Writing binary mapping to " << par.mappingFile << ".bin\n";
+        mapping.writeMapping(par.mappingFile + ".bin");
+    }
+
+    return EXIT_SUCCESS;
+}
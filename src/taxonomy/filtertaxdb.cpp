@@ -13,24 +13,6 @@ int filtertaxdb(int argc, const char **argv, const Command& command) {
     Parameters& par = Parameters::getInstance();
     par.parseParameters(argc, argv, command, 3);
 
-    std::string nodesFile = par.db1 + "_nodes.dmp";
-    std::string namesFile = par.db1 + "_names.dmp";
-    std::string mergedFile = par.db1 + "_merged.dmp";
-    if (FileUtil::fileExists(nodesFile.c_str())
-        && FileUtil::fileExists(namesFile.c_str())
-        && FileUtil::fileExists(mergedFile.c_str())) {
-    } else if (FileUtil::fileExists("nodes.dmp")
-               && FileUtil::fileExists("names.dmp")
-               && FileUtil::fileExists("merged.dmp")) {
-        nodesFile = "nodes.dmp";
-        namesFile = "names.dmp";
-        mergedFile = "merged.dmp";
-    } else {
-        Debug(Debug::ERROR) << "names.dmp, nodes.dmp or merged.dmp from NCBI taxdump could not be found!\n";
-        EXIT(EXIT_FAILURE);
-    }
-
-
     DBReader<unsigned int> reader(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
     reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
@@ -51,7 +33,7 @@ int filtertaxdb(int argc, const char **argv, const Command& command) {
 
     bool invertSelection = par.invertSelection;
     Debug(Debug::INFO) << "Loading NCBI taxonomy\n";
-    NcbiTaxonomy t(namesFile, nodesFile, mergedFile);
+    NcbiTaxonomy * t = NcbiTaxonomy::openTaxonomy(par.db1);
     Debug::Progress progress(reader.getSize());
 
     Debug(Debug::INFO) << "Computing LCA\n";
@@ -94,7 +76,7 @@ int filtertaxdb(int argc, const char **argv, const Command& command) {
 
                 // remove blacklisted taxa
                 for (j = 0; j < taxListSize && !isAncestor; ++j) {
-                    isAncestor |= t.IsAncestor(taxalist[j], taxon);
+                    isAncestor |= t->IsAncestor(taxalist[j], taxon);
                 }
 
                 filterTaxon = invertSelection? isAncestor: !isAncestor;
@@ -116,6 +98,7 @@ int filtertaxdb(int argc, const char **argv, const Command& command) {
     reader.close();
 
     delete[] taxalist;
+    delete t;
 
     return EXIT_SUCCESS;
 }
@@ -1,74 +1,41 @@
 #include "NcbiTaxonomy.h"
 #include "Parameters.h"
-#include "DBWriter.h"
-#include "FileUtil.h"
+#include "DBReader.h"
 #include "Debug.h"
 #include "Util.h"
 #include <algorithm>
-#include <unordered_map>
 
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
-static bool compareToFirstInt(const std::pair<unsigned int, unsigned int>& lhs, const std::pair<unsigned int, unsigned int>&  rhs){
-    return (lhs.first <= rhs.first);
-}
+// children with reads of every node, node ids of the children of node i are in children[childOffsets[i]..childOffsets[i+1])
+struct CladeChildren {
+    std::vector<size_t> childOffsets;
+    std::vector<int> children;
+};
 
-template<typename K, typename V>
-V at(const std::unordered_map<K, V>& map, K key, V default_value = V()) {
-    typename std::unordered_map<K, V>::const_iterator it = map.find(key);
-    if (it == map.end()) {
-        return default_value;
-    } else {
-        return it->second;
-    }
-}
-
-unsigned int cladeCountVal(const std::unordered_map<TaxID, TaxonCounts>& map, TaxID key) {
-    typename std::unordered_map<TaxID, TaxonCounts>::const_iterator it = map.find(key);
-    if (it == map.end()) {
-        return 0;
-    } else {
-        return it->second.cladeCount;
-    }
-}
-
-
-void taxReport(FILE* FP,
+static void taxReport(FILE* FP,
         const NcbiTaxonomy& taxDB,
-        const std::unordered_map<TaxID, TaxonCounts> & cladeCounts,
+        const std::vector<size_t> &taxCounts,
+        const std::vector<size_t> &cladeCounts,
+        CladeChildren &tree,
         unsigned long totalReads,
-        TaxID taxID = 0, int depth = 0) {
-
-    std::unordered_map<TaxID, TaxonCounts>::const_iterator it = cladeCounts.find(taxID);
-    unsigned int cladeCount = it == cladeCounts.end()? 0 : it->second.cladeCount;
-    unsigned int taxCount = it == cladeCounts.end()? 0 : it->second.taxCount;
-    if (taxID == 0) {
-        if (cladeCount > 0) {
-            fprintf(FP, "%.4f\t%i\t%i\t%i\tno rank\tunidentified\n",
-                    100 * cladeCount / double(totalReads),
-                    cladeCount, taxCount, taxID);
-        }
-        taxReport(FP, taxDB, cladeCounts, totalReads, 1);
-    } else {
-        if (cladeCount == 0) {
-            return;
-        }
-        const TaxonNode* taxon = taxDB.taxonNode(taxID);
-        fprintf(FP, "%.4f\t%i\t%i\t%i\t%s\t%s%s\n",
-                100*cladeCount/double(totalReads), cladeCount, taxCount, taxID,
-               taxon->rank.c_str(), std::string(2*depth, ' ').c_str(), taxon->name.c_str());
-
-        std::vector<TaxID> children = it->second.children;
-        std::sort(children.begin(), children.end(), [&](int a, int b) { return cladeCountVal(cladeCounts, a) > cladeCountVal(cladeCounts,b); });
-        for (TaxID childTaxId : children) {
-            if (cladeCounts.count(childTaxId)) {
-                taxReport(FP, taxDB, cladeCounts, totalReads, childTaxId, depth + 1);
-            } else {
-                break;
-            }
-        }
+        int nodeId, int depth = 0) {
+    const size_t cladeCount = cladeCounts[nodeId];
+    if (cladeCount == 0) {
+        return;
+    }
+    const TaxonNode* taxon = taxDB.taxonNodeById(nodeId);
+    fprintf(FP, "%.4f\t%zu\t%zu\t%i\t%s\t%s%s\n",
+            100*cladeCount/double(totalReads), cladeCount, taxCounts[nodeId], taxon->taxId,
+            taxDB.getString(taxon->rankIdx), std::string(2*depth, ' ').c_str(), taxDB.getString(taxon->nameIdx));
+
+    std::vector<int>::iterator begin = tree.children.begin() + tree.childOffsets[nodeId];
+    std::vector<int>::iterator end = tree.children.begin() + tree.childOffsets[nodeId + 1];
+    std::sort(begin, end, [&](int a, int b) { return cladeCounts[a] > cladeCounts[b]; });
+    for (std::vector<int>::iterator it = begin; it != end; ++it) {
+        taxReport(FP, taxDB, taxCounts, cladeCounts, tree, totalReads, *it, depth + 1);
     }
 }
 
@@ -76,36 +43,6 @@ int taxonomyreport(int argc, const char **argv, const Command& command) {
     Parameters& par = Parameters::getInstance();
     par.parseParameters(argc, argv, command, 3);
 
-    std::string nodesFile = par.db1 + "_nodes.dmp";
-    std::string namesFile = par.db1 + "_names.dmp";
-    std::string mergedFile = par.db1 + "_merged.dmp";
-    std::string delnodesFile = par.db1 + "_delnodes.dmp";
-    if (FileUtil::fileExists(nodesFile.c_str())
-        && FileUtil::fileExists(namesFile.c_str())
-        && FileUtil::fileExists(mergedFile.c_str())
-        && FileUtil::fileExists(delnodesFile.c_str())) {
-    } else if (FileUtil::fileExists("nodes.dmp")
-               && FileUtil::fileExists("names.dmp")
-               && FileUtil::fileExists("merged.dmp")
-               && FileUtil::fileExists("delnodes.dmp")) {
-        nodesFile = "nodes.dmp";
-        namesFile = "names.dmp";
-        mergedFile = "merged.dmp";
-        delnodesFile = "delnodes.dmp";
-    } else {
-        Debug(Debug::ERROR) << "names.dmp, nodes.dmp, merged.dmp or delnodes.dmp from NCBI taxdump could not be found!\n";
-        EXIT(EXIT_FAILURE);
-    }
-    std::vector<std::pair<unsigned int, unsigned int>> mapping;
-    if(FileUtil::fileExists(std::string(par.db1 + "_mapping").c_str()) == false){
-        Debug(Debug::ERROR) << par.db1 + "_mapping" << " does not exist. Please create the taxonomy mapping!\n";
-        EXIT(EXIT_FAILURE);
-    }
-    bool isSorted = Util::readMapping( par.db1 + "_mapping", mapping);
-    if(isSorted == false){
-        std::stable_sort(mapping.begin(), mapping.end(), compareToFirstInt);
-    }
-
     DBReader<unsigned int> reader(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
     reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
@@ -114,26 +51,34 @@ int taxonomyreport(int argc, const char **argv, const Command& command) {
 
     // 1. Read taxonomy
     Debug(Debug::INFO) << "Loading NCBI taxonomy\n";
-    NcbiTaxonomy taxDB(namesFile, nodesFile, mergedFile);
+    NcbiTaxonomy * taxDB = NcbiTaxonomy::openTaxonomy(par.db1);
+    const size_t nodeCount = taxDB->getNodeCount();
 
     // 2. Read LCA file
     Debug::Progress progress(reader.getSize());
     Debug(Debug::INFO) << "Reading LCA results\n";
 
-
-    std::unordered_map<TaxID, unsigned int> taxCounts;
-
-//  Currentlly not parallel
-//    #pragma omp parallel
+    // reads per internal node id, every thread counts into its own array and the arrays are summed in parallel
+    std::vector<size_t> taxCounts(nodeCount, 0);
+    std::vector<size_t*> threadCounts;
+    size_t unclassified = 0;
+    size_t taxonNotFound = 0;
+#pragma omp parallel
     {
         const char *entry[255];
-        //char buffer[1024];
         unsigned int thread_idx = 0;
+        unsigned int threadCount = 1;
 #ifdef OPENMP
         thread_idx = (unsigned int) omp_get_thread_num();
+        threadCount = (unsigned int) omp_get_num_threads();
 #endif
+#pragma omp single
+        threadCounts.resize(threadCount, NULL);
+
+        size_t *counts = new size_t[nodeCount]();
+        threadCounts[thread_idx] = counts;
 
-//        #pragma omp for schedule(dynamic, 10) reduction (+:taxonNotFound, found)
+#pragma omp for schedule(dynamic, 100) reduction (+: unclassified, taxonNotFound)
         for (size_t i = 0; i < reader.getSize(); ++i) {
             progress.updateProgress();
 
@@ -142,20 +87,78 @@ int taxonomyreport(int argc, const char **argv, const Command& command) {
             const size_t columns = Util::getWordsOfLine(data, entry, 255);
             if (columns == 0) {
                 Debug(Debug::WARNING) << "Empty entry: " << i << "!";
-            } else {
-                int taxon = Util::fast_atoi<int>(entry[0]);
-                ++taxCounts[taxon];
-                //__sync_fetch_and_add(&(offsets[kmerIdx]), 1);
+                continue;
+            }
+            TaxID taxon = Util::fast_atoi<int>(entry[0]);
+            if (taxon == 0) {
+                unclassified++;
+                continue;
             }
+            TaxonNode const *node = taxDB->taxonNode(taxon, false);
+            if (node == NULL) {
+                taxonNotFound++;
+                continue;
+            }
+            counts[node->id]++;
         }
-    };
+
+#pragma omp for schedule(static)
+        for (size_t i = 0; i < nodeCount; ++i) {
+            size_t sum = 0;
+            for (size_t j = 0; j < threadCounts.size(); ++j) {
+                sum += threadCounts[j][i];
+            }
+            taxCounts[i] = sum;
+        }
+        delete[] counts;
+    }
     Debug(Debug::INFO) << "\n";
-    Debug(Debug::INFO) << "Found " << taxCounts.size() << " different taxa for " << reader.getSize() << " different reads.\n";
-    Debug(Debug::INFO) << taxCounts.at(0) << " reads are unclassified.\n";
+    size_t differentTaxa = (unclassified > 0) ? 1 : 0;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        differentTaxa += (taxCounts[i] > 0);
+    }
+    Debug(Debug::INFO) << "Found " << differentTaxa << " different taxa for " << reader.getSize() << " different reads.\n";
+    Debug(Debug::INFO) << unclassified << " reads are unclassified.\n";
+    if (taxonNotFound > 0) {
+        Debug(Debug::WARNING) << taxonNotFound << " reads have a taxon that is not part of the taxonomy.\n";
+    }
 
-    std::unordered_map<TaxID, TaxonCounts> cladeCounts = taxDB.getCladeCounts(taxCounts);
-    taxReport(resultFP, taxDB, cladeCounts, reader.getSize());
+    std::vector<size_t> cladeCounts = taxDB->getCladeCounts(taxCounts);
+
+    // only nodes with reads are printed, children keep the order of the taxonomy before sorting by clade count
+    CladeChildren tree;
+    tree.childOffsets.resize(nodeCount + 1, 0);
+    std::vector<int> parents(nodeCount, -1);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        const TaxonNode *node = taxDB->taxonNodeById(i);
+        if (cladeCounts[i] > 0 && node->parentTaxId != node->taxId) {
+            parents[i] = taxDB->taxonNode(node->parentTaxId)->id;
+            tree.childOffsets[parents[i] + 1]++;
+        }
+    }
+    for (size_t i = 0; i < nodeCount; ++i) {
+        tree.childOffsets[i + 1] += tree.childOffsets[i];
+    }
+    tree.children.resize(tree.childOffsets[nodeCount]);
+    std::vector<size_t> fill(tree.childOffsets.begin(), tree.childOffsets.end() - 1);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        if (parents[i] != -1) {
+            tree.children[fill[parents[i]]++] = i;
+        }
+    }
+
+    const size_t totalReads = reader.getSize();
+    if (unclassified > 0) {
+        fprintf(resultFP, "%.4f\t%zu\t%zu\t%i\tno rank\tunidentified\n",
+                100 * unclassified / double(totalReads), unclassified, unclassified, 0);
+    }
+    TaxonNode const *root = taxDB->taxonNode(1, false);
+    if (root != NULL) {
+        taxReport(resultFP, *taxDB, taxCounts, cladeCounts, tree, totalReads, root->id);
+    }
+    fclose(resultFP);
 
     reader.close();
+    delete taxDB;
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,72 @@
+#ifndef ALIGNMENTTESTUTIL_H
+#define ALIGNMENTTESTUTIL_H
+
+// Sequence generators and checks shared by the alignment tests
+
+#include <string>
+
+#include "StripedSmithWaterman.h"
+#include "Sequence.h"
+#include "SubstitutionMatrix.h"
+
+// uniform random amino acids
+inline std::string randomSequence(size_t length, unsigned int seed) {
+    const char *aa = "ACDEFGHIKLMNPQRSTVWY";
+    std::string result;
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1103515245 + 12345;
+        result.push_back(aa[(seed >> 16) % 20]);
+    }
+    return result;
+}
+
+// substitutes, deletes and inserts after the given percentage of residues
+inline std::string mutate(const std::string &seq, unsigned int seed,
+                          unsigned int substitutions = 15, unsigned int deletions = 3, unsigned int insertions = 3) {
+    const char *aa = "ACDEFGHIKLMNPQRSTVWY";
+    std::string result;
+    for (size_t i = 0; i < seq.size(); i++) {
+        seed = seed * 1103515245 + 12345;
+        unsigned int r = (seed >> 16) % 100;
+        if (r < substitutions) {
+            result.push_back(aa[(seed >> 8) % 20]);
+        } else if (r < substitutions + deletions) {
+            continue;
+        } else if (r < substitutions + deletions + insertions) {
+            result.push_back(seq[i]);
+            result.push_back(aa[(seed >> 4) % 20]);
+        } else {
+            result.push_back(seq[i]);
+        }
+    }
+    return result;
+}
+
+// score of the alignment described by the cigar, -1 if the cigar does not end at the end positions
+inline int cigarScore(const s_align &aln, const Sequence &query, const Sequence &target, SubstitutionMatrix &subMat, int gapOpen, int gapExtend) {
+    int score = 0;
+    int32_t qPos = aln.qStartPos1;
+    int32_t tPos = aln.dbStartPos1;
+    for (int32_t c = 0; c < aln.cigarLen; ++c) {
+        char letter = SmithWaterman::cigar_int_to_op(aln.cigar[c]);
+        uint32_t length = SmithWaterman::cigar_int_to_len(aln.cigar[c]);
+        if (letter == 'M') {
+            for (uint32_t i = 0; i < length; ++i) {
+                score += subMat.subMatrix[query.int_sequence[qPos++]][target.int_sequence[tPos++]];
+            }
+        } else {
+            score -= gapOpen + (length - 1) * gapExtend;
+            if (letter == 'I') {
+                qPos += length;
+            } else {
+                tPos += length;
+            }
+        }
+    }
+    if (qPos - 1 != aln.qEndPos1 || tPos - 1 != aln.dbEndPos1) {
+        return -1;
+    }
+    return score;
+}
+
+#endif
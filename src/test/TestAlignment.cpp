@@ -160,7 +160,6 @@ int main (int, const char**) {
     double Kmn=1.74e+12;
     std::cout << dbSize/Kmn<< " " <<  Kmn * exp(-(alignment.score1 * lambda)) << std::endl;
     delete [] tinySubMat;
-    delete [] alignment.cigar;
     delete s;
     delete dbSeq;
     return 0;
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <string>
+
+#include "StripedSmithWaterman.h"
+#include "Sequence.h"
+#include "SubstitutionMatrix.h"
+#include "Parameters.h"
+#include "AlignmentTestUtil.h"
+
+const char* binary_name = "test_alignmentbanded";
+
+int main (int, const char**) {
+    SubstitutionMatrix subMat("blosum62.out", 2.0, 0.0f);
+    int8_t *tinySubMat = new int8_t[subMat.alphabetSize * subMat.alphabetSize];
+    for (int i = 0; i < subMat.alphabetSize; i++) {
+        for (int j = 0; j < subMat.alphabetSize; j++) {
+            tinySubMat[i * subMat.alphabetSize + j] = (int8_t) subMat.subMatrix[i][j];
+        }
+    }
+    const int gapOpen = 11;
+    const int gapExtend = 1;
+    EvalueComputation evaluer(100000, &subMat, gapOpen, gapExtend);
+
+    std::string base = "GLTVDCVVFGLDEQIDLKVLLIQRQIPPFQHQWALPGGFVQMDESLEDAARRELREETGVQGIFLEQLYTFGDLGRDPRDRIISVAYYALINLIEYPLQASTDAEDAAWYSIENLPSLAFDHAQILKQAI";
+    std::string longBase = randomSequence(5000, 42);
+
+    Sequence query(10000, Parameters::DBTYPE_AMINO_ACIDS, &subMat, 0, false, false);
+    Sequence target(10000, Parameters::DBTYPE_AMINO_ACIDS, &subMat, 0, false, false);
+    SmithWaterman aligner(10000, subMat.alphabetSize, false);
+
+    size_t failed = 0;
+    size_t banded = 0;
+    for (unsigned int round = 0; round < 40; round++) {
+        const std::string &seq = (round % 10 == 9) ? longBase : base;
+        std::string q = mutate(seq, round * 7 + 1);
+        std::string t = mutate(seq, round * 13 + 5);
+        // shift the target so that the alignment does not sit on the main diagonal
+        int diagonal = 0;
+        if (round % 2) {
+            t = longBase.substr(round * 100, round * 3) + t;
+            diagonal = -static_cast<int>(round * 3);
+        }
+        query.mapSequence(0, 0, q.c_str());
+        target.mapSequence(1, 1, t.c_str());
+        aligner.ssw_init(&query, tinySubMat, &subMat, subMat.alphabetSize, 2);
+
+        s_align classic = aligner.ssw_align(target.int_sequence, target.L, gapOpen, gapExtend, 2, 10000, &evaluer, 0, 0.0, query.L / 2);
+        // a band that has to be widened for the indels of the long sequences
+        s_align band;
+        if (aligner.ssw_align_banded(band, target.int_sequence, target.L, gapOpen, gapExtend, 2, 10000, &evaluer, 0, 0.0, diagonal, 8) == false) {
+            continue;
+        }
+        banded++;
+
+        int score = cigarScore(band, query, target, subMat, gapOpen, gapExtend);
+        if (classic.score1 != band.score1 || band.cigar == NULL || score != band.score1) {
+            std::cout << "Round " << round << ": classic " << classic.score1 << " " << classic.qStartPos1 << "-" << classic.qEndPos1
+                      << " " << classic.dbStartPos1 << "-" << classic.dbEndPos1 << ", banded " << band.score1
+                      << " " << band.qStartPos1 << "-" << band.qEndPos1 << " " << band.dbStartPos1 << "-" << band.dbEndPos1
+                      << " cigar score " << score << "\n";
+            failed++;
+        }
+    }
+    // unknown diagonals are left to the full alignment
+    s_align unknown;
+    if (aligner.ssw_align_banded(unknown, target.int_sequence, target.L, gapOpen, gapExtend, 2, 10000, &evaluer, 0, 0.0, INT_MAX, 4)) {
+        std::cout << "Banded alignment without diagonal\n";
+        failed++;
+    }
+    delete [] tinySubMat;
+
+    if (failed > 0) {
+        std::cout << failed << " alignments differ\n";
+        return EXIT_FAILURE;
+    }
+    if (banded < 30) {
+        std::cout << "Only " << banded << " alignments were banded\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "Banded alignments match\n";
+    return EXIT_SUCCESS;
+}
@@ -9,6 +9,8 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
+#include <cfloat>
+#include <climits>
 #include <vector>
 #include <iostream>
 
@@ -22,6 +24,8 @@
 #include "ExtendedSubstitutionMatrix.h"
 #include "SubstitutionMatrix.h"
 #include "StripedSmithWaterman.h"
+#include "Matcher.h"
+#include "NucleotideMatrix.h"
 
 const char* binary_name = "test_alignmentperformance";
 
@@ -29,6 +33,50 @@ const char* binary_name = "test_alignmentperformance";
 
 KSEQ_INIT(int, read)
 
+// counts heap allocations, glibc lets the executable replace malloc
+static size_t allocations = 0;
+#ifdef __GLIBC__
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) {
+    allocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    allocations++;
+    return __libc_realloc(ptr, size);
+}
+}
+#endif
+
+std::vector<std::string> randomData(const char *alphabet, size_t count, size_t length, unsigned int seed){
+    std::vector<std::string> retVec;
+    const size_t alphabetSize = strlen(alphabet);
+    for (size_t i = 0; i < count; i++) {
+        std::string sequence;
+        for (size_t j = 0; j < length + (i * 37) % length; j++) {
+            seed = seed * 1103515245 + 12345;
+            // every other sequence is a mutated copy of its predecessor
+            if (i % 2 == 1 && j < retVec.back().size() && (seed >> 16) % 10 < 7) {
+                sequence.push_back(retVec.back()[j]);
+            } else {
+                sequence.push_back(alphabet[(seed >> 16) % alphabetSize]);
+            }
+        }
+        retVec.push_back(sequence);
+    }
+    return retVec;
+}
+
 
 std::vector<std::string> readData(std::string fasta_filename){
     std::vector<std::string> retVec;
@@ -51,61 +99,90 @@ std::vector<std::string> readData(std::string fasta_filename){
     fclose(fasta_file);
     return retVec;
 }
-int main (int, const char**) {
-    const size_t kmer_size=6;
-
+int main (int argc, const char **argv) {
     Parameters& par = Parameters::getInstance();
     SubstitutionMatrix subMat(par.scoringMatrixFile.c_str(), 2.0, 0);
-    std::cout << "Subustitution matrix:\n";
-    SubstitutionMatrix::print(subMat.subMatrix,subMat.int2aa,subMat.alphabetSize);
-    std::cout << "\n";
-
-    std::cout << "subMatrix:\n";
-    std::cout << "\n";
-
-
-    std::cout << "Sequence (id 0):\n";
-    Sequence* query = new Sequence(10000, 0, &subMat, kmer_size, true, false);
-    Sequence* dbSeq = new Sequence(10000, 0, &subMat, kmer_size, true, false);
-    //dbSeq->mapSequence(1,"lala2",ref_seq);
-    SmithWaterman aligner(15000, subMat.alphabetSize, false);
     int8_t * tinySubMat = new int8_t[subMat.alphabetSize*subMat.alphabetSize];
     for (int i = 0; i < subMat.alphabetSize; i++) {
         for (int j = 0; j < subMat.alphabetSize; j++) {
-            std::cout << ( i*subMat.alphabetSize + j) << " " << subMat.subMatrix[i][j] << " ";
-
             tinySubMat[i*subMat.alphabetSize + j] = (int8_t)subMat.subMatrix[i][j];
         }
-        std::cout << std::endl;
     }
 
-    int gap_open = 10;
-    int gap_extend = 1;
-    int mode = 0;
+    // sequences longer than 500 residues of the given fasta file or random sequences
+    std::vector<std::string> sequences = (argc > 1) ? readData(argv[1]) : randomData("ACDEFGHIKLMNPQRSTVWY", 60, 300, 1);
+    const size_t maxLen = 15000;
+    Sequence query(maxLen, Parameters::DBTYPE_AMINO_ACIDS, &subMat, 0, false, false);
+    Sequence dbSeq(maxLen, Parameters::DBTYPE_AMINO_ACIDS, &subMat, 0, false, false);
+    SmithWaterman aligner(maxLen, subMat.alphabetSize, false);
+
+    const int gap_open = 11;
+    const int gap_extend = 1;
+    EvalueComputation evalueComputation(100000, &subMat, gap_open, gap_extend);
+    // the path of the alignment module, including the backtrace of the result
+    Matcher matcher(Parameters::DBTYPE_AMINO_ACIDS, maxLen, &subMat, &evalueComputation, false, gap_open, gap_extend);
+    Matcher::result_t result;
     size_t cells = 0;
-    std::vector<std::string> sequences = readData("/Users/mad/Documents/databases/rfam/Rfam.fasta");
-    for(size_t seq_i = 0; seq_i < sequences.size(); seq_i++){
-        query->mapSequence(1,1,sequences[seq_i].c_str());
-        aligner.ssw_init(query, tinySubMat, &subMat, subMat.alphabetSize, 2);
+    size_t alnAllocations = 0;
+    // the workspace of the aligner grows during the first round, the second round is counted
+    for (size_t seq_i = 0; seq_i < 2 * sequences.size(); seq_i++) {
+        const bool isCounted = seq_i >= sequences.size();
+        query.mapSequence(1, 1, sequences[seq_i % sequences.size()].c_str());
+        aligner.ssw_init(&query, tinySubMat, &subMat, subMat.alphabetSize, 2);
+        matcher.initQuery(&query);
+        int32_t maskLen = query.L / 2;
+        for (size_t seq_j = 0; seq_j < sequences.size(); seq_j++) {
+            dbSeq.mapSequence(2, 2, sequences[seq_j].c_str());
+            size_t before = allocations;
+            s_align alignment = aligner.ssw_align(dbSeq.int_sequence, dbSeq.L, gap_open, gap_extend, 2, 10000, &evalueComputation, 0, 0.0, maskLen);
+            s_align single = aligner.ssw_align_single_pass(dbSeq.int_sequence, dbSeq.L, gap_open, gap_extend, 2, 10000, &evalueComputation, 0, 0.0, maskLen, 0);
+            s_align banded;
+            aligner.ssw_align_banded(banded, dbSeq.int_sequence, dbSeq.L, gap_open, gap_extend, 2, 10000, &evalueComputation, 0, 0.0, 0, 16);
+            matcher.getSWResult(result, &dbSeq, INT_MAX, false, 0, 0.0, FLT_MAX, Matcher::SCORE_COV_SEQID, 0, false);
+            if (isCounted) {
+                alnAllocations += allocations - before;
+                cells += query.L * dbSeq.L;
+            }
+            if (isCounted && alignment.score1 != single.score1) {
+                std::cout << "Single pass score differs for " << seq_i << " " << seq_j << "\n";
+            }
+        }
+    }
+    std::cout << "Cells: " << cells << "\n";
+    std::cout << "Allocations per amino acid alignment: " << (alnAllocations / static_cast<double>(sequences.size() * sequences.size())) << "\n";
 
-        for(size_t seq_j = 0; seq_j < sequences.size(); seq_j++) {
-            dbSeq->mapSequence(2, 2, sequences[seq_j].c_str());
-            int32_t maskLen = query->L / 2;
-            EvalueComputation evalueComputation(100000, &subMat, gap_open, gap_extend);
-            s_align alignment = aligner.ssw_align(dbSeq->int_sequence, dbSeq->L, gap_open, gap_extend, 0, 10000, &evalueComputation, 0, 0.0, maskLen);
-            if(mode == 0 ){
-                cells += query->L * dbSeq->L;
-                std::cout << alignment.qEndPos1 << " " << alignment.dbEndPos1 << "\n";
-            } else {
-                std::cout << alignment.qStartPos1 << " " << alignment.qEndPos1 << " "
-                        << alignment.dbStartPos1 << " " << alignment.dbEndPos1 << "\n";
+    NucleotideMatrix nuclMat("nucleotide.out", 1.0, 0.0);
+    std::vector<std::string> nuclSequences = randomData("ACGT", 60, 300, 2);
+    Sequence nuclQuery(maxLen, Parameters::DBTYPE_NUCLEOTIDES, &nuclMat, 0, false, false);
+    Sequence nuclTarget(maxLen, Parameters::DBTYPE_NUCLEOTIDES, &nuclMat, 0, false, false);
+    BandedNucleotideAligner nuclAligner(&nuclMat, maxLen, 5, 2);
+    EvalueComputation nuclEvalue(100000, &nuclMat, 5, 2);
+    Matcher nuclMatcher(Parameters::DBTYPE_NUCLEOTIDES, maxLen, &nuclMat, &nuclEvalue, false, 5, 2);
+    std::string backtrace;
+    size_t nuclAllocations = 0;
+    for (size_t seq_i = 0; seq_i < 2 * nuclSequences.size(); seq_i++) {
+        const bool isCounted = seq_i >= nuclSequences.size();
+        nuclQuery.mapSequence(1, 1, nuclSequences[seq_i % nuclSequences.size()].c_str());
+        nuclAligner.initQuery(&nuclQuery);
+        nuclMatcher.initQuery(&nuclQuery);
+        for (size_t seq_j = 0; seq_j < nuclSequences.size(); seq_j++) {
+            nuclTarget.mapSequence(2, 2, nuclSequences[seq_j].c_str());
+            size_t before = allocations;
+            int aaIds = 0;
+            backtrace.clear();
+            nuclAligner.align(&nuclTarget, 0, false, backtrace, aaIds, &nuclEvalue);
+            nuclMatcher.getSWResult(result, &nuclTarget, 0, false, 0, 0.0, FLT_MAX, Matcher::SCORE_COV_SEQID, 0, false);
+            if (isCounted) {
+                nuclAllocations += allocations - before;
             }
         }
     }
-    std::cerr << "Cells : " << cells << std::endl;
+    std::cout << "Allocations per nucleotide alignment: " << (nuclAllocations / static_cast<double>(nuclSequences.size() * nuclSequences.size())) << "\n";
     delete [] tinySubMat;
-    delete query;
-    delete dbSeq;
-    return 0;
+#ifdef __GLIBC__
+    if (alnAllocations > 0 || nuclAllocations > 0) {
+        return EXIT_FAILURE;
+    }
+#endif
+    return EXIT_SUCCESS;
 }
-
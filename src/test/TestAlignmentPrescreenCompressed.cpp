@@ -0,0 +1,97 @@
+#include "Alignment.h"
+#include "Debug.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Parameters.h"
+#include "Util.h"
+#include "AlignmentTestUtil.h"
+
+#include <string>
+#include <vector>
+
+const char* binary_name = "test_alignmentprescreencompressed";
+
+void writeSequences(const std::string &name, const std::vector<std::string> &sequences, unsigned int mode) {
+    DBWriter writer(name.c_str(), (name + ".index").c_str(), 1, mode, Parameters::DBTYPE_AMINO_ACIDS);
+    writer.open();
+    for (size_t i = 0; i < sequences.size(); i++) {
+        std::string entry = sequences[i] + "\n";
+        writer.writeData(entry.c_str(), entry.size(), i, 0);
+    }
+    writer.close(true);
+}
+
+std::vector<std::string> align(Parameters &par, const std::string &query, const std::string &target, const std::string &pref, bool prescreen) {
+    std::string out = "test_prescreen_aln";
+    par.db1 = query;
+    par.prescreen = prescreen;
+    Alignment aligner(query, target, pref, pref + ".index", out, out + ".index", par);
+    aligner.run(par.maxAccept, par.maxRejected);
+
+    DBReader<unsigned int> reader(out.c_str(), (out + ".index").c_str(), 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    reader.open(DBReader<unsigned int>::SORT_BY_ID);
+    std::vector<std::string> results;
+    for (size_t i = 0; i < reader.getSize(); i++) {
+        results.push_back(reader.getData(i, 0));
+    }
+    reader.close();
+    DBReader<unsigned int>::removeDb(out);
+    return results;
+}
+
+// compressed targets are decompressed into one buffer per thread, the prescreen window has to score each of them
+int main (int, const char**) {
+    Parameters& par = Parameters::getInstance();
+    par.threads = 1;
+    par.compressed = 0;
+    par.evalThr = 1e-5;
+
+    std::string base = "GLTVDCVVFGLDEQIDLKVLLIQRQIPPFQHQWALPGGFVQMDESLEDAARRELREETGVQGIFLEQLYTFGDLGRDPRDRIISVAYYALINLIEYPLQASTDAEDAAWYSIENLPSLAFDHAQILKQAI";
+    std::vector<std::string> queries;
+    queries.push_back(base);
+    queries.push_back(mutate(base, 7, 25, 2, 0));
+    // related targets between unrelated ones, each window mixes both
+    std::vector<std::string> targets;
+    for (unsigned int i = 0; i < 4 * SmithWaterman::BATCH_SIZE; i++) {
+        if (i % 3 == 0) {
+            targets.push_back(mutate(base, i + 1, 25, 2, 0));
+        } else {
+            targets.push_back(randomSequence(40 + i % 90, i));
+        }
+    }
+
+    std::string query = "test_prescreen_query";
+    std::string target = "test_prescreen_target";
+    std::string compressedTarget = "test_prescreen_target_compressed";
+    std::string pref = "test_prescreen_pref";
+    writeSequences(query, queries, Parameters::WRITER_ASCII_MODE);
+    writeSequences(target, targets, Parameters::WRITER_ASCII_MODE);
+    writeSequences(compressedTarget, targets, Parameters::WRITER_COMPRESSED_MODE);
+
+    DBWriter prefWriter(pref.c_str(), (pref + ".index").c_str(), 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_PREFILTER_RES);
+    prefWriter.open();
+    std::string hits;
+    for (size_t i = 0; i < targets.size(); i++) {
+        hits.append(SSTR(i)).append("\t0\t0\n");
+    }
+    for (size_t i = 0; i < queries.size(); i++) {
+        prefWriter.writeData(hits.c_str(), hits.size(), i, 0);
+    }
+    prefWriter.close();
+
+    std::vector<std::string> expected = align(par, query, target, pref, false);
+    std::vector<std::string> plain = align(par, query, target, pref, true);
+    std::vector<std::string> compressed = align(par, query, compressedTarget, pref, true);
+
+    DBReader<unsigned int>::removeDb(query);
+    DBReader<unsigned int>::removeDb(target);
+    DBReader<unsigned int>::removeDb(compressedTarget);
+    DBReader<unsigned int>::removeDb(pref);
+
+    bool hasHits = expected.size() == queries.size() && expected[0].empty() == false;
+    bool plainOk = hasHits && plain == expected;
+    bool compressedOk = hasHits && compressed == expected;
+    Debug(Debug::INFO) << "Prescreen with plain targets: " << (plainOk ? "ok" : "failed") << "\n";
+    Debug(Debug::INFO) << "Prescreen with compressed targets: " << (compressedOk ? "ok" : "failed") << "\n";
+    return (plainOk && compressedOk) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
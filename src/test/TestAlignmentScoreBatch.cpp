@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "StripedSmithWaterman.h"
+#include "Sequence.h"
+#include "SubstitutionMatrix.h"
+#include "Parameters.h"
+#include "AlignmentTestUtil.h"
+
+const char* binary_name = "test_alignmentscorebatch";
+
+int main (int, const char**) {
+    SubstitutionMatrix subMat("blosum62.out", 2.0, 0.0f);
+    int8_t *tinySubMat = new int8_t[subMat.alphabetSize * subMat.alphabetSize];
+    for (int i = 0; i < subMat.alphabetSize; i++) {
+        for (int j = 0; j < subMat.alphabetSize; j++) {
+            tinySubMat[i * subMat.alphabetSize + j] = (int8_t) subMat.subMatrix[i][j];
+        }
+    }
+    const int gapOpen = 11;
+    const int gapExtend = 1;
+    EvalueComputation evaluer(100000, &subMat, gapOpen, gapExtend);
+
+    std::string base = "GLTVDCVVFGLDEQIDLKVLLIQRQIPPFQHQWALPGGFVQMDESLEDAARRELREETGVQGIFLEQLYTFGDLGRDPRDRIISVAYYALINLIEYPLQASTDAEDAAWYSIENLPSLAFDHAQILKQAI";
+    unsigned int seed = 42;
+    // related targets of different lengths, unrelated ones and some that do not fit 8 bit
+    std::vector<std::string> targets;
+    for (int i = 0; i < 3 * SmithWaterman::BATCH_SIZE - 5; i++) {
+        std::string target;
+        if (i % 3 == 0) {
+            target = mutate(base, i * 7 + 1, 30);
+        } else if (i % 11 == 1) {
+            target = base + base;
+        } else {
+            for (int j = 0; j < 20 + (i * 37) % 400; j++) {
+                seed = seed * 1103515245 + 12345;
+                target.push_back("ACDEFGHIKLMNPQRSTVWY"[(seed >> 16) % 20]);
+            }
+        }
+        targets.push_back(target);
+    }
+
+    Sequence query(10000, Parameters::DBTYPE_AMINO_ACIDS, &subMat, 0, false, true);
+    Sequence target(10000, Parameters::DBTYPE_AMINO_ACIDS, &subMat, 0, false, true);
+    SmithWaterman aligner(10000, subMat.alphabetSize, true);
+    query.mapSequence(0, 0, base.c_str());
+    aligner.ssw_init(&query, tinySubMat, &subMat, subMat.alphabetSize, 2);
+
+    // three targets per lane, one after another
+    const size_t lanes = SmithWaterman::BATCH_SIZE;
+    std::vector<size_t> start(targets.size());
+    std::vector<size_t> laneEnd(lanes, 0);
+    for (size_t i = 0; i < targets.size(); i++) {
+        start[i] = laneEnd[i % lanes];
+        laneEnd[i % lanes] += targets[i].size();
+    }
+    const size_t length = *std::max_element(laneEnd.begin(), laneEnd.end());
+    // the kernel loads whole registers, keep them aligned
+    uint8_t *batch = (uint8_t *) mem_align(ALIGN_INT, length * lanes);
+    uint8_t *maxima = (uint8_t *) mem_align(ALIGN_INT, length * lanes);
+    memset(batch, SmithWaterman::BATCH_PAD, length * lanes);
+    for (size_t i = 0; i < targets.size(); i++) {
+        for (size_t pos = 0; pos < targets[i].size(); pos++) {
+            batch[(start[i] + pos) * lanes + i % lanes] = subMat.aa2int[(int) targets[i][pos]];
+        }
+        batch[start[i] * lanes + i % lanes] |= SmithWaterman::BATCH_START;
+    }
+    if (aligner.ssw_score_batch(batch, length, gapOpen, gapExtend, maxima) == false) {
+        std::cout << "Batch scores not computed\n";
+        return EXIT_FAILURE;
+    }
+
+    size_t failed = 0;
+    for (size_t i = 0; i < targets.size(); i++) {
+        int score = 0;
+        for (size_t pos = 0; pos < targets[i].size(); pos++) {
+            score = std::max(score, (int) maxima[(start[i] + pos) * lanes + i % lanes]);
+        }
+        target.mapSequence(1, 1, targets[i].c_str());
+        s_align classic = aligner.ssw_align(target.int_sequence, target.L, gapOpen, gapExtend, 0, 10000, &evaluer, 0, 0.0, query.L / 2);
+        bool ok = (score == 255) ? (classic.score1 >= 200) : (classic.score1 == score);
+        if (ok == false) {
+            std::cout << "Target " << i << ": batch score " << score << ", ssw_align " << classic.score1 << "\n";
+            failed++;
+        }
+    }
+    free(batch);
+    free(maxima);
+    delete [] tinySubMat;
+
+    if (failed > 0) {
+        std::cout << failed << " batch scores differ\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "Batch scores match\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <string>
+
+#include "StripedSmithWaterman.h"
+#include "Sequence.h"
+#include "SubstitutionMatrix.h"
+#include "Parameters.h"
+#include "AlignmentTestUtil.h"
+
+const char* binary_name = "test_alignmentsinglepass";
+
+int main (int, const char**) {
+    SubstitutionMatrix subMat("blosum62.out", 2.0, 0.0f);
+    int8_t *tinySubMat = new int8_t[subMat.alphabetSize * subMat.alphabetSize];
+    for (int i = 0; i < subMat.alphabetSize; i++) {
+        for (int j = 0; j < subMat.alphabetSize; j++) {
+            tinySubMat[i * subMat.alphabetSize + j] = (int8_t) subMat.subMatrix[i][j];
+        }
+    }
+    const int gapOpen = 11;
+    const int gapExtend = 1;
+    EvalueComputation evaluer(100000, &subMat, gapOpen, gapExtend);
+
+    std::string base = "GLTVDCVVFGLDEQIDLKVLLIQRQIPPFQHQWALPGGFVQMDESLEDAARRELREETGVQGIFLEQLYTFGDLGRDPRDRIISVAYYALINLIEYPLQASTDAEDAAWYSIENLPSLAFDHAQILKQAI";
+    std::string longBase = randomSequence(5000, 42);
+
+    Sequence query(10000, Parameters::DBTYPE_AMINO_ACIDS, &subMat, 0, false, false);
+    Sequence target(10000, Parameters::DBTYPE_AMINO_ACIDS, &subMat, 0, false, false);
+    SmithWaterman aligner(10000, subMat.alphabetSize, false);
+
+    size_t failed = 0;
+    for (unsigned int round = 0; round < 40; round++) {
+        const std::string &seq = (round % 10 == 9) ? longBase : base;
+        std::string q = mutate(seq, round * 7 + 1);
+        std::string t = mutate(seq, round * 13 + 5);
+        // shift the target so that the alignment does not sit on the main diagonal
+        if (round % 2) {
+            t = seq.substr(0, round * 3) + t;
+        }
+        query.mapSequence(0, 0, q.c_str());
+        target.mapSequence(1, 1, t.c_str());
+        aligner.ssw_init(&query, tinySubMat, &subMat, subMat.alphabetSize, 2);
+        const int32_t maskLen = query.L / 2;
+
+        s_align classic = aligner.ssw_align(target.int_sequence, target.L, gapOpen, gapExtend, 2, 10000, &evaluer, 0, 0.0, maskLen);
+        // a diagonal far off the alignment forces a narrow band for the long sequences
+        int diagonal = (round % 10 == 9) ? 3000 : 0;
+        s_align single = aligner.ssw_align_single_pass(target.int_sequence, target.L, gapOpen, gapExtend, 2, 10000, &evaluer, 0, 0.0, maskLen, diagonal);
+
+        int score = cigarScore(single, query, target, subMat, gapOpen, gapExtend);
+        if (classic.score1 != single.score1 || classic.qEndPos1 != single.qEndPos1 || classic.dbEndPos1 != single.dbEndPos1
+            || single.cigar == NULL || score != single.score1) {
+            std::cout << "Round " << round << ": classic " << classic.score1 << " " << classic.qStartPos1 << "-" << classic.qEndPos1
+                      << " " << classic.dbStartPos1 << "-" << classic.dbEndPos1 << ", single pass " << single.score1
+                      << " " << single.qStartPos1 << "-" << single.qEndPos1 << " " << single.dbStartPos1 << "-" << single.dbEndPos1
+                      << " cigar score " << score << "\n";
+            failed++;
+        }
+    }
+    delete [] tinySubMat;
+
+    if (failed > 0) {
+        std::cout << failed << " alignments differ\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "Single pass alignments match\n";
+    return EXIT_SUCCESS;
+}
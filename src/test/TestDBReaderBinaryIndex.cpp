@@ -0,0 +1,67 @@
+#include "Debug.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "FileUtil.h"
+#include "Parameters.h"
+
+#include <string>
+
+const char* binary_name = "test_dbreaderbinaryindex";
+
+bool compareReaders(DBReader<unsigned int> &text, DBReader<unsigned int> &binary) {
+    if (text.getSize() != binary.getSize() || text.getDataSize() != binary.getDataSize()
+        || text.getLastKey() != binary.getLastKey()) {
+        return false;
+    }
+    for (size_t i = 0; i < text.getSize(); i++) {
+        if (text.getDbKey(i) != binary.getDbKey(i) || text.getSeqLens(i) != binary.getSeqLens(i)
+            || std::string(text.getData(i, 0)) != std::string(binary.getData(i, 0))
+            || binary.getId(text.getDbKey(i)) != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main (int, const char**) {
+    Parameters& par = Parameters::getInstance();
+    par.threads = 2;
+
+    // two writer threads interleave keys, so the offsets are not sorted by key
+    DBWriter writer("test_binary_index", "test_binary_index.index", 2, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_GENERIC_DB);
+    writer.open();
+    for (unsigned int key = 0; key < 1000; key++) {
+        std::string entry(1 + (key * 7919) % 97, 'A' + (key % 26));
+        writer.writeData(entry.c_str(), entry.size(), 1000 - key, key % 2);
+    }
+    writer.close(true);
+
+    std::string binaryIndex = "test_binary_index.index.bin";
+    if (FileUtil::fileExists(binaryIndex.c_str()) == false) {
+        Debug(Debug::ERROR) << "No binary index written\n";
+        return EXIT_FAILURE;
+    }
+
+    const int modes[] = { DBReader<unsigned int>::NOSORT, DBReader<unsigned int>::LINEAR_ACCCESS,
+                          DBReader<unsigned int>::SORT_BY_LENGTH, DBReader<unsigned int>::SORT_BY_LINE };
+    for (size_t i = 0; i < sizeof(modes) / sizeof(int); i++) {
+        DBReader<unsigned int> binary("test_binary_index", "test_binary_index.index", 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+        binary.open(modes[i]);
+
+        FileUtil::move(binaryIndex.c_str(), (binaryIndex + ".tmp").c_str());
+        DBReader<unsigned int> text("test_binary_index", "test_binary_index.index", 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+        text.open(modes[i]);
+        FileUtil::move((binaryIndex + ".tmp").c_str(), binaryIndex.c_str());
+
+        bool equal = compareReaders(text, binary);
+        Debug(Debug::INFO) << "Mode " << modes[i] << ": " << (equal ? "equal" : "different") << "\n";
+        text.close();
+        binary.close();
+        if (equal == false) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    DBReader<unsigned int>::removeDb("test_binary_index");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,59 @@
+#include "Debug.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Parameters.h"
+
+#include <climits>
+#include <set>
+#include <string>
+
+const char* binary_name = "test_dbreaderkeylookup";
+
+bool checkLookup(const char *name, unsigned int stride, unsigned int maxKey) {
+    const int modes[] = { DBReader<unsigned int>::NOSORT, DBReader<unsigned int>::LINEAR_ACCCESS,
+                          DBReader<unsigned int>::SORT_BY_LENGTH, DBReader<unsigned int>::SORT_BY_LINE };
+    std::set<unsigned int> written;
+    DBWriter writer(name, (std::string(name) + ".index").c_str(), 2, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_GENERIC_DB);
+    writer.open();
+    for (unsigned int key = 0; key <= maxKey; key += stride) {
+        // leave a few holes
+        if (key % 13 == 5) {
+            continue;
+        }
+        std::string entry(1 + key % 31, 'A' + (key % 26));
+        writer.writeData(entry.c_str(), entry.size(), key, key % 2);
+        written.insert(key);
+    }
+    // a duplicated key resolves to one of its entries
+    writer.writeData("DUP", 3, stride * 2, 0);
+    writer.close(true);
+
+    bool success = true;
+    for (size_t i = 0; i < sizeof(modes) / sizeof(int); i++) {
+        DBReader<unsigned int> reader(name, (std::string(name) + ".index").c_str(), 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+        reader.open(modes[i]);
+        for (unsigned int key = 0; key <= maxKey + stride + 1; key++) {
+            size_t id = reader.getId(key);
+            bool expected = written.find(key) != written.end();
+            if (expected != (id != UINT_MAX) || (expected && reader.getDbKey(id) != key)) {
+                Debug(Debug::ERROR) << name << " mode " << modes[i] << ": wrong id for key " << key << "\n";
+                success = false;
+                break;
+            }
+        }
+        reader.close();
+    }
+    DBReader<unsigned int>::removeDb(name);
+    return success;
+}
+
+int main (int, const char**) {
+    Parameters& par = Parameters::getInstance();
+    par.threads = 2;
+
+    bool dense = checkLookup("test_key_lookup_dense", 1, 5000);
+    bool sparse = checkLookup("test_key_lookup_sparse", 37, 37 * 5000);
+    Debug(Debug::INFO) << "Dense keys: " << (dense ? "ok" : "failed") << "\n";
+    Debug(Debug::INFO) << "Sparse keys: " << (sparse ? "ok" : "failed") << "\n";
+    return (dense && sparse) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
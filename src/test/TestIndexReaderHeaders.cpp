@@ -0,0 +1,63 @@
+#include "Debug.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "IndexReader.h"
+#include "Parameters.h"
+#include "PrefilteringIndexReader.h"
+#include "SubstitutionMatrix.h"
+
+#include <string>
+
+const char* binary_name = "test_indexreaderheaders";
+
+// an index created without headers has to read them from the _h database next to the indexed database
+int main (int, const char**) {
+    Parameters& par = Parameters::getInstance();
+    par.threads = 1;
+
+    const char *sequences[] = { "MDEKKIEQLRPYIVNYIRNFHSDDIISEKERVVIDLEKLYNYGIVDFVEYICENPYGG\n",
+                                "MLGVNAVIGAGIFLTPGAVIRLAGTWAPVAYILAGLFAGIMALVFATAARYVRTNGAS\n",
+                                "MSTNPKPQRKTKRNTNRRPQDVKFPGGGQIVGGVYLLPRRGPRLGVRATRKTSERSQP\n" };
+    const size_t count = sizeof(sequences) / sizeof(sequences[0]);
+
+    std::string db = "test_index_headers";
+    std::string hdr = db + "_h";
+    DBWriter seqWriter(db.c_str(), (db + ".index").c_str(), 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_AMINO_ACIDS);
+    seqWriter.open();
+    DBWriter hdrWriter(hdr.c_str(), (hdr + ".index").c_str(), 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_GENERIC_DB);
+    hdrWriter.open();
+    for (size_t i = 0; i < count; i++) {
+        seqWriter.writeData(sequences[i], strlen(sequences[i]), i, 0);
+        std::string header = "header_" + SSTR(i) + "\n";
+        hdrWriter.writeData(header.c_str(), header.size(), i, 0);
+    }
+    seqWriter.close(true);
+    hdrWriter.close(true);
+
+    SubstitutionMatrix subMat(par.scoringMatrixFile.c_str(), 8.0, -0.2f);
+    DBReader<unsigned int> dbr(db.c_str(), (db + ".index").c_str(), 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    dbr.open(DBReader<unsigned int>::NOSORT);
+    std::string index = PrefilteringIndexReader::indexName(db);
+    PrefilteringIndexReader::createIndexFile(index, &dbr, NULL, NULL, NULL, &subMat, par.maxSeqLen,
+                                             false, "", false, subMat.alphabetSize, 6, 0, 0, 0, 0);
+    dbr.close();
+
+    bool success = IndexReader::databaseName(index) == db && IndexReader::databaseName(db + ".linidx") == db;
+    IndexReader headers(index, 1, IndexReader::HEADERS);
+    if (headers.sequenceReader->getSize() != count) {
+        success = false;
+    }
+    for (size_t i = 0; i < count && success; i++) {
+        std::string header = "header_" + SSTR(i) + "\n";
+        if (header != headers.sequenceReader->getDataByDBKey(i, 0)) {
+            Debug(Debug::ERROR) << "Wrong header for key " << i << "\n";
+            success = false;
+        }
+    }
+
+    DBReader<unsigned int>::removeDb(db);
+    DBReader<unsigned int>::removeDb(hdr);
+    DBReader<unsigned int>::removeDb(index);
+    Debug(Debug::INFO) << "Headers of an index without headers: " << (success ? "ok" : "failed") << "\n";
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
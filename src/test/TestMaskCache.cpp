@@ -0,0 +1,103 @@
+#include "Debug.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "FileUtil.h"
+#include "IndexBuilder.h"
+#include "IndexTable.h"
+#include "MaskCache.h"
+#include "Parameters.h"
+#include "SequenceLookup.h"
+#include "SubstitutionMatrix.h"
+
+#include <string>
+#include <sys/stat.h>
+
+const char* binary_name = "test_maskcache";
+
+// random residues with low complexity repeats, the seed shifts the repeats so that lengths stay the same
+void writeDatabase(const std::string &name, unsigned int seed) {
+    const char *aa = "ACDEFGHIKLMNPQRSTVWY";
+    DBWriter writer(name.c_str(), (name + ".index").c_str(), 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_AMINO_ACIDS);
+    writer.open();
+    for (unsigned int key = 0; key < 200; ++key) {
+        std::string sequence;
+        size_t length = 60 + key % 150;
+        unsigned int state = key * 7919 + seed;
+        for (size_t i = 0; i < length; ++i) {
+            state = state * 1103515245 + 12345;
+            if ((i + seed) % 50 < 20 && key % 3 != 0) {
+                sequence.push_back("QPQ"[i % 3]);
+            } else {
+                sequence.push_back(aa[(state >> 16) % 20]);
+            }
+        }
+        sequence.push_back('\n');
+        writer.writeData(sequence.c_str(), sequence.size(), key, 0);
+    }
+    writer.close(true);
+}
+
+std::string maskDatabase(const std::string &name, SubstitutionMatrix &subMat, bool maskCache) {
+    DBReader<unsigned int> dbr(name.c_str(), (name + ".index").c_str(), 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    dbr.open(DBReader<unsigned int>::NOSORT);
+    Sequence seq(32000, Parameters::DBTYPE_AMINO_ACIDS, &subMat, 6, false, false);
+    IndexTable table(subMat.alphabetSize, 6, false);
+    SequenceLookup *masked = NULL;
+    IndexBuilder::fillDatabase(&table, &masked, NULL, subMat, &seq, &dbr, 0, dbr.getSize(), 0, true, false, maskCache);
+    std::string result(masked->getData(), masked->getDataSize());
+    delete masked;
+    dbr.close();
+    return result;
+}
+
+bool cacheWrittenAt(const std::string &name, struct timespec &mtime) {
+    struct stat cacheStat;
+    if (stat(MaskCache::getCacheFile(name).c_str(), &cacheStat) != 0) {
+        return false;
+    }
+    mtime = FileUtil::getModificationTime(cacheStat);
+    return true;
+}
+
+int main (int, const char**) {
+    Parameters& par = Parameters::getInstance();
+    par.threads = 1;
+    SubstitutionMatrix subMat(par.scoringMatrixFile.c_str(), 8.0, -0.2f);
+    std::string db = "test_mask_cache";
+    bool success = true;
+
+    writeDatabase(db, 0);
+    remove(MaskCache::getCacheFile(db).c_str());
+    std::string expected = maskDatabase(db, subMat, false);
+
+    // the first run writes the cache, the second reads it without writing it again
+    std::string written = maskDatabase(db, subMat, true);
+    struct timespec writeTime;
+    if (cacheWrittenAt(db, writeTime) == false || written != expected) {
+        Debug(Debug::ERROR) << "Mask cache was not written\n";
+        success = false;
+    }
+    std::string read = maskDatabase(db, subMat, true);
+    struct timespec readTime;
+    if (cacheWrittenAt(db, readTime) == false || readTime.tv_sec != writeTime.tv_sec || readTime.tv_nsec != writeTime.tv_nsec) {
+        Debug(Debug::ERROR) << "Mask cache was not reused\n";
+        success = false;
+    }
+    if (read != expected) {
+        Debug(Debug::ERROR) << "Masks read from the cache differ\n";
+        success = false;
+    }
+
+    // rebuilt right away with sequences of the same lengths, the old masks must not be applied
+    writeDatabase(db, 25);
+    std::string rebuilt = maskDatabase(db, subMat, false);
+    if (rebuilt == expected || maskDatabase(db, subMat, true) != rebuilt) {
+        Debug(Debug::ERROR) << "Stale mask cache was used\n";
+        success = false;
+    }
+
+    remove(MaskCache::getCacheFile(db).c_str());
+    DBReader<unsigned int>::removeDb(db);
+    Debug(Debug::INFO) << "Mask cache round trip: " << (success ? "ok" : "failed") << "\n";
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
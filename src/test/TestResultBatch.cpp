@@ -0,0 +1,78 @@
+#include "Debug.h"
+#include "Matcher.h"
+#include "ResultBatch.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+const char* binary_name = "test_resultbatch";
+
+int main (int, const char**) {
+    std::string data;
+    char buffer[1024];
+    for (unsigned int i = 0; i < 200; i++) {
+        std::string cigar = SSTR(1 + i % 13) + "M" + SSTR(1 + i % 3) + (i % 2 ? "I" : "D") + SSTR(5 + i % 7) + "M";
+        // many ties in score and e-value
+        Matcher::result_t res((i * 7919) % 101, 50 + i % 5, 0.5, 0.5, (i % 10) / 10.0f, (i % 4) * 1e-5,
+                              40, 0, 39, 100, 10, 49, 50 + i % 3, cigar);
+        size_t len = Matcher::resultToBuffer(buffer, res, true, false);
+        data.append(buffer, len);
+    }
+
+    std::vector<Matcher::result_t> vector;
+    Matcher::readAlignmentResults(vector, (char *) data.c_str(), true);
+    std::sort(vector.begin(), vector.end(), Matcher::compareHits);
+
+    ResultBatch batch;
+    batch.readResults((char *) data.c_str());
+    batch.sort();
+
+    std::string expected;
+    std::string actual;
+    for (size_t i = 0; i < vector.size(); i++) {
+        size_t len = Matcher::resultToBuffer(buffer, vector[i], true, false);
+        expected.append(buffer, len);
+    }
+    for (size_t i = 0; i < batch.size(); i++) {
+        size_t len = batch.toBuffer(buffer, i, true);
+        actual.append(buffer, len);
+    }
+    if (expected != actual) {
+        Debug(Debug::ERROR) << "Sorted batch differs from sorted result_t vector\n";
+        return EXIT_FAILURE;
+    }
+
+    batch.pop();
+    Matcher::result_t first = batch.get(0);
+    batch.push(first);
+    if (batch.size() != vector.size() || batch.get(batch.size() - 1).backtrace != vector[0].backtrace) {
+        Debug(Debug::ERROR) << "Push after pop lost the backtrace\n";
+        return EXIT_FAILURE;
+    }
+
+    batch.clear();
+    if (batch.empty() == false) {
+        Debug(Debug::ERROR) << "Batch not empty after clear\n";
+        return EXIT_FAILURE;
+    }
+
+    // uncompressed backtraces as produced by the aligner, written like resultToBuffer with compression
+    const char *backtraces[] = { "", "M", "I", "MMMMMMMMMMMMDDMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMIIIIIIIIIIIIMM", "DDDMMMMMMM" };
+    expected.clear();
+    actual.clear();
+    for (size_t i = 0; i < sizeof(backtraces) / sizeof(backtraces[0]); i++) {
+        Matcher::result_t res(i, 60, 0.5, 0.5, 0.9f, 1e-10, 40, 0, 39, 100, 10, 49, 50, backtraces[i]);
+        size_t len = Matcher::resultToBuffer(buffer, res, true);
+        expected.append(buffer, len);
+        batch.pushCompressed(res, true);
+        len = batch.toBuffer(buffer, i, true);
+        actual.append(buffer, len);
+    }
+    if (expected != actual) {
+        Debug(Debug::ERROR) << "Compressed backtraces differ from resultToBuffer\n";
+        return EXIT_FAILURE;
+    }
+    Debug(Debug::INFO) << "ResultBatch matches result_t output\n";
+    return EXIT_SUCCESS;
+}
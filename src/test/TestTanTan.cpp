@@ -5,6 +5,8 @@
 #include <iostream>
 #include <cstring>
 #include <math.h>
+#include <vector>
+#include <algorithm>
 #include "tantan.h"
 #include "SubstitutionMatrix.h"
 #include "Sequence.h"
@@ -59,5 +61,19 @@ int main (int, const char**) {
 
     }
     std::cout << std::endl;
-    return 0;
+
+    // the vectorised gapless model has to agree with the scalar model with negligible gap probabilities
+    for(int i = 0; i < refSeq.L; i++){
+        refInt[i] = (char) refSeq.int_sequence[i];
+    }
+    std::vector<float> gapless(len);
+    std::vector<float> gapped(len);
+    tantan::getProbabilities(refInt, refInt+len, 50, probMatrixPointers, 0.005, 0.05, 0.9, 0, 0, gapless.data());
+    tantan::getProbabilities(refInt, refInt+len, 50, probMatrixPointers, 0.005, 0.05, 0.9, 1e-12, 0, gapped.data());
+    float maxDiff = 0;
+    for(size_t i = 0; i < len; i++){
+        maxDiff = std::max(maxDiff, std::abs(gapless[i] - gapped[i]));
+    }
+    std::cout << "Max. probability difference: " << maxDiff << std::endl;
+    return (maxDiff < 1e-4) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
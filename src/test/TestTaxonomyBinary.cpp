@@ -0,0 +1,100 @@
+#include "NcbiTaxonomy.h"
+#include "TaxonomyMapping.h"
+#include "FileUtil.h"
+#include "Debug.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+const char* binary_name = "test_taxonomybinary";
+
+int main (int, const char**) {
+    // a random tree in NCBI dump format, tax ids are not contiguous
+    std::vector<TaxID> taxa;
+    taxa.push_back(1);
+    FILE *nodes = fopen("test_taxonomy_nodes.dmp", "w");
+    FILE *names = fopen("test_taxonomy_names.dmp", "w");
+    fprintf(nodes, "1\t|\t1\t|\tno rank\t|\t\t|\n");
+    fprintf(names, "1\t|\troot\t|\t\t|\tscientific name\t|\n");
+    const char *ranks[] = { "superkingdom", "phylum", "class", "order", "family", "genus", "species" };
+    unsigned int seed = 42;
+    for (size_t i = 1; i < 2000; i++) {
+        seed = seed * 1103515245 + 12345;
+        TaxID parent = taxa[(seed >> 16) % taxa.size()];
+        TaxID taxId = 3 * i + (seed >> 8) % 3 + 2;
+        taxa.push_back(taxId);
+        fprintf(nodes, "%d\t|\t%d\t|\t%s\t|\t\t|\n", taxId, parent, ranks[i % 7]);
+        fprintf(names, "%d\t|\tsynonym %d\t|\t\t|\tsynonym\t|\n", taxId, taxId);
+        fprintf(names, "%d\t|\ttaxon %d\t|\t\t|\tscientific name\t|\n", taxId, taxId);
+    }
+    fclose(nodes);
+    fclose(names);
+    FILE *merged = fopen("test_taxonomy_merged.dmp", "w");
+    fprintf(merged, "100000\t|\t%d\t|\n", taxa[10]);
+    fclose(merged);
+    taxa.push_back(100000);
+
+    NcbiTaxonomy parsed("test_taxonomy_names.dmp", "test_taxonomy_nodes.dmp", "test_taxonomy_merged.dmp");
+    parsed.writeTaxonomy(NcbiTaxonomy::getTaxonomyFile("test_taxonomy"));
+    NcbiTaxonomy *mapped = NcbiTaxonomy::openTaxonomy("test_taxonomy");
+
+    size_t failed = 0;
+    for (size_t i = 0; i < taxa.size(); i++) {
+        TaxonNode const *a = parsed.taxonNode(taxa[i]);
+        TaxonNode const *b = mapped->taxonNode(taxa[i]);
+        if (a->taxId != b->taxId || a->parentTaxId != b->parentTaxId
+            || strcmp(parsed.getString(a->nameIdx), mapped->getString(b->nameIdx)) != 0
+            || strcmp(parsed.getString(a->rankIdx), mapped->getString(b->rankIdx)) != 0) {
+            failed++;
+        }
+        std::vector<TaxID> pair;
+        pair.push_back(taxa[i]);
+        pair.push_back(taxa[(i * 7919) % taxa.size()]);
+        if (parsed.LCA(pair)->taxId != mapped->LCA(pair)->taxId
+            || parsed.taxLineage(a) != mapped->taxLineage(b)) {
+            failed++;
+        }
+    }
+
+    // sequence keys to taxa, including a merged and an unknown taxon and a duplicated key
+    FILE *mappingFile = fopen("test_taxonomy_mapping", "w");
+    for (size_t i = 0; i < taxa.size(); i += 3) {
+        fprintf(mappingFile, "%zu\t%d\n", 2 * i, taxa[i]);
+    }
+    fprintf(mappingFile, "1\t100000\n3\t99999999\n0\t%d\n", taxa[1]);
+    fclose(mappingFile);
+    TaxonomyMapping parsedMapping("test_taxonomy_mapping", parsed);
+    parsedMapping.writeMapping(TaxonomyMapping::getMappingFile("test_taxonomy"));
+    TaxonomyMapping *mappedMapping = TaxonomyMapping::openMapping("test_taxonomy", *mapped);
+    for (unsigned int key = 0; key < 2 * taxa.size() + 10; key++) {
+        int expected = TaxonomyMapping::NOT_MAPPED;
+        if (key == 1) {
+            expected = parsed.taxonNode(taxa[10])->id;
+        } else if (key == 3) {
+            expected = TaxonomyMapping::NOT_IN_TAXONOMY;
+        } else if (key % 2 == 0 && key / 2 < taxa.size() && (key / 2) % 3 == 0) {
+            expected = parsed.taxonNode(taxa[key / 2])->id;
+        }
+        if (parsedMapping.nodeId(key) != expected || mappedMapping->nodeId(key) != expected) {
+            failed++;
+        }
+    }
+    delete mappedMapping;
+    delete mapped;
+
+    FileUtil::remove("test_taxonomy_nodes.dmp");
+    FileUtil::remove("test_taxonomy_names.dmp");
+    FileUtil::remove("test_taxonomy_merged.dmp");
+    FileUtil::remove("test_taxonomy_mapping");
+    FileUtil::remove(NcbiTaxonomy::getTaxonomyFile("test_taxonomy").c_str());
+    FileUtil::remove(TaxonomyMapping::getMappingFile("test_taxonomy").c_str());
+
+    if (failed > 0) {
+        Debug(Debug::ERROR) << failed << " taxa differ between parsed and mapped taxonomy\n";
+        return EXIT_FAILURE;
+    }
+    Debug(Debug::INFO) << "Mapped taxonomy matches parsed taxonomy\n";
+    return EXIT_SUCCESS;
+}
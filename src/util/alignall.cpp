@@ -19,7 +19,7 @@ int alignall(int argc, const char **argv, const Command &command) {
 
     DBReader<unsigned int> tdbr(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
     tdbr.open(DBReader<unsigned int>::NOSORT);
-    if (par.preloadMode != Parameters::PRELOAD_MODE_MMAP) {
+    if (Parameters::shouldTouchData(par.preloadMode)) {
         tdbr.readMmapedDataInMemory();
     }
     const int targetSeqType = tdbr.getDbtype();
@@ -22,7 +22,7 @@ int alignbykmer(int argc, const char **argv, const Command &command) {
     Parameters &par = Parameters::getInstance();
     par.parseParameters(argc, argv, command, 4, false);
 
-    bool touch = (par.preloadMode != Parameters::PRELOAD_MODE_MMAP);
+    bool touch = Parameters::shouldTouchData(par.preloadMode);
     IndexReader * tDbrIdx = new IndexReader(par.db2, par.threads, IndexReader::SEQUENCES, (touch) ? (IndexReader::PRELOAD_INDEX | IndexReader::PRELOAD_DATA) : 0 );
     IndexReader * qDbrIdx = NULL;
     int querySeqType = 0;
@@ -25,6 +25,7 @@ int doCompression(int argc, const char **argv, const Command& command, bool shou
     int dbtype = reader.getDbtype();
     dbtype = shouldCompress ? dbtype | (1 << 31) : dbtype & ~(1 << 31);
     DBWriter writer(par.db2.c_str(), par.db2Index.c_str(), par.threads, shouldCompress, dbtype);
+    writer.trainDictionary(reader);
     writer.open();
     Debug::Progress progress(reader.getSize());
 
@@ -88,33 +88,45 @@ int convertalignments(int argc, const char **argv, const Command &command) {
 
     const bool sameDB = par.db1.compare(par.db2) == 0 ? true : false;
     const int format = par.formatAlignmentMode;
-    const bool touch = (par.preloadMode != Parameters::PRELOAD_MODE_MMAP);
+    const bool touch = Parameters::shouldTouchData(par.preloadMode);
 
     bool needSequenceDB = false;
     bool needBacktrace = false;
     bool needFullHeaders = false;
-    const std::vector<int> outcodes = Parameters::getOutputFormat(par.outfmt, needSequenceDB, needBacktrace, needFullHeaders);
+    bool needQueryHeaders = false;
+    bool needTargetHeaders = false;
+    const std::vector<int> outcodes = Parameters::getOutputFormat(par.outfmt, needSequenceDB, needBacktrace, needFullHeaders, needQueryHeaders, needTargetHeaders);
     if(format == Parameters::FORMAT_ALIGNMENT_SAM){
         needSequenceDB = true;
         needBacktrace = true;
     }
+    // only the custom tab format can do without identifiers, without any column the fixed BLAST tab format is written
+    if (format != Parameters::FORMAT_ALIGNMENT_BLAST_TAB || outcodes.empty()) {
+        needQueryHeaders = true;
+        needTargetHeaders = true;
+    }
     bool isTranslatedSearch = false;
 
 
     int dbaccessMode = needSequenceDB ? (DBReader<unsigned int>::USE_INDEX | DBReader<unsigned int>::USE_DATA) : (DBReader<unsigned int>::USE_INDEX);
 
     IndexReader qDbr(par.db1, par.threads,  IndexReader::SRC_SEQUENCES, (touch) ? (IndexReader::PRELOAD_INDEX | IndexReader::PRELOAD_DATA) : 0, dbaccessMode);
-    IndexReader qDbrHeader(par.db1, par.threads, IndexReader::SRC_HEADERS , (touch) ? (IndexReader::PRELOAD_INDEX | IndexReader::PRELOAD_DATA) : 0);
+    IndexReader *qDbrHeader = NULL;
+    if (needQueryHeaders || (sameDB && needTargetHeaders)) {
+        qDbrHeader = new IndexReader(par.db1, par.threads, IndexReader::SRC_HEADERS , (touch) ? (IndexReader::PRELOAD_INDEX | IndexReader::PRELOAD_DATA) : 0);
+    }
 
     IndexReader *tDbr;
-    IndexReader *tDbrHeader;
+    IndexReader *tDbrHeader = NULL;
     if (sameDB) {
         tDbr = &qDbr;
-        tDbrHeader= &qDbrHeader;
+        tDbrHeader = qDbrHeader;
     } else {
 
         tDbr = new IndexReader(par.db2, par.threads, IndexReader::SRC_SEQUENCES, (touch) ? (IndexReader::PRELOAD_INDEX | IndexReader::PRELOAD_DATA) : 0, dbaccessMode);
-        tDbrHeader = new IndexReader(par.db2, par.threads, IndexReader::SRC_HEADERS, (touch) ? (IndexReader::PRELOAD_INDEX | IndexReader::PRELOAD_DATA) : 0);
+        if (needTargetHeaders) {
+            tDbrHeader = new IndexReader(par.db2, par.threads, IndexReader::SRC_HEADERS, (touch) ? (IndexReader::PRELOAD_INDEX | IndexReader::PRELOAD_DATA) : 0);
+        }
     }
 
     bool queryNucs = Parameters::isEqualDbtype(qDbr.sequenceReader->getDbtype(), Parameters::DBTYPE_NUCLEOTIDES);
@@ -266,13 +278,18 @@ int convertalignments(int argc, const char **argv, const Command &command) {
                 }
             }
 
-            size_t qHeaderId = qDbrHeader.sequenceReader->getId(queryKey);
-            const char *qHeader = qDbrHeader.sequenceReader->getData(qHeaderId, thread_idx);
-            size_t qHeaderLen = qDbrHeader.sequenceReader->getSeqLens(qHeaderId);
-            std::string queryId = Util::parseFastaHeader(qHeader);
-            if (sameDB && needFullHeaders) {
-                queryHeaderBuffer.assign(qHeader, std::max(qHeaderLen, static_cast<size_t>(2)) - 2);
-                qHeader = (char*) queryHeaderBuffer.c_str();
+            const char *qHeader = NULL;
+            size_t qHeaderLen = 0;
+            std::string queryId;
+            if (needQueryHeaders) {
+                size_t qHeaderId = qDbrHeader->sequenceReader->getId(queryKey);
+                qHeader = qDbrHeader->sequenceReader->getData(qHeaderId, thread_idx);
+                qHeaderLen = qDbrHeader->sequenceReader->getSeqLens(qHeaderId);
+                queryId = Util::parseFastaHeader(qHeader);
+                if (sameDB && needFullHeaders) {
+                    queryHeaderBuffer.assign(qHeader, std::max(qHeaderLen, static_cast<size_t>(2)) - 2);
+                    qHeader = (char*) queryHeaderBuffer.c_str();
+                }
             }
 
             char *data = alnDbr.getData(i, thread_idx);
@@ -286,10 +303,15 @@ int convertalignments(int argc, const char **argv, const Command &command) {
                     EXIT(EXIT_FAILURE);
                 }
 
-                size_t tHeaderId = tDbrHeader->sequenceReader->getId(res.dbKey);
-                const char *tHeader = tDbrHeader->sequenceReader->getData(tHeaderId, thread_idx);
-                size_t tHeaderLen = tDbrHeader->sequenceReader->getSeqLens(tHeaderId);
-                std::string targetId = Util::parseFastaHeader(tHeader);
+                const char *tHeader = NULL;
+                size_t tHeaderLen = 0;
+                std::string targetId;
+                if (needTargetHeaders) {
+                    size_t tHeaderId = tDbrHeader->sequenceReader->getId(res.dbKey);
+                    tHeader = tDbrHeader->sequenceReader->getData(tHeaderId, thread_idx);
+                    tHeaderLen = tDbrHeader->sequenceReader->getSeqLens(tHeaderId);
+                    targetId = Util::parseFastaHeader(tHeader);
+                }
 
                 unsigned int gapOpenCount = 0;
                 unsigned int alnLen = res.alnLength;
@@ -552,15 +574,20 @@ int convertalignments(int argc, const char **argv, const Command &command) {
     // tsv output
     resultWriter.close(true);
     if (isDb == false) {
-        FileUtil::remove(par.db4Index.c_str());
+        DBReader<unsigned int>::removeIndex(par.db4Index);
     }
 
     alnDbr.close();
-    if (needSequenceDB) {
-        if (sameDB == false) {
-            delete tDbr;
+    if (sameDB == false) {
+        delete tDbr;
+        if (tDbrHeader != NULL) {
             delete tDbrHeader;
         }
+    }
+    if (qDbrHeader != NULL) {
+        delete qDbrHeader;
+    }
+    if (needSequenceDB) {
         delete evaluer;
     }
     delete subMat;
@@ -11,6 +11,159 @@
 #include "Util.h"
 #include "KSeqWrapper.h"
 #include "itoa.h"
+#include "MemoryMapped.h"
+#include "DecompressionStream.h"
+
+#include <cstring>
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+static bool isNucleotideSequence(const char *sequence, size_t length) {
+    size_t cnt = 0;
+    for (size_t i = 0; i < length; i++) {
+        switch (toupper(sequence[i])) {
+            case 'T':
+            case 'A':
+            case 'G':
+            case 'C':
+            case 'U':
+            case 'N':
+                cnt++;
+                break;
+        }
+    }
+    const float nuclDNAFraction = static_cast<float>(cnt) / static_cast<float>(length);
+    return nuclDNAFraction > 0.9;
+}
+
+static void buildSplitHeader(std::string &splitHeader, std::string &splitId, const std::string &header,
+                             const std::string &headerId, size_t split, size_t splitCnt, bool splitSeqByLen) {
+    splitId.append(headerId);
+    if (splitCnt > 1) {
+        splitId.append("_");
+        splitId.append(SSTR(split));
+    }
+    // For split entries replace the found identifier by identifier_splitNumber
+    // Also add another hint that it was split to the end of the header
+    splitHeader.append(header);
+    if (splitSeqByLen == true && splitCnt > 1) {
+        if (headerId.empty() == false) {
+            size_t pos = splitHeader.find(headerId);
+            if (pos != std::string::npos) {
+                splitHeader.erase(pos, headerId.length());
+                splitHeader.insert(pos, splitId);
+            }
+        }
+        splitHeader.append(" Split=");
+        splitHeader.append(SSTR(split));
+    }
+
+    // space is needed for later parsing
+    splitHeader.append(" ", 1);
+    splitHeader.append("\n");
+}
+
+// entries of one part of a FASTA file, parsed by one thread and written later in input order
+struct ParsedChunk {
+    std::string headers;
+    std::string sequences;
+    // offsets of each entry, with one additional end offset
+    std::vector<size_t> headerOffsets;
+    std::vector<size_t> sequenceOffsets;
+    // first entry of each record, with one additional end entry
+    std::vector<size_t> recordEntries;
+    // records without identifier
+    std::vector<size_t> missingIdentifiers;
+    bool invalidEntry;
+    // the chunk contained FASTQ records and has to be parsed sequentially
+    bool hasQualities;
+};
+
+static void parseFastaChunk(const char *data, size_t size, const Parameters &par, Debug::Progress &progress, ParsedChunk &chunk) {
+    chunk.headers.clear();
+    chunk.sequences.clear();
+    chunk.headerOffsets.assign(1, 0);
+    chunk.sequenceOffsets.assign(1, 0);
+    chunk.recordEntries.assign(1, 0);
+    chunk.missingIdentifiers.clear();
+    chunk.invalidEntry = false;
+    chunk.hasQualities = false;
+
+    std::string header;
+    header.reserve(1024);
+    std::string splitHeader;
+    splitHeader.reserve(1024);
+    std::string splitId;
+    splitId.reserve(1024);
+    KSeqBuffer kseq(data, size);
+    while (kseq.ReadEntry() && kseq.hasQualities() == false) {
+        progress.updateProgress();
+        const KSeqWrapper::KSeqEntry &e = kseq.entry;
+        if (e.name.l == 0) {
+            chunk.invalidEntry = true;
+            break;
+        }
+
+        size_t splitCnt = 1;
+        if (par.splitSeqByLen == true) {
+            splitCnt = (size_t) ceilf(static_cast<float>(e.sequence.l) / static_cast<float>(par.maxSeqLen));
+        }
+
+        header.append(e.name.s, e.name.l);
+        if (e.comment.l > 0) {
+            header.append(" ", 1);
+            header.append(e.comment.s, e.comment.l);
+        }
+        std::string headerId = Util::parseFastaHeader(header);
+        if (headerId.empty()) {
+            chunk.missingIdentifiers.push_back(chunk.headerOffsets.size() - 1);
+        }
+        for (size_t split = 0; split < splitCnt; split++) {
+            buildSplitHeader(splitHeader, splitId, header, headerId, split, splitCnt, par.splitSeqByLen);
+            chunk.headers.append(splitHeader);
+            chunk.headerOffsets.push_back(chunk.headers.size());
+            if (par.splitSeqByLen) {
+                size_t len = std::min(par.maxSeqLen, e.sequence.l - split * par.maxSeqLen);
+                chunk.sequences.append(e.sequence.s + split * par.maxSeqLen, len);
+            } else {
+                chunk.sequences.append(e.sequence.s, e.sequence.l);
+            }
+            chunk.sequenceOffsets.push_back(chunk.sequences.size());
+            splitHeader.clear();
+            splitId.clear();
+        }
+        chunk.recordEntries.push_back(chunk.headerOffsets.size() - 1);
+        header.clear();
+    }
+    chunk.hasQualities = kseq.hasQualities();
+}
+
+// returns the position of the first FASTA header that starts a line at or after pos
+static size_t findNextHeader(const char *data, size_t size, size_t pos) {
+    while (pos < size) {
+        const char *newline = (const char *) memchr(data + pos, '\n', size - pos);
+        if (newline == NULL) {
+            return size;
+        }
+        pos = (newline - data) + 1;
+        if (pos < size && data[pos] == '>') {
+            return pos;
+        }
+    }
+    return size;
+}
+
+// returns the position of the last FASTA header that starts a line, or 0 if there is none after the first byte
+static size_t findLastHeader(const char *data, size_t size) {
+    for (size_t pos = size; pos > 1; pos--) {
+        if (data[pos - 1] == '>' && data[pos - 2] == '\n') {
+            return pos - 1;
+        }
+    }
+    return 0;
+}
 
 void renumberIdsInIndexByOffsetOrder(char * dataName, char * indexName) {
     DBReader<unsigned int> reader(dataName, indexName, 1, DBReader<unsigned int>::USE_INDEX);
@@ -69,22 +222,7 @@ int createdb(int argc, const char **argv, const Command& command) {
         size_t isNuclCnt = 0;
         if (kseq->ReadEntry()) {
             const KSeqWrapper::KSeqEntry &e = kseq->entry;
-
-            size_t cnt = 0;
-            for (size_t i = 0; i < e.sequence.l; i++) {
-                switch (toupper(e.sequence.s[i])) {
-                    case 'T':
-                    case 'A':
-                    case 'G':
-                    case 'C':
-                    case 'U':
-                    case 'N':
-                        cnt++;
-                        break;
-                }
-            }
-            float nuclDNAFraction = static_cast<float>(cnt) / static_cast<float>(e.sequence.l);
-            if (nuclDNAFraction > 0.9) {
+            if (isNucleotideSequence(e.sequence.s, e.sequence.l)) {
                 isNuclCnt += true;
             }
         }
@@ -139,8 +277,225 @@ int createdb(int argc, const char **argv, const Command& command) {
         header.reserve(1024);
         std::string splitId;
         splitId.reserve(1024);
-        kseq = KSeqFactory(filenames[fileIdx].c_str());
-        while (kseq->ReadEntry()) {
+
+        // FASTA input is parsed in parallel, in chunks that start at a header line
+        // chunks that turn out to contain FASTQ records and the rest of the file are read by the sequential loop
+        const size_t threads = static_cast<size_t>(par.threads);
+        const size_t chunkSize = 16 * 1024 * 1024;
+        std::vector<ParsedChunk> chunks(threads);
+        std::vector<size_t> chunkStarts(threads + 1);
+        std::vector<size_t> chunkEntries(threads + 1);
+        // converts up to one chunk per thread from the records in data[pos, end) and returns the position after the
+        // written entries, has to be called by a single thread of a parallel region
+        auto convertChunks = [&](const char *data, size_t pos, size_t end, bool &needsSequential) -> size_t {
+            size_t chunkCnt = 0;
+            chunkStarts[0] = pos;
+            while (chunkCnt < threads && chunkStarts[chunkCnt] < end) {
+                chunkStarts[chunkCnt + 1] = findNextHeader(data, end, chunkStarts[chunkCnt] + chunkSize);
+                chunkCnt++;
+            }
+
+            ParsedChunk *chunkData = &chunks[0];
+            const size_t *starts = &chunkStarts[0];
+            const Parameters *parameters = &par;
+            Debug::Progress *chunkProgress = &progress;
+#pragma omp taskgroup
+            {
+                for (size_t i = 0; i < chunkCnt; i++) {
+#pragma omp task firstprivate(i, data, chunkData, starts, parameters, chunkProgress)
+                    parseFastaChunk(data + starts[i], starts[i + 1] - starts[i], *parameters, *chunkProgress, chunkData[i]);
+                }
+            }
+
+            // replay the checks of the sequential loop in input order
+            size_t validChunks = 0;
+            chunkEntries[0] = 0;
+            for (; validChunks < chunkCnt; validChunks++) {
+                const ParsedChunk &chunk = chunks[validChunks];
+                if (chunk.hasQualities) {
+                    break;
+                }
+                const unsigned int firstEntry = entries_num + chunkEntries[validChunks];
+                size_t chunkCount = count;
+                size_t chunkSampleCount = sampleCount;
+                size_t chunkNuclCnt = isNuclCnt;
+                bool changesDbType = false;
+                for (size_t record = 0; par.dbType == 0 && changesDbType == false && record < chunk.recordEntries.size() - 1; record++) {
+                    const size_t recordStart = chunk.sequenceOffsets[chunk.recordEntries[record]];
+                    const size_t recordEnd = chunk.sequenceOffsets[chunk.recordEntries[record + 1]];
+                    for (size_t entry = chunk.recordEntries[record]; entry < chunk.recordEntries[record + 1]; entry++) {
+                        if (chunkCount < 10 || (chunkCount % 100) == 0) {
+                            if (chunkSampleCount < testForNucSequence && isNucleotideSequence(chunk.sequences.c_str() + recordStart, recordEnd - recordStart)) {
+                                chunkNuclCnt += true;
+                            }
+                            chunkSampleCount++;
+                        }
+                        if (chunkNuclCnt == chunkSampleCount || chunkNuclCnt == testForNucSequence) {
+                            if (isNuclDb == false) {
+                                // the sequential loop switches to a DNA database here
+                                changesDbType = true;
+                                break;
+                            }
+                        } else if (isNuclDb == true && chunkNuclCnt != chunkSampleCount) {
+                            Debug(Debug::ERROR) << "Database does not look like a DNA database anymore. Sorry our prediction went wrong.\n";
+                            Debug(Debug::ERROR) << "Please recompute with --dbtype 1 flag.\n";
+                            EXIT(EXIT_FAILURE);
+                        }
+                        chunkCount++;
+                    }
+                }
+                if (changesDbType) {
+                    break;
+                }
+                for (size_t i = 0; i < chunk.missingIdentifiers.size(); i++) {
+                    Debug(Debug::WARNING) << "Can not extract identifier from entry " << (firstEntry + chunk.missingIdentifiers[i]) << ".\n";
+                }
+                const size_t entries = chunk.headerOffsets.size() - 1;
+                if (chunk.invalidEntry) {
+                    Debug(Debug::ERROR) << "Fasta entry: " << (firstEntry + entries) << " is invalid.\n";
+                    EXIT(EXIT_FAILURE);
+                }
+                count += entries;
+                sampleCount = chunkSampleCount;
+                isNuclCnt = chunkNuclCnt;
+                chunkEntries[validChunks + 1] = chunkEntries[validChunks] + entries;
+            }
+
+            // every shard receives the entries with its id residue in input order
+            const unsigned int firstId = par.identifierOffset + entries_num;
+            const size_t *entryOffsets = &chunkEntries[0];
+            std::vector<unsigned short> *lookupData = sourceLookup;
+            DBWriter *hdrOut = &hdrWriter;
+            DBWriter *seqOut = &seqWriter;
+            const unsigned short source = fileIdx;
+            const unsigned int splits = shuffleSplits;
+            const char lineEnd = newline;
+#pragma omp taskgroup
+            {
+                for (size_t splitIdx = 0; splitIdx < splits; splitIdx++) {
+#pragma omp task firstprivate(splitIdx, validChunks, firstId, chunkData, entryOffsets, lookupData, hdrOut, seqOut, source, splits, lineEnd)
+                    {
+                        for (size_t i = 0; i < validChunks; i++) {
+                            const ParsedChunk &chunk = chunkData[i];
+                            const unsigned int chunkFirstId = firstId + entryOffsets[i];
+                            const size_t entries = entryOffsets[i + 1] - entryOffsets[i];
+                            for (size_t j = (splitIdx + splits - chunkFirstId % splits) % splits; j < entries; j += splits) {
+                                unsigned int id = chunkFirstId + j;
+                                lookupData[splitIdx].emplace_back(source);
+                                hdrOut->writeData(chunk.headers.c_str() + chunk.headerOffsets[j],
+                                                  chunk.headerOffsets[j + 1] - chunk.headerOffsets[j], id, splitIdx);
+                                seqOut->writeStart(splitIdx);
+                                seqOut->writeAdd(chunk.sequences.c_str() + chunk.sequenceOffsets[j],
+                                                 chunk.sequenceOffsets[j + 1] - chunk.sequenceOffsets[j], splitIdx);
+                                seqOut->writeAdd(&lineEnd, 1, splitIdx);
+                                seqOut->writeEnd(id, splitIdx, true);
+                            }
+                        }
+                    }
+                }
+            }
+            entries_num += chunkEntries[validChunks];
+            numEntriesInCurrFile += chunkEntries[validChunks];
+
+            needsSequential = validChunks < chunkCnt;
+            return chunkStarts[validChunks];
+        };
+
+        // the sequential readers choose the format by the file extension, compressed files are only decompressed
+        // in parallel if they would be read as such
+        int streamFormat = DecompressionStream::FORMAT_NONE;
+        if (threads > 1 && Util::endsWith(".gz", filenames[fileIdx])) {
+            streamFormat = DecompressionStream::detectFormat(filenames[fileIdx]);
+        } else if (threads > 1 && Util::endsWith(".zst", filenames[fileIdx])) {
+            streamFormat = DecompressionStream::FORMAT_ZSTD;
+        }
+        MemoryMapped input;
+        bool isMapped = false;
+        bool needsSequential = false;
+        kseq = NULL;
+        if (threads > 1 && streamFormat == DecompressionStream::FORMAT_NONE && Util::endsWith(".gz", filenames[fileIdx]) == false
+            && Util::endsWith(".bz2", filenames[fileIdx]) == false && Util::endsWith(".zst", filenames[fileIdx]) == false
+            && FileUtil::getFileSize(filenames[fileIdx]) > 0) {
+            isMapped = input.open(filenames[fileIdx], MemoryMapped::WholeFile, MemoryMapped::SequentialScan);
+        }
+        if (isMapped && input.getData()[0] == '>') {
+            const char *data = (const char *) input.getData();
+            const size_t dataSize = input.size();
+            size_t parsedBytes = 0;
+#pragma omp parallel num_threads(par.threads)
+            {
+#pragma omp single
+                {
+                    while (parsedBytes < dataSize && needsSequential == false) {
+                        parsedBytes = convertChunks(data, parsedBytes, dataSize, needsSequential);
+                    }
+                }
+            }
+            if (parsedBytes < dataSize) {
+                kseq = new KSeqBuffer(data + parsedBytes, dataSize - parsedBytes);
+            }
+        } else if (streamFormat != DecompressionStream::FORMAT_NONE) {
+            // the next part of the input is decompressed in a task while the current one is parsed
+            DecompressionStream *stream = new DecompressionStream(filenames[fileIdx], streamFormat);
+            const size_t batchSize = threads * chunkSize;
+            std::string current;
+            std::string next;
+            bool hasMore = false;
+#pragma omp parallel num_threads(par.threads)
+            {
+#pragma omp single
+                hasMore = stream->fill(current, batchSize);
+            }
+            if (current.empty() == false && current[0] != '>') {
+                stream->unread(current.c_str(), current.size());
+                needsSequential = true;
+            }
+            while (current.empty() == false && needsSequential == false) {
+                size_t end = current.size();
+                if (hasMore) {
+                    end = findLastHeader(current.c_str(), current.size());
+                    if (end == 0) {
+                        // a single record that is larger than the buffer
+                        hasMore = stream->fill(current, batchSize);
+                        continue;
+                    }
+                }
+                next.assign(current, end, std::string::npos);
+                size_t pos = 0;
+                bool nextHasMore = false;
+#pragma omp parallel num_threads(par.threads)
+                {
+#pragma omp single
+                    {
+                        if (hasMore) {
+                            std::string *nextData = &next;
+                            bool *nextResult = &nextHasMore;
+#pragma omp task firstprivate(stream, nextData, nextResult, batchSize)
+                            *nextResult = stream->fill(*nextData, batchSize);
+                        }
+                        while (pos < end && needsSequential == false) {
+                            pos = convertChunks(current.c_str(), pos, end, needsSequential);
+                        }
+#pragma omp taskwait
+                    }
+                }
+                if (needsSequential) {
+                    stream->unread(next.c_str(), next.size());
+                    stream->unread(current.c_str() + pos, end - pos);
+                    break;
+                }
+                current.swap(next);
+                hasMore = nextHasMore;
+            }
+            if (needsSequential) {
+                kseq = new KSeqStream(stream);
+            } else {
+                delete stream;
+            }
+        } else {
+            kseq = KSeqFactory(filenames[fileIdx].c_str());
+        }
+        while (kseq != NULL && kseq->ReadEntry()) {
             progress.updateProgress();
             const KSeqWrapper::KSeqEntry &e = kseq->entry;
             if (e.name.l == 0) {
@@ -171,24 +526,8 @@ int createdb(int argc, const char **argv, const Command& command) {
                 if (par.dbType == 0) {
                     // check for the first 10 sequences if they are nucleotide sequences
                     if (count < 10 || (count % 100) == 0) {
-                        if (sampleCount < testForNucSequence) {
-                            size_t cnt = 0;
-                            for (size_t i = 0; i < e.sequence.l; i++) {
-                                switch (toupper(e.sequence.s[i])) {
-                                    case 'T':
-                                    case 'A':
-                                    case 'G':
-                                    case 'C':
-                                    case 'U':
-                                    case 'N':
-                                        cnt++;
-                                        break;
-                                }
-                            }
-                            const float nuclDNAFraction = static_cast<float>(cnt) / static_cast<float>(e.sequence.l);
-                            if (nuclDNAFraction > 0.9) {
-                                isNuclCnt += true;
-                            }
+                        if (sampleCount < testForNucSequence && isNucleotideSequence(e.sequence.s, e.sequence.l)) {
+                            isNuclCnt += true;
                         }
                         sampleCount++;
                     }
@@ -207,29 +546,7 @@ int createdb(int argc, const char **argv, const Command& command) {
                     }
                 }
 
-                splitId.append(headerId);
-                if (splitCnt > 1) {
-                    splitId.append("_");
-                    splitId.append(SSTR(split));
-                }
-                // For split entries replace the found identifier by identifier_splitNumber
-                // Also add another hint that it was split to the end of the header
-                splitHeader.append(header);
-                if (par.splitSeqByLen == true && splitCnt > 1) {
-                    if (headerId.empty() == false) {
-                        size_t pos = splitHeader.find(headerId);
-                        if (pos != std::string::npos) {
-                            splitHeader.erase(pos, headerId.length());
-                            splitHeader.insert(pos, splitId);
-                        }
-                    }
-                    splitHeader.append(" Split=");
-                    splitHeader.append(SSTR(split));
-                }
-
-                // space is needed for later parsing
-                splitHeader.append(" ", 1);
-                splitHeader.append("\n");
+                buildSplitHeader(splitHeader, splitId, header, headerId, split, splitCnt, par.splitSeqByLen);
 
                 // Finally write down the entry
                 unsigned int splitIdx = id % shuffleSplits;
@@ -259,6 +576,7 @@ int createdb(int argc, const char **argv, const Command& command) {
             header.clear();
         }
         delete kseq;
+        input.close();
     }
     Debug(Debug::INFO) << "\n";
     hdrWriter.close(true);
@@ -319,7 +637,7 @@ int createdb(int argc, const char **argv, const Command& command) {
         splitCounter++;
     }
     lookupFile.close(true);
-    FileUtil::remove(lookupIndexFile.c_str());
+    DBReader<unsigned int>::removeIndex(lookupIndexFile);
     delete[] sourceLookup;
 
     return EXIT_SUCCESS;
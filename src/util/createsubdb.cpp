@@ -56,6 +56,9 @@ int createsubdb(int argc, const char **argv, const Command& command) {
     }
     writer.close();
     DBWriter::writeDbtypeFile(par.db3.c_str(), reader.getDbtype(), isCompressed);
+    if (isCompressed) {
+        DBWriter::linkDictionaryFile(par.db2, par.db3);
+    }
     free(line);
     reader.close();
     fclose(orderFile);
@@ -23,7 +23,7 @@ int createtsv(int argc, const char **argv, const Command &command) {
 
     bool queryNucs = Parameters::isEqualDbtype(DBReader<unsigned int>::parseDbType(par.db1.c_str()), Parameters::DBTYPE_NUCLEOTIDES);
     bool targetNucs = Parameters::isEqualDbtype(DBReader<unsigned int>::parseDbType(par.db2.c_str()), Parameters::DBTYPE_NUCLEOTIDES);
-    const bool touch = (par.preloadMode != Parameters::PRELOAD_MODE_MMAP);
+    const bool touch = Parameters::shouldTouchData(par.preloadMode);
     int queryHeaderType = (queryNucs) ? IndexReader::SRC_HEADERS : IndexReader::HEADERS;
     queryHeaderType = (par.idxSeqSrc == 0) ? queryHeaderType :  (par.idxSeqSrc == 1) ?  IndexReader::HEADERS : IndexReader::SRC_HEADERS;
     IndexReader qDbrHeader(par.db1, par.threads, queryHeaderType, (touch) ? (IndexReader::PRELOAD_INDEX | IndexReader::PRELOAD_DATA) : 0);
@@ -167,9 +167,9 @@ int createtsv(int argc, const char **argv, const Command &command) {
 
     if (par.dbOut == false) {
         if (hasTargetDB) {
-            FileUtil::remove(par.db4Index.c_str());
+            DBReader<unsigned int>::removeIndex(par.db4Index);
         } else {
-            FileUtil::remove(par.db3Index.c_str());
+            DBReader<unsigned int>::removeIndex(par.db3Index);
         }
     }
 
@@ -0,0 +1,70 @@
+#include "Parameters.h"
+#include "Util.h"
+#include "Debug.h"
+#include "FileUtil.h"
+#include "SharedMemoryDB.h"
+#include "PrefilteringIndexReader.h"
+
+#include <csignal>
+#include <unistd.h>
+
+int dbd(int argc, const char **argv, const Command& command) {
+    Parameters& par = Parameters::getInstance();
+    par.parseParameters(argc, argv, command, 1, true, Parameters::PARSE_VARIADIC);
+
+    // the sequence data, headers and precomputed index of each DB are kept resident
+    std::vector<std::string> files;
+    for (size_t i = 0; i < par.filenames.size(); i++) {
+        std::vector<std::string> dbs;
+        dbs.push_back(par.filenames[i]);
+        std::string headerDb = par.filenames[i] + "_h";
+        if (FileUtil::fileExists((headerDb + ".index").c_str())) {
+            dbs.push_back(headerDb);
+        }
+        std::string indexDb = PrefilteringIndexReader::searchForIndex(par.filenames[i]);
+        if (indexDb.empty() == false) {
+            dbs.push_back(indexDb);
+        }
+        for (size_t j = 0; j < dbs.size(); j++) {
+            std::vector<std::string> dataFiles = FileUtil::findDatafiles(dbs[j].c_str());
+            if (dataFiles.empty()) {
+                Debug(Debug::ERROR) << "No datafile could be found for " << dbs[j] << "!\n";
+                EXIT(EXIT_FAILURE);
+            }
+            files.insert(files.end(), dataFiles.begin(), dataFiles.end());
+        }
+    }
+
+    // block the signals before loading, they are only received by sigwait
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    sigprocmask(SIG_BLOCK, &signals, NULL);
+
+    // the segments are removed by name, a file replaced in the meantime has a different one
+    std::vector<std::string> segments;
+    for (size_t i = 0; i < files.size(); i++) {
+        Debug(Debug::INFO) << "Loading " << files[i] << "\n";
+        std::string segment;
+        if (SharedMemoryDB::create(files[i], segment) == false) {
+            break;
+        }
+        segments.push_back(segment);
+    }
+    int status = EXIT_SUCCESS;
+    if (segments.size() == files.size()) {
+        Debug(Debug::INFO) << "Databases are resident in shared memory, stop with kill -TERM " << getpid() << "\n";
+        int signal;
+        sigwait(&signals, &signal);
+        Debug(Debug::INFO) << "Received signal " << signal << ", removing shared memory segments\n";
+    } else {
+        status = EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < segments.size(); i++) {
+        SharedMemoryDB::remove(segments[i]);
+    }
+    return status;
+}
@@ -93,14 +93,14 @@ int expandaln(int argc, const char **argv, const Command& command) {
     DBReader<unsigned int> queryReader(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
     queryReader.open(DBReader<unsigned int>::NOSORT);
     const int queryDbType = queryReader.getDbtype();
-    if (par.preloadMode != Parameters::PRELOAD_MODE_MMAP) {
+    if (Parameters::shouldTouchData(par.preloadMode)) {
         queryReader.readMmapedDataInMemory();
     }
 
     DBReader<unsigned int> targetReader(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
     targetReader.open(DBReader<unsigned int>::NOSORT);
     const int targetDbType = targetReader.getDbtype();
-    if (par.preloadMode != Parameters::PRELOAD_MODE_MMAP) {
+    if (Parameters::shouldTouchData(par.preloadMode)) {
         targetReader.readMmapedDataInMemory();
     }
 
@@ -126,7 +126,7 @@ int expandaln(int argc, const char **argv, const Command& command) {
 
     DBReader<unsigned int> expansionReader(par.db4.c_str(), par.db4Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
     expansionReader.open(DBReader<unsigned int>::NOSORT);
-    if (par.preloadMode != Parameters::PRELOAD_MODE_MMAP) {
+    if (Parameters::shouldTouchData(par.preloadMode)) {
         expansionReader.readMmapedDataInMemory();
     }
 
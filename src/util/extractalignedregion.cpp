@@ -12,7 +12,7 @@
 int doExtractAlignedRegion(Parameters &par) {
     DBReader<unsigned int> qdbr(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
     qdbr.open(DBReader<unsigned int>::NOSORT);
-    if (par.preloadMode != Parameters::PRELOAD_MODE_MMAP) {
+    if (Parameters::shouldTouchData(par.preloadMode)) {
         qdbr.readMmapedDataInMemory();
     }
 
@@ -24,7 +24,7 @@ int doExtractAlignedRegion(Parameters &par) {
     } else {
         tdbr = new DBReader<unsigned int>(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
         tdbr->open(DBReader<unsigned int>::NOSORT);
-        if (par.preloadMode != Parameters::PRELOAD_MODE_MMAP) {
+        if (Parameters::shouldTouchData(par.preloadMode)) {
             tdbr->readMmapedDataInMemory();
         }
     }
@@ -90,6 +90,7 @@ int doExtractAlignedRegion(Parameters &par) {
 
     FileUtil::symlinkAbs(par.hdr1, par.hdr4);
     FileUtil::symlinkAbs(par.hdr1Index, par.hdr4Index);
+    DBWriter::linkDictionaryFile(par.hdr1, par.hdr4);
 
     alndbr.close();
     qdbr.close();
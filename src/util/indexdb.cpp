@@ -35,6 +35,8 @@ bool isIndexCompatible(DBReader<unsigned int>& index, const Parameters& par, con
         return false;
     if (par.spacedKmerPattern != PrefilteringIndexReader::getSpacedPattern(&index))
         return false;
+    if (meta.headers1 != (par.indexHeaders ? 1 : 0))
+        return false;
     if (meta.headers2 == 1 && (par.db1 != par.db2))
         return true;
     return true;
@@ -113,7 +115,7 @@ int indexdb(int argc, const char **argv, const Command &command) {
 
     DBReader<unsigned int> *hdbr1 = NULL;
     DBReader<unsigned int> *hdbr2 = NULL;
-    {
+    if (par.indexHeaders) {
         hdbr1 = new DBReader<unsigned int>(par.hdr1.c_str(), par.hdr1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
         hdbr1->open(DBReader<unsigned int>::NOSORT);
         if (sameDB == false) {
@@ -125,7 +127,7 @@ int indexdb(int argc, const char **argv, const Command &command) {
     PrefilteringIndexReader::createIndexFile(indexDB, &dbr, dbr2, hdbr1, hdbr2, seedSubMat, par.maxSeqLen,
                                              par.spacedKmer, par.spacedKmerPattern, par.compBiasCorrection,
                                              seedSubMat->alphabetSize, par.kmerSize, par.maskMode, par.maskLowerCaseMode,
-                                             par.kmerScore);
+                                             par.maskCache, par.kmerScore);
 
     if (hdbr2 != NULL) {
         hdbr2->close();
@@ -22,7 +22,15 @@ int mvdb(int argc, const char **argv, const Command& command) {
     }
 
     FileUtil::move(par.db1Index.c_str(), par.db2Index.c_str());
+    std::string binaryIndexFile = par.db1Index + ".bin";
+    if (FileUtil::fileExists(binaryIndexFile.c_str())) {
+        FileUtil::move(binaryIndexFile.c_str(), (par.db2Index + ".bin").c_str());
+    }
     FileUtil::move(par.db1dbtype.c_str(), par.db2dbtype.c_str());
+    std::string dictFile = par.db1 + ".dict";
+    if (FileUtil::fileExists(dictFile.c_str())) {
+        FileUtil::move(dictFile.c_str(), (par.db2 + ".dict").c_str());
+    }
 
     return EXIT_SUCCESS;
 }
@@ -167,7 +167,7 @@ int offsetalignment(int argc, const char **argv, const Command &command) {
     Parameters &par = Parameters::getInstance();
     par.parseParameters(argc, argv, command, 6);
 
-    const bool touch = par.preloadMode != Parameters::PRELOAD_MODE_MMAP;
+    const bool touch = Parameters::shouldTouchData(par.preloadMode);
     int queryDbType = DBReader<unsigned int>::parseDbType(par.db1.c_str());
     if(Parameters::isEqualDbtype(queryDbType, Parameters::DBTYPE_INDEX_DB)){
         DBReader<unsigned int> idxdbr(par.db1.c_str(), par.db1Index.c_str(), 1, DBReader<unsigned int>::USE_INDEX | DBReader<unsigned int>::USE_DATA);
@@ -28,7 +28,7 @@ int result2msa(Parameters &par, const std::string &resultData, const std::string
 
     DBReader<unsigned int> qDbr(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
     qDbr.open(DBReader<unsigned int>::NOSORT);
-    if(par.preloadMode != Parameters::PRELOAD_MODE_MMAP){
+    if (Parameters::shouldTouchData(par.preloadMode)) {
         qDbr.readMmapedDataInMemory();
     }
     DBReader<unsigned int> queryHeaderReader(par.hdr1.c_str(), par.hdr1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
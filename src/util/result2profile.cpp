@@ -36,7 +36,7 @@ int result2profile(DBReader<unsigned int> &resultReader, Parameters &par, const
     int targetSeqType = -1;
     int targetDbtype = DBReader<unsigned int>::parseDbType(par.db2.c_str());
     if (Parameters::isEqualDbtype(targetDbtype, Parameters::DBTYPE_INDEX_DB)) {
-        bool touch = (par.preloadMode != Parameters::PRELOAD_MODE_MMAP);
+        bool touch = Parameters::shouldTouchData(par.preloadMode);
         tDbrIdx = new IndexReader(par.db2, par.threads, IndexReader::SEQUENCES, (touch) ? (IndexReader::PRELOAD_INDEX | IndexReader::PRELOAD_DATA) : 0);
         tDbr = tDbrIdx->sequenceReader;
         tDbr->getDbtype();
@@ -56,7 +56,7 @@ int result2profile(DBReader<unsigned int> &resultReader, Parameters &par, const
     if (!sameDatabase) {
         qDbr = new DBReader<unsigned int>(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
         qDbr->open(DBReader<unsigned int>::NOSORT);
-        if (par.preloadMode != Parameters::PRELOAD_MODE_MMAP) {
+        if (Parameters::shouldTouchData(par.preloadMode)) {
             qDbr->readMmapedDataInMemory();
         }
 
@@ -81,7 +81,7 @@ int result2profile(DBReader<unsigned int> &resultReader, Parameters &par, const
     // qDbr->readMmapedDataInMemory();
     // make sure to touch target after query, so if there is not enough memory for the query, at least the targets
     // might have had enough space left to be residung in the page cache
-    if (sameDatabase == false && templateDBIsIndex == false && par.preloadMode != Parameters::PRELOAD_MODE_MMAP) {
+    if (sameDatabase == false && templateDBIsIndex == false && Parameters::shouldTouchData(par.preloadMode)) {
         tDbr->readMmapedDataInMemory();
     }
 
@@ -376,10 +376,12 @@ int result2profile(int argc, const char **argv, const Command &command) {
     if (MMseqsMPI::isMaster()) {
         FileUtil::symlinkAbs(par.hdr1, par.hdr4);
         FileUtil::symlinkAbs(par.hdr1Index, par.hdr4Index);
+        DBWriter::linkDictionaryFile(par.hdr1, par.hdr4);
 
         if (par.omitConsensus == false) {
             FileUtil::symlinkAbs(par.hdr1, par.db4 + "_consensus_h");
             FileUtil::symlinkAbs(par.hdr1Index, par.db4 + "_consensus_h.index");
+            DBWriter::linkDictionaryFile(par.hdr1, par.db4 + "_consensus_h");
         }
     }
 
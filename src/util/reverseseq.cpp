@@ -49,6 +49,7 @@ int reverseseq(int argn, const char **argv, const Command& command) {
 
     FileUtil::symlinkAbs(par.hdr1, par.hdr2);
     FileUtil::symlinkAbs(par.hdr1Index, par.hdr2Index);
+    DBWriter::linkDictionaryFile(par.hdr1, par.hdr2);
     FileUtil::symlinkAbs((par.hdr1 + ".dbtype"), (par.hdr2 + ".dbtype"));
 
     return EXIT_SUCCESS;
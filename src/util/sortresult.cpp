@@ -4,6 +4,7 @@
 #include "Debug.h"
 #include "Util.h"
 #include "Matcher.h"
+#include "ResultBatch.h"
 #include "QueryMatcher.h"
 
 #ifdef OPENMP
@@ -32,8 +33,8 @@ int sortresult(int argc, const char **argv, const Command &command) {
         const char *entry[255];
         char buffer[2048];
 
-        std::vector<Matcher::result_t> alnResults;
-        alnResults.reserve(300);
+        ResultBatch alnResults;
+        alnResults.reserve(300, 300 * 32);
 
         std::vector<hit_t> prefResults;
         prefResults.reserve(300);
@@ -49,7 +50,7 @@ int sortresult(int argc, const char **argv, const Command &command) {
             while (*data != '\0') {
                 const size_t columns = Util::getWordsOfLine(data, entry, 255);
                 if (columns >= Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
-                    alnResults.emplace_back(Matcher::parseAlignmentRecord(data, true));
+                    alnResults.parseRecord(data, entry, columns);
                     format = columns >= Matcher::ALN_RES_WITH_BT_COL_CNT ? 1 : 0;
                 } else if (columns == 3) {
                     prefResults.emplace_back(QueryMatcher::parsePrefilterHit(data));
@@ -63,9 +64,9 @@ int sortresult(int argc, const char **argv, const Command &command) {
 
             writer.writeStart(thread_idx);
             if (format == 0 || format == 1) {
-                std::sort(alnResults.begin(), alnResults.end(), Matcher::compareHits);
+                alnResults.sort();
                 for (size_t i = 0; i < alnResults.size(); ++i) {
-                    size_t length = Matcher::resultToBuffer(buffer, alnResults[i], format == 1, false);
+                    size_t length = alnResults.toBuffer(buffer, i, format == 1);
                     writer.writeAdd(buffer, length, thread_idx);
                 }
             } else if (format == 2) {
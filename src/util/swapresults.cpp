@@ -1,4 +1,5 @@
 #include "Matcher.h"
+#include "ResultBatch.h"
 #include "SubstitutionMatrix.h"
 #include "DBReader.h"
 #include "DBWriter.h"
@@ -70,7 +71,7 @@ int doswap(Parameters& par, bool isGeneralMode) {
         resultReader.close();
     } else {
 
-        bool touch = (par.preloadMode != Parameters::PRELOAD_MODE_MMAP);
+        bool touch = Parameters::shouldTouchData(par.preloadMode);
         IndexReader query(par.db1, par.threads, IndexReader::SEQUENCES,  (touch) ? IndexReader::PRELOAD_INDEX : 0 );
         aaResSize = query.sequenceReader->getAminoAcidDBSize();
 
@@ -232,10 +233,12 @@ int doswap(Parameters& par, bool isGeneralMode) {
 #ifdef OPENMP
             thread_idx = (unsigned int) omp_get_thread_num();
 #endif
-            // we are reusing this vector also for the prefiltering results
+            // we are reusing this batch also for the prefiltering results
             // qcov is used for pScore because its the first float value
             // and alnLength for diagonal because its the first int value after
-            std::vector<Matcher::result_t> curRes;
+            ResultBatch curRes;
+            curRes.reserve(300, 300 * 32);
+            const char *words[255];
             char buffer[1024+32768];
             std::string ss;
             ss.reserve(100000);
@@ -257,19 +260,19 @@ int doswap(Parameters& par, bool isGeneralMode) {
                 bool evalBreak = false;
                 while (dataSize > 0) {
                     if (isAlignmentResult) {
-                        Matcher::result_t res = Matcher::parseAlignmentRecord(data, true);
-                        Matcher::result_t::swapResult(res, evaluer, hasBacktrace);
-                        if (res.eval > par.evalThr) {
+                        const size_t columns = Util::getWordsOfLine(data, words, 255);
+                        curRes.parseRecord(data, words, columns);
+                        const size_t last = curRes.size() - 1;
+                        curRes.swapResult(last, evaluer, hasBacktrace);
+                        if (curRes.eval[last] > par.evalThr) {
                             evalBreak = true;
-                            goto outer;
+                            curRes.pop();
                         }
-                        curRes.emplace_back(res);
                     } else {
                         hit_t hit = QueryMatcher::parsePrefilterHit(data);
                         hit.diagonal = static_cast<unsigned short>(static_cast<short>(hit.diagonal) * -1);
-                        curRes.emplace_back(hit.seqId, hit.prefScore, 0, 0, 0, -static_cast<float>(hit.prefScore), hit.diagonal, 0, 0, 0, 0, 0, 0, "");
+                        curRes.push(hit.seqId, hit.prefScore, 0, 0, 0, -static_cast<float>(hit.prefScore), hit.diagonal, 0, 0, 0, 0, 0, 0, NULL, 0);
                     }
-                    outer:
                     char *nextLine = Util::skipLine(data);
                     size_t lineLen = nextLine - data;
                     dataSize -= lineLen;
@@ -277,20 +280,17 @@ int doswap(Parameters& par, bool isGeneralMode) {
                 }
 
                 if (curRes.empty() == false) {
-                    if (curRes.size() > 1) {
-                        std::sort(curRes.begin(), curRes.end(), Matcher::compareHits);
-                    }
+                    curRes.sort();
 
                     for (size_t j = 0; j < curRes.size(); j++) {
-                        const Matcher::result_t &res = curRes[j];
                         if (isAlignmentResult) {
-                            size_t len = Matcher::resultToBuffer(buffer, res, hasBacktrace, false);
+                            size_t len = curRes.toBuffer(buffer, j, hasBacktrace);
                             ss.append(buffer, len);
                         } else {
                             hit_t hit;
-                            hit.seqId = res.dbKey;
-                            hit.prefScore = res.score;
-                            hit.diagonal = res.alnLength;
+                            hit.seqId = curRes.dbKey[j];
+                            hit.prefScore = curRes.score[j];
+                            hit.diagonal = curRes.alnLength[j];
                             size_t len = QueryMatcher::prefilterHitToBuffer(buffer, hit);
                             ss.append(buffer, len);
                         }
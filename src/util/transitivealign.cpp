@@ -97,7 +97,7 @@ int transitivealign(int argc, const char **argv, const Command &command) {
 
     DBReader<unsigned int> sequenceDbr(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
     sequenceDbr.open(DBReader<unsigned int>::NOSORT);
-    if (par.preloadMode != Parameters::PRELOAD_MODE_MMAP) {
+    if (Parameters::shouldTouchData(par.preloadMode)) {
         sequenceDbr.readMmapedDataInMemory();
     }
     const int querySeqType = sequenceDbr.getDbtype();
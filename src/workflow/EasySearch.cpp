@@ -61,7 +61,9 @@ int doeasysearch(int argc, const char **argv, const Command &command, bool linse
     {
         bool needSequenceDB = false;
         bool needFullHeaders = false;
-        Parameters::getOutputFormat(par.outfmt, needSequenceDB, needBacktrace, needFullHeaders);
+        bool needQueryHeaders = false;
+        bool needTargetHeaders = false;
+        Parameters::getOutputFormat(par.outfmt, needSequenceDB, needBacktrace, needFullHeaders, needQueryHeaders, needTargetHeaders);
     }
     if(par.formatAlignmentMode == Parameters::FORMAT_ALIGNMENT_SAM){
         needBacktrace = true;
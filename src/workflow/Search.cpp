@@ -291,6 +291,16 @@ int search(int argc, const char **argv, const Command& command) {
             par.realign = false;
         }
     }
+
+    // the LCA can only replace the alignments if the align module writes the final result
+    const int fusedLcaUnsupported = Parameters::SEARCH_MODE_FLAG_TARGET_PROFILE | Parameters::SEARCH_MODE_FLAG_QUERY_TRANSLATED
+                                    | Parameters::SEARCH_MODE_FLAG_TARGET_TRANSLATED | Parameters::SEARCH_MODE_FLAG_QUERY_NUCLEOTIDE
+                                    | Parameters::SEARCH_MODE_FLAG_TARGET_NUCLEOTIDE;
+    if (par.fusedLca && (par.numIterations > 1 || par.sensSteps > 1 || par.sliceSearch || isUngappedMode || (searchMode & fusedLcaUnsupported))) {
+        par.printUsageMessage(command, MMseqsParameter::COMMAND_ALIGN | MMseqsParameter::COMMAND_PREFILTER);
+        Debug(Debug::ERROR) << "Fused LCA is only supported for single step amino acid or query profile searches with gapped alignments.\n";
+        EXIT(EXIT_FAILURE);
+    }
     par.printParameters(command.cmd, argc, argv, par.searchworkflow);
 
     if (FileUtil::directoryExists(par.db4.c_str()) == false) {
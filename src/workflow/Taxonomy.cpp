@@ -3,6 +3,7 @@
 #include "Debug.h"
 #include "Util.h"
 #include "CommandCaller.h"
+#include "DBReader.h"
 #include "taxonomy.sh.h"
 
 
@@ -49,6 +50,25 @@ int taxonomy(int argc, const char **argv, const Command& command) {
     cmd.addVariable("REMOVE_TMP", par.removeTmpFiles ? "TRUE" : NULL);
     cmd.addVariable("RUNNER", par.runner.c_str());
 
+    if (par.fusedLca) {
+        // the align module can only replace search and lca if it writes the final search result
+        const int queryDbType = DBReader<unsigned int>::parseDbType(par.db1.c_str());
+        const int targetDbType = DBReader<unsigned int>::parseDbType(par.db2.c_str());
+        const bool isFusable = (par.taxonomySearchMode == Parameters::TAXONOMY_SINGLE_SEARCH || par.taxonomySearchMode == Parameters::TAXONOMY_TOP_HIT)
+                               && par.taxonomyOutpuMode == Parameters::TAXONOMY_OUTPUT_LCA
+                               && par.sensSteps == 1 && par.numIterations == 1 && par.alignmentMode != Parameters::ALIGNMENT_MODE_UNGAPPED
+                               && Parameters::isEqualDbtype(queryDbType, Parameters::DBTYPE_NUCLEOTIDES) == false
+                               && Parameters::isEqualDbtype(targetDbType, Parameters::DBTYPE_AMINO_ACIDS);
+        if (isFusable) {
+            cmd.addVariable("FUSED_LCA", "1");
+            par.PARAM_LCA_MODE.wasSet = true;
+        } else {
+            Debug(Debug::WARNING) << "Fused LCA is not supported for this search, computing the LCA separately.\n";
+            par.fusedLca = false;
+            par.PARAM_FUSED_LCA.wasSet = false;
+        }
+    }
+
     int alignmentMode = par.alignmentMode;
     if (par.taxonomySearchMode == Parameters::TAXONOMY_2BLCA) {
         // at least cov must be set for extractalignedregion